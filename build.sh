@@ -62,6 +62,9 @@ for i in $(seq 1 ${#word}); do
       profiling=true
       options="$options -DBUILD_PROFILING=ON"
     ;;
+    'a') # Enable allocation tracking.
+      options="$options -DBUILD_ALLOCATION_TRACKING=ON"
+    ;;
     'b') # Build benchmarks.
       options="$options -DBUILD_BENCHMARKS=ON"
     ;;
@@ -0,0 +1,214 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "config.hpp"
+
+namespace HAPI_NAMESPACE_NAME {
+
+  //! \brief What the allocation tracker does when a frame allocates after warm-up.
+  enum struct AllocationPolicy : std::uint8_t {
+    Ignore,
+    Report,
+    Abort,
+  };
+
+  //! \brief The number of heap allocations made, and their size.
+  struct AllocationCounts {
+    //! \brief The number of allocations.
+    std::uint64_t allocations;
+
+    //! \brief The bytes requested by the allocations.
+    std::uint64_t bytes;
+
+    //! \brief The number of frees.
+    std::uint64_t frees;
+  };
+
+  /*!
+   * \brief Counts global heap allocations per execution phase and per frame.
+   *
+   * When HAPI_TRACK_ALLOCATIONS is defined the global operator new and delete are replaced with
+   * ones that report to this tracker, otherwise nothing is counted and every count stays zero.
+   * Allocations are attributed to the phase the calling thread is in, which is the phase set by
+   * setPhase() unless the thread overrides it with setThreadPhase().
+   *
+   * Once warm-up is over a steady state frame shouldn't allocate at all, endFrame() reports or
+   * aborts on any frame that does, depending on the policy. Allocations that are expected, such as
+   * rebuilding the swapchain, should be made under an Exemption.
+   */
+  class AllocationTracker final {
+  public:
+    //! \brief The most execution phases allocations can be attributed to.
+    static constexpr std::size_t MaxPhases = 8;
+
+    //! \brief The thread phase that defers to the phase set by setPhase().
+    static constexpr std::uint8_t NoPhase = 0xFF;
+
+    //! \brief The number of frames allowed to allocate when no warm-up is requested.
+    static constexpr std::uint64_t DefaultWarmupFrames = 120;
+
+    //! \brief Exempts the allocations of the calling thread from the frame check while in scope.
+    class Exemption final {
+    public:
+      //! \brief Explicitly defined default constructor, begins the exemption.
+      Exemption() noexcept;
+
+      //! \brief Explicitly defined destructor, ends the exemption.
+     ~Exemption() noexcept;
+
+    private:
+      // Not allowed.
+      Exemption(const Exemption&) = delete;
+      Exemption& operator=(const Exemption&) = delete;
+    };
+
+  public:
+    /*!
+     * \brief  Gets the process wide allocation tracker.
+     * \return The tracker instance.
+     */
+    static AllocationTracker& instance() noexcept;
+
+    /*!
+     * \brief  Whether or not the global operator new and delete are hooked in this build.
+     * \return True if HAPI_TRACK_ALLOCATIONS was defined when building the library.
+     */
+    static bool enabled() noexcept;
+
+  private:
+    //! \brief Explicitly defined default constructor.
+    AllocationTracker() noexcept;
+
+    // Not allowed.
+    AllocationTracker(const AllocationTracker&) = delete;
+    AllocationTracker& operator=(const AllocationTracker&) = delete;
+
+  public:
+    /*!
+     * \brief     Sets how frames that allocate after warm-up are handled.
+     * \param[in] policy What to do when a frame allocates.
+     * \param[in] warmupFrames The number of frames allowed to allocate, zero selects the default.
+     * \param[in] phaseNames The names of the phases for reports, must have static storage duration.
+     */
+    void configure(AllocationPolicy policy, std::uint64_t warmupFrames, std::span<const char* const> phaseNames) noexcept;
+
+    /*!
+     * \brief     Sets the phase allocations are attributed to.
+     * \param[in] phase The phase, less than MaxPhases.
+     */
+    void setPhase(std::uint8_t phase) noexcept;
+
+    /*!
+     * \brief     Overrides the phase allocations of the calling thread are attributed to.
+     * \param[in] phase The phase, or NoPhase to defer to the phase set by setPhase().
+     */
+    void setThreadPhase(std::uint8_t phase) noexcept;
+
+    //! \brief Begins counting the allocations of a new frame.
+    void beginFrame() noexcept;
+
+    /*!
+     * \brief Ends the frame, reporting or aborting if it allocated after warm-up.
+     *
+     * Only the frame's allocations are checked, frees are fine.
+     */
+    void endFrame() noexcept;
+
+    /*!
+     * \brief     Gets the allocations attributed to a phase since the process started.
+     * \param[in] phase The phase, less than MaxPhases.
+     * \return    The counts of the phase.
+     */
+    AllocationCounts phaseCounts(std::uint8_t phase) const noexcept;
+
+    /*!
+     * \brief  Gets the allocations of the last frame that ended, not counting exempt ones.
+     * \return The counts of the frame.
+     */
+    AllocationCounts frameCounts() const noexcept;
+
+    /*!
+     * \brief     Records an allocation of the calling thread, called by the operator new hooks.
+     * \param[in] size The size of the allocation.
+     */
+    void recordAllocation(std::size_t size) noexcept;
+
+    //! \brief Records a free of the calling thread, called by the operator delete hooks.
+    void recordFree() noexcept;
+
+  private:
+    //! \brief The counters of a single phase.
+    struct PhaseCounters {
+      //! \brief The allocations since the process started.
+      std::atomic<std::uint64_t> allocations;
+
+      //! \brief The bytes allocated since the process started.
+      std::atomic<std::uint64_t> bytes;
+
+      //! \brief The frees since the process started.
+      std::atomic<std::uint64_t> frees;
+
+      //! \brief The non-exempt allocations of the current frame.
+      std::atomic<std::uint64_t> frameAllocations;
+
+      //! \brief The bytes of the non-exempt allocations of the current frame.
+      std::atomic<std::uint64_t> frameBytes;
+    };
+
+    /*!
+     * \brief  Gets the phase allocations of the calling thread are attributed to.
+     * \return The counters of the phase.
+     */
+    PhaseCounters& currentPhase() noexcept;
+
+  private:
+    //! \brief The counters of every phase.
+    std::array<PhaseCounters, MaxPhases> mPhases;
+
+    //! \brief The names of the phases for reports.
+    std::span<const char* const> mPhaseNames;
+
+    //! \brief The counts of the last frame that ended.
+    AllocationCounts mLastFrame;
+
+    //! \brief The frees of the current frame.
+    std::atomic<std::uint64_t> mFrameFrees;
+
+    //! \brief The number of frames that have ended.
+    std::uint64_t mFrame;
+
+    //! \brief The number of frames allowed to allocate.
+    std::uint64_t mWarmupFrames;
+
+    //! \brief The phase allocations are attributed to.
+    std::atomic<std::uint8_t> mPhase;
+
+    //! \brief What to do when a frame allocates after warm-up.
+    AllocationPolicy mPolicy;
+  };
+
+}
@@ -23,19 +23,40 @@
 #include <array>
 #include <chrono>
 #include <memory>
+#include <thread>
+#include <vector>
+#include "alloctracker.hpp"
+#include "arena.hpp"
 #include "event.hpp"
+#include "framepacer.hpp"
+#include "profile.hpp"
+#include "scheduler.hpp"
+#include "snapshot.hpp"
 #include "version.hpp"
 #include "window.hpp"
 #include "graphics/cmdbuf.hpp"
+#include "graphics/cmdmgr.hpp"
+#include "graphics/dltque.hpp"
 #include "graphics/dscset.hpp"
 #include "graphics/fence.hpp"
 #include "graphics/frmbuf.hpp"
+#include "graphics/frmrng.hpp"
 #include "graphics/gfxpip.hpp"
+#include "graphics/gpuprf.hpp"
+#include "graphics/hstalc.hpp"
+#include "graphics/memalc.hpp"
+#include "graphics/pipcmp.hpp"
+#include "graphics/pipreg.hpp"
 #include "graphics/rdrctx.hpp"
 #include "graphics/rdrpss.hpp"
 #include "graphics/resbuf.hpp"
+#include "graphics/rsdmgr.hpp"
 #include "graphics/semphr.hpp"
+#include "graphics/shdmod.hpp"
+#include "graphics/stgrng.hpp"
 #include "graphics/swpchn.hpp"
+#include "graphics/ufmrng.hpp"
+#include "graphics/xfrque.hpp"
 #include "graphics/txrimg.hpp"
 
 namespace HAPI_NAMESPACE_NAME {
@@ -59,8 +80,44 @@ namespace HAPI_NAMESPACE_NAME {
 
       //! \brief The version of the application being created.
       Version appVersion;
+
+      //! \brief The number of frames the CPU may record ahead of the GPU, zero uses the default.
+      std::uint32_t framesInFlight;
+
+      //! \brief The number of frames per second to pace the application to, zero is uncapped.
+      double targetFrameRate;
+
+      //! \brief The number of fixed simulation steps per second, zero uses the default.
+      double simulationRate;
+
+      //! \brief The most simulation steps a single frame may catch up on, zero uses the default.
+      std::uint32_t maxSimulationSteps;
+
+      //! \brief The number of job workers, including the main thread, zero uses every core.
+      std::uint32_t workerCount;
+
+      //! \brief Whether rendering runs on its own thread, a frame behind simulation.
+      bool pipelinedRendering;
+
+      //! \brief Whether pipelines leave cull mode, front face and topology to the command buffer where supported.
+      bool extendedDynamicState;
+
+      //! \brief The file compiled pipelines are cached in between runs, null disables the disk cache.
+      const char* pipelineCachePath;
+
+      //! \brief The file profiling builds write a Chrome trace of CPU zones to, null disables tracing.
+      const char* traceFilePath;
+
+      //! \brief What allocation tracking builds do when a frame allocates after warm-up.
+      AllocationPolicy allocationPolicy;
     };
 
+    //! \brief The number of simulation steps per second used when none is requested.
+    static constexpr double DefaultSimulationRate = 60.0;
+
+    //! \brief The most simulation steps a frame catches up on, when no limit is requested.
+    static constexpr std::uint32_t DefaultMaxSimulationSteps = 5;
+
   private:
     /*!
      * \brief Describes the different phases of execution an application can be in.
@@ -110,9 +167,12 @@ namespace HAPI_NAMESPACE_NAME {
      * \brief Keeps track of various timing related information for the application.
      */
     struct Timing {
-      //! \brief Collects the number of passing nanoseconds per frame.
+      //! \brief Collects the number of passing nanoseconds per frame, consumed by simulation steps.
       Nanoseconds accumulator;
 
+      //! \brief The fixed amount of time a single simulation step advances by.
+      Nanoseconds simulationStep;
+
       //! \brief The amount of nanoseconds the last frame took.
       Nanoseconds lastFrameDelta;
 
@@ -124,6 +184,43 @@ namespace HAPI_NAMESPACE_NAME {
 
       //! \brief The number of frames that have elapsed.
       std::uint64_t framesElapsed;
+
+      //! \brief The number of fixed simulation steps that have elapsed.
+      std::uint64_t simulationSteps;
+
+      //! \brief How far between the previous and current simulation step rendering should be.
+      float interpolationAlpha;
+    };
+
+    /*!
+     * \brief Describes the state advanced by every fixed simulation step.
+     *
+     * Rendering interpolates between the previous and current copies of this state, so it stays
+     * smooth when rendering runs faster than simulation.
+     */
+    struct SimulationState {
+      //! \brief The rotation of the displayed model, in radians.
+      float rotation;
+    };
+
+    /*!
+     * \brief Describes everything needed to render a frame, captured after simulation.
+     *
+     * Snapshots are immutable once handed off, so the render thread never reads state that the
+     * game thread is busy changing.
+     */
+    struct RenderSnapshot {
+      //! \brief The rotation of the displayed model, interpolated for this frame, in radians.
+      float rotation;
+
+      //! \brief The latest size the window was resized to.
+      glm::uvec2 windowSize;
+
+      //! \brief Incremented on every resize, the renderer rebuilds the swapchain when it changes.
+      std::uint64_t resizeSerial;
+
+      //! \brief Whether or not the window is minimized.
+      bool windowMinimized;
     };
 
   public:
@@ -184,13 +281,61 @@ namespace HAPI_NAMESPACE_NAME {
      */
     bool quitting() const noexcept;
 
+    /*!
+     * \brief  Gets the pacer that paces the frames of this application.
+     * \return The frame pacer, which can be used to query pacing statistics or change the rate.
+     */
+    FramePacer& framePacer() noexcept;
+
+    /*!
+     * \brief  Gets the pacer that paces the frames of this application.
+     * \return The frame pacer, which can be used to query pacing statistics.
+     */
+    const FramePacer& framePacer() const noexcept;
+
+    /*!
+     * \brief  Gets how far between the previous and current simulation step the current frame is.
+     * \return A value in the range [0, 1), used to interpolate simulation state for rendering.
+     */
+    float interpolationAlpha() const noexcept;
+
+    /*!
+     * \brief  Gets the profiler measuring the GPU time of the frames of this application.
+     * \return The GPU profiler, or null if this isn't a profiling build.
+     */
+    const gfx::GpuProfiler* gpuProfiler() const noexcept;
+
   private:
+    //! \brief Initializes the job scheduler, making the calling thread its main thread.
+    void initializeJobScheduler();
+
+    //! \brief Initializes the per-thread arenas transient frame data is allocated from.
+    void initializeFrameArenas();
+
     //! \brief Initializes the application window.
     void initializeWindow();
 
+    //! \brief Initializes the host allocator every vulkan object allocates host memory through.
+    void initializeHostAllocator();
+
     //! \brief Initializes the render context.
     void initializeRenderContext();
 
+    //! \brief Initializes the device memory allocator.
+    void initializeMemoryAllocator();
+
+    //! \brief Initializes the deletion queue GPU objects are destroyed through.
+    void initializeDeletionQueue();
+
+    //! \brief Initializes the shader library pipelines load their shader modules through.
+    void initializeShaderLibrary();
+
+    //! \brief Initializes the compiler pipelines are built on workers with.
+    void initializePipelineCompiler();
+
+    //! \brief Initializes the registry identical pipeline states are shared through.
+    void initializePipelineRegistry();
+
     //! \brief Initialize the swapchain.
     void initializeSwapChain();
 
@@ -200,14 +345,14 @@ namespace HAPI_NAMESPACE_NAME {
     //! \brief Initializes the framebuffers.
     void initializeFrameBuffers();
 
-    //! \brief Initializes the vertex buffer.
+    //! \brief Initializes the vertex buffer, streamable so it is dropped before the budget runs out.
     void initializeVertexBuffer();
 
     //! \brief Initializes the index buffer.
     void initializeIndexBuffer();
 
-    //! \brief Initializes the uniform buffer.
-    void initializeUniformBuffer();
+    //! \brief Initializes the uniform ring per-frame uniforms are allocated from.
+    void initializeUniformRing();
 
     //! \brief Initializes the texture image.
     void initializeTextureImage();
@@ -218,8 +363,8 @@ namespace HAPI_NAMESPACE_NAME {
     //! \brief Initializes the descriptor set layout.
     void initializeDescriptorSetLayout();
 
-    //! \brief Initializes the descriptor set.
-    void initializeDescriptorSet();
+    //! \brief Initializes the per-frame descriptor sets.
+    void initializeDescriptorSets();
 
     //! \brief Initializes the pipeline layout.
     void initializePipelineLayout();
@@ -230,8 +375,25 @@ namespace HAPI_NAMESPACE_NAME {
     //! \brief Initializes the command pool.
     void initializeCommandPool();
 
-    //! \brief Initializes the command buffer.
-    void initializeCommandBuffer();
+    //! \brief Initializes the ring of per-frame contexts.
+    void initializeFrameRing();
+
+    //! \brief Initializes the residency manager keeping memory usage under the budget.
+    void initializeResidencyManager();
+
+    //! \brief Initializes the staging ring uploads to device local buffers go through.
+    void initializeStagingRing();
+
+    //! \brief Initializes the transfer queue, if the device has a transfer only queue family.
+    void initializeTransferQueue();
+
+    //! \brief Initializes the per-frame, per-thread command pools.
+    void initializeCommandPoolManager();
+
+  #if defined(HAPI_PROFILE)
+    //! \brief Initializes the GPU profiler.
+    void initializeGpuProfiler();
+  #endif
 
     //! \brief Initializes this application.
     void initialize();
@@ -239,9 +401,51 @@ namespace HAPI_NAMESPACE_NAME {
     //! \brief Terminates this application.
     void terminate() noexcept;
 
+    /*!
+     * \brief     Enters the given execution phase, allocations are attributed to it from here on.
+     * \param[in] phase The phase to enter.
+     */
+    void enterPhase(ExecutionPhase phase) noexcept;
+
     //! \brief Executes a frame of operations within the application.
     void executeFrame() noexcept;
 
+    //! \brief Executes the event polling phase of a frame, must run on the main thread.
+    void executeEventPolling() noexcept;
+
+    //! \brief Executes the simulation phase of a frame.
+    void executeSimulation() noexcept;
+
+    //! \brief Executes the updating phase of a frame.
+    void executeUpdating() noexcept;
+
+    //! \brief Executes the rendering phase of a frame, handing it off if rendering is pipelined.
+    void executeRendering() noexcept;
+
+    //! \brief The loop the render thread runs, rendering snapshots until stopped.
+    void renderThreadLoop() noexcept;
+
+    /*!
+     * \brief     Records, submits and presents a frame.
+     * \param[in] snapshot The state to render.
+     * \param[in] threadIndex The slot of the calling thread in the command pool manager.
+     */
+    void renderSnapshot(const RenderSnapshot& snapshot, std::uint32_t threadIndex) noexcept;
+
+    /*!
+     * \brief Runs as many fixed simulation steps as the accumulated frame time allows.
+     *
+     * The accumulator is capped to the maximum number of catch-up steps, so a long frame can't
+     * cause every following frame to fall further behind.
+     */
+    void simulateFixedSteps() noexcept;
+
+    /*!
+     * \brief     Advances the simulation state by a single fixed step.
+     * \param[in] step The amount of time to advance by, in seconds.
+     */
+    void simulate(float step) noexcept;
+
     //! \brief Rebuilds the swapchain and framebuffers.
     void rebuildSwapChainAndFrameBuffers();
 
@@ -310,15 +514,45 @@ namespace HAPI_NAMESPACE_NAME {
     //! \brief Describes the executing state of the application.
     ExecutionState mExecutionState;
 
+    //! \brief Paces the frames of this application to the target frame rate.
+    FramePacer mFramePacer;
+
+    //! \brief The simulation state as of the previous fixed step.
+    SimulationState mPreviousState;
+
+    //! \brief The simulation state as of the latest fixed step.
+    SimulationState mCurrentState;
+
     //! \brief The main window for this application.
     Window* mMainWindow;
 
-    //! \brief The framebuffers for this application.
-    std::array<std::unique_ptr<gfx::FrameBuffer>, 3> mFrameBuffers;
+    //! \brief The scheduler the phases of every frame are executed on.
+    std::unique_ptr<JobScheduler> mJobScheduler;
+
+    //! \brief The arenas transient frame data is allocated from, indexed like command pool threads.
+    std::vector<std::unique_ptr<LinearArena>> mFrameArenas;
+
+    //! \brief The framebuffers for this application, one per swapchain image.
+    std::vector<std::unique_ptr<gfx::FrameBuffer>> mFrameBuffers;
+
+    //! \brief The completion value of the frame last rendering to each swapchain image, if any.
+    std::vector<std::uint64_t> mImagesInFlight;
+
+    //! \brief The host memory of every vulkan object, outlives the render context.
+    std::unique_ptr<gfx::HostAllocator> mHostAllocator;
 
     //! \brief The render context for this application.
     std::unique_ptr<gfx::RenderContext> mRenderContext;
 
+    //! \brief The allocator resources get their device memory from.
+    std::unique_ptr<gfx::MemoryAllocator> mMemoryAllocator;
+
+    //! \brief Defers the destruction of GPU objects until the frames using them are done.
+    std::unique_ptr<gfx::DeletionQueue> mDeletionQueue;
+
+    //! \brief Loads shader modules once, and shares them between pipelines.
+    std::unique_ptr<gfx::ShaderLibrary> mShaderLibrary;
+
     //! \brief The swapchain for this application.
     std::unique_ptr<gfx::SwapChain> mSwapChain;
 
@@ -328,11 +562,14 @@ namespace HAPI_NAMESPACE_NAME {
     //! \brief The resource buffer we will be using for our vertices.
     std::unique_ptr<gfx::ResourceBuffer> mVertexBuffer;
 
+    //! \brief The handle the residency manager tracks the vertex buffer by.
+    gfx::ResidencyHandle mVertexResidency;
+
     //! \brief The resource buffer we will be using for our indices.
     std::unique_ptr<gfx::ResourceBuffer> mIndexBuffer;
 
-    //! \brief The resource buffer we will be using for uniforms.
-    std::unique_ptr<gfx::ResourceBuffer> mUniformBuffer;
+    //! \brief The uniform ring we will be allocating per-frame uniforms from.
+    std::unique_ptr<gfx::UniformRing> mUniformRing;
 
     //! \brief The texture image we will be displaying to the screen.
     std::unique_ptr<gfx::TextureImage> mTextureImage;
@@ -343,20 +580,61 @@ namespace HAPI_NAMESPACE_NAME {
     //! \brief The descriptor set layout we will be using.
     std::unique_ptr<gfx::DescriptorSetLayout> mDescriptorLayout;
 
-    //! \brief The descriptor set that we will be using to update our uniform buffer.
+    //! \brief The descriptor set of the uniform ring, slices are bound by dynamic offset.
     std::unique_ptr<gfx::DescriptorSet> mUniformDescriptorSet;
 
     //! \brief The layout for the graphics pipeline.
     std::unique_ptr<gfx::PipelineLayout> mPipelineLayout;
 
-    //! \brief The graphics pipeline used for this application.
-    std::unique_ptr<gfx::Pipeline> mGraphicsPipeline;
+    //! \brief Compiles pipelines on the job scheduler's workers.
+    std::unique_ptr<gfx::PipelineCompiler> mPipelineCompiler;
+
+    //! \brief Shares a single pipeline between every request for the same state.
+    std::unique_ptr<gfx::PipelineRegistry> mPipelineRegistry;
+
+    //! \brief The graphics pipeline used for this application, draws are skipped until it's ready.
+    gfx::PipelineHandle mGraphicsPipeline;
 
     //! \brief The command pool we will use to create command buffers.
     std::unique_ptr<gfx::CommandPool> mCommandPool;
 
-    //! \brief The command buffer used to record commands.
-    std::unique_ptr<gfx::CommandBuffer> mCommandBuffer;
+    //! \brief The ring of frames in flight, each with its own command buffer and sync objects.
+    std::unique_ptr<gfx::FrameRing> mFrameRing;
+
+    //! \brief Evicts the least recently used streamable resources when over the memory budget.
+    std::unique_ptr<gfx::ResidencyManager> mResidencyManager;
+
+    //! \brief The staging ring uploads to device local buffers go through.
+    std::unique_ptr<gfx::StagingRing> mStagingRing;
+
+    //! \brief The transfer queue asynchronous uploads go through, null if the device has none.
+    std::unique_ptr<gfx::TransferQueue> mTransferQueue;
+
+    //! \brief The ticket of the geometry uploaded on the transfer queue.
+    std::uint64_t mGeometryTicket;
+
+    //! \brief The command pools secondary command buffers are recorded from.
+    std::unique_ptr<gfx::CommandPoolManager> mCommandPoolManager;
+
+  #if defined(HAPI_PROFILE)
+    //! \brief The profiler measuring GPU zones of every frame.
+    std::unique_ptr<gfx::GpuProfiler> mGpuProfiler;
+  #endif
+
+    //! \brief The snapshots handed from the game thread to the render thread.
+    SnapshotBuffer<RenderSnapshot> mSnapshots;
+
+    //! \brief The thread rendering happens on, if pipelined.
+    std::thread mRenderThread;
+
+    //! \brief The latest size the window was resized to.
+    glm::uvec2 mPendingWindowSize;
+
+    //! \brief Incremented by the game thread whenever the window is resized.
+    std::uint64_t mResizeSerial;
+
+    //! \brief The resize serial the swapchain was last rebuilt for, owned by rendering.
+    std::uint64_t mAppliedResizeSerial;
 
     //! \brief Whether or not the window minimized.
     bool mWindowMinimized;
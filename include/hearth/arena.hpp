@@ -0,0 +1,197 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "config.hpp"
+
+namespace HAPI_NAMESPACE_NAME {
+
+  /*!
+   * \brief A bump allocator for data that only lives until the end of a frame.
+   *
+   * Allocation moves an offset through a single block, nothing is freed individually, reset()
+   * releases everything at once. Allocations that don't fit spill into overflow blocks, and the next
+   * reset() grows the main block to cover the whole frame, so a steady state frame allocates
+   * nothing from the general heap.
+   *
+   * An arena is not thread safe, every thread should allocate from its own.
+   */
+  class LinearArena final {
+  public:
+    //! \brief The size of the main block when none is requested.
+    static constexpr std::size_t DefaultCapacity = 64 * 1024;
+
+    //! \brief The information needed to create a linear arena.
+    struct CreateInfo {
+      //! \brief The initial size of the main block, zero selects the default.
+      std::size_t capacity;
+    };
+
+  public:
+    /*!
+     * \brief     Explicitly defined constructor, creates this object from the given information.
+     * \param[in] createInfo The information needed to create this object.
+     */
+    LinearArena(const CreateInfo& createInfo);
+
+  private:
+    // Not allowed.
+    LinearArena(const LinearArena&) = delete;
+    LinearArena& operator=(const LinearArena&) = delete;
+
+  public:
+    /*!
+     * \brief     Allocates uninitialized memory that stays valid until the next reset.
+     * \param[in] size The size of the memory.
+     * \param[in] alignment The alignment of the memory, must be a power of two.
+     * \return    The memory.
+     */
+    void* allocate(std::size_t size, std::size_t alignment);
+
+    /*!
+     * \brief Releases every allocation, growing the main block if the last frame overflowed it.
+     *
+     * Nothing allocated from this arena may be used afterwards.
+     */
+    void reset();
+
+    /*!
+     * \brief  Gets the bytes allocated since the last reset, including alignment padding.
+     * \return The used bytes.
+     */
+    std::size_t used() const noexcept;
+
+    /*!
+     * \brief  Gets the size of the main block.
+     * \return The bytes that can be allocated without overflowing.
+     */
+    std::size_t capacity() const noexcept;
+
+  private:
+    //! \brief A block of memory allocations are bumped through.
+    struct Block {
+      //! \brief The memory of the block.
+      std::unique_ptr<std::byte[]> memory;
+
+      //! \brief The size of the block.
+      std::size_t size;
+
+      //! \brief The offset of the next allocation.
+      std::size_t offset;
+    };
+
+    /*!
+     * \brief     Bumps an allocation through the given block.
+     * \param[in] block The block to allocate from.
+     * \param[in] size The size of the allocation.
+     * \param[in] alignment The alignment of the allocation.
+     * \return    The allocation, or null if it doesn't fit.
+     */
+    static void* bump(Block& block, std::size_t size, std::size_t alignment) noexcept;
+
+  private:
+    //! \brief The block allocations go to first.
+    Block mBlock;
+
+    //! \brief The blocks allocations spilled into after the main block filled up.
+    std::vector<Block> mOverflow;
+
+    //! \brief The bytes allocated since the last reset.
+    std::size_t mUsed;
+  };
+
+  /*!
+   * \brief An allocator for standard containers that allocates from a linear arena.
+   *
+   * Deallocation does nothing, memory is reclaimed when the arena resets. A container using it must
+   * not outlive the frame it was created in.
+   */
+  template<typename Type>
+  class ArenaAllocator {
+  public:
+    //! \brief The type of element allocated.
+    using value_type = Type;
+
+  public:
+    /*!
+     * \brief     Explicitly defined constructor, allocates from the given arena.
+     * \param[in] arena The arena to allocate from.
+     */
+    ArenaAllocator(LinearArena& arena) noexcept
+      : mArena(&arena)
+    { }
+
+    /*!
+     * \brief     Explicitly defined converting constructor, allocates from the same arena as other.
+     * \param[in] other The allocator of another element type.
+     */
+    template<typename Other>
+    ArenaAllocator(const ArenaAllocator<Other>& other) noexcept
+      : mArena(other.arena())
+    { }
+
+  public:
+    /*!
+     * \brief     Allocates memory for the given number of elements.
+     * \param[in] count The number of elements.
+     * \return    The uninitialized memory.
+     */
+    Type* allocate(std::size_t count) {
+      return static_cast<Type*>(mArena->allocate(count * sizeof(Type), alignof(Type)));
+    }
+
+    //! \brief Does nothing, the arena reclaims memory on reset.
+    void deallocate(Type*, std::size_t) noexcept { }
+
+    /*!
+     * \brief  Gets the arena this allocator allocates from.
+     * \return The arena.
+     */
+    LinearArena* arena() const noexcept {
+      return mArena;
+    }
+
+    //! \brief Allocators are equal if they allocate from the same arena.
+    template<typename Other>
+    bool operator==(const ArenaAllocator<Other>& other) const noexcept {
+      return mArena == other.arena();
+    }
+
+    //! \brief Allocators are unequal if they allocate from different arenas.
+    template<typename Other>
+    bool operator!=(const ArenaAllocator<Other>& other) const noexcept {
+      return mArena != other.arena();
+    }
+
+  private:
+    //! \brief The arena memory comes from.
+    LinearArena* mArena;
+  };
+
+  //! \brief A vector whose elements live in a linear arena, for per-frame lists.
+  template<typename Type>
+  using ArenaVector = std::vector<Type, ArenaAllocator<Type>>;
+
+}
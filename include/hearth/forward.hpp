@@ -26,6 +26,10 @@ namespace HAPI_NAMESPACE_NAME {
 
   class Application;
   class Event;
+  class FramePacer;
+  class JobCounter;
+  class JobScheduler;
+  class LinearArena;
   class Version;
   class Window;
 
@@ -33,19 +37,37 @@ namespace HAPI_NAMESPACE_NAME {
 
     class CommandBuffer;
     class CommandPool;
+    class CommandPoolManager;
+    class DeletionQueue;
     class DescriptorPool;
     class DescriptorSet;
     class DescriptorSetLayout;
     class Fence;
     class FrameBuffer;
+    class FrameRing;
+    class GpuProfiler;
+    class GpuZone;
+    class HostAllocator;
+    class MemoryAllocator;
     class Pipeline;
+    class PipelineCache;
+    class PipelineCompiler;
+    class PipelineHandle;
     class PipelineLayout;
+    class PipelineRegistry;
     class RenderContext;
     class RenderPass;
+    class ResidencyManager;
     class ResourceBuffer;
     class Semaphore;
+    class ShaderLibrary;
+    class ShaderModule;
+    class StagingRing;
     class SwapChain;
     class TextureImage;
+    class TimelineSemaphore;
+    class TransferQueue;
+    class UniformRing;
 
   }
 
@@ -0,0 +1,169 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include "config.hpp"
+
+namespace HAPI_NAMESPACE_NAME {
+
+  //! \brief The different ways a frame pacer can pace frames.
+  enum struct PacingMode : std::uint8_t {
+    Uncapped,
+    TargetRate,
+  };
+
+  /*!
+   * \brief Paces the frames of an application to a target rate.
+   *
+   * Waiting for the next frame deadline is done in two steps, the pacer first sleeps for as long as
+   * it safely can, then spins for the remainder. How long it is safe to sleep for is calibrated at
+   * runtime, by measuring how far past the requested duration the operating system wakes us up.
+   */
+  class FramePacer final {
+  public:
+    //! \brief Shortcut type definition for overly verbose standard chrono steady clock.
+    using SteadyClock = std::chrono::steady_clock;
+
+    //! \brief Shortcut type definition for overly verbose standard chrono steady clock time pont.
+    using TimePoint = SteadyClock::time_point;
+
+    //! \brief Shortcut type definition for overly verbose standard chrono nanoseconds.
+    using Nanoseconds = std::chrono::nanoseconds;
+
+    //! \brief The information needed to create a frame pacer.
+    struct CreateInfo {
+      //! \brief The way frames should be paced.
+      PacingMode mode;
+
+      //! \brief The number of frames per second to target, when pacing to a target rate.
+      double targetFrameRate;
+
+      //! \brief The initial amount of time reserved for spinning, before calibration kicks in.
+      Nanoseconds spinThreshold;
+    };
+
+    //! \brief Describes the measured accuracy of a frame pacer.
+    struct Statistics {
+      //! \brief How late the last paced frame woke up relative to its deadline.
+      Nanoseconds lastOversleep;
+
+      //! \brief The average lateness of paced frames, relative to their deadlines.
+      Nanoseconds averageOversleep;
+
+      //! \brief The worst lateness of any paced frame, relative to its deadline.
+      Nanoseconds maxOversleep;
+
+      //! \brief The amount of time currently reserved for spinning after a sleep.
+      Nanoseconds spinThreshold;
+
+      //! \brief The number of frames that waited for their deadline.
+      std::uint64_t pacedFrames;
+
+      //! \brief The number of frames that were already past their deadline.
+      std::uint64_t missedFrames;
+    };
+
+  public:
+    //! \brief Explicitly defined default constructor, creates an uncapped pacer.
+    FramePacer() noexcept;
+
+    /*!
+     * \brief     Explicitly defined constructor, creates this object from the given information.
+     * \param[in] createInfo The information needed to create this object.
+     */
+    FramePacer(const CreateInfo& createInfo);
+
+  public:
+    /*!
+     * \brief     Restarts pacing, with the first frame deadline one frame period after the given time.
+     * \param[in] start The point in time pacing starts from.
+     */
+    void reset(TimePoint start) noexcept;
+
+    /*!
+     * \brief Waits until the deadline of the current frame, then moves onto the next one.
+     *
+     * If the current frame is already past its deadline, this returns immediately. If it fell
+     * behind by more than a whole frame, the deadlines are re-anchored to now instead of trying to
+     * catch up with a burst of unpaced frames.
+     */
+    void wait() noexcept;
+
+    /*!
+     * \brief     Changes the rate at which frames are paced.
+     * \param[in] targetFrameRate The new number of frames per second, zero uncaps the pacer.
+     */
+    void targetFrameRate(double targetFrameRate);
+
+    /*!
+     * \brief  Gets the rate at which frames are paced.
+     * \return The number of frames per second targeted, zero if uncapped.
+     */
+    double targetFrameRate() const noexcept;
+
+    /*!
+     * \brief  Gets the way this pacer paces frames.
+     * \return The pacing mode.
+     */
+    PacingMode mode() const noexcept;
+
+    /*!
+     * \brief  Gets the measured accuracy of this pacer.
+     * \return The pacing statistics gathered since the last reset.
+     */
+    const Statistics& statistics() const noexcept;
+
+  private:
+    /*!
+     * \brief     Feeds a measured sleep error into the spin threshold calibration.
+     * \param[in] error How much longer than requested the last sleep took.
+     */
+    void calibrate(Nanoseconds error) noexcept;
+
+  private:
+    //! \brief The statistics gathered while pacing.
+    Statistics mStatistics;
+
+    //! \brief The deadline of the current frame.
+    TimePoint mDeadline;
+
+    //! \brief The duration of a single frame, at the target rate.
+    Nanoseconds mFramePeriod;
+
+    //! \brief The smallest spin threshold calibration is allowed to settle on.
+    Nanoseconds mMinimumSpin;
+
+    //! \brief The running mean of the sleep error, in nanoseconds.
+    double mSleepErrorMean;
+
+    //! \brief The running mean absolute deviation of the sleep error, in nanoseconds.
+    double mSleepErrorDeviation;
+
+    //! \brief The number of frames per second targeted.
+    double mTargetFrameRate;
+
+    //! \brief The way this pacer paces frames.
+    PacingMode mMode;
+  };
+
+}
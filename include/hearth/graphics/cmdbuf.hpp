@@ -20,18 +20,37 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 #pragma once
+#include <array>
 #include <cstdint>
+#include <span>
 #include <vector>
 #include <glm/glm.hpp>
 #include <vulkan/vulkan.h>
 #include "../forward.hpp"
+#include "fence.hpp"
 #include "frmbuf.hpp"
 #include "gfxpip.hpp"
 #include "rdrpss.hpp"
 #include "resbuf.hpp"
+#include "semphr.hpp"
 
 namespace HAPI_NAMESPACE_NAME::gfx {
 
+  //! \brief The most color attachments the dynamic blend state of a command buffer can be set for.
+  constexpr std::uint32_t kMaxColorAttachments = 8;
+
+  //! \brief The different levels a command buffer can be allocated at.
+  enum struct CommandBufferLevel : std::uint8_t {
+    Primary,
+    Secondary,
+  };
+
+  //! \brief Describes where the commands of a subpass will be recorded.
+  enum struct SubpassContents : std::uint8_t {
+    Inline,
+    SecondaryCommandBuffers,
+  };
+
   //! \brief Describes information for starting a renderpass.
   struct BeginRenderPassInfo {
     //! \brief The renderpass we will be starting.
@@ -42,6 +61,108 @@ namespace HAPI_NAMESPACE_NAME::gfx {
 
     //! \brief The render area extent.
     glm::uvec2 renderAreaExtent;
+
+    //! \brief Whether the first subpass is recorded inline, or by secondary command buffers.
+    SubpassContents contents;
+  };
+
+  //! \brief Describes the renderpass state a secondary command buffer continues from.
+  struct InheritanceInfo {
+    //! \brief The renderpass the secondary command buffer will be executed within.
+    const RenderPass* renderPass;
+
+    //! \brief The framebuffer being rendered to, may be null if not known ahead of time.
+    const FrameBuffer* frameBuffer;
+
+    //! \brief The subpass the secondary command buffer will be executed within.
+    std::uint32_t subpass;
+  };
+
+  //! \brief Describes how a command buffer should be synchronized when submitted.
+  struct SubmitInfo {
+    //! \brief The semaphore to wait on before execution, may be null.
+    const Semaphore* waitSemaphore;
+
+    //! \brief The pipeline stages that wait on the wait semaphore.
+    std::uint32_t waitStages;
+
+    //! \brief The semaphore to signal once execution completes, may be null.
+    const Semaphore* signalSemaphore;
+
+    //! \brief The fence to signal once execution completes, may be null.
+    const Fence* fence;
+
+    //! \brief The timeline semaphore to signal once execution completes, may be null.
+    const TimelineSemaphore* timelineSemaphore;
+
+    //! \brief The value the timeline semaphore will be signaled with.
+    std::uint64_t timelineValue;
+  };
+
+  //! \brief Describes a barrier on a range of a buffer, which may transfer queue family ownership.
+  struct BufferBarrier {
+    //! \brief The buffer the barrier applies to.
+    const ResourceBuffer* buffer;
+
+    //! \brief The offset of the range.
+    VkDeviceSize offset;
+
+    //! \brief The size of the range.
+    VkDeviceSize size;
+
+    //! \brief The kind of writes earlier commands made.
+    VkAccessFlags sourceAccess;
+
+    //! \brief The kind of accesses later commands make.
+    VkAccessFlags destinationAccess;
+
+    //! \brief The queue family releasing ownership, VK_QUEUE_FAMILY_IGNORED if not transferring.
+    std::uint32_t sourceQueueFamily;
+
+    //! \brief The queue family acquiring ownership, VK_QUEUE_FAMILY_IGNORED if not transferring.
+    std::uint32_t destinationQueueFamily;
+  };
+
+  //! \brief The dynamic state last recorded into a command buffer, so redundant changes can be skipped.
+  struct DynamicStateTracker {
+    //! \brief The blend state of each color attachment.
+    std::array<ColorBlendAttachment, kMaxColorAttachments> attachments;
+
+    //! \brief The blending constants.
+    float blendConstants[4];
+
+    //! \brief The width of lines.
+    float lineWidth;
+
+    //! \brief The states the bound pipeline leaves dynamic, a mask of DynamicStateFlags.
+    std::uint32_t dynamicStates;
+
+    //! \brief The states that were recorded since the last pipeline that bakes them, a mask of DynamicStateFlags.
+    std::uint32_t knownStates;
+
+    //! \brief The attachments whose blend enable is known, one bit per attachment.
+    std::uint8_t knownBlendEnables;
+
+    //! \brief The attachments whose blend equation is known, one bit per attachment.
+    std::uint8_t knownBlendEquations;
+
+    //! \brief The attachments whose write mask is known, one bit per attachment.
+    std::uint8_t knownWriteMasks;
+
+    //! \brief The primitive topology.
+    TopologyType topology;
+
+    //! \brief The polygon mode.
+    PolygonMode polygonMode;
+
+    //! \brief The culling mode.
+    FaceCullMode cullMode;
+
+    //! \brief The front face generation mode.
+    FrontFace frontFace;
+
+    //! \brief The logical operation.
+    LogicOp logicOp;
   };
 
   //! \brief Represents the object that allows command buffers to be allocated.
@@ -52,6 +173,9 @@ namespace HAPI_NAMESPACE_NAME::gfx {
       //! \brief The logical device the command pool will be created from.
       VkDevice logicalDevice;
 
+      //! \brief The callbacks host memory is allocated through, null uses the driver's allocator.
+      const VkAllocationCallbacks* allocationCallbacks;
+
       //! \brief The queue index the command pool will allocate command buffers on.
       std::uint32_t queueIndex;
     };
@@ -91,10 +215,20 @@ namespace HAPI_NAMESPACE_NAME::gfx {
      */
     VkCommandPool handle() const noexcept;
 
+    /*!
+     * \brief Resets every command buffer allocated from this pool at once.
+     *
+     * None of the command buffers of this pool may be pending execution when this is called.
+     */
+    void reset();
+
   private:
     //! \brief The logical device that created this command pool.
     VkDevice mLogicalDevice;
 
+    //! \brief The callbacks host memory is allocated through.
+    const VkAllocationCallbacks* mAllocationCallbacks;
+
     //! \brief The handle to this command pool, given to us by vulkan.
     VkCommandPool mCommandPool;
   };
@@ -109,6 +243,12 @@ namespace HAPI_NAMESPACE_NAME::gfx {
 
       //! \brief The logical device the command buffer will be created with.
       VkDevice logicalDevice;
+
+      //! \brief The queue freeing is deferred through, if null freeing waits for the device.
+      DeletionQueue* deletionQueue;
+
+      //! \brief Whether the command buffer is a primary or secondary command buffer.
+      CommandBufferLevel level;
     };
 
   public:
@@ -140,17 +280,29 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     CommandBuffer& operator=(CommandBuffer&& other) noexcept;
 
   public:
-    //! \brief Tells the command buffer to start recording.
+    /*!
+     * \brief Tells the command buffer to start recording.
+     *
+     * This does not wait for any previous submission of this command buffer to finish, the owner
+     * of the command buffer is expected to have waited on the fence it was last submitted with.
+     */
     void begin();
 
+    /*!
+     * \brief     Tells a secondary command buffer to start recording, continuing a renderpass.
+     * \param[in] inheritanceInfo The renderpass state the commands will be executed within.
+     */
+    void begin(const InheritanceInfo& inheritanceInfo);
+
     //! \brief Tells the command buffer to end recording.
     void end();
 
     /*!
      * \brief     Submits this command buffer for execution.
      * \param[in] queue The queue to submit this command buffer to.
+     * \param[in] submitInfo The synchronization to perform around execution.
      */
-    void submit(VkQueue queue);
+    void submit(VkQueue queue, const SubmitInfo& submitInfo);
 
     /*!
      * \brief     Updates the data of a buffer.
@@ -161,6 +313,34 @@ namespace HAPI_NAMESPACE_NAME::gfx {
      */
     void updateBuffer(const ResourceBuffer* buffer, std::size_t offset, const void* data, std::size_t dataSize);
 
+    /*!
+     * \brief     Copies regions of one buffer into another, must be recorded outside a renderpass.
+     * \param[in] source The buffer to copy from.
+     * \param[in] destination The buffer to copy into.
+     * \param[in] regions The regions to copy.
+     */
+    void copyBuffer(const ResourceBuffer* source, const ResourceBuffer* destination, std::span<const VkBufferCopy> regions);
+
+    /*!
+     * \brief     Makes the memory writes of earlier commands visible to later commands.
+     * \param[in] sourceStages The stages of earlier commands to wait on.
+     * \param[in] sourceAccess The kind of writes earlier commands made.
+     * \param[in] destinationStages The stages of later commands that have to wait.
+     * \param[in] destinationAccess The kind of accesses later commands make.
+     */
+    void memoryBarrier(std::uint32_t sourceStages, VkAccessFlags sourceAccess, std::uint32_t destinationStages, VkAccessFlags destinationAccess);
+
+    /*!
+     * \brief     Synchronizes ranges of buffers, releasing or acquiring queue family ownership.
+     * \param[in] sourceStages The stages of earlier commands to wait on.
+     * \param[in] destinationStages The stages of later commands that have to wait.
+     * \param[in] barriers The buffer ranges to synchronize.
+     *
+     * An ownership transfer is recorded twice, releasing on the source family's queue and then
+     * acquiring on the destination family's queue, with the same ranges and queue families.
+     */
+    void bufferBarrier(std::uint32_t sourceStages, std::uint32_t destinationStages, std::span<const BufferBarrier> barriers);
+
     /*!
      * \brief     Updates the viewport of a bound graphics pipeline.
      * \param[in] viewport The new viewport.
@@ -173,6 +353,75 @@ namespace HAPI_NAMESPACE_NAME::gfx {
      */
     void updateScissor(const Scissor& scissor);
 
+    /*!
+     * \brief     Sets the width of lines, if the bound pipeline leaves it dynamic.
+     * \param[in] lineWidth The new line width.
+     *
+     * Like every dynamic state setter, this is skipped when the bound pipeline bakes the state, or
+     * when the state already has the given value, so it has to be called after bindPipeline().
+     */
+    void setLineWidth(float lineWidth);
+
+    /*!
+     * \brief     Sets the blending constants, if the bound pipeline leaves them dynamic.
+     * \param[in] blendConstants The new blending constants.
+     */
+    void setBlendConstants(const float blendConstants[4]);
+
+    /*!
+     * \brief     Sets the culling mode, if the bound pipeline leaves it dynamic.
+     * \param[in] cullMode The new culling mode.
+     */
+    void setCullMode(FaceCullMode cullMode);
+
+    /*!
+     * \brief     Sets the front face generation mode, if the bound pipeline leaves it dynamic.
+     * \param[in] frontFace The new front face generation mode.
+     */
+    void setFrontFace(FrontFace frontFace);
+
+    /*!
+     * \brief     Sets the primitive topology, if the bound pipeline leaves it dynamic.
+     * \param[in] topology The new topology, of the same class as the one the pipeline was created with.
+     */
+    void setPrimitiveTopology(TopologyType topology);
+
+    /*!
+     * \brief     Sets the polygon mode, if the bound pipeline leaves it dynamic.
+     * \param[in] polygonMode The new polygon mode.
+     */
+    void setPolygonMode(PolygonMode polygonMode);
+
+    /*!
+     * \brief     Sets the logical operation, if the bound pipeline leaves it dynamic.
+     * \param[in] logicOp The new logical operation.
+     */
+    void setLogicOp(LogicOp logicOp);
+
+    /*!
+     * \brief     Sets whether blending is enabled for a range of color attachments, if the bound
+     *            pipeline leaves it dynamic.
+     * \param[in] firstAttachment The first color attachment to set.
+     * \param[in] attachments The blend state of each attachment, only the enable is used.
+     */
+    void setColorBlendEnable(std::uint32_t firstAttachment, std::span<const ColorBlendAttachment* const> attachments);
+
+    /*!
+     * \brief     Sets the blend factors and operations for a range of color attachments, if the bound
+     *            pipeline leaves them dynamic.
+     * \param[in] firstAttachment The first color attachment to set.
+     * \param[in] attachments The blend state of each attachment, only the factors and operations are used.
+     */
+    void setColorBlendEquation(std::uint32_t firstAttachment, std::span<const ColorBlendAttachment* const> attachments);
+
+    /*!
+     * \brief     Sets the write mask for a range of color attachments, if the bound pipeline leaves
+     *            it dynamic.
+     * \param[in] firstAttachment The first color attachment to set.
+     * \param[in] attachments The blend state of each attachment, only the write mask is used.
+     */
+    void setColorWriteMask(std::uint32_t firstAttachment, std::span<const ColorBlendAttachment* const> attachments);
+
     /*!
      * \brief     Binds the given vertex buffer.
      * \param[in] vertexBuffer The vertex buffer to bind.
@@ -189,6 +438,9 @@ namespace HAPI_NAMESPACE_NAME::gfx {
      * \brief     Binds the given pipeline the given bind point.
      * \param[in] pipeline The pipeline to bind.
      * \param[in] bindPoint The point to bind to.
+     *
+     * States the pipeline bakes overwrite whatever was set before, so they're forgotten by the
+     * dynamic state tracker and set again the next time a setter is called.
      */
     void bindPipeline(const Pipeline* pipeline, PipelineBindPoint bindPoint);
 
@@ -196,8 +448,9 @@ namespace HAPI_NAMESPACE_NAME::gfx {
      * \brief     Binds the given descriptor set.
      * \param[in] descriptorSet The descriptor set that should be bound.
      * \param[in] layout The layout of the pipeline.
+     * \param[in] dynamicOffsets The offsets of the set's dynamic descriptors, in binding order.
      */
-    void bindDescriptorSet(const DescriptorSet* descriptorSet, const PipelineLayout* layout);
+    void bindDescriptorSet(const DescriptorSet* descriptorSet, const PipelineLayout* layout, std::span<const std::uint32_t> dynamicOffsets = { });
 
     /*!
      * \brief     Draws polygons from the given bound vertex buffers based on the pipeline.
@@ -224,18 +477,64 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     //! \brief Ends render pass recording.
     void endRenderPass();
 
+    /*!
+     * \brief     Executes the given secondary command buffers from this primary command buffer.
+     * \param[in] commandBuffers The secondary command buffers to execute, in order.
+     */
+    void executeCommands(std::span<const CommandBuffer* const> commandBuffers);
+
+    /*!
+     * \brief     Resets a range of queries of a query pool, must be recorded outside a renderpass.
+     * \param[in] queryPool The query pool whose queries should be reset.
+     * \param[in] firstQuery The index of the first query to reset.
+     * \param[in] queryCount The number of queries to reset.
+     */
+    void resetQueries(VkQueryPool queryPool, std::uint32_t firstQuery, std::uint32_t queryCount);
+
+    /*!
+     * \brief     Writes the GPU timestamp into a query once all previous commands reach a stage.
+     * \param[in] queryPool The timestamp query pool to write into.
+     * \param[in] query The index of the query to write.
+     * \param[in] stage The pipeline stage to wait on before writing the timestamp.
+     */
+    void writeTimestamp(VkQueryPool queryPool, std::uint32_t query, PipelineStages stage);
+
+    /*!
+     * \brief  Gets the handle of this command buffer.
+     * \return The handle that vulkan gave us when this object was created.
+     */
+    VkCommandBuffer handle() const noexcept;
+
+    /*!
+     * \brief  Gets the level this command buffer was allocated at.
+     * \return Whether this is a primary or secondary command buffer.
+     */
+    CommandBufferLevel level() const noexcept;
+
+    /*!
+     * \brief  Gets the dynamic state recorded into this command buffer since begin().
+     * \return The dynamic state tracker of this command buffer.
+     */
+    const DynamicStateTracker& dynamicState() const noexcept;
+
   private:
     //! \brief The logical device that this command buffer was created from.
     VkDevice mLogicalDevice;
 
+    //! \brief The queue freeing is deferred through.
+    DeletionQueue* mDeletionQueue;
+
     //! \brief The command pool this buffer was created from.
     VkCommandPool mCommandPool;
 
     //! \brief The command buffer this object represents.
     VkCommandBuffer mCommandBuffer;
 
-    //! \brief The fence that will help synchronize the recording of this command buffer.
-    VkFence mRecordingFence;
+    //! \brief The level this command buffer was allocated at.
+    CommandBufferLevel mLevel;
+
+    //! \brief The dynamic state recorded since begin().
+    DynamicStateTracker mDynamicState;
   };
 
 }
@@ -0,0 +1,169 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "../forward.hpp"
+#include "cmdbuf.hpp"
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  /*!
+   * \brief Manages a command pool for every recording thread, of every frame in flight.
+   *
+   * Command pools are not thread safe, so every thread that records commands gets its own pool.
+   * Each frame in flight also gets its own set of pools, so a frame's pools can be reset wholesale
+   * once its fence has been waited on, while other frames are still executing.
+   *
+   * beginFrame() must be called from a single thread before any recording starts. After that each
+   * thread may acquire secondary command buffers from its own slot without synchronization.
+   */
+  class CommandPoolManager final {
+  public:
+    //! \brief The information needed to create a command pool manager.
+    struct CreateInfo {
+      //! \brief The logical device the command pools will be created from.
+      VkDevice logicalDevice;
+
+      //! \brief The callbacks host memory is allocated through, null uses the driver's allocator.
+      const VkAllocationCallbacks* allocationCallbacks;
+
+      //! \brief The queue index the command pools will allocate command buffers on.
+      std::uint32_t queueIndex;
+
+      //! \brief The number of frames that may be in flight at once.
+      std::uint32_t framesInFlight;
+
+      //! \brief The number of threads that will record commands.
+      std::uint32_t threadCount;
+    };
+
+  private:
+    //! \brief The pool of a single thread, of a single frame, along with its allocated buffers.
+    struct PoolSlot {
+      //! \brief The pool command buffers are allocated from.
+      CommandPool commandPool;
+
+      /*!
+       * \brief The secondary command buffers allocated from the pool, reused across frames.
+       *
+       * A deque keeps previously acquired buffers in place as more are allocated.
+       */
+      std::deque<CommandBuffer> secondaries;
+
+      //! \brief The number of secondary command buffers handed out since the last reset.
+      std::size_t secondariesUsed;
+    };
+
+  public:
+    //! \brief Explicitly defined default constructor.
+    CommandPoolManager() noexcept;
+
+    /*!
+     * \brief     Explicitly defined constructor, creates this object from the given information.
+     * \param[in] createInfo The information to create this object.
+     */
+    CommandPoolManager(const CreateInfo& createInfo);
+
+    /*!
+     * \brief     Explicitly defined move constructor, allows moving data of another object into
+     *            this one.
+     * \param[in] other The object to move data from.
+     */
+    CommandPoolManager(CommandPoolManager&& other) noexcept;
+
+    /*!
+     * \brief     Explicitly defined move assignment operator, allows moving data of another object
+     *            into this one.
+     * \param[in] other The object data that will be moved.
+     * \return    This object with the new object data.
+     */
+    CommandPoolManager& operator=(CommandPoolManager&& other) noexcept;
+
+  private:
+    // Not allowed.
+    CommandPoolManager(const CommandPoolManager&) = delete;
+    CommandPoolManager& operator=(const CommandPoolManager&) = delete;
+
+  public:
+    /*!
+     * \brief     Starts recording a frame, resetting every pool belonging to it.
+     * \param[in] frameIndex The frame in flight that is about to be recorded.
+     *
+     * The fence of the given frame must have been waited on before calling this.
+     */
+    void beginFrame(std::uint32_t frameIndex);
+
+    /*!
+     * \brief     Acquires a secondary command buffer for the given thread, in the current frame.
+     * \param[in] threadIndex The index of the recording thread.
+     * \return    A secondary command buffer that is ready to begin recording.
+     */
+    CommandBuffer& acquireSecondary(std::uint32_t threadIndex);
+
+    /*!
+     * \brief     Gets the command pool of the given thread, in the current frame.
+     * \param[in] threadIndex The index of the recording thread.
+     * \return    The command pool that thread should allocate from.
+     */
+    CommandPool& commandPool(std::uint32_t threadIndex);
+
+    /*!
+     * \brief  Gets the number of threads this manager has pools for.
+     * \return The number of recording threads.
+     */
+    std::uint32_t threadCount() const noexcept;
+
+    /*!
+     * \brief  Gets the number of frames in flight this manager has pools for.
+     * \return The number of frames in flight.
+     */
+    std::uint32_t frameCount() const noexcept;
+
+  private:
+    /*!
+     * \brief     Gets the pool slot of the given thread, in the current frame.
+     * \param[in] threadIndex The index of the recording thread.
+     * \return    The pool slot.
+     */
+    PoolSlot& slot(std::uint32_t threadIndex);
+
+  private:
+    //! \brief The logical device the command pools were created from.
+    VkDevice mLogicalDevice;
+
+    //! \brief The pool slots, laid out frame major so a frame's slots are contiguous.
+    std::vector<PoolSlot> mSlots;
+
+    //! \brief The number of threads that record commands.
+    std::uint32_t mThreadCount;
+
+    //! \brief The number of frames that may be in flight at once.
+    std::uint32_t mFrameCount;
+
+    //! \brief The frame currently being recorded.
+    std::uint32_t mFrameIndex;
+  };
+
+}
@@ -0,0 +1,111 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include "../forward.hpp"
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  /*!
+   * \brief Defers the destruction of GPU objects until the GPU is done with them.
+   *
+   * Every deleter is tagged with the completion value of the submission being recorded when it was
+   * queued, since that submission may still reference the object. Deleters run once collect() is
+   * told that value has completed, so freeing a resource mid-frame never drains the GPU.
+   *
+   * At shutdown, once the device is idle, drain() runs every pending deleter and from then on runs
+   * deleters as soon as they are queued. Deleters may be queued from any thread.
+   */
+  class DeletionQueue final {
+  public:
+    //! \brief Explicitly defined default constructor.
+    DeletionQueue() noexcept;
+
+    //! \brief Explicitly defined destructor, runs every pending deleter.
+   ~DeletionQueue() noexcept;
+
+  private:
+    // Not allowed.
+    DeletionQueue(const DeletionQueue&) = delete;
+    DeletionQueue& operator=(const DeletionQueue&) = delete;
+
+  public:
+    /*!
+     * \brief     Queues the destruction of an object that may still be in use by the GPU.
+     * \param[in] deleter The function that destroys the object.
+     */
+    void enqueue(std::function<void()> deleter);
+
+    /*!
+     * \brief     Moves on to the next submission, after the current one was given its value.
+     * \param[in] submittedValue The completion value of the submission that was just prepared.
+     *
+     * Deleters queued from here on are tagged with the value of the submission after it.
+     */
+    void advance(std::uint64_t submittedValue) noexcept;
+
+    /*!
+     * \brief     Runs the deleters of every submission that has finished executing.
+     * \param[in] completedValue A completion value the GPU is known to have reached.
+     */
+    void collect(std::uint64_t completedValue);
+
+    /*!
+     * \brief Runs every pending deleter, and any queued after, right away.
+     *
+     * Only call this once the device is idle and nothing will be submitted anymore.
+     */
+    void drain();
+
+    /*!
+     * \brief  Gets the number of deleters waiting on the GPU.
+     * \return The pending deleter count.
+     */
+    std::size_t pending() const;
+
+  private:
+    /*!
+     * \brief     Takes the oldest deleter off the queue, if the GPU is done with it.
+     * \param[in] completedValue The latest completion value the GPU has reached.
+     * \return    The deleter, or an empty function if none has finished.
+     */
+    std::function<void()> takeFinished(std::uint64_t completedValue);
+
+  private:
+    //! \brief The deleters waiting on the GPU, oldest first, tagged with their completion value.
+    std::deque<std::pair<std::uint64_t, std::function<void()>>> mDeleters;
+
+    //! \brief Guards the deleters, objects may be destroyed from any thread.
+    mutable std::mutex mLock;
+
+    //! \brief The completion value of the submission being recorded.
+    std::uint64_t mRecordingValue;
+
+    //! \brief Whether or not deleters run as soon as they're queued.
+    bool mDrained;
+  };
+
+}
@@ -62,6 +62,9 @@ namespace HAPI_NAMESPACE_NAME::gfx {
       //! \brief The logical device that will create the descriptor pool.
       VkDevice logicalDevice;
 
+      //! \brief The callbacks host memory is allocated through, null uses the driver's allocator.
+      const VkAllocationCallbacks* allocationCallbacks;
+
       //! \brief The maximum number of sets the descriptor pool can have.
       std::uint32_t maxSets;
     };
@@ -105,6 +108,9 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     //! \brief The logical device that will create this descriptor pool.
     VkDevice mLogicalDevice;
 
+    //! \brief The callbacks host memory is allocated through.
+    const VkAllocationCallbacks* mAllocationCallbacks;
+
     //! \brief The handle to this descriptor pool, given to us by vulkan.
     VkDescriptorPool mDescriptorPool;
   };
@@ -134,6 +140,9 @@ namespace HAPI_NAMESPACE_NAME::gfx {
 
       //! \brief The logical device the descriptor set layout will be created from.
       VkDevice logicalDevice;
+
+      //! \brief The callbacks host memory is allocated through, null uses the driver's allocator.
+      const VkAllocationCallbacks* allocationCallbacks;
     };
 
   public:
@@ -175,6 +184,9 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     //! \brief The logical device that this descriptor set layout will be created from.
     VkDevice mLogicalDevice;
 
+    //! \brief The callbacks host memory is allocated through.
+    const VkAllocationCallbacks* mAllocationCallbacks;
+
     //! \brief The handle to the descriptor set layout, given to us by vulkan.
     VkDescriptorSetLayout mDescriptorLayout;
   };
@@ -34,8 +34,10 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     /*!
      * \brief     Explicitly defined constructor, creates this object from the given information.
      * \param[in] logicalDevice The device that will create this object.
+     * \param[in] signaled Whether or not the fence should start out in the signaled state.
+     * \param[in] allocationCallbacks The callbacks host memory is allocated through, may be null.
      */
-    Fence(VkDevice logicalDevice);
+    Fence(VkDevice logicalDevice, bool signaled = false, const VkAllocationCallbacks* allocationCallbacks = nullptr);
 
     //! \brief Explicitly defined desstructor, makes sure this object gets destroyed properly.
    ~Fence() noexcept;
@@ -69,12 +71,21 @@ namespace HAPI_NAMESPACE_NAME::gfx {
      * \brief     Waits for this fence to be signaled.
      * \param[in] timeout The amount of time to wait, in nanoseconds.
      */
-    void wait(std::uint64_t timeout);
+    void wait(std::uint64_t timeout) const;
+
+    /*!
+     * \brief  Checks whether or not this fence is currently signaled, without waiting.
+     * \return True if the fence has been signaled.
+     */
+    bool signaled() const;
 
   private:
     //! \brief The device that will create this fence.
     VkDevice mLogicalDevice;
 
+    //! \brief The callbacks host memory is allocated through.
+    const VkAllocationCallbacks* mAllocationCallbacks;
+
     //! \brief The handle that vulkan will give us.
     VkFence mFence;
   };
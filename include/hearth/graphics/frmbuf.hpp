@@ -42,6 +42,12 @@ namespace HAPI_NAMESPACE_NAME::gfx {
       //! \brief The logical device the framebuffer will be created with.
       VkDevice logicalDevice;
 
+      //! \brief The callbacks host memory is allocated through, null uses the driver's allocator.
+      const VkAllocationCallbacks* allocationCallbacks;
+
+      //! \brief The queue destruction is deferred through, if null destruction waits for the device.
+      DeletionQueue* deletionQueue;
+
       //! \brief The renderpass type that the framebuffer will be able to accept.
       VkRenderPass renderPass;
     };
@@ -91,6 +97,12 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     //! \brief The logical device that this framebuffer will be created with.
     VkDevice mLogicalDevice;
 
+    //! \brief The callbacks host memory is allocated through.
+    const VkAllocationCallbacks* mAllocationCallbacks;
+
+    //! \brief The queue destruction is deferred through.
+    DeletionQueue* mDeletionQueue;
+
     //! \brief The framebuffer handle given to us by vulkan.
     VkFramebuffer mFrameBuffer;
   };
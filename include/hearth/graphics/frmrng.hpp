@@ -0,0 +1,209 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "../forward.hpp"
+#include "cmdbuf.hpp"
+#include "fence.hpp"
+#include "semphr.hpp"
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  //! \brief Describes everything a single frame in flight needs to be recorded and submitted.
+  struct FrameContext {
+    //! \brief The command buffer this frame records into.
+    CommandBuffer commandBuffer;
+
+    //! \brief The fence signaled when the GPU has finished executing this frame, unused with timelines.
+    Fence inFlight;
+
+    //! \brief The semaphore signaled when the swapchain image for this frame is available.
+    Semaphore imageAvailable;
+
+    //! \brief The semaphore signaled when this frame has finished rendering.
+    Semaphore renderFinished;
+
+    //! \brief The completion value of this frame's last submission, zero if it was never submitted.
+    std::uint64_t completionValue;
+  };
+
+  /*!
+   * \brief Represents a ring of per-frame contexts, allowing multiple frames to be in flight.
+   *
+   * While the GPU is executing one frame, the CPU may record the next one into a different slot of
+   * the ring. The CPU only blocks when it wraps around to a slot whose previous submission has not
+   * finished executing yet.
+   *
+   * Every submission is given a monotonically increasing completion value. When the device supports
+   * them these are signaled on a single timeline semaphore, otherwise they are derived from the
+   * per-frame fences. Either way, anything that was last used by a submission can check whether or
+   * not it's still in use by comparing against the value of that submission.
+   *
+   * The ring is advanced from a single thread, but completed() and wait() may be called from any.
+   */
+  class FrameRing final {
+  public:
+    //! \brief The number of frames in flight used when none are requested.
+    static constexpr std::uint32_t DefaultFramesInFlight = 2;
+
+    //! \brief The information needed to create a frame ring.
+    struct CreateInfo {
+      //! \brief The command pool the per-frame command buffers are allocated from.
+      const CommandPool* commandPool;
+
+      //! \brief The logical device the per-frame objects will be created with.
+      VkDevice logicalDevice;
+
+      //! \brief The callbacks host memory is allocated through, null uses the driver's allocator.
+      const VkAllocationCallbacks* allocationCallbacks;
+
+      //! \brief The number of frames that may be in flight at once, zero selects the default.
+      std::uint32_t framesInFlight;
+
+      //! \brief Whether or not to track completion with a timeline semaphore instead of fences.
+      bool timelineSemaphores;
+    };
+
+  public:
+    //! \brief Explicitly defined default constructor.
+    FrameRing() noexcept;
+
+    /*!
+     * \brief     Explicitly defined constructor, creates this object from the given information.
+     * \param[in] createInfo The information to create this object.
+     */
+    FrameRing(const CreateInfo& createInfo);
+
+    //! \brief Explicitly defined destructor, waits for all frames in flight to finish.
+   ~FrameRing() noexcept;
+
+    /*!
+     * \brief     Explicitly defined move constructor, allows moving data of another object into
+     *            this one.
+     * \param[in] other The object to move data from.
+     */
+    FrameRing(FrameRing&& other) noexcept;
+
+    /*!
+     * \brief     Explicitly defined move assignment operator, allows moving data of another object
+     *            into this one.
+     * \param[in] other The object data that will be moved.
+     * \return    This object with the new object data.
+     */
+    FrameRing& operator=(FrameRing&& other) noexcept;
+
+  private:
+    // Not allowed.
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+  public:
+    /*!
+     * \brief  Advances to the next frame of the ring and waits until its slot is free to record.
+     * \return The context of the frame to record.
+     *
+     * The returned frame is left in its completed state, prepareSubmit() should be called right
+     * before the frame is submitted so that a frame which ends up not being submitted can't
+     * deadlock the ring.
+     */
+    FrameContext& acquireFrame();
+
+    /*!
+     * \brief  Prepares the current frame to be submitted, assigning its completion value.
+     * \return The value the submission should signal the timeline semaphore with.
+     *
+     * Resets the in flight fence of the current frame when not using a timeline semaphore.
+     */
+    std::uint64_t prepareSubmit();
+
+    /*!
+     * \brief  Gets the timeline semaphore frame submissions should signal.
+     * \return The timeline semaphore of this ring, or null if fences are used instead.
+     */
+    const TimelineSemaphore* timeline() const noexcept;
+
+    /*!
+     * \brief     Checks whether or not the submission with the given value has finished executing.
+     * \param[in] value The completion value of the submission, zero is always complete.
+     * \return    True if the GPU has finished executing that submission and all before it.
+     */
+    bool completed(std::uint64_t value) const;
+
+    /*!
+     * \brief     Waits for the submission with the given value to finish executing.
+     * \param[in] value The completion value of the submission, zero returns immediately.
+     */
+    void wait(std::uint64_t value) const;
+
+    /*!
+     * \brief  Gets the context of the frame currently being recorded.
+     * \return The frame context last returned by acquireFrame().
+     */
+    FrameContext& current() noexcept;
+
+    /*!
+     * \brief  Gets the index of the frame currently being recorded.
+     * \return The ring slot of the current frame.
+     */
+    std::uint32_t index() const noexcept;
+
+    /*!
+     * \brief  Gets the number of frames that may be in flight at once.
+     * \return The number of slots in this ring.
+     */
+    std::uint32_t size() const noexcept;
+
+    //! \brief Waits for every frame in flight to finish executing.
+    void waitIdle();
+
+  private:
+    /*!
+     * \brief     Finds the frame whose fence tracks the submission with the given value.
+     * \param[in] value The completion value of the submission.
+     * \return    The frame with the oldest submission at or after the given value.
+     */
+    const FrameContext& findSubmission(std::uint64_t value) const;
+
+  private:
+    //! \brief The logical device that created the frame objects.
+    VkDevice mLogicalDevice;
+
+    //! \brief The per-frame contexts of this ring.
+    std::vector<FrameContext> mFrames;
+
+    //! \brief The timeline semaphore signaled by frame submissions, if supported.
+    TimelineSemaphore mTimeline;
+
+    //! \brief The completion value of the last prepared submission.
+    std::uint64_t mSubmittedValue;
+
+    //! \brief The ring slot of the frame currently being recorded.
+    std::uint32_t mFrameIndex;
+
+    //! \brief Guards the fences and completion values against other threads checking on them.
+    mutable std::mutex mSubmissionLock;
+  };
+
+}
@@ -128,6 +128,27 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     ShaderStageAllGraphicsBit = 0x0000001F,
   };
 
+  /*!
+   * \brief The pipeline states that can be set on a command buffer instead of baked into a pipeline.
+   *
+   * Line width and blend constants are always available, the rest need the matching
+   * VK_EXT_extended_dynamic_state extension, both on the device and in the vulkan headers the
+   * engine was built against, see RenderContext::dynamicStateSupport().
+   */
+  enum DynamicStateFlags : std::uint32_t {
+    DynamicStateLineWidthBit          = 0x00000001,
+    DynamicStateBlendConstantsBit     = 0x00000002,
+    DynamicStateCullModeBit           = 0x00000004,
+    DynamicStateFrontFaceBit          = 0x00000008,
+    DynamicStateTopologyBit           = 0x00000010,
+    DynamicStateLogicOpBit            = 0x00000020,
+    DynamicStatePolygonModeBit        = 0x00000040,
+    DynamicStateColorBlendEnableBit   = 0x00000080,
+    DynamicStateColorBlendEquationBit = 0x00000100,
+    DynamicStateColorWriteMaskBit     = 0x00000200,
+    DynamicStateCoreBits              = 0x00000003,
+  };
+
   //! \brief Represents the region of the framebuffer that a rendered image will be placed.
   struct Viewport {
     //! \brief The origin of this viewport.
@@ -228,6 +249,9 @@ namespace HAPI_NAMESPACE_NAME::gfx {
 
       //! \brief The logical device the pipeline layout will be created from.
       VkDevice logicalDevice;
+
+      //! \brief The callbacks host memory is allocated through, null uses the driver's allocator.
+      const VkAllocationCallbacks* allocationCallbacks;
     };
 
   public:
@@ -269,6 +293,9 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     //! \brief The logical device this pipeline layout was created from.
     VkDevice mLogicalDevice;
 
+    //! \brief The callbacks host memory is allocated through.
+    const VkAllocationCallbacks* mAllocationCallbacks;
+
     //! \brief The handle to the pipeline layout, given to us by vulkan.
     VkPipelineLayout mPipelineLayout;
   };
@@ -284,24 +311,45 @@ namespace HAPI_NAMESPACE_NAME::gfx {
       //! \brief The attribute descriptions for a vertex buffer that is compatible with this pipeline.
       std::vector<const AttributeDescription*> vertexAttributes;
 
+      //! \brief The shader module of the vertex stage, only needed during construction.
+      const ShaderModule* vertexShader;
+
+      //! \brief The shader module of the fragment stage, only needed during construction.
+      const ShaderModule* fragmentShader;
+
       //! \brief The states of color blending the pipeline should apply.
       const ColorBlendState* colorBlending;
 
       //! \brief The layout for the pipeline.
       const PipelineLayout* layout;
 
-      //! \brief The base pipeline to create the pipeline from.
-      Pipeline* base;
+      //! \brief The base pipeline to derive the pipeline from, may be null.
+      const Pipeline* base;
+
+      //! \brief Whether or not other pipelines may be derived from this one.
+      bool allowDerivatives;
 
       //! \brief The logical device that will the pipeline.
       VkDevice logicalDevice;
 
+      //! \brief The callbacks host memory is allocated through, null uses the driver's allocator.
+      const VkAllocationCallbacks* allocationCallbacks;
+
+      //! \brief The cache compiled pipelines are looked up in and added to, may be null.
+      VkPipelineCache pipelineCache;
+
+      //! \brief The queue destruction is deferred through, if null destruction waits for the device.
+      DeletionQueue* deletionQueue;
+
       //! \brief The renderpass the pipeline should be compatible with.
       VkRenderPass renderPass;
 
       //! \brief The subpass the pipeline should be bound to.
       std::uint32_t subpass;
 
+      //! \brief The states set on the command buffer instead, a mask of DynamicStateFlags.
+      std::uint32_t dynamicStates;
+
       //! \brief The width of lines generated with PolygonMode::Line.
       float lineWidth;
 
@@ -353,6 +401,12 @@ namespace HAPI_NAMESPACE_NAME::gfx {
      */
     VkPipeline handle() const noexcept;
 
+    /*!
+     * \brief  Gets the states this pipeline expects to be set on the command buffer.
+     * \return A mask of DynamicStateFlags, the baked values of these states are ignored.
+     */
+    std::uint32_t dynamicStates() const noexcept;
+
   private:
     /*!
      * \brief     Initializes this graphics pipeline.
@@ -364,8 +418,17 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     //! \brief The logical device that will create this pipeline.
     VkDevice mLogicalDevice;
 
+    //! \brief The callbacks host memory is allocated through.
+    const VkAllocationCallbacks* mAllocationCallbacks;
+
+    //! \brief The queue destruction is deferred through.
+    DeletionQueue* mDeletionQueue;
+
     //! \brief The pipeline handle that vulkan will give us.
     VkPipeline mGraphicsPipeline;
+
+    //! \brief The states set on the command buffer instead of baked in.
+    std::uint32_t mDynamicStates;
   };
 
 }
@@ -0,0 +1,266 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "../forward.hpp"
+#include "cmdbuf.hpp"
+#include "rdrpss.hpp"
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  //! \brief The timings of a single GPU zone, over the recent history of frames.
+  struct GpuZoneStatistics {
+    //! \brief The name the zone was recorded with.
+    std::string_view name;
+
+    //! \brief The time the zone took in the most recently read back frame, in milliseconds.
+    double lastMilliseconds;
+
+    //! \brief The mean time the zone took, in milliseconds.
+    double averageMilliseconds;
+
+    //! \brief The median time the zone took, in milliseconds.
+    double p50Milliseconds;
+
+    //! \brief The 95th percentile of the time the zone took, in milliseconds.
+    double p95Milliseconds;
+
+    //! \brief The 99th percentile of the time the zone took, in milliseconds.
+    double p99Milliseconds;
+
+    //! \brief The number of samples the statistics were computed from.
+    std::size_t sampleCount;
+  };
+
+  /*!
+   * \brief Measures the time spent on the GPU by named zones of command buffers.
+   *
+   * Every zone writes a timestamp query at its beginning and end. Each frame in flight owns its own
+   * range of the query pool, which is read back without waiting the next time that frame begins,
+   * since by then its previous submission is known to have finished executing.
+   *
+   * beginFrame() and resetQueries() must be called from a single thread before any zones are
+   * recorded. Zones may then be recorded from any thread, into any command buffer of the frame.
+   */
+  class GpuProfiler final {
+  public:
+    //! \brief The zone returned when no zone could be recorded.
+    static constexpr std::uint32_t InvalidZone = ~std::uint32_t(0);
+
+    //! \brief The number of zones each frame can record when none is requested.
+    static constexpr std::uint32_t DefaultMaxZones = 64;
+
+    //! \brief The number of samples kept per zone when none is requested.
+    static constexpr std::size_t DefaultHistorySize = 240;
+
+    //! \brief The information needed to create a GPU profiler.
+    struct CreateInfo {
+      //! \brief The physical device, used to query timestamp support and period.
+      VkPhysicalDevice physicalDevice;
+
+      //! \brief The logical device the query pool will be created from.
+      VkDevice logicalDevice;
+
+      //! \brief The callbacks host memory is allocated through, null uses the driver's allocator.
+      const VkAllocationCallbacks* allocationCallbacks;
+
+      //! \brief The queue family the profiled command buffers are submitted to.
+      std::uint32_t queueIndex;
+
+      //! \brief The number of frames that may be in flight at once.
+      std::uint32_t framesInFlight;
+
+      //! \brief The number of zones each frame can record, zero selects the default.
+      std::uint32_t maxZones;
+
+      //! \brief The number of samples kept per zone for statistics, zero selects the default.
+      std::size_t historySize;
+    };
+
+  private:
+    //! \brief The zones recorded by a single frame in flight.
+    struct FrameSlot {
+      //! \brief The name of every zone recorded, indexed by zone.
+      std::vector<std::string_view> names;
+
+      //! \brief The number of zones recorded the last time this frame was used.
+      std::uint32_t zoneCount;
+    };
+
+    //! \brief The recent samples of a single zone.
+    struct ZoneHistory {
+      //! \brief The samples, used as a ring once full.
+      std::vector<double> samples;
+
+      //! \brief The index the next sample will be written to.
+      std::size_t next;
+
+      //! \brief The most recent sample.
+      double last;
+    };
+
+  public:
+    /*!
+     * \brief     Explicitly defined constructor, creates this object from the given information.
+     * \param[in] createInfo The information to create this object.
+     */
+    GpuProfiler(const CreateInfo& createInfo);
+
+    //! \brief Explicitly defined destructor, properly prepares this object for destruction.
+   ~GpuProfiler() noexcept;
+
+  private:
+    // Not allowed.
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+  public:
+    /*!
+     * \brief     Starts profiling a frame, reading back the results of its previous use.
+     * \param[in] frameIndex The frame in flight that is about to be recorded.
+     *
+     * The given frame's previous submission must have finished executing before calling this.
+     */
+    void beginFrame(std::uint32_t frameIndex);
+
+    /*!
+     * \brief     Records the reset of the current frame's queries.
+     * \param[in] commandBuffer The primary command buffer of the frame, outside of a renderpass.
+     *
+     * Must execute before any zone of the frame, recording it first in the primary command buffer
+     * is enough.
+     */
+    void resetQueries(CommandBuffer& commandBuffer);
+
+    /*!
+     * \brief     Begins a zone in the given command buffer.
+     * \param[in] commandBuffer The command buffer to record the zone into.
+     * \param[in] name The name of the zone, must outlive the profiler, a literal is expected.
+     * \param[in] stage The stage the previous commands need to reach before the zone starts.
+     * \return    The zone to pass to endZone(), or InvalidZone if the frame is out of zones.
+     */
+    std::uint32_t beginZone(CommandBuffer& commandBuffer, std::string_view name, PipelineStages stage = PipelineStageTopOfPipeBit);
+
+    /*!
+     * \brief     Ends a zone in the given command buffer.
+     * \param[in] commandBuffer The command buffer to record the end into, usually the same as the beginning.
+     * \param[in] zone The zone returned by beginZone().
+     * \param[in] stage The stage the zone's commands need to reach before the zone ends.
+     */
+    void endZone(CommandBuffer& commandBuffer, std::uint32_t zone, PipelineStages stage = PipelineStageBottomOfPipeBit);
+
+    /*!
+     * \brief  Computes the statistics of every zone that has been read back so far.
+     * \return The statistics of each zone, sorted by name.
+     */
+    std::vector<GpuZoneStatistics> statistics() const;
+
+    /*!
+     * \brief  Whether or not the profiled queue supports timestamps at all.
+     * \return False if zones will never be recorded.
+     */
+    bool supported() const noexcept;
+
+  private:
+    /*!
+     * \brief     Reads back the timestamps of the given frame, without waiting.
+     * \param[in] slot The frame whose timestamps should be read back.
+     * \param[in] firstQuery The first query of the frame's range.
+     */
+    void collect(const FrameSlot& slot, std::uint32_t firstQuery);
+
+  private:
+    //! \brief The logical device that created the query pool.
+    VkDevice mLogicalDevice;
+
+    //! \brief The callbacks host memory is allocated through.
+    const VkAllocationCallbacks* mAllocationCallbacks;
+
+    //! \brief The timestamp query pool, two queries per zone per frame.
+    VkQueryPool mQueryPool;
+
+    //! \brief The zones recorded by each frame in flight.
+    std::vector<FrameSlot> mSlots;
+
+    //! \brief The samples of every zone, by name.
+    std::unordered_map<std::string_view, ZoneHistory> mHistories;
+
+    //! \brief Guards the samples, as statistics may be requested from other threads.
+    mutable std::mutex mHistoriesLock;
+
+    //! \brief The number of zones recorded so far in the current frame.
+    std::atomic<std::uint32_t> mZoneCount;
+
+    //! \brief The number of nanoseconds per timestamp tick.
+    double mTimestampPeriod;
+
+    //! \brief The bits of a timestamp that are valid.
+    std::uint64_t mTimestampMask;
+
+    //! \brief The number of samples kept per zone.
+    std::size_t mHistorySize;
+
+    //! \brief The number of zones each frame can record.
+    std::uint32_t mMaxZones;
+
+    //! \brief The frame currently being recorded.
+    std::uint32_t mFrameIndex;
+  };
+
+  //! \brief Records a GPU zone for as long as this object is in scope.
+  class GpuZone final {
+  public:
+    /*!
+     * \brief     Explicitly defined constructor, begins the zone.
+     * \param[in] profiler The profiler to record the zone with, may be null to record nothing.
+     * \param[in] commandBuffer The command buffer to record the zone into.
+     * \param[in] name The name of the zone, a literal is expected.
+     */
+    GpuZone(GpuProfiler* profiler, CommandBuffer& commandBuffer, std::string_view name);
+
+    //! \brief Explicitly defined destructor, ends the zone.
+   ~GpuZone() noexcept;
+
+  private:
+    // Not allowed.
+    GpuZone(const GpuZone&) = delete;
+    GpuZone& operator=(const GpuZone&) = delete;
+
+  private:
+    //! \brief The profiler the zone is recorded with.
+    GpuProfiler* mProfiler;
+
+    //! \brief The command buffer the zone is recorded into.
+    CommandBuffer& mCommandBuffer;
+
+    //! \brief The zone returned by the profiler.
+    std::uint32_t mZone;
+  };
+
+}
@@ -0,0 +1,230 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "../forward.hpp"
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  //! \brief The host memory the driver has allocated within a single allocation scope.
+  struct HostAllocationStatistics {
+    //! \brief The scope the statistics were gathered for.
+    VkSystemAllocationScope scope;
+
+    //! \brief The bytes currently allocated through the callbacks.
+    std::uint64_t bytes;
+
+    //! \brief The most bytes that were allocated through the callbacks at once.
+    std::uint64_t peakBytes;
+
+    //! \brief The bytes the driver reports having allocated itself, for executable memory.
+    std::uint64_t internalBytes;
+
+    //! \brief The number of allocations made.
+    std::uint64_t allocations;
+
+    //! \brief The number of reallocations made, those that moved also count as an allocation and a free.
+    std::uint64_t reallocations;
+
+    //! \brief The number of allocations freed.
+    std::uint64_t frees;
+
+    //! \brief The allocations made per second, since statistics were last computed.
+    double allocationsPerSecond;
+
+    //! \brief The frees made per second, since statistics were last computed.
+    double freesPerSecond;
+  };
+
+  /*!
+   * \brief Provides the host memory the driver allocates for vulkan objects, and accounts for it.
+   *
+   * Small allocations are served from pooled size classes, one pool per allocation scope, so that
+   * short lived command scope allocations don't contend with long lived object ones. Anything
+   * larger, or aligned beyond what the pools guarantee, goes straight to the system heap.
+   *
+   * Every object must be destroyed with the same callbacks it was created with, so the allocator
+   * has to outlive every object created through it, including the instance.
+   */
+  class HostAllocator final {
+  public:
+    //! \brief The number of allocation scopes vulkan distinguishes.
+    static constexpr std::size_t ScopeCount = 5;
+
+    //! \brief The number of pooled size classes, from 64 bytes doubling up to 8 kilobytes.
+    static constexpr std::size_t SizeClassCount = 8;
+
+    //! \brief The size of the slabs pools carve blocks from when none is requested.
+    static constexpr std::size_t DefaultSlabSize = 64 * 1024;
+
+    //! \brief The information needed to create a host allocator.
+    struct CreateInfo {
+      //! \brief The size of the slabs pools carve blocks from, zero selects the default.
+      std::size_t slabSize;
+    };
+
+  private:
+    //! \brief The blocks of a single allocation scope.
+    struct Pool {
+      //! \brief Guards the free lists and slabs.
+      std::mutex lock;
+
+      //! \brief The first free block of every size class, linked through the blocks themselves.
+      std::array<void*, SizeClassCount> freeLists;
+
+      //! \brief The slabs the blocks were carved from.
+      std::vector<std::unique_ptr<std::byte[]>> slabs;
+    };
+
+    //! \brief The counters of a single allocation scope, see HostAllocationStatistics.
+    struct Counters {
+      std::atomic<std::uint64_t> bytes;
+      std::atomic<std::uint64_t> peakBytes;
+      std::atomic<std::uint64_t> internalBytes;
+      std::atomic<std::uint64_t> allocations;
+      std::atomic<std::uint64_t> reallocations;
+      std::atomic<std::uint64_t> frees;
+    };
+
+    //! \brief The call counts of a single allocation scope, as of the last computed statistics.
+    struct Sample {
+      std::uint64_t allocations;
+      std::uint64_t frees;
+    };
+
+  public:
+    /*!
+     * \brief     Explicitly defined constructor, creates this object from the given information.
+     * \param[in] createInfo The information needed to create this object.
+     */
+    HostAllocator(const CreateInfo& createInfo);
+
+  private:
+    // Not allowed.
+    HostAllocator(const HostAllocator&) = delete;
+    HostAllocator& operator=(const HostAllocator&) = delete;
+
+  public:
+    /*!
+     * \brief  Gets the callbacks to pass wherever vulkan takes a pAllocator.
+     * \return The allocation callbacks, valid for as long as this allocator.
+     */
+    const VkAllocationCallbacks* callbacks() const noexcept;
+
+    /*!
+     * \brief  Computes the statistics of every allocation scope.
+     * \return The statistics of each scope, indexed by scope.
+     *
+     * Rates are measured over the time since statistics were last computed, so computing them
+     * once per second or per frame gives the rate over that period.
+     */
+    std::array<HostAllocationStatistics, ScopeCount> statistics();
+
+  public:
+    /*!
+     * \brief     Allocates a block, from the scope's pool if it fits.
+     * \param[in] size The size of the allocation.
+     * \param[in] alignment The alignment of the allocation.
+     * \param[in] scope The scope of the allocation.
+     * \return    The allocation, or null if out of memory.
+     */
+    void* allocate(std::size_t size, std::size_t alignment, VkSystemAllocationScope scope) noexcept;
+
+    /*!
+     * \brief     Grows or shrinks an allocation, in place if its block is large enough.
+     * \param[in] original The allocation to resize, may be null.
+     * \param[in] size The new size of the allocation, zero frees it.
+     * \param[in] alignment The alignment of the allocation, the same as the original.
+     * \param[in] scope The scope of the allocation.
+     * \return    The resized allocation, or null if out of memory.
+     */
+    void* reallocate(void* original, std::size_t size, std::size_t alignment, VkSystemAllocationScope scope) noexcept;
+
+    /*!
+     * \brief     Frees an allocation, returning its block to the pool it came from.
+     * \param[in] memory The allocation to free, may be null.
+     */
+    void deallocate(void* memory) noexcept;
+
+    /*!
+     * \brief     Accounts for memory the driver allocated without going through the callbacks.
+     * \param[in] size The size of the allocation.
+     * \param[in] scope The scope of the allocation.
+     */
+    void internalAllocated(std::size_t size, VkSystemAllocationScope scope) noexcept;
+
+    /*!
+     * \brief     Accounts for memory the driver freed without going through the callbacks.
+     * \param[in] size The size of the allocation.
+     * \param[in] scope The scope of the allocation.
+     */
+    void internalFreed(std::size_t size, VkSystemAllocationScope scope) noexcept;
+
+  private:
+
+    /*!
+     * \brief     Takes a free block of the given size class, carving a new slab if there is none.
+     * \param[in] pool The pool of the allocation's scope.
+     * \param[in] sizeClass The size class of the block.
+     * \return    The block, or null if out of memory.
+     */
+    void* takeBlock(Pool& pool, std::size_t sizeClass) noexcept;
+
+    /*!
+     * \brief     Accounts for bytes allocated within a scope.
+     * \param[in] counters The counters of the scope.
+     * \param[in] bytes The number of bytes allocated.
+     */
+    static void addBytes(Counters& counters, std::uint64_t bytes) noexcept;
+
+  private:
+    //! \brief The callbacks handed to vulkan, pointing back at this allocator.
+    VkAllocationCallbacks mCallbacks;
+
+    //! \brief The pools of every allocation scope.
+    std::array<Pool, ScopeCount> mPools;
+
+    //! \brief The counters of every allocation scope.
+    std::array<Counters, ScopeCount> mCounters;
+
+    //! \brief Guards the samples rates are computed from.
+    std::mutex mSampleLock;
+
+    //! \brief The counters of every scope as of the last computed statistics.
+    std::array<Sample, ScopeCount> mSamples;
+
+    //! \brief The time statistics were last computed.
+    std::chrono::steady_clock::time_point mSampleTime;
+
+    //! \brief The size of the slabs blocks are carved from.
+    std::size_t mSlabSize;
+  };
+
+}
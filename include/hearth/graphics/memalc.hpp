@@ -0,0 +1,352 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "../forward.hpp"
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  class MemoryBlock;
+
+  //! \brief Describes how the resource an allocation is bound to lays out its memory.
+  enum struct AllocationKind : std::uint8_t {
+    Buffer = 0,
+    Image  = 1,
+  };
+
+  //! \brief Describes how a resource's memory is accessed, which decides the memory type it gets.
+  enum struct MemoryUsage : std::uint8_t {
+    //! \brief Only the GPU accesses the memory, device local and not host visible if possible.
+    GpuOnly,
+
+    //! \brief The CPU writes the memory once or rarely, the GPU reads it, uncached host memory.
+    CpuToGpu,
+
+    //! \brief The GPU writes the memory, the CPU reads it back, cached host memory if possible.
+    GpuToCpu,
+
+    //! \brief Small memory the CPU writes every frame, device local host visible memory if possible.
+    CpuToGpuFrequent,
+  };
+
+  //! \brief Describes the memory type a resource was placed in, for callers to tell which path they got.
+  struct MemoryPlacement {
+    //! \brief The index of the memory type.
+    std::uint32_t memoryType;
+
+    //! \brief The property flags of the memory type.
+    std::uint32_t propertyFlags;
+
+    //! \brief The size of the heap the memory type belongs to.
+    VkDeviceSize heapSize;
+
+    //! \brief Whether or not the memory is device local.
+    bool deviceLocal;
+
+    //! \brief Whether or not the memory is host visible, and so mapped.
+    bool hostVisible;
+
+    //! \brief Whether or not host reads of the memory are cached.
+    bool hostCached;
+  };
+
+  //! \brief Represents a range of device memory handed out by the memory allocator.
+  struct Allocation {
+    //! \brief The device memory the range lives in, null if this allocation is empty.
+    VkDeviceMemory memory;
+
+    //! \brief The offset of the range into the device memory.
+    VkDeviceSize offset;
+
+    //! \brief The size of the range.
+    VkDeviceSize size;
+
+    //! \brief The host address of the range, null unless the memory is host visible.
+    void* mapped;
+
+    //! \brief The memory type the range was allocated from.
+    std::uint32_t memoryType;
+
+    //! \brief The block the range was sub-allocated from, null for dedicated allocations.
+    MemoryBlock* block;
+
+    //! \brief The range's node within its block, internal to the allocator.
+    std::uint32_t node;
+  };
+
+  //! \brief The information needed to allocate memory for a resource.
+  struct AllocationInfo {
+    //! \brief The memory requirements of the resource.
+    VkMemoryRequirements requirements;
+
+    //! \brief How the resource's memory is accessed.
+    MemoryUsage usage;
+
+    //! \brief How the resource lays out its memory.
+    AllocationKind kind;
+
+    //! \brief Whether or not the resource should get its own device memory.
+    bool dedicated;
+
+    //! \brief Opaque data handed back in defragmentation moves, to identify the resource.
+    void* userData;
+  };
+
+  //! \brief Describes the memory used by the allocator.
+  struct MemoryStatistics {
+    //! \brief The number of blocks ranges are sub-allocated from.
+    std::size_t blockCount;
+
+    //! \brief The number of live sub-allocated ranges.
+    std::size_t allocationCount;
+
+    //! \brief The number of live dedicated allocations.
+    std::size_t dedicatedCount;
+
+    //! \brief The bytes of device memory held by blocks.
+    VkDeviceSize blockBytes;
+
+    //! \brief The bytes of the blocks that are handed out.
+    VkDeviceSize usedBytes;
+
+    //! \brief The bytes of device memory held by dedicated allocations.
+    VkDeviceSize dedicatedBytes;
+
+    //! \brief The largest free range of any block.
+    VkDeviceSize largestFreeRange;
+  };
+
+  /*!
+   * \brief Describes an allocation the allocator would like to move, to compact its blocks.
+   *
+   * The destination has already been allocated. The owner of the resource, identified by its user
+   * data, copies its contents over, rebinds to the destination and frees the source once the GPU
+   * no longer uses it.
+   */
+  struct DefragmentationMove {
+    //! \brief The user data the source was allocated with.
+    void* userData;
+
+    //! \brief The allocation to move out of.
+    Allocation source;
+
+    //! \brief The allocation to move into.
+    Allocation destination;
+  };
+
+  /*!
+   * \brief Sub-allocates device memory for resources out of large blocks.
+   *
+   * Every memory type has its own heap of blocks, split further by whether buffers or images are
+   * placed in them so that the buffer image granularity never has to be considered. Ranges are
+   * handed out of a block with a two level segregated fit allocator, which finds a good fit and
+   * coalesces freed neighbours in constant time. Resources larger than the dedicated threshold, or
+   * that ask for it, get device memory of their own.
+   *
+   * Host visible blocks are mapped once on creation and stay mapped for their lifetime.
+   *
+   * Memory types are scored against the usage of the resource, by the properties it prefers and
+   * avoids, with ties going to the larger heap. Device local host visible memory is only a small
+   * window through the PCIe BAR unless the system has resizable BAR, so it is reserved for small
+   * data written every frame.
+   */
+  class MemoryAllocator final {
+  public:
+    //! \brief The size of blocks when none is requested.
+    static constexpr VkDeviceSize DefaultBlockSize = 64ull * 1024 * 1024;
+
+    //! \brief The information needed to create a memory allocator.
+    struct CreateInfo {
+      //! \brief The physical device, used to query memory types and limits.
+      VkPhysicalDevice physicalDevice;
+
+      //! \brief The logical device memory will be allocated from.
+      VkDevice logicalDevice;
+
+      //! \brief The callbacks host memory is allocated through, null uses the driver's allocator.
+      const VkAllocationCallbacks* allocationCallbacks;
+
+      //! \brief The size of each block, zero selects the default.
+      VkDeviceSize blockSize;
+
+      //! \brief Resources at least this large get dedicated memory, zero selects half a block.
+      VkDeviceSize dedicatedThreshold;
+    };
+
+  public:
+    /*!
+     * \brief     Explicitly defined constructor, creates this object from the given information.
+     * \param[in] createInfo The information to create this object.
+     */
+    MemoryAllocator(const CreateInfo& createInfo);
+
+    //! \brief Explicitly defined destructor, frees every block.
+   ~MemoryAllocator() noexcept;
+
+  private:
+    // Not allowed.
+    MemoryAllocator(const MemoryAllocator&) = delete;
+    MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+
+  public:
+    /*!
+     * \brief     Allocates memory for a resource.
+     * \param[in] allocationInfo The requirements of the resource.
+     * \return    The allocated range, bind the resource at its memory and offset.
+     */
+    Allocation allocate(const AllocationInfo& allocationInfo);
+
+    /*!
+     * \brief         Frees memory of a resource, the GPU must no longer be using it.
+     * \param[in,out] allocation The allocation to free, reset to empty on return.
+     */
+    void free(Allocation& allocation) noexcept;
+
+    /*!
+     * \brief     Gets the user data of an allocation.
+     * \param[in] allocation The allocation.
+     * \return    The user data the allocation was made or last updated with.
+     */
+    void* userData(const Allocation& allocation) const noexcept;
+
+    /*!
+     * \brief     Replaces the user data of an allocation, for when its owner moves.
+     * \param[in] allocation The allocation.
+     * \param[in] userData The new user data, null keeps the allocation from being moved.
+     */
+    void setUserData(const Allocation& allocation, void* userData) noexcept;
+
+    /*!
+     * \brief     Plans moves that would empty the least used block of each heap.
+     * \param[in] maxBytes The most bytes the moves may copy in total.
+     * \return    The moves to perform, with their destinations allocated.
+     *
+     * Only ranges allocated with user data are moved, as there is no one to notify about others.
+     * Resource buffers allocate with themselves as user data, see ResourceBuffer::relocate().
+     */
+    std::vector<DefragmentationMove> planDefragmentation(VkDeviceSize maxBytes);
+
+    /*!
+     * \brief  Gets the memory usage of every memory type combined.
+     * \return The combined statistics.
+     */
+    MemoryStatistics statistics() const;
+
+    /*!
+     * \brief     Gets the memory usage of a single memory type.
+     * \param[in] memoryType The index of the memory type.
+     * \return    The statistics of the memory type.
+     */
+    MemoryStatistics statistics(std::uint32_t memoryType) const;
+
+    /*!
+     * \brief     Finds the memory type a resource would be placed in.
+     * \param[in] typeBits The memory types the resource supports.
+     * \param[in] usage How the resource's memory is accessed.
+     * \return    The index of the best scoring memory type.
+     */
+    std::uint32_t findMemoryType(std::uint32_t typeBits, MemoryUsage usage) const;
+
+    /*!
+     * \brief     Describes the given memory type.
+     * \param[in] memoryType The index of the memory type.
+     * \return    The placement of resources allocated from the memory type.
+     */
+    MemoryPlacement placement(std::uint32_t memoryType) const noexcept;
+
+    /*!
+     * \brief  Checks whether the whole of device local memory is host visible.
+     * \return True if the system has resizable BAR, false if only a small window is visible.
+     */
+    bool resizableBar() const noexcept;
+
+    /*!
+     * \brief  Gets the memory properties of the physical device.
+     * \return The memory types and heaps the allocator chooses from.
+     */
+    const VkPhysicalDeviceMemoryProperties& memoryProperties() const noexcept;
+
+  private:
+    //! \brief The blocks of a single memory type, for a single kind of resource.
+    struct Heap {
+      //! \brief The blocks ranges are sub-allocated from.
+      std::vector<std::unique_ptr<MemoryBlock>> blocks;
+    };
+
+    /*!
+     * \brief     Allocates and, if host visible, maps device memory.
+     * \param[in] memoryType The memory type to allocate from.
+     * \param[in] size The size of the memory.
+     * \param[out] mapped The host address of the memory, if it was mapped.
+     * \return    The device memory.
+     */
+    VkDeviceMemory allocateDeviceMemory(std::uint32_t memoryType, VkDeviceSize size, void** mapped);
+
+    /*!
+     * \brief     Gets the heap of the given memory type and kind.
+     * \param[in] memoryType The memory type.
+     * \param[in] kind The kind of resource.
+     * \return    The heap.
+     */
+    Heap& heap(std::uint32_t memoryType, AllocationKind kind) noexcept;
+
+  private:
+    //! \brief The logical device memory is allocated from.
+    VkDevice mLogicalDevice;
+
+    //! \brief The callbacks host memory is allocated through.
+    const VkAllocationCallbacks* mAllocationCallbacks;
+
+    //! \brief The memory types and heaps of the physical device.
+    VkPhysicalDeviceMemoryProperties mMemoryProperties;
+
+    //! \brief The heaps of every memory type, for buffers and images.
+    std::array<Heap, VK_MAX_MEMORY_TYPES * 2> mHeaps;
+
+    //! \brief The live dedicated allocations of every memory type, by count and bytes.
+    std::array<std::pair<std::size_t, VkDeviceSize>, VK_MAX_MEMORY_TYPES> mDedicated;
+
+    //! \brief Guards every heap, allocation may happen from any thread.
+    mutable std::mutex mLock;
+
+    //! \brief The size of each block.
+    VkDeviceSize mBlockSize;
+
+    //! \brief Resources at least this large get dedicated memory.
+    VkDeviceSize mDedicatedThreshold;
+
+    //! \brief The number of live device memory allocations.
+    std::uint32_t mDeviceAllocationCount;
+
+    //! \brief The most device memory allocations the device allows.
+    std::uint32_t mMaxDeviceAllocationCount;
+
+    //! \brief Whether or not the whole of device local memory is host visible.
+    bool mResizableBar;
+  };
+
+}
@@ -0,0 +1,147 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "../forward.hpp"
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  /*!
+   * \brief Caches compiled pipelines, and persists them between runs.
+   *
+   * On creation the cache file is loaded, if its header matches the vendor, device, driver version
+   * and pipeline cache UUID of the physical device, otherwise it is discarded and the cache starts
+   * empty. Every thread that creates pipelines gets its own cache, so threads don't contend on the
+   * driver's lock, and save() merges them into the main cache before writing it out.
+   *
+   * Saving writes to a temporary file first and renames it over the cache file, so a crash while
+   * saving never leaves a truncated cache behind. The cache is saved on destruction.
+   */
+  class PipelineCache final {
+  public:
+    //! \brief The information needed to create a pipeline cache.
+    struct CreateInfo {
+      //! \brief The physical device the cache must match.
+      VkPhysicalDevice physicalDevice;
+
+      //! \brief The logical device the pipeline cache will be created from.
+      VkDevice logicalDevice;
+
+      //! \brief The callbacks host memory is allocated through, null uses the driver's allocator.
+      const VkAllocationCallbacks* allocationCallbacks;
+
+      //! \brief The file the cache is loaded from and saved to, null keeps the cache in memory.
+      const char* filePath;
+
+      //! \brief The number of threads that create pipelines, each gets its own cache.
+      std::uint32_t threadCount;
+    };
+
+  public:
+    //! \brief Explicitly defined default constructor.
+    PipelineCache() noexcept;
+
+    /*!
+     * \brief     Explicitly defined constructor, creates this object from the given information.
+     * \param[in] createInfo The information needed to create this object.
+     */
+    PipelineCache(const CreateInfo& createInfo);
+
+    //! \brief Explicitly defined destructor, saves the cache and destroys it.
+   ~PipelineCache() noexcept;
+
+    /*!
+     * \brief     Explicitly defined move constructor, allows moving data of another object into
+     *            this one.
+     * \param[in] other The object data that will be moved.
+     */
+    PipelineCache(PipelineCache&& other) noexcept;
+
+    /*!
+     * \brief     Explicitly defined move assignment operator, allows moving data of another object
+     *            into this one.
+     * \param[in] other The object data that will be moved.
+     * \return    This object with the new object data.
+     */
+    PipelineCache& operator=(PipelineCache&& other) noexcept;
+
+  public:
+    /*!
+     * \brief  Gets the handle of the main cache, for pipelines created outside of worker threads.
+     * \return The vulkan pipeline cache object.
+     */
+    VkPipelineCache handle() const noexcept;
+
+    /*!
+     * \brief     Gets the cache of a thread that creates pipelines.
+     * \param[in] threadIndex The index of the thread.
+     * \return    The cache of the thread, or the main cache if the index is out of range.
+     */
+    VkPipelineCache threadHandle(std::uint32_t threadIndex) const noexcept;
+
+    /*!
+     * \brief  Whether or not the cache was loaded from disk.
+     * \return False if there was no cache file, or it didn't match the physical device.
+     */
+    bool loaded() const noexcept;
+
+    /*!
+     * \brief Merges the caches of every thread into the main cache, and writes it out.
+     *
+     * Does nothing if the cache has no file. No thread may create pipelines while saving.
+     */
+    void save();
+
+  private:
+    /*!
+     * \brief  Reads the cache file, validating it against the physical device.
+     * \return The cache data, or nothing if the file is missing or doesn't match.
+     */
+    std::vector<std::uint8_t> readCacheFile() const;
+
+  private:
+    //! \brief The physical device the cache must match.
+    VkPhysicalDevice mPhysicalDevice;
+
+    //! \brief The logical device that created this pipeline cache.
+    VkDevice mLogicalDevice;
+
+    //! \brief The callbacks host memory is allocated through.
+    const VkAllocationCallbacks* mAllocationCallbacks;
+
+    //! \brief The file the cache is saved to, empty if kept in memory.
+    std::string mFilePath;
+
+    //! \brief The main cache, the caches of every thread are merged into it.
+    VkPipelineCache mPipelineCache;
+
+    //! \brief The caches of every thread that creates pipelines.
+    std::vector<VkPipelineCache> mThreadCaches;
+
+    //! \brief Whether or not the cache was loaded from disk.
+    bool mLoaded;
+  };
+
+}
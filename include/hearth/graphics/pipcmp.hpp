@@ -0,0 +1,184 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "../forward.hpp"
+#include "gfxpip.hpp"
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  //! \brief The state of a pipeline being compiled asynchronously.
+  enum struct PipelineStatus : std::uint8_t {
+    Pending,
+    Ready,
+    Failed,
+  };
+
+  /*!
+   * \brief Refers to a pipeline compiled asynchronously, which may not be ready yet.
+   *
+   * Handles are cheap to copy, the pipeline lives for as long as any handle refers to it. Polling
+   * is safe from any thread, so the renderer can check every draw and skip or substitute the ones
+   * whose pipeline isn't ready yet.
+   */
+  class PipelineHandle final {
+  private:
+    friend class PipelineCompiler;
+
+    //! \brief The state of a single compilation, defined privately.
+    struct Build;
+
+  public:
+    //! \brief Explicitly defined default constructor, refers to no pipeline.
+    PipelineHandle() noexcept = default;
+
+  private:
+    /*!
+     * \brief     Explicitly defined constructor, refers to the given compilation.
+     * \param[in] build The compilation.
+     */
+    explicit PipelineHandle(std::shared_ptr<Build> build) noexcept;
+
+  public:
+    /*!
+     * \brief  Gets the state of the compilation.
+     * \return The status, failed if this handle refers to no pipeline.
+     */
+    PipelineStatus status() const noexcept;
+
+    /*!
+     * \brief  Checks whether the pipeline can be used.
+     * \return True once the pipeline has compiled.
+     */
+    bool ready() const noexcept;
+
+    /*!
+     * \brief  Gets the pipeline, if it's ready.
+     * \return The pipeline, or null if it is still compiling or failed to.
+     */
+    const Pipeline* get() const noexcept;
+
+    /*!
+     * \brief     Gets the pipeline if it's ready, or a substitute if not.
+     * \param[in] fallback The pipeline to use until this one is ready, may be null to skip the draw.
+     * \return    The pipeline or the fallback.
+     */
+    const Pipeline* resolve(const Pipeline* fallback) const noexcept;
+
+  private:
+    //! \brief The compilation this handle refers to.
+    std::shared_ptr<Build> mBuild;
+  };
+
+  /*!
+   * \brief Compiles pipelines on the workers of a job scheduler, without blocking the caller.
+   *
+   * The descriptions of the pipeline are copied, shader modules owned by a shader library are kept
+   * alive until the compilation finishes. The layout, base pipeline and render pass must outlive
+   * it. Each compilation goes through the pipeline cache of the worker that compiles it, and is
+   * scheduled as a background job, so a frame waiting on its own jobs never ends up compiling.
+   *
+   * Pipelines may only be compiled and waited on from threads of the job scheduler, any thread may
+   * poll their handles.
+   */
+  class PipelineCompiler final {
+  public:
+    //! \brief The information needed to create a pipeline compiler.
+    struct CreateInfo {
+      //! \brief The scheduler to compile pipelines on.
+      JobScheduler* scheduler;
+
+      //! \brief The pipeline cache to compile through, may be null.
+      const PipelineCache* pipelineCache;
+    };
+
+  public:
+    /*!
+     * \brief     Explicitly defined constructor, creates this object from the given information.
+     * \param[in] createInfo The information needed to create this object.
+     */
+    PipelineCompiler(const CreateInfo& createInfo);
+
+    //! \brief Explicitly defined destructor, waits for every outstanding compilation.
+   ~PipelineCompiler() noexcept;
+
+  private:
+    // Not allowed.
+    PipelineCompiler(const PipelineCompiler&) = delete;
+    PipelineCompiler& operator=(const PipelineCompiler&) = delete;
+
+  public:
+    /*!
+     * \brief     Starts compiling a pipeline on a worker.
+     * \param[in] createInfo The information needed to create the pipeline.
+     * \param[in] base The pipeline to derive from, used only if it's ready and allows derivatives.
+     * \return    The handle to poll or wait on.
+     *
+     * The base of the create info takes precedence over the base handle. A base handle is kept
+     * alive until the compilation finishes.
+     */
+    PipelineHandle compile(const Pipeline::CreateInfo& createInfo, const PipelineHandle& base = { });
+
+    /*!
+     * \brief     Waits for a pipeline to finish compiling, executing jobs while waiting.
+     * \param[in] handle The handle of the pipeline.
+     * \return    The pipeline, or null if it failed to compile.
+     */
+    const Pipeline* wait(const PipelineHandle& handle);
+
+    //! \brief Waits for every outstanding compilation to finish.
+    void waitAll();
+
+    /*!
+     * \brief  Gets the number of pipelines still compiling.
+     * \return The outstanding compilation count.
+     */
+    std::size_t pending() const;
+
+  private:
+    /*!
+     * \brief     Compiles a pipeline, the function of compilation jobs.
+     * \param[in] data The compilation.
+     */
+    static void compileJob(void* data) noexcept;
+
+    //! \brief Forgets compilations that have finished. Only called with the lock held.
+    void collectFinished();
+
+  private:
+    //! \brief The scheduler pipelines are compiled on.
+    JobScheduler* mScheduler;
+
+    //! \brief The pipeline cache pipelines are compiled through.
+    const PipelineCache* mPipelineCache;
+
+    //! \brief The compilations that may still be running, kept alive until they have finished.
+    std::vector<std::shared_ptr<PipelineHandle::Build>> mBuilds;
+
+    //! \brief Guards the outstanding compilations.
+    mutable std::mutex mLock;
+  };
+
+}
@@ -0,0 +1,153 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "../forward.hpp"
+#include "gfxpip.hpp"
+#include "pipcmp.hpp"
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  /*!
+   * \brief A canonical, hashable description of the state of a pipeline.
+   *
+   * Covers the vertex layout, blending, rasterization, layout, render pass and subpass, and the
+   * code of every shader, independent of the order vertex bindings and attributes were listed in.
+   * Two create infos with equal keys create interchangeable pipelines. The base pipeline and
+   * caches aren't part of the key, they only change how fast a pipeline compiles. Neither are
+   * the values of dynamic states, a dynamic topology only keeps its class, so materials that
+   * differ only in those share a pipeline.
+   */
+  class PipelineKey final {
+  public:
+    /*!
+     * \brief     Explicitly defined constructor, derives the key of the given pipeline state.
+     * \param[in] createInfo The information a pipeline would be created with.
+     */
+    explicit PipelineKey(const Pipeline::CreateInfo& createInfo);
+
+  public:
+    /*!
+     * \brief  Gets the hash of this key.
+     * \return The hash, computed once on construction.
+     */
+    std::size_t hash() const noexcept;
+
+    /*!
+     * \brief     Compares two keys.
+     * \param[in] other The key to compare against.
+     * \return    True if both describe the same pipeline state.
+     */
+    bool operator==(const PipelineKey& other) const noexcept;
+
+  private:
+    //! \brief The state, flattened into words in a canonical order.
+    std::vector<std::uint64_t> mWords;
+
+    //! \brief The hash of the words.
+    std::size_t mHash;
+  };
+
+  //! \brief Hashes pipeline keys for unordered containers.
+  struct PipelineKeyHash {
+    /*!
+     * \brief     Gets the hash of a key.
+     * \param[in] key The key to hash.
+     * \return    The hash of the key.
+     */
+    std::size_t operator()(const PipelineKey& key) const noexcept {
+      return key.hash();
+    }
+  };
+
+  /*!
+   * \brief Shares a single pipeline between every request for the same pipeline state.
+   *
+   * Requests are keyed by PipelineKey, the first request for a key compiles the pipeline and every
+   * later one gets a handle to the same compilation. Every pipeline the registry compiles allows
+   * derivatives, so new states can be derived from a similar, already compiled one.
+   *
+   * Pipelines stay alive until the registry is cleared or destroyed. Requests may be made from any
+   * thread of the compiler's job scheduler.
+   */
+  class PipelineRegistry final {
+  public:
+    //! \brief The information needed to create a pipeline registry.
+    struct CreateInfo {
+      //! \brief The compiler new pipeline states are compiled with.
+      PipelineCompiler* compiler;
+    };
+
+  public:
+    /*!
+     * \brief     Explicitly defined constructor, creates this object from the given information.
+     * \param[in] createInfo The information needed to create this object.
+     */
+    PipelineRegistry(const CreateInfo& createInfo);
+
+  private:
+    // Not allowed.
+    PipelineRegistry(const PipelineRegistry&) = delete;
+    PipelineRegistry& operator=(const PipelineRegistry&) = delete;
+
+  public:
+    /*!
+     * \brief     Gets the pipeline of the given state, compiling it if it is new or last failed to.
+     * \param[in] createInfo The information the pipeline is created with.
+     * \param[in] base The pipeline to derive from, used only if it has already compiled.
+     * \return    The handle of the pipeline, shared by every request for the same state.
+     */
+    PipelineHandle acquire(const Pipeline::CreateInfo& createInfo, const PipelineHandle& base = { });
+
+    //! \brief Forgets every pipeline, they are destroyed once no handle refers to them anymore.
+    void clear();
+
+    /*!
+     * \brief  Gets the number of unique pipeline states.
+     * \return The number of registered pipelines.
+     */
+    std::size_t size() const;
+
+    /*!
+     * \brief  Gets the number of requests that found an existing pipeline.
+     * \return The number of requests that didn't compile.
+     */
+    std::uint64_t hits() const;
+
+  private:
+    //! \brief The compiler new pipeline states are compiled with.
+    PipelineCompiler* mCompiler;
+
+    //! \brief The pipelines of every state requested so far.
+    std::unordered_map<PipelineKey, PipelineHandle, PipelineKeyHash> mPipelines;
+
+    //! \brief The number of requests that found an existing pipeline.
+    std::uint64_t mHits;
+
+    //! \brief Guards the pipelines, requests may come from any worker.
+    mutable std::mutex mLock;
+  };
+
+}
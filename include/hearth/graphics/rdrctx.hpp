@@ -27,9 +27,37 @@
 #include <vulkan/vulkan.h>
 #include "../forward.hpp"
 #include "cmdbuf.hpp"
+#include "pipcch.hpp"
 
 namespace HAPI_NAMESPACE_NAME::gfx {
 
+  //! \brief The memory budget of a single memory heap.
+  struct HeapBudget {
+    //! \brief The size of the heap.
+    VkDeviceSize size;
+
+    //! \brief The bytes of the heap in use by this process, zero if the driver doesn't report it.
+    VkDeviceSize usage;
+
+    //! \brief The bytes of the heap this process can use before the driver starts paging.
+    VkDeviceSize budget;
+
+    //! \brief Whether or not the heap is device local.
+    bool deviceLocal;
+  };
+
+  //! \brief The memory budget of every memory heap of a physical device.
+  struct MemoryBudget {
+    //! \brief The budget of each heap, indexed by heap.
+    std::array<HeapBudget, VK_MAX_MEMORY_HEAPS> heaps;
+
+    //! \brief The number of heaps in use.
+    std::uint32_t heapCount;
+
+    //! \brief Whether the driver reported usage and budget, otherwise the budget is an estimate.
+    bool reported;
+  };
+
   //! \brief Represents an object that can perform rendering operations on a window of an Application.
   class RenderContext final {
   public:
@@ -43,6 +71,18 @@ namespace HAPI_NAMESPACE_NAME::gfx {
 
       //! \brief The version of the application.
       std::uint32_t appVersion;
+
+      //! \brief The callbacks host memory is allocated through, null uses the driver's allocator.
+      const VkAllocationCallbacks* allocationCallbacks;
+
+      //! \brief The file compiled pipelines are cached in between runs, null keeps them in memory.
+      const char* pipelineCachePath;
+
+      //! \brief The number of threads that create pipelines, each gets its own pipeline cache.
+      std::uint32_t pipelineThreadCount;
+
+      //! \brief Whether or not to enable the extended dynamic state extensions the device supports.
+      bool extendedDynamicState;
     };
 
   public:
@@ -80,6 +120,51 @@ namespace HAPI_NAMESPACE_NAME::gfx {
      */
     VkInstance environment() const noexcept;
 
+    /*!
+     * \brief  Whether or not timeline semaphores were enabled on the logical device.
+     * \return True if the device supports VK_KHR_timeline_semaphore and it was enabled.
+     */
+    bool timelineSemaphoreSupport() const noexcept;
+
+    /*!
+     * \brief  Whether or not a queue was created on a transfer only queue family.
+     * \return True if the device has a transfer family without graphics, and transferQueue() is valid.
+     */
+    bool transferQueueSupport() const noexcept;
+
+    /*!
+     * \brief  Whether or not VK_EXT_memory_budget was enabled on the logical device.
+     * \return True if memoryBudget() reports the driver's usage and budget.
+     */
+    bool memoryBudgetSupport() const noexcept;
+
+    /*!
+     * \brief  Queries the current memory budget of every heap, cheap enough to call every frame.
+     * \return The budget of every heap.
+     *
+     * Without VK_EXT_memory_budget, the budget is estimated as a share of each heap and usage is
+     * left for the caller to account for.
+     */
+    MemoryBudget memoryBudget() const;
+
+    /*!
+     * \brief  Gets the pipeline states that can be set on a command buffer.
+     * \return A mask of DynamicStateFlags, only the core bits unless extended dynamic state was enabled.
+     */
+    std::uint32_t dynamicStateSupport() const noexcept;
+
+    /*!
+     * \brief  Gets the pipeline cache pipelines should be created through.
+     * \return The pipeline cache, saved when this render context is destroyed.
+     */
+    const PipelineCache& pipelineCache() const noexcept;
+
+    /*!
+     * \brief  Gets the pipeline cache pipelines should be created through.
+     * \return The pipeline cache, saved when this render context is destroyed.
+     */
+    PipelineCache& pipelineCache() noexcept;
+
     // TODO: move these.
     VkSurfaceKHR surface() const noexcept { return mSurface; }
     VkPhysicalDevice physicalDevice() const noexcept { return mPhysicalDevice; }
@@ -88,6 +173,8 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     VkQueue presentQueue() const noexcept { return mPresentQueuePair.first; }
     std::uint32_t graphicsQueueIndex() const noexcept { return mGraphicsQueuePair.second; }
     std::uint32_t presentQueueIndex() const noexcept { return mPresentQueuePair.second; }
+    VkQueue transferQueue() const noexcept { return mTransferQueuePair.first; }
+    std::uint32_t transferQueueIndex() const noexcept { return mTransferQueuePair.second; }
 
   private:
     /*!
@@ -106,8 +193,18 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     //! \brief Performs operations to choose a suitable physical device to render with.
     void pickPhysicalDevice();
 
-    //! \brief Initailizes the logical device for this render context.
-    void initializeLogicalDevice();
+    /*!
+     * \brief     Initailizes the logical device for this render context.
+     * \param[in] extendedDynamicState Whether to enable the extended dynamic state the device supports.
+     */
+    void initializeLogicalDevice(bool extendedDynamicState);
+
+    /*!
+     * \brief     Initializes the pipeline cache, loading it from disk if possible.
+     * \param[in] filePath The file the cache is kept in, may be null.
+     * \param[in] threadCount The number of threads that create pipelines.
+     */
+    void initializePipelineCache(const char* filePath, std::uint32_t threadCount);
 
   private:
     //! \brief The queue graphics commands will be sent to.
@@ -116,6 +213,9 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     //! \brief The queue present commands will be sent to.
     std::pair<VkQueue, std::uint32_t> mPresentQueuePair;
 
+    //! \brief The queue asynchronous uploads will be sent to, null without a transfer only family.
+    std::pair<VkQueue, std::uint32_t> mTransferQueuePair;
+
     //! \brief The vulkan instance that will allow us to interact with the driver.
     VkInstance mInstance;
 
@@ -128,6 +228,21 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     //! \brief The logical device that we will be using to get memory and other things from the GPU.
     VkDevice mLogicalDevice;
 
+    //! \brief The callbacks host memory is allocated through.
+    const VkAllocationCallbacks* mAllocationCallbacks;
+
+    //! \brief The cache compiled pipelines are kept in.
+    PipelineCache mPipelineCache;
+
+    //! \brief The pipeline states that can be set on a command buffer, a mask of DynamicStateFlags.
+    std::uint32_t mDynamicStateSupport;
+
+    //! \brief Whether or not timeline semaphores were enabled on the logical device.
+    bool mTimelineSemaphoreSupport;
+
+    //! \brief Whether or not memory budget queries were enabled on the logical device.
+    bool mMemoryBudgetSupport;
+
   #if defined(HAPI_DEBUG)
     //! \brief Provides methods of debugging for the instance.
     VkDebugUtilsMessengerEXT mDebugMessenger;
@@ -23,7 +23,7 @@
 #include <cstdint>
 #include <vector>
 #include <vulkan/vulkan.h>
-#include "../config.hpp"
+#include "../forward.hpp"
 #include "format.hpp"
 
 namespace HAPI_NAMESPACE_NAME::gfx {
@@ -160,6 +160,12 @@ namespace HAPI_NAMESPACE_NAME::gfx {
 
       //! \brief The logical device that will create the renderpass.
       VkDevice logicalDevice;
+
+      //! \brief The callbacks host memory is allocated through, null uses the driver's allocator.
+      const VkAllocationCallbacks* allocationCallbacks;
+
+      //! \brief The queue destruction is deferred through, if null destruction waits for the device.
+      DeletionQueue* deletionQueue;
     };
 
   public:
@@ -208,6 +214,12 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     //! \brief The logical device this renderpass will be created with.
     VkDevice mLogicalDevice;
 
+    //! \brief The callbacks host memory is allocated through.
+    const VkAllocationCallbacks* mAllocationCallbacks;
+
+    //! \brief The queue destruction is deferred through.
+    DeletionQueue* mDeletionQueue;
+
     //! \brief The renderpass handle given to us by vulkan.
     VkRenderPass mRenderPass;
   };
@@ -23,9 +23,25 @@
 #include <cstdint>
 #include <vulkan/vulkan.h>
 #include "../forward.hpp"
+#include "memalc.hpp"
 
 namespace HAPI_NAMESPACE_NAME::gfx {
 
+  //! \brief Describes where the memory of a resource buffer lives, and so how data reaches it.
+  enum struct BufferResidency : std::uint8_t {
+    //! \brief Memory only the GPU can access, written through a staging ring.
+    DeviceLocal,
+
+    //! \brief Host visible memory the CPU writes into directly.
+    Upload,
+
+    //! \brief Host visible memory, cached if possible, the CPU reads back from.
+    Readback,
+
+    //! \brief Small host visible memory the CPU writes every frame, device local if possible.
+    Dynamic,
+  };
+
   //! \brief Represents a buffer of memory on the GPU that we can map CPU memory to.
   class ResourceBuffer {
   public:
@@ -44,20 +60,32 @@ namespace HAPI_NAMESPACE_NAME::gfx {
 
     //! \brief The information needed to create this resource buffer.
     struct CreateInfo {
-      //! \brief The physical device that we will be getting memory from.
-      VkPhysicalDevice physicalDevice;
+      //! \brief The allocator that we will be getting memory from.
+      MemoryAllocator* allocator;
+
+      //! \brief The staging ring that uploads the initial data, required for device local buffers.
+      StagingRing* stagingRing;
+
+      //! \brief The queue destruction is deferred through, if null destruction waits for the device.
+      DeletionQueue* deletionQueue;
 
       //! \brief The logical device that will create the buffer.
       VkDevice logicalDevice;
 
+      //! \brief The callbacks host memory is allocated through, null uses the driver's allocator.
+      const VkAllocationCallbacks* allocationCallbacks;
+
       //! \brief The size of the buffer.
       std::size_t bufferSize;
 
-      //! \brief The initial data to store in the resource buffer.
+      //! \brief The initial data to store in the resource buffer, may be null.
       const void* initialData;
 
       //! \brief The usage of the buffer.
       std::uint16_t bufferUsage;
+
+      //! \brief Where the memory of the buffer should live.
+      BufferResidency residency;
     };
 
   public:
@@ -95,6 +123,50 @@ namespace HAPI_NAMESPACE_NAME::gfx {
      */
     VkBuffer handle() const noexcept;
 
+    /*!
+     * \brief  Gets the memory this resource buffer is bound to.
+     * \return The allocation handed out by the memory allocator.
+     */
+    const Allocation& allocation() const noexcept;
+
+    /*!
+     * \brief  Gets the size of this resource buffer.
+     * \return The size requested on creation.
+     */
+    std::size_t size() const noexcept;
+
+    /*!
+     * \brief  Gets where the memory of this resource buffer lives.
+     * \return The residency requested on creation.
+     */
+    BufferResidency residency() const noexcept;
+
+    /*!
+     * \brief  Gets the host address of this resource buffer's memory.
+     * \return The persistently mapped memory, null unless the memory is host visible.
+     */
+    void* mapped() const noexcept;
+
+    /*!
+     * \brief  Gets the memory type this resource buffer was placed in.
+     * \return The placement, which tells whether or not the residency's preferred memory was found.
+     */
+    MemoryPlacement placement() const noexcept;
+
+    /*!
+     * \brief         Moves this resource buffer into the destination of a defragmentation move.
+     * \param[in,out] commandBuffer The command buffer the copy of the contents is recorded into.
+     * \param[in]     move A move the memory allocator planned, whose user data is this buffer.
+     * \return        The buffer that held the contents until now, destroy it once the copy has
+     *                executed.
+     *
+     * Resource buffers allocate with themselves as user data, so the moves the memory allocator
+     * plans name the buffers to relocate. The buffer is recreated over the destination, commands
+     * recorded from then on must use the new handle, and nothing may write it until the copy has
+     * executed.
+     */
+    ResourceBuffer relocate(CommandBuffer& commandBuffer, const DefragmentationMove& move);
+
   private:
     /*!
      * \brief     Initializes this resource buffer.
@@ -104,24 +176,46 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     void initializeBuffer(std::size_t size, std::uint16_t usage);
 
     /*!
-     * \brief     Maps the given data to this resource buffer's memory.
+     * \brief     Writes the given data into this resource buffer's bound memory.
      * \param[in] size The size of the resource buffer.
-     * \param[in] data The data to map to this resource buffer.
+     * \param[in] data The data to write into this resource buffer, may be null.
+     *
+     * Host visible memory stays mapped and is written directly, even for device local buffers on
+     * devices that share their memory with the host. Other device local memory is written through
+     * the staging ring once its uploads are flushed.
      */
     void mapMemory(std::size_t size, const void* data);
 
   private:
-    //! \brief The physical device we will allocate memory from.
-    VkPhysicalDevice mPhysicalDevice;
+    //! \brief The allocator we will allocate memory from.
+    MemoryAllocator* mAllocator;
+
+    //! \brief The staging ring uploads to device local memory go through.
+    StagingRing* mStagingRing;
+
+    //! \brief The queue destruction is deferred through.
+    DeletionQueue* mDeletionQueue;
 
     //! \brief The device this resource buffer will be created from.
     VkDevice mLogicalDevice;
 
+    //! \brief The callbacks host memory is allocated through.
+    const VkAllocationCallbacks* mAllocationCallbacks;
+
     //! \brief The handle to this resource buffer.
     VkBuffer mBufferHandle;
 
-    //! \brief The memory this buffer stores.
-    VkDeviceMemory mBufferMemory;
+    //! \brief The memory this buffer is bound to.
+    Allocation mAllocation;
+
+    //! \brief The size of this resource buffer.
+    std::size_t mSize;
+
+    //! \brief The usage this resource buffer was created with, kept to recreate it when relocated.
+    std::uint16_t mUsage;
+
+    //! \brief Where the memory of this resource buffer lives.
+    BufferResidency mResidency;
   };
 
 }
@@ -0,0 +1,239 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "../forward.hpp"
+#include "rdrctx.hpp"
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  //! \brief Identifies a resource tracked by a residency manager, by its entry and that entry's generation.
+  using ResidencyHandle = std::uint64_t;
+
+  /*!
+   * \brief Keeps memory usage under the budget by evicting the least recently used streamable resources.
+   *
+   * Streamable resources are tracked with a callback that evicts them, and are touched by every
+   * frame that uses them. Once per frame update() queries the budget of every heap, and for each
+   * heap over its target evicts resources that no frame in flight uses, least recently used first,
+   * until the heap is back under target. Evicting before the driver starts paging turns running
+   * out of memory into a gradual loss of quality, rather than a sudden cliff in frame time.
+   *
+   * Evicted resources should be destroyed through a deletion queue, their memory is assumed to be
+   * back in the budget once the frames in flight have finished.
+   *
+   * Handles carry the generation of their entry, which changes whenever the entry is released, so
+   * handles of resources that are no longer tracked are ignored rather than naming whichever
+   * resource reused their entry.
+   */
+  class ResidencyManager final {
+  public:
+    //! \brief The handle returned when a resource isn't tracked.
+    static constexpr ResidencyHandle InvalidHandle = ~ResidencyHandle(0);
+
+    //! \brief The share of the budget to stay under when none is requested.
+    static constexpr float DefaultTargetUsage = 0.9f;
+
+    //! \brief The information needed to create a residency manager.
+    struct CreateInfo {
+      //! \brief The render context to query memory budgets from.
+      const RenderContext* renderContext;
+
+      //! \brief The allocator to account usage with, when the driver doesn't report it.
+      const MemoryAllocator* allocator;
+
+      //! \brief The number of frames that may be in flight at once.
+      std::uint32_t framesInFlight;
+
+      //! \brief The share of each heap's budget to stay under, zero selects the default.
+      float targetUsage;
+    };
+
+    //! \brief Describes a resource the residency manager may evict.
+    struct StreamableInfo {
+      //! \brief The memory type the resource was allocated from.
+      std::uint32_t memoryType;
+
+      //! \brief The bytes the resource holds.
+      VkDeviceSize size;
+
+      /*!
+       * \brief Evicts the resource, returning the bytes it still holds.
+       *
+       * Returning zero drops the resource and stops tracking it, returning less than it held
+       * demotes it, for example to a lower level of detail. Called without any lock held.
+       */
+      std::function<VkDeviceSize()> evict;
+    };
+
+  public:
+    /*!
+     * \brief     Explicitly defined constructor, creates this object from the given information.
+     * \param[in] createInfo The information needed to create this object.
+     */
+    ResidencyManager(const CreateInfo& createInfo);
+
+  private:
+    // Not allowed.
+    ResidencyManager(const ResidencyManager&) = delete;
+    ResidencyManager& operator=(const ResidencyManager&) = delete;
+
+  public:
+    /*!
+     * \brief     Starts tracking a streamable resource, as used by the current frame.
+     * \param[in] streamableInfo The resource to track.
+     * \return    The handle of the resource.
+     */
+    ResidencyHandle track(StreamableInfo streamableInfo);
+
+    /*!
+     * \brief     Stops tracking a resource, before it is destroyed by its owner.
+     * \param[in] handle The handle of the resource, may be InvalidHandle or no longer tracked.
+     */
+    void untrack(ResidencyHandle handle);
+
+    /*!
+     * \brief     Marks a resource as used by the current frame.
+     * \param[in] handle The handle of the resource, ignored if no longer tracked.
+     */
+    void touch(ResidencyHandle handle);
+
+    /*!
+     * \brief     Updates the bytes a resource holds, after it was streamed back in.
+     * \param[in] handle The handle of the resource, ignored if no longer tracked.
+     * \param[in] size The bytes the resource now holds.
+     */
+    void resize(ResidencyHandle handle, VkDeviceSize size);
+
+    /*!
+     * \brief Starts a new frame, querying budgets and evicting from every heap over its target.
+     *
+     * Must be called once per frame, before the frame's resources are touched.
+     */
+    void update();
+
+    /*!
+     * \brief  Gets the memory budget as of the last update.
+     * \return The budget of every heap, with usage accounted for even if the driver doesn't report it.
+     */
+    MemoryBudget budget() const;
+
+  private:
+    //! \brief The index linking to no entry.
+    static constexpr std::uint32_t InvalidIndex = ~std::uint32_t(0);
+
+    //! \brief A tracked resource, linked into the recency list.
+    struct Entry {
+      //! \brief Evicts the resource.
+      std::function<VkDeviceSize()> evict;
+
+      //! \brief The bytes the resource holds.
+      VkDeviceSize size;
+
+      //! \brief The frame the resource was last used by.
+      std::uint64_t lastUsed;
+
+      //! \brief The heap the resource's memory is in.
+      std::uint32_t heap;
+
+      //! \brief The neighbouring, less recently used resource.
+      std::uint32_t previous;
+
+      //! \brief The neighbouring, more recently used resource.
+      std::uint32_t next;
+
+      //! \brief The generation of the entry, bumped whenever it is released.
+      std::uint32_t generation;
+
+      //! \brief Whether or not the entry is in use.
+      bool tracked;
+    };
+
+    /*!
+     * \brief     Finds the entry a handle names.
+     * \param[in] handle The handle of the resource.
+     * \return    The index of the entry, or InvalidIndex if the resource is no longer tracked.
+     */
+    std::uint32_t find(ResidencyHandle handle) const noexcept;
+
+    /*!
+     * \brief     Removes an entry from the recency list.
+     * \param[in] index The index of the entry.
+     */
+    void unlink(std::uint32_t index) noexcept;
+
+    /*!
+     * \brief     Adds an entry to the most recently used end of the recency list.
+     * \param[in] index The index of the entry.
+     */
+    void append(std::uint32_t index) noexcept;
+
+    /*!
+     * \brief     Releases an entry, for its index to be reused by a new generation.
+     * \param[in] index The index of the entry.
+     */
+    void release(std::uint32_t index);
+
+  private:
+    //! \brief The render context budgets are queried from.
+    const RenderContext* mRenderContext;
+
+    //! \brief The allocator usage is accounted with, when the driver doesn't report it.
+    const MemoryAllocator* mAllocator;
+
+    //! \brief The tracked resources.
+    std::vector<Entry> mEntries;
+
+    //! \brief The indices of released entries, to be reused.
+    std::vector<std::uint32_t> mFreeIndices;
+
+    //! \brief The least recently used resource.
+    std::uint32_t mHead;
+
+    //! \brief The most recently used resource.
+    std::uint32_t mTail;
+
+    //! \brief The bytes evicted by each recent frame, per heap, that the driver may still count.
+    std::vector<std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS>> mRecentlyEvicted;
+
+    //! \brief The budget as of the last update.
+    MemoryBudget mBudget;
+
+    //! \brief Guards everything, resources may be touched from any thread.
+    mutable std::mutex mLock;
+
+    //! \brief The current frame.
+    std::uint64_t mFrame;
+
+    //! \brief The number of frames that may be in flight at once.
+    std::uint32_t mFramesInFlight;
+
+    //! \brief The share of each heap's budget to stay under.
+    float mTargetUsage;
+  };
+
+}
@@ -20,6 +20,8 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 #pragma once
+#include <cstdint>
+#include <limits>
 #include <vulkan/vulkan.h>
 #include "../forward.hpp"
 
@@ -34,8 +36,9 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     /*!
      * \brief     Explicitly defined constructor, creates this object from the given information.
      * \param[in] logicalDevice The device that will create this object.
+     * \param[in] allocationCallbacks The callbacks host memory is allocated through, may be null.
      */
-    Semaphore(VkDevice logicalDevice);
+    Semaphore(VkDevice logicalDevice, const VkAllocationCallbacks* allocationCallbacks = nullptr);
 
     //! \brief Explicitly defined desstructor, makes sure this object gets destroyed properly.
    ~Semaphore() noexcept;
@@ -66,6 +69,92 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     //! \brief The device that created this semaphore.
     VkDevice mLogicalDevice;
 
+    //! \brief The callbacks host memory is allocated through.
+    const VkAllocationCallbacks* mAllocationCallbacks;
+
+    //! \brief The semaphore handle that vulkan will give us.
+    VkSemaphore mSemaphore;
+  };
+
+  /*!
+   * \brief Represents a timeline semaphore, a semaphore with a monotonically increasing 64-bit value.
+   *
+   * Unlike binary semaphores, timeline semaphores can be waited on and signaled from the host, and
+   * a single one can track the completion of any number of submissions by the value each of them
+   * signals. Requires VK_KHR_timeline_semaphore to be enabled on the logical device.
+   */
+  class TimelineSemaphore {
+  public:
+    //! \brief Explicitly defined default constructor.
+    TimelineSemaphore() noexcept;
+
+    /*!
+     * \brief     Explicitly defined constructor, creates this object from the given information.
+     * \param[in] logicalDevice The device that will create this object.
+     * \param[in] initialValue The value the semaphore starts out with.
+     * \param[in] allocationCallbacks The callbacks host memory is allocated through, may be null.
+     */
+    TimelineSemaphore(VkDevice logicalDevice, std::uint64_t initialValue = 0, const VkAllocationCallbacks* allocationCallbacks = nullptr);
+
+    //! \brief Explicitly defined destructor, makes sure this object gets destroyed properly.
+   ~TimelineSemaphore() noexcept;
+
+    /*!
+     * \brief     Explicitly defined move constructor, allows moving data of another object into
+     *            this one.
+     * \param[in] other The object to move data from.
+     */
+    TimelineSemaphore(TimelineSemaphore&& other) noexcept;
+
+    /*!
+     * \brief     Explicitly defined move assignment operator, allows moving data of another object
+     *            into this one.
+     * \param[in] other The object data that will be moved.
+     * \return    This object with the new object data.
+     */
+    TimelineSemaphore& operator=(TimelineSemaphore&& other) noexcept;
+
+  public:
+    /*!
+     * \brief  Gets the handle of this semaphore.
+     * \return The vulkan semaphore this was created with.
+     */
+    VkSemaphore handle() const noexcept;
+
+    /*!
+     * \brief  Gets the current value of this semaphore, without waiting.
+     * \return The last value signaled by either the host or the device.
+     */
+    std::uint64_t value() const;
+
+    /*!
+     * \brief     Checks whether or not this semaphore has reached the given value, without waiting.
+     * \param[in] value The value to check for.
+     * \return    True if the current value is greater than or equal to the given one.
+     */
+    bool reached(std::uint64_t value) const;
+
+    /*!
+     * \brief     Waits on the host for this semaphore to reach the given value.
+     * \param[in] value The value to wait for.
+     * \param[in] timeout The amount of time to wait, in nanoseconds.
+     * \return    False if the timeout expired before the value was reached, true otherwise.
+     */
+    bool wait(std::uint64_t value, std::uint64_t timeout = std::numeric_limits<std::uint64_t>::max()) const;
+
+    /*!
+     * \brief     Signals this semaphore from the host.
+     * \param[in] value The new value, must be greater than the current value.
+     */
+    void signal(std::uint64_t value);
+
+  private:
+    //! \brief The device that created this semaphore.
+    VkDevice mLogicalDevice;
+
+    //! \brief The callbacks host memory is allocated through.
+    const VkAllocationCallbacks* mAllocationCallbacks;
+
     //! \brief The semaphore handle that vulkan will give us.
     VkSemaphore mSemaphore;
   };
@@ -0,0 +1,207 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "../forward.hpp"
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  /*!
+   * \brief Represents compiled SPIR-V code pipelines can be created from.
+   *
+   * Modules owned by a ShaderLibrary can be shared from a plain pointer through shared_from_this().
+   */
+  class ShaderModule final : public std::enable_shared_from_this<ShaderModule> {
+  public:
+    //! \brief The information needed to create this shader module.
+    struct CreateInfo {
+      //! \brief The logical device the shader module will be created from.
+      VkDevice logicalDevice;
+
+      //! \brief The callbacks host memory is allocated through, null uses the driver's allocator.
+      const VkAllocationCallbacks* allocationCallbacks;
+
+      //! \brief The SPIR-V code, only read during construction.
+      std::span<const std::uint32_t> code;
+    };
+
+  public:
+    /*!
+     * \brief     Hashes SPIR-V code, modules with equal code have equal hashes.
+     * \param[in] code The code to hash.
+     * \return    The hash of the code.
+     */
+    static std::uint64_t hashCode(std::span<const std::uint32_t> code) noexcept;
+
+  public:
+    //! \brief Explicitly defined default constructor.
+    ShaderModule() noexcept;
+
+    /*!
+     * \brief     Explicitly defined constructor, creates this object from the given information.
+     * \param[in] createInfo The information needed to create this object.
+     */
+    ShaderModule(const CreateInfo& createInfo);
+
+    //! \brief Explicitly defined destructor, properly prepares this object for destruction.
+   ~ShaderModule() noexcept;
+
+    /*!
+     * \brief     Explicitly defined move constructor, allows moving data of another object into
+     *            this one.
+     * \param[in] other The object data that will be moved.
+     */
+    ShaderModule(ShaderModule&& other) noexcept;
+
+    /*!
+     * \brief     Explicitly defined move assignment operator, allows moving data of another object
+     *            into this one.
+     * \param[in] other The object data that will be moved.
+     * \return    This object with the new object data.
+     */
+    ShaderModule& operator=(ShaderModule&& other) noexcept;
+
+  public:
+    /*!
+     * \brief  Gets the handle to this shader module.
+     * \return The vulkan shader module object this shader module was created with.
+     */
+    VkShaderModule handle() const noexcept;
+
+    /*!
+     * \brief  Gets the hash of the code this shader module was created from.
+     * \return The hash of the code.
+     */
+    std::uint64_t hash() const noexcept;
+
+    /*!
+     * \brief  Gets the code this shader module was created from.
+     * \return A copy of the code, kept for as long as this shader module lives.
+     */
+    std::span<const std::uint32_t> code() const noexcept;
+
+  private:
+    //! \brief The logical device that created this shader module.
+    VkDevice mLogicalDevice;
+
+    //! \brief The callbacks host memory is allocated through.
+    const VkAllocationCallbacks* mAllocationCallbacks;
+
+    //! \brief The handle to the shader module, given to us by vulkan.
+    VkShaderModule mShaderModule;
+
+    //! \brief The hash of the code.
+    std::uint64_t mHash;
+
+    //! \brief A copy of the code, so modules whose hashes collide can be told apart.
+    std::vector<std::uint32_t> mCode;
+  };
+
+  /*!
+   * \brief Loads shader modules once, and shares them between every pipeline that uses them.
+   *
+   * Files are memory mapped rather than read into a buffer, and code already in memory is used in
+   * place. Modules are deduplicated by the path they were loaded from and by their code, so
+   * pipelines sharing a shader read and compile it once. The hash of the code only picks a bucket,
+   * the code is compared word by word against the copy every live module keeps, so colliding hashes
+   * never share a module. A module lives for as long as anything holds on to it, the library only
+   * keeps weak references and forgets modules that expired whenever it creates a new one.
+   *
+   * Modules may be loaded from any thread.
+   */
+  class ShaderLibrary final {
+  public:
+    //! \brief The information needed to create a shader library.
+    struct CreateInfo {
+      //! \brief The logical device shader modules will be created from.
+      VkDevice logicalDevice;
+
+      //! \brief The callbacks host memory is allocated through, null uses the driver's allocator.
+      const VkAllocationCallbacks* allocationCallbacks;
+    };
+
+  public:
+    /*!
+     * \brief     Explicitly defined constructor, creates this object from the given information.
+     * \param[in] createInfo The information needed to create this object.
+     */
+    ShaderLibrary(const CreateInfo& createInfo) noexcept;
+
+  private:
+    // Not allowed.
+    ShaderLibrary(const ShaderLibrary&) = delete;
+    ShaderLibrary& operator=(const ShaderLibrary&) = delete;
+
+  public:
+    /*!
+     * \brief     Loads the shader module of a SPIR-V file, mapping the file into memory.
+     * \param[in] filePath The path of the file.
+     * \return    The shader module, shared with everything else that loaded the same code.
+     */
+    std::shared_ptr<const ShaderModule> load(const std::string& filePath);
+
+    /*!
+     * \brief     Loads the shader module of SPIR-V code already in memory.
+     * \param[in] code The code, only read during this call.
+     * \return    The shader module, shared with everything else that loaded the same code.
+     */
+    std::shared_ptr<const ShaderModule> load(std::span<const std::uint32_t> code);
+
+    /*!
+     * \brief  Gets the number of shader modules still alive.
+     * \return The live module count.
+     */
+    std::size_t size() const;
+
+  private:
+    /*!
+     * \brief     Finds the module with the given code, or creates it. Only called with the lock held.
+     * \param[in] code The code of the module.
+     * \return    The shader module.
+     */
+    std::shared_ptr<const ShaderModule> findOrCreate(std::span<const std::uint32_t> code);
+
+  private:
+    //! \brief The logical device shader modules are created from.
+    VkDevice mLogicalDevice;
+
+    //! \brief The callbacks host memory is allocated through.
+    const VkAllocationCallbacks* mAllocationCallbacks;
+
+    //! \brief The modules loaded from files, by path.
+    std::unordered_map<std::string, std::weak_ptr<const ShaderModule>> mPaths;
+
+    //! \brief Every module, bucketed by the hash of its code.
+    std::unordered_multimap<std::uint64_t, std::weak_ptr<const ShaderModule>> mModules;
+
+    //! \brief Guards the maps, modules may be loaded from any thread.
+    mutable std::mutex mLock;
+  };
+
+}
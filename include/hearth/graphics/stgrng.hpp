@@ -0,0 +1,183 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "../forward.hpp"
+#include "memalc.hpp"
+#include "resbuf.hpp"
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  /*!
+   * \brief Uploads data into device local resource buffers through a persistent staging buffer.
+   *
+   * Uploads are copied into a host visible ring buffer right away and the copies into their
+   * destinations are batched until the ring is flushed into a command buffer. Every flushed batch
+   * is retired with the completion value of the submission that carries it, and its part of the
+   * ring is reclaimed once the frame ring reports that submission has finished executing.
+   *
+   * Uploads may be made from any thread. Destinations must outlive the flush of their uploads.
+   */
+  class StagingRing final {
+  public:
+    //! \brief The capacity of the ring when none is requested.
+    static constexpr VkDeviceSize DefaultCapacity = 16ull * 1024 * 1024;
+
+    //! \brief The alignment of every upload within the ring.
+    static constexpr VkDeviceSize UploadAlignment = 16;
+
+    //! \brief The information needed to create a staging ring.
+    struct CreateInfo {
+      //! \brief The allocator the staging buffer gets its memory from.
+      MemoryAllocator* allocator;
+
+      //! \brief The logical device the staging buffer will be created with.
+      VkDevice logicalDevice;
+
+      //! \brief The callbacks host memory is allocated through, null uses the driver's allocator.
+      const VkAllocationCallbacks* allocationCallbacks;
+
+      //! \brief The frame ring whose completion values batches are retired with.
+      const FrameRing* frameRing;
+
+      //! \brief The size of the staging buffer, zero selects the default.
+      VkDeviceSize capacity;
+    };
+
+  public:
+    /*!
+     * \brief     Explicitly defined constructor, creates this object from the given information.
+     * \param[in] createInfo The information to create this object.
+     */
+    StagingRing(const CreateInfo& createInfo);
+
+    //! \brief Explicitly defined destructor, properly prepares this object for destruction.
+   ~StagingRing() noexcept;
+
+  private:
+    // Not allowed.
+    StagingRing(const StagingRing&) = delete;
+    StagingRing& operator=(const StagingRing&) = delete;
+
+  public:
+    /*!
+     * \brief     Copies data into the ring and queues a copy of it into the given buffer.
+     * \param[in] destination The device local buffer to upload into.
+     * \param[in] offset The offset into the destination to upload to.
+     * \param[in] data The data to upload.
+     * \param[in] size The size of the data.
+     *
+     * Blocks until enough of the ring is reclaimed when it's full.
+     */
+    void upload(const ResourceBuffer* destination, VkDeviceSize offset, const void* data, VkDeviceSize size);
+
+    /*!
+     * \brief     Records every queued copy into the given command buffer, outside a renderpass.
+     * \param[in] commandBuffer The command buffer to record into.
+     *
+     * The copies are made visible to vertex input, shaders and later transfers with a single barrier.
+     * The recorded batch must be retired with the completion value of the submission carrying it.
+     */
+    void flush(CommandBuffer& commandBuffer);
+
+    /*!
+     * \brief     Retires the last flushed batch, its part of the ring is reclaimed once complete.
+     * \param[in] completionValue The completion value of the submission carrying the batch.
+     */
+    void retire(std::uint64_t completionValue);
+
+    /*!
+     * \brief  Gets the capacity of the ring.
+     * \return The size of the staging buffer.
+     */
+    VkDeviceSize capacity() const noexcept;
+
+  private:
+    //! \brief A copy waiting to be flushed.
+    struct Copy {
+      //! \brief The buffer to copy into.
+      const ResourceBuffer* destination;
+
+      //! \brief The region of the ring to copy, and where to.
+      VkBufferCopy region;
+    };
+
+    //! \brief A flushed batch whose part of the ring is still in use by the GPU.
+    struct Batch {
+      //! \brief The bytes of the ring the batch occupies, including any wasted on wrapping.
+      VkDeviceSize bytes;
+
+      //! \brief The completion value of the submission that carries the batch.
+      std::uint64_t completionValue;
+    };
+
+    /*!
+     * \brief     Reserves a contiguous range of the ring, the lock must be held.
+     * \param[in] size The aligned size of the range.
+     * \return    The offset of the range, or nothing if the ring is too full.
+     */
+    std::optional<VkDeviceSize> reserve(VkDeviceSize size);
+
+    //! \brief Reclaims the ranges of every completed batch, the lock must be held.
+    void reclaim();
+
+  private:
+    //! \brief The host visible buffer uploads are staged in.
+    ResourceBuffer mBuffer;
+
+    //! \brief The frame ring whose completion values batches are retired with.
+    const FrameRing* mFrameRing;
+
+    //! \brief The copies waiting to be flushed.
+    std::vector<Copy> mCopies;
+
+    //! \brief The retired batches, oldest first.
+    std::deque<Batch> mBatches;
+
+    //! \brief Guards the ring, uploads may happen from any thread.
+    mutable std::mutex mLock;
+
+    //! \brief The size of the ring.
+    VkDeviceSize mCapacity;
+
+    //! \brief The offset the next upload is staged at.
+    VkDeviceSize mHead;
+
+    //! \brief The offset of the oldest range still in use.
+    VkDeviceSize mTail;
+
+    //! \brief The bytes of the ring in use, including any wasted on wrapping.
+    VkDeviceSize mUsed;
+
+    //! \brief The bytes of the ring used by copies that haven't been flushed.
+    VkDeviceSize mPendingBytes;
+
+    //! \brief The bytes of the ring used by the flushed batch that hasn't been retired.
+    VkDeviceSize mFlushedBytes;
+  };
+
+}
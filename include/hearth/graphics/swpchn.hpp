@@ -20,7 +20,7 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 #pragma once
-#include <array>
+#include <optional>
 #include <utility>
 #include <vector>
 #include <glm/glm.hpp>
@@ -54,6 +54,12 @@ namespace HAPI_NAMESPACE_NAME::gfx {
       //! \brief The logical device the swapchain should be created from.
       VkDevice logicalDevice;
 
+      //! \brief The callbacks host memory is allocated through, null uses the driver's allocator.
+      const VkAllocationCallbacks* allocationCallbacks;
+
+      //! \brief The queue destruction is deferred through, if null destruction waits for the device.
+      DeletionQueue* deletionQueue;
+
       //! \brief The resolution of the images of the swapchain, should match window resolution.
       glm::uvec2 imageResolution;
 
@@ -100,13 +106,13 @@ namespace HAPI_NAMESPACE_NAME::gfx {
      * \brief  Gets the image views for this swapchain.
      * \return A const reference to the image views of this swapchain.
      */
-    const std::array<VkImageView, 3>& imageViews() const noexcept;
+    const std::vector<VkImageView>& imageViews() const noexcept;
 
     /*!
      * \brief  Gets the image views for this swapchain.
      * \return A non-const reference to the image view of this swapchain.
      */
-    std::array<VkImageView, 3>& imageViews() noexcept;
+    std::vector<VkImageView>& imageViews() noexcept;
 
     /*!
      * \brief  Gets the handle for this swapchain.
@@ -133,10 +139,29 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     BufferStrategy bufferStrategy() const noexcept;
 
     /*!
-     * \brief     Presents the next image of the swapchain to the screen.
-     * \param[in] presentQueue The queue with presentation support, to present the next image.
+     * \brief  The number of images this swapchain was created with.
+     * \return The image count, which may be more than the requested buffer strategy.
+     */
+    std::uint32_t imageCount() const noexcept;
+
+    /*!
+     * \brief     Acquires the next image of the swapchain to render into.
+     * \param[in] imageAvailable The semaphore to signal once the image can be rendered into.
+     * \return    The index of the acquired image, or nothing if the swapchain had to be rebuilt.
+     *
+     * Images may be acquired out of order, the returned index should be used to pick the
+     * framebuffer to render into.
+     */
+    std::optional<std::uint32_t> acquireNextImage(const Semaphore* imageAvailable);
+
+    /*!
+     * \brief     Presents an acquired image of the swapchain to the screen.
+     * \param[in] presentQueue The queue with presentation support, to present the image.
+     * \param[in] imageIndex The index of the image to present, as returned by acquireNextImage().
+     * \param[in] renderFinished The semaphore to wait on before presenting.
+     * \return    False if the swapchain had to be rebuilt, true otherwise.
      */
-    void present(VkQueue presentQueue);
+    bool present(VkQueue presentQueue, std::uint32_t imageIndex, const Semaphore* renderFinished);
 
     /*!
      * \brief     Changes the resolution of the swapchain and it's images.
@@ -155,24 +180,31 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     //! \brief Initializes the swapchain image views.
     void initializeImageViews();
 
-    //! \brief Initializes the semaphores used in image acquirement.
-    void initializeSemaphores();
-
     /*!
      * \brief     Entirely rebuilds the swapchain.
      * \param[in] resolution The new resolution of the swapchain.
+     *
+     * The old swapchain is handed to the new one and, with a deletion queue, destroyed once the
+     * frames in flight are done with it instead of waiting for the device.
      */
     void rebuildSwapChain(const glm::uvec2& resolution);
 
+    /*!
+     * \brief     Destroys a swapchain and its image views, through the deletion queue if there is one.
+     * \param[in] imageViews The image views of the swapchain.
+     * \param[in] swapChain The swapchain to destroy.
+     */
+    void destroySwapChain(const std::vector<VkImageView>& imageViews, VkSwapchainKHR swapChain) noexcept;
+
   private:
     //! \brief The surface this swapchain will be presenting images to.
     std::pair<Window*, VkSurfaceKHR> mSurfacePair;
 
     //! \brief The images of the swapchain, that will be used to present rendered graphics to the screen.
-    std::array<VkImage, 3> mImages;
+    std::vector<VkImage> mImages;
 
     //! \brief An attachment of a framebuffer, defines the region of an image a renderpass will draw into.
-    std::array<VkImageView, 3> mImageViews;
+    std::vector<VkImageView> mImageViews;
 
     //! \brief The physical device this swapchain should be created from.
     VkPhysicalDevice mPhysicalDevice;
@@ -180,20 +212,20 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     //! \brief The logical device that created this swapchain.
     VkDevice mLogicalDevice;
 
-    //! \brief The swapchain handle given to us by vulkan.
-    VkSwapchainKHR mSwapChain;
+    //! \brief The callbacks host memory is allocated through.
+    const VkAllocationCallbacks* mAllocationCallbacks;
 
-    //! \brief The semaphore signaled when an image is available.
-    VkSemaphore mImageAvailable;
+    //! \brief The queue destruction is deferred through.
+    DeletionQueue* mDeletionQueue;
 
-    //! \brief The semaphore signaled when rendering is done.
-    VkSemaphore mRenderFinished;
+    //! \brief The swapchain handle given to us by vulkan.
+    VkSwapchainKHR mSwapChain;
 
     //! \brief The extent of the swapchain images.
     VkExtent2D mExtent;
 
-    //! \brief The next available swapchain image.
-    std::uint32_t mNextImage;
+    //! \brief The number of images the swapchain was created with.
+    std::uint32_t mImageCount;
 
     //! \brief The format of the swapchain images.
     VkFormat mFormat;
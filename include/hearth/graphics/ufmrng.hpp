@@ -0,0 +1,158 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vulkan/vulkan.h>
+#include "../forward.hpp"
+#include "memalc.hpp"
+#include "resbuf.hpp"
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  //! \brief Represents a slice of uniform memory handed out for the current frame.
+  struct UniformSlice {
+    //! \brief The host address to write the uniform data into.
+    void* data;
+
+    //! \brief The dynamic offset to bind the slice's descriptor with.
+    std::uint32_t offset;
+  };
+
+  /*!
+   * \brief Hands out aligned slices of a persistently mapped uniform buffer, per frame in flight.
+   *
+   * Every frame in flight owns a region of the buffer that is allocated from linearly and reset as
+   * a whole when the frame comes around again, which the frame ring only allows once the GPU is
+   * done with it. Slices are bound through a single dynamic uniform buffer descriptor covering the
+   * whole buffer, so any number of per-object uniforms share one descriptor set. The buffer lives
+   * in device local host visible memory when the device has it, so shaders don't read across PCIe.
+   *
+   * Slices may be allocated from any thread between beginFrame() calls. Host writes are visible to
+   * the submission that follows without any barrier.
+   */
+  class UniformRing final {
+  public:
+    //! \brief The bytes of uniform data each frame may allocate, when none is requested.
+    static constexpr std::size_t DefaultFrameCapacity = 256 * 1024;
+
+    //! \brief The information needed to create a uniform ring.
+    struct CreateInfo {
+      //! \brief The allocator the uniform buffer gets its memory from.
+      MemoryAllocator* allocator;
+
+      //! \brief The physical device, used to query the dynamic offset alignment.
+      VkPhysicalDevice physicalDevice;
+
+      //! \brief The logical device the uniform buffer will be created with.
+      VkDevice logicalDevice;
+
+      //! \brief The callbacks host memory is allocated through, null uses the driver's allocator.
+      const VkAllocationCallbacks* allocationCallbacks;
+
+      //! \brief The number of frames that may be in flight at once.
+      std::uint32_t framesInFlight;
+
+      //! \brief The bytes each frame may allocate, zero selects the default.
+      std::size_t frameCapacity;
+    };
+
+  public:
+    /*!
+     * \brief     Explicitly defined constructor, creates this object from the given information.
+     * \param[in] createInfo The information to create this object.
+     */
+    UniformRing(const CreateInfo& createInfo);
+
+    //! \brief Explicitly defined destructor, properly prepares this object for destruction.
+   ~UniformRing() noexcept;
+
+  private:
+    // Not allowed.
+    UniformRing(const UniformRing&) = delete;
+    UniformRing& operator=(const UniformRing&) = delete;
+
+  public:
+    /*!
+     * \brief     Starts allocating from the region of the given frame, discarding its old slices.
+     * \param[in] frameIndex The ring slot of the frame being recorded.
+     */
+    void beginFrame(std::uint32_t frameIndex);
+
+    /*!
+     * \brief     Allocates a slice of the current frame's region.
+     * \param[in] size The size of the uniform data.
+     * \return    The slice to write the data into and bind with.
+     */
+    UniformSlice allocate(std::size_t size);
+
+    /*!
+     * \brief     Copies the given value into a new slice of the current frame's region.
+     * \param[in] value The uniform data to copy.
+     * \return    The dynamic offset to bind the slice's descriptor with.
+     */
+    template<typename T>
+    std::uint32_t push(const T& value) {
+      static_assert(std::is_trivially_copyable_v<T>, "Uniform data must be trivially copyable.");
+      const auto slice = allocate(sizeof(T));
+      std::memcpy(slice.data, &value, sizeof(T));
+      return slice.offset;
+    }
+
+    /*!
+     * \brief  Gets the uniform buffer slices are allocated from.
+     * \return The buffer to point dynamic uniform buffer descriptors at, with an offset of zero.
+     */
+    const ResourceBuffer* buffer() const noexcept;
+
+    /*!
+     * \brief  Gets the alignment of every slice.
+     * \return The device's minimum uniform buffer offset alignment.
+     */
+    std::size_t alignment() const noexcept;
+
+    /*!
+     * \brief  Gets the bytes each frame may allocate.
+     * \return The size of each frame's region.
+     */
+    std::size_t frameCapacity() const noexcept;
+
+  private:
+    //! \brief The persistently mapped buffer slices are allocated from.
+    ResourceBuffer mBuffer;
+
+    //! \brief The alignment of every slice.
+    std::size_t mAlignment;
+
+    //! \brief The size of each frame's region.
+    std::size_t mFrameCapacity;
+
+    //! \brief The offset of the current frame's region.
+    std::size_t mFrameBase;
+
+    //! \brief The bytes of the current frame's region handed out.
+    std::atomic<std::size_t> mHead;
+  };
+
+}
@@ -0,0 +1,243 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "../forward.hpp"
+#include "cmdbuf.hpp"
+#include "fence.hpp"
+#include "memalc.hpp"
+#include "resbuf.hpp"
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  /*!
+   * \brief Uploads data into device local resource buffers on a dedicated transfer queue.
+   *
+   * Uploads are staged in memory of their own and gathered until submitted, so large assets can be
+   * uploaded without holding up rendering. Every submitted batch releases ownership of its
+   * destinations from the transfer family to the graphics family. Once a batch has finished
+   * executing, acquire() records the matching acquire into a graphics command buffer.
+   *
+   * Every upload returns the ticket of the batch it's part of. A ticket is ready once acquire() has
+   * acquired it, and the destination may be used by commands recorded after that point.
+   *
+   * Uploads may be made from any thread. Destinations must outlive their batches.
+   */
+  class TransferQueue final {
+  public:
+    //! \brief The information needed to create a transfer queue.
+    struct CreateInfo {
+      //! \brief The allocator staging memory is allocated from.
+      MemoryAllocator* allocator;
+
+      //! \brief The logical device the queue was created with.
+      VkDevice logicalDevice;
+
+      //! \brief The callbacks host memory is allocated through, null uses the driver's allocator.
+      const VkAllocationCallbacks* allocationCallbacks;
+
+      //! \brief The queue of the transfer family uploads are submitted to.
+      VkQueue transferQueue;
+
+      //! \brief The index of the transfer queue family.
+      std::uint32_t transferFamily;
+
+      //! \brief The index of the graphics queue family that acquires the destinations.
+      std::uint32_t graphicsFamily;
+    };
+
+  public:
+    /*!
+     * \brief     Explicitly defined constructor, creates this object from the given information.
+     * \param[in] createInfo The information to create this object.
+     */
+    TransferQueue(const CreateInfo& createInfo);
+
+    //! \brief Explicitly defined destructor, waits for every batch to finish.
+   ~TransferQueue() noexcept;
+
+  private:
+    // Not allowed.
+    TransferQueue(const TransferQueue&) = delete;
+    TransferQueue& operator=(const TransferQueue&) = delete;
+
+  public:
+    /*!
+     * \brief     Stages data and queues a copy of it into the given buffer.
+     * \param[in] destination The device local buffer to upload into.
+     * \param[in] offset The offset into the destination to upload to.
+     * \param[in] data The data to upload.
+     * \param[in] size The size of the data.
+     * \return    The ticket of the batch the upload is part of.
+     */
+    std::uint64_t upload(const ResourceBuffer* destination, VkDeviceSize offset, const void* data, VkDeviceSize size);
+
+    /*!
+     * \brief  Submits every queued upload to the transfer queue as a single batch.
+     * \return The ticket of the submitted batch, or of the last one if nothing was queued.
+     */
+    std::uint64_t submit();
+
+    /*!
+     * \brief     Records the ownership acquires of every finished batch, outside a renderpass.
+     * \param[in] commandBuffer The graphics command buffer to record into.
+     * \return    The newest ticket that is now ready.
+     */
+    std::uint64_t acquire(CommandBuffer& commandBuffer);
+
+    /*!
+     * \brief     Checks whether or not the batch of the given ticket has finished executing.
+     * \param[in] ticket The ticket of the batch, zero is always complete.
+     * \return    True if the batch and all before it have finished executing.
+     */
+    bool completed(std::uint64_t ticket) const;
+
+    /*!
+     * \brief     Checks whether or not the destinations of the given ticket have been acquired.
+     * \param[in] ticket The ticket of the batch, zero is always ready.
+     * \return    True if the destinations may be used by graphics commands.
+     */
+    bool ready(std::uint64_t ticket) const;
+
+    /*!
+     * \brief     Waits for the batch of the given ticket to finish executing, it must be submitted.
+     * \param[in] ticket The ticket of the batch.
+     */
+    void wait(std::uint64_t ticket) const;
+
+  private:
+    //! \brief Host visible memory a single upload is staged in.
+    struct Staging {
+      //! \brief The buffer the data is copied from.
+      VkBuffer buffer;
+
+      //! \brief The memory of the buffer.
+      Allocation allocation;
+    };
+
+    //! \brief An upload waiting to be submitted.
+    struct Upload {
+      //! \brief The memory the upload is staged in.
+      Staging staging;
+
+      //! \brief The buffer to copy into.
+      const ResourceBuffer* destination;
+
+      //! \brief The region to copy.
+      VkBufferCopy region;
+    };
+
+    //! \brief A submitted batch of uploads, recycled once finished.
+    struct Batch {
+      //! \brief The command buffer the batch was recorded into.
+      CommandBuffer commandBuffer;
+
+      //! \brief Signaled once the batch finishes executing.
+      Fence fence;
+
+      //! \brief The ticket of the batch.
+      std::uint64_t ticket;
+
+      //! \brief The memory the batch's uploads were staged in.
+      std::vector<Staging> staging;
+
+      //! \brief The ranges the batch released ownership of.
+      std::vector<BufferBarrier> releases;
+    };
+
+    /*!
+     * \brief     Creates host visible memory and copies the given data into it.
+     * \param[in] data The data to stage.
+     * \param[in] size The size of the data.
+     * \return    The staging buffer and its memory.
+     */
+    Staging createStaging(const void* data, VkDeviceSize size);
+
+    /*!
+     * \brief         Destroys staging memory, the GPU must no longer be using it.
+     * \param[in,out] staging The staging buffer and memory to destroy.
+     */
+    void destroyStaging(Staging& staging) noexcept;
+
+    //! \brief Recycles every finished batch, queuing its acquires, the lock must be held.
+    void retireCompleted();
+
+    /*!
+     * \brief     Finds the in flight batch of the given ticket, the lock must be held.
+     * \param[in] ticket The ticket of the batch.
+     * \return    The batch, or null if it already finished or was never submitted.
+     */
+    const Batch* findBatch(std::uint64_t ticket) const noexcept;
+
+  private:
+    //! \brief The allocator staging memory is allocated from.
+    MemoryAllocator* mAllocator;
+
+    //! \brief The logical device the queue was created with.
+    VkDevice mLogicalDevice;
+
+    //! \brief The callbacks host memory is allocated through.
+    const VkAllocationCallbacks* mAllocationCallbacks;
+
+    //! \brief The queue uploads are submitted to.
+    VkQueue mQueue;
+
+    //! \brief The index of the transfer queue family.
+    std::uint32_t mTransferFamily;
+
+    //! \brief The index of the graphics queue family.
+    std::uint32_t mGraphicsFamily;
+
+    //! \brief The command pool batches are recorded with, on the transfer family.
+    CommandPool mCommandPool;
+
+    //! \brief The uploads waiting to be submitted.
+    std::vector<Upload> mUploads;
+
+    //! \brief The submitted batches, oldest first.
+    std::deque<std::unique_ptr<Batch>> mInFlight;
+
+    //! \brief The finished batches, ready to be reused.
+    std::vector<std::unique_ptr<Batch>> mFreeBatches;
+
+    //! \brief The acquires of finished batches, waiting to be recorded.
+    std::vector<BufferBarrier> mAcquires;
+
+    //! \brief The ticket of the batch being gathered.
+    std::uint64_t mNextTicket;
+
+    //! \brief The newest ticket that finished executing.
+    std::uint64_t mCompletedTicket;
+
+    //! \brief The newest ticket whose acquires were recorded.
+    std::uint64_t mAcquiredTicket;
+
+    //! \brief Guards the queue, uploads may happen from any thread.
+    mutable std::mutex mLock;
+  };
+
+}
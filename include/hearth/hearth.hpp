@@ -20,9 +20,14 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 #pragma once
+#include "alloctracker.hpp"
 #include "application.hpp"
 #include "environment.hpp"
 #include "event.hpp"
+#include "framepacer.hpp"
+#include "profile.hpp"
+#include "scheduler.hpp"
+#include "snapshot.hpp"
 #include "version.hpp"
 #include "window.hpp"
 #include "graphics/rdrctx.hpp"
@@ -0,0 +1,208 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "config.hpp"
+
+namespace HAPI_NAMESPACE_NAME {
+
+  //! \brief Whether a profile record marks the beginning or the end of a zone.
+  enum struct ProfilePhase : std::uint8_t {
+    Begin,
+    End,
+  };
+
+  //! \brief A single timestamped event of a CPU zone.
+  struct ProfileRecord {
+    //! \brief The name of the zone, must have static storage duration.
+    const char* name;
+
+    //! \brief The time of the event, in nanoseconds since tracing started.
+    std::uint64_t timestamp;
+
+    //! \brief Whether the zone began or ended.
+    ProfilePhase phase;
+  };
+
+  /*!
+   * \brief Collects CPU zones from every thread and streams them to a Chrome trace file.
+   *
+   * Each thread that records zones gets its own fixed size ring of records, which only that thread
+   * writes to, so recording is a couple of relaxed loads and a store. A background thread drains
+   * the rings into a JSON trace that can be opened in chrome://tracing or Perfetto. When a thread
+   * records faster than the rings are drained, records are dropped rather than blocking.
+   *
+   * Zones should be recorded through the HAPI_PROFILE_ZONE() macro, which compiles to nothing
+   * unless HAPI_PROFILE is defined.
+   */
+  class Profiler final {
+  public:
+    //! \brief The number of records each thread can buffer before records are dropped.
+    static constexpr std::size_t RecordsPerThread = 16384;
+
+    //! \brief How often the background thread drains the per-thread rings.
+    static constexpr std::chrono::milliseconds FlushInterval{ 50 };
+
+  private:
+    class ThreadBuffer;
+
+  public:
+    /*!
+     * \brief  Gets the process wide profiler.
+     * \return The profiler instance.
+     */
+    static Profiler& instance() noexcept;
+
+  private:
+    //! \brief Explicitly defined default constructor.
+    Profiler() noexcept;
+
+    //! \brief Explicitly defined destructor, stops tracing if it's still running.
+   ~Profiler() noexcept;
+
+    // Not allowed.
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+  public:
+    /*!
+     * \brief     Starts tracing to the given file, replacing its contents.
+     * \param[in] filePath The path of the trace file to write.
+     */
+    void start(const char* filePath);
+
+    //! \brief Stops tracing, writing out every outstanding record and closing the trace file.
+    void stop() noexcept;
+
+    /*!
+     * \brief  Whether or not zones are currently being traced.
+     * \return True between start() and stop().
+     */
+    bool tracing() const noexcept;
+
+    /*!
+     * \brief  Gets the number of records dropped because a thread's ring was full.
+     * \return The number of dropped records since tracing started.
+     */
+    std::uint64_t droppedRecords() const noexcept;
+
+    /*!
+     * \brief     Records an event of a zone on the calling thread.
+     * \param[in] name The name of the zone, must have static storage duration.
+     * \param[in] phase Whether the zone begins or ends.
+     */
+    void record(const char* name, ProfilePhase phase) noexcept;
+
+  private:
+    /*!
+     * \brief  Gets the ring of the calling thread, registering one on first use.
+     * \return The ring of the calling thread, or null if one couldn't be allocated.
+     */
+    ThreadBuffer* threadBuffer() noexcept;
+
+    //! \brief Drains the per-thread rings periodically, until tracing stops.
+    void flushLoop() noexcept;
+
+    //! \brief Drains the per-thread rings into the trace file.
+    void flush() noexcept;
+
+  private:
+    //! \brief The rings of every thread that has recorded a zone, kept until the profiler dies.
+    std::vector<std::unique_ptr<ThreadBuffer>> mBuffers;
+
+    //! \brief Guards the list of rings and the trace file.
+    std::mutex mBuffersLock;
+
+    //! \brief The thread draining the rings.
+    std::thread mFlushThread;
+
+    //! \brief Wakes the flush thread early when tracing stops.
+    std::condition_variable mFlushSignal;
+
+    //! \brief Guards the stop request.
+    std::mutex mFlushLock;
+
+    //! \brief The trace file being written.
+    std::ofstream mFile;
+
+    //! \brief The time timestamps are relative to.
+    std::chrono::steady_clock::time_point mEpoch;
+
+    //! \brief The number of records dropped since tracing started.
+    std::atomic<std::uint64_t> mDropped;
+
+    //! \brief Whether or not zones are being traced.
+    std::atomic<bool> mTracing;
+
+    //! \brief Whether or not the flush thread has been asked to stop.
+    bool mStopping;
+
+    //! \brief Whether or not an event has been written yet, for separating events.
+    bool mFirstEvent;
+  };
+
+  //! \brief Records a CPU zone for as long as this object is in scope.
+  class ProfileZone final {
+  public:
+    /*!
+     * \brief     Explicitly defined constructor, begins the zone.
+     * \param[in] name The name of the zone, must have static storage duration.
+     */
+    explicit ProfileZone(const char* name) noexcept
+      : mName(name)
+    {
+      Profiler::instance().record(mName, ProfilePhase::Begin);
+    }
+
+    //! \brief Explicitly defined destructor, ends the zone.
+   ~ProfileZone() noexcept {
+      Profiler::instance().record(mName, ProfilePhase::End);
+    }
+
+  private:
+    // Not allowed.
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+  private:
+    //! \brief The name of the zone.
+    const char* mName;
+  };
+
+}
+
+// Zone macros, which compile to nothing unless profiling.
+#if defined(HAPI_PROFILE)
+#  define HAPI_PROFILE_CONCAT_IMPL(lhs, rhs) lhs##rhs
+#  define HAPI_PROFILE_CONCAT(lhs, rhs)      HAPI_PROFILE_CONCAT_IMPL(lhs, rhs)
+#  define HAPI_PROFILE_ZONE(name)            const ::HAPI_NAMESPACE_NAME::ProfileZone HAPI_PROFILE_CONCAT(_hapi__zone, __LINE__)(name)
+#else
+#  define HAPI_PROFILE_ZONE(name)            static_cast<void>(0)
+#endif
@@ -0,0 +1,367 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+#include "config.hpp"
+
+namespace HAPI_NAMESPACE_NAME {
+
+  class JobCounter;
+
+  /*!
+   * \brief Describes which threads a job is allowed to run on.
+   *
+   * Background jobs are long running work that no frame waits on. Only idle workers other than
+   * the main thread pick them up, never a thread waiting on a counter.
+   */
+  enum struct JobAffinity : std::uint8_t {
+    AnyThread,
+    MainThread,
+    Background,
+  };
+
+  //! \brief The signature of the function a job executes.
+  using JobFunction = void(*)(void* data);
+
+  /*!
+   * \brief Describes a unit of work for the job scheduler.
+   *
+   * Jobs must not throw, an exception escaping a job terminates the application.
+   */
+  struct Job {
+    //! \brief The function to execute.
+    JobFunction function;
+
+    //! \brief The data passed to the function, owned by the scheduling code.
+    void* data;
+
+    //! \brief The counter to decrement once the job has executed, may be null.
+    JobCounter* counter;
+
+    //! \brief The threads the job is allowed to run on.
+    JobAffinity affinity;
+  };
+
+  /*!
+   * \brief Counts the outstanding jobs of a group, so that they can be waited on or depended on.
+   *
+   * Scheduling a job with a counter increments it, and the counter is decremented once the job has
+   * executed. Jobs scheduled after a counter run once it reaches zero. A counter that jobs were
+   * scheduled with must be waited on through the scheduler before it is destroyed.
+   */
+  class JobCounter final {
+  public:
+    //! \brief The number of continuations stored without allocating.
+    static constexpr std::size_t InlineContinuations = 8;
+
+  public:
+    //! \brief Explicitly defined default constructor.
+    JobCounter() noexcept;
+
+  private:
+    // Not allowed.
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+  public:
+    /*!
+     * \brief  Gets the number of outstanding jobs.
+     * \return The current value of the counter.
+     */
+    std::uint32_t value() const noexcept;
+
+    /*!
+     * \brief  Checks whether every counted job has executed.
+     * \return True if the counter is zero.
+     */
+    bool done() const noexcept;
+
+  private:
+    friend class JobScheduler;
+
+    //! \brief The number of outstanding jobs.
+    std::atomic<std::uint32_t> mValue;
+
+    //! \brief Guards the continuations of this counter.
+    std::mutex mContinuationLock;
+
+    //! \brief The first jobs to schedule once this counter reaches zero.
+    std::array<Job, InlineContinuations> mInlineContinuations;
+
+    //! \brief The number of inline continuations in use.
+    std::size_t mInlineCount;
+
+    //! \brief The jobs to schedule once this counter reaches zero, past the inline ones.
+    std::vector<Job> mContinuations;
+  };
+
+  /*!
+   * \brief     Creates a job which calls a member function on the given object.
+   * \tparam    Method The member function to call.
+   * \param[in] object The object to call the member function on.
+   * \param[in] counter The counter to decrement once the job has executed, may be null.
+   * \param[in] affinity The threads the job is allowed to run on.
+   * \return    The job.
+   */
+  template<auto Method, typename Type>
+  Job makeMemberJob(Type* object, JobCounter* counter, JobAffinity affinity = JobAffinity::AnyThread) noexcept {
+    return Job{
+      .function = [](void* data) { (static_cast<Type*>(data)->*Method)(); },
+      .data     = object,
+      .counter  = counter,
+      .affinity = affinity
+    };
+  }
+
+  /*!
+   * \brief Schedules jobs across a pool of worker threads, balancing load by work stealing.
+   *
+   * Every worker owns a deque, jobs scheduled from a worker go into its own deque and idle workers
+   * steal from the others. The thread that creates the scheduler becomes worker zero, the main
+   * thread, which is the only one that runs jobs with main thread affinity. The main thread helps
+   * execute jobs whenever it waits on a counter.
+   *
+   * Jobs may only be scheduled from threads owned by the scheduler, including the main thread. A
+   * scheduler without workers besides the main thread runs background jobs as they're scheduled.
+   */
+  class JobScheduler final {
+  public:
+    //! \brief The number of jobs each worker's deque holds, and the number of job slots it adds at once.
+    static constexpr std::size_t MaxJobsPerWorker = 4096;
+
+    //! \brief The most chunks parallelFor() splits a range into, per worker.
+    static constexpr std::size_t ChunksPerWorker = 8;
+
+    //! \brief The information needed to create a job scheduler.
+    struct CreateInfo {
+      //! \brief The number of workers to create, including the main thread, zero uses every core.
+      std::uint32_t workerCount;
+    };
+
+  private:
+    //! \brief The state of a single worker, defined privately.
+    struct Worker;
+
+    //! \brief The storage of a scheduled job, defined privately.
+    struct JobSlot;
+
+  public:
+    /*!
+     * \brief     Explicitly defined constructor, creates this object from the given information.
+     * \param[in] createInfo The information needed to create this object.
+     *
+     * The calling thread becomes the main thread of this scheduler.
+     */
+    JobScheduler(const CreateInfo& createInfo);
+
+    //! \brief Explicitly defined destructor, stops and joins every worker thread.
+   ~JobScheduler() noexcept;
+
+  private:
+    // Not allowed.
+    JobScheduler(const JobScheduler&) = delete;
+    JobScheduler& operator=(const JobScheduler&) = delete;
+
+  public:
+    /*!
+     * \brief     Schedules a job for execution.
+     * \param[in] job The job to schedule.
+     */
+    void schedule(const Job& job);
+
+    /*!
+     * \brief     Schedules a job to execute once the given counter reaches zero.
+     * \param[in] job The job to schedule.
+     * \param[in] dependency The counter that must reach zero before the job may execute.
+     */
+    void scheduleAfter(const Job& job, JobCounter& dependency);
+
+    /*!
+     * \brief     Waits for the given counter to reach zero, executing jobs while waiting.
+     * \param[in] counter The counter to wait on.
+     */
+    void wait(JobCounter& counter);
+
+    //! \brief Executes every job currently queued for the main thread, main thread only.
+    void runMainThreadJobs();
+
+    /*!
+     * \brief     Splits a range into chunks, executes them in parallel and waits for all of them.
+     * \param[in] count The number of elements in the range.
+     * \param[in] grainSize The number of elements a single job processes, raised so that no more
+     *            than ChunksPerWorker chunks are scheduled per worker.
+     * \param[in] function Called with the begin and end of every chunk, from any worker.
+     */
+    template<typename Function>
+    void parallelFor(std::size_t count, std::size_t grainSize, Function&& function);
+
+    /*!
+     * \brief  Gets the number of workers, including the main thread.
+     * \return The worker count.
+     */
+    std::uint32_t workerCount() const noexcept;
+
+    /*!
+     * \brief  Gets the index of the calling worker.
+     * \return The worker index, zero on the main thread.
+     */
+    static std::uint32_t workerIndex();
+
+  private:
+    /*!
+     * \brief     Queues a job without touching its counter.
+     * \param[in] job The job to queue.
+     */
+    void enqueue(const Job& job);
+
+    /*!
+     * \brief     Finds a slot of the given worker whose job has started, adding slots if none has.
+     * \param[in] worker The worker scheduling the job, owned by the calling thread.
+     * \return    The free slot.
+     */
+    JobSlot* acquireSlot(Worker& worker);
+
+    /*!
+     * \brief  Tries to find and execute a single job.
+     * \return True if a job was executed.
+     */
+    bool tryExecuteJob();
+
+    /*!
+     * \brief     Executes a queued job, releasing its storage slot, and completes its counter.
+     * \param[in] slot The slot of the job to execute.
+     */
+    void execute(JobSlot* slot);
+
+    /*!
+     * \brief     Executes a job and completes its counter.
+     * \param[in] job The job to execute.
+     */
+    void run(const Job& job);
+
+    /*!
+     * \brief  Takes the oldest job off the main thread queue.
+     * \return The slot of the job, or null if the queue is empty.
+     */
+    JobSlot* popMainThreadJob();
+
+    /*!
+     * \brief  Takes the oldest job off the background queue.
+     * \return The slot of the job, or null if the queue is empty.
+     */
+    JobSlot* popBackgroundJob();
+
+    /*!
+     * \brief     The loop each worker thread runs until the scheduler is destroyed.
+     * \param[in] index The index of the worker.
+     */
+    void workerLoop(std::uint32_t index);
+
+  private:
+    //! \brief The workers of this scheduler, the first being the main thread.
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+
+    //! \brief Guards the main thread job queue.
+    std::mutex mMainThreadLock;
+
+    //! \brief Jobs waiting to execute on the main thread, used as a ring that doubles when full.
+    std::vector<JobSlot*> mMainThreadJobs;
+
+    //! \brief The number of jobs taken off the main thread queue.
+    std::size_t mMainThreadHead;
+
+    //! \brief The number of jobs put on the main thread queue.
+    std::size_t mMainThreadTail;
+
+    //! \brief Guards the background job queue.
+    std::mutex mBackgroundLock;
+
+    //! \brief Jobs waiting for an idle worker, used as a ring that doubles when full.
+    std::vector<JobSlot*> mBackgroundJobs;
+
+    //! \brief The number of jobs taken off the background queue.
+    std::size_t mBackgroundHead;
+
+    //! \brief The number of jobs put on the background queue.
+    std::size_t mBackgroundTail;
+
+    //! \brief Guards sleeping workers.
+    std::mutex mSleepLock;
+
+    //! \brief Wakes sleeping workers when new jobs arrive.
+    std::condition_variable mWakeCondition;
+
+    //! \brief The number of workers currently sleeping.
+    std::atomic<std::uint32_t> mSleepingWorkers;
+
+    //! \brief Whether or not the workers should keep running.
+    std::atomic<bool> mRunning;
+  };
+
+  template<typename Function>
+  void JobScheduler::parallelFor(std::size_t count, std::size_t grainSize, Function&& function) {
+    using FunctionType = std::remove_reference_t<Function>;
+
+    // Describes a chunk of the range.
+    struct Range {
+      FunctionType* function;
+      std::size_t   begin;
+      std::size_t   end;
+    };
+
+    // Nothing to do.
+    if (count == 0)
+      return;
+
+    // Split into chunks, coarsening them rather than flooding the workers' job storage.
+    const auto maxChunks = workerCount() * ChunksPerWorker;
+    grainSize = std::max({ grainSize, std::size_t(1), (count + maxChunks - 1) / maxChunks });
+    std::vector<Range> ranges((count + grainSize - 1) / grainSize);
+    for (std::size_t index = 0; index < ranges.size(); index++)
+      ranges[index] = Range{ &function, index * grainSize, std::min(count, (index + 1) * grainSize) };
+
+    // Schedule and wait.
+    JobCounter counter;
+    for (auto& range : ranges) {
+      schedule(Job{
+        .function = [](void* data) {
+          auto* chunk = static_cast<Range*>(data);
+          (*chunk->function)(chunk->begin, chunk->end);
+        },
+        .data     = &range,
+        .counter  = &counter,
+        .affinity = JobAffinity::AnyThread
+      });
+    }
+
+    wait(counter);
+  }
+
+}
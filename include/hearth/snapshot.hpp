@@ -0,0 +1,152 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include "config.hpp"
+
+namespace HAPI_NAMESPACE_NAME {
+
+  /*!
+   * \brief Hands snapshots from a single producer to a single consumer, without locking.
+   *
+   * The snapshots are double buffered, the producer writes snapshot N + 1 while the consumer reads
+   * snapshot N. Snapshots are consumed in order, none are skipped, and the producer waits if it
+   * would get more than one snapshot ahead of the consumer. Waiting on either side spins briefly
+   * before blocking until the other side publishes or releases, and returns null once the buffer
+   * has been stopped.
+   */
+  template<typename Type>
+  class SnapshotBuffer final {
+  public:
+    //! \brief Explicitly defined default constructor.
+    SnapshotBuffer() noexcept
+      : mSlots()
+      , mPublished(0)
+      , mReleased(0)
+      , mStopped(false)
+      , mWriteSequence(0)
+      , mReadSequence(0)
+    { }
+
+  private:
+    // Not allowed.
+    SnapshotBuffer(const SnapshotBuffer&) = delete;
+    SnapshotBuffer& operator=(const SnapshotBuffer&) = delete;
+
+  public:
+    /*!
+     * \brief  Waits for a slot to write the next snapshot into, producer only.
+     * \return The slot to write into, or null if the buffer was stopped.
+     */
+    Type* beginWrite() noexcept {
+      // The slot is free once the consumer released the snapshot two before this one.
+      const auto sequence = mWriteSequence + 1;
+      if (!waitUntil(mReleased, [&](std::uint64_t released) { return released + 2 >= sequence; }))
+        return nullptr;
+
+      return &mSlots[sequence & 1];
+    }
+
+    //! \brief Publishes the snapshot written since beginWrite(), producer only.
+    void endWrite() noexcept {
+      mPublished.store(++mWriteSequence, std::memory_order_release);
+      mPublished.notify_one();
+    }
+
+    /*!
+     * \brief  Waits for the next snapshot to be published, consumer only.
+     * \return The snapshot to read, or null if the buffer was stopped.
+     */
+    const Type* beginRead() noexcept {
+      const auto sequence = mReadSequence + 1;
+      if (!waitUntil(mPublished, [&](std::uint64_t published) { return published >= sequence; }))
+        return nullptr;
+
+      return &mSlots[sequence & 1];
+    }
+
+    //! \brief Releases the snapshot read since beginRead(), consumer only.
+    void endRead() noexcept {
+      mReleased.store(++mReadSequence, std::memory_order_release);
+      mReleased.notify_one();
+    }
+
+    //! \brief Stops the buffer, waking both sides up with nothing to read or write.
+    void stop() noexcept {
+      mStopped.store(true, std::memory_order_release);
+
+      // Blocked sides only wake up to a new value, nothing uses the sequence numbers once stopped.
+      mPublished.fetch_add(1, std::memory_order_release);
+      mReleased.fetch_add(1, std::memory_order_release);
+      mPublished.notify_one();
+      mReleased.notify_one();
+    }
+
+  private:
+    /*!
+     * \brief     Waits until the given condition holds for a sequence number, or the buffer is stopped.
+     * \param[in] sequence The sequence number the other side advances.
+     * \param[in] condition The condition to wait for, given the sequence number.
+     * \return    False if the buffer was stopped.
+     */
+    template<typename Condition>
+    bool waitUntil(const std::atomic<std::uint64_t>& sequence, Condition&& condition) const noexcept {
+      for (std::uint32_t spins = 0;; spins++) {
+        const auto observed = sequence.load(std::memory_order_acquire);
+        if (mStopped.load(std::memory_order_acquire))
+          return false;
+
+        if (condition(observed))
+          return true;
+
+        // Sleep until the other side changes the sequence number, rather than burning a core.
+        if (spins >= kSpinsBeforeWait)
+          sequence.wait(observed, std::memory_order_acquire);
+      }
+    }
+
+  private:
+    //! \brief The number of times to check a condition before blocking the thread.
+    static constexpr std::uint32_t kSpinsBeforeWait = 256;
+
+    //! \brief The two snapshot slots, alternated between.
+    std::array<Type, 2> mSlots;
+
+    //! \brief The sequence number of the latest published snapshot.
+    alignas(64) std::atomic<std::uint64_t> mPublished;
+
+    //! \brief The sequence number of the latest released snapshot.
+    alignas(64) std::atomic<std::uint64_t> mReleased;
+
+    //! \brief Whether or not the buffer was stopped.
+    std::atomic<bool> mStopped;
+
+    //! \brief The sequence number of the latest written snapshot, producer owned.
+    alignas(64) std::uint64_t mWriteSequence;
+
+    //! \brief The sequence number of the latest read snapshot, consumer owned.
+    alignas(64) std::uint64_t mReadSequence;
+  };
+
+}
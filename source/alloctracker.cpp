@@ -0,0 +1,314 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <hearth/alloctracker.hpp>
+
+#if defined(HAPI_WINDOWS_OS)
+#  include <malloc.h>
+#endif
+
+namespace HAPI_NAMESPACE_NAME {
+
+  // The phase allocations of the calling thread are attributed to, if overridden.
+  thread_local std::uint8_t tThreadPhase = AllocationTracker::NoPhase;
+
+  // How many exemptions the calling thread is in.
+  thread_local std::uint32_t tExemptionDepth = 0;
+
+  AllocationTracker::Exemption::Exemption() noexcept {
+    tExemptionDepth++;
+  }
+
+  AllocationTracker::Exemption::~Exemption() noexcept {
+    tExemptionDepth--;
+  }
+
+  AllocationTracker& AllocationTracker::instance() noexcept {
+    static AllocationTracker tracker;
+    return tracker;
+  }
+
+  bool AllocationTracker::enabled() noexcept {
+  #if defined(HAPI_TRACK_ALLOCATIONS)
+    return true;
+  #else
+    return false;
+  #endif
+  }
+
+  AllocationTracker::AllocationTracker() noexcept
+    : mPhases()
+    , mPhaseNames()
+    , mLastFrame()
+    , mFrameFrees(0)
+    , mFrame(0)
+    , mWarmupFrames(DefaultWarmupFrames)
+    , mPhase(0)
+    , mPolicy(AllocationPolicy::Ignore)
+  { }
+
+  void AllocationTracker::configure(AllocationPolicy policy, std::uint64_t warmupFrames, std::span<const char* const> phaseNames) noexcept {
+    mPolicy       = policy;
+    mWarmupFrames = warmupFrames != 0 ? warmupFrames : DefaultWarmupFrames;
+    mPhaseNames   = phaseNames;
+  }
+
+  void AllocationTracker::setPhase(std::uint8_t phase) noexcept {
+    mPhase.store(phase, std::memory_order_relaxed);
+  }
+
+  void AllocationTracker::setThreadPhase(std::uint8_t phase) noexcept {
+    tThreadPhase = phase;
+  }
+
+  void AllocationTracker::beginFrame() noexcept {
+    for (auto& phase : mPhases) {
+      phase.frameAllocations.store(0, std::memory_order_relaxed);
+      phase.frameBytes.store(0, std::memory_order_relaxed);
+    }
+
+    mFrameFrees.store(0, std::memory_order_relaxed);
+  }
+
+  void AllocationTracker::endFrame() noexcept {
+    AllocationCounts frame{ 0, 0, mFrameFrees.load(std::memory_order_relaxed) };
+    for (const auto& phase : mPhases) {
+      frame.allocations += phase.frameAllocations.load(std::memory_order_relaxed);
+      frame.bytes       += phase.frameBytes.load(std::memory_order_relaxed);
+    }
+
+    mLastFrame = frame;
+    mFrame++;
+
+    // Everything is allowed to allocate while warming up, caches and pools fill up on first use.
+    if (mPolicy == AllocationPolicy::Ignore || mFrame <= mWarmupFrames || frame.allocations == 0)
+      return;
+
+    // Report through stdio, so reporting doesn't allocate itself.
+    std::fprintf(
+      stderr, "Frame %llu allocated %llu times (%llu bytes) after warm-up.\n",
+      static_cast<unsigned long long>(mFrame),
+      static_cast<unsigned long long>(frame.allocations),
+      static_cast<unsigned long long>(frame.bytes)
+    );
+
+    for (std::size_t index = 0; index < mPhases.size(); index++) {
+      const auto allocations = mPhases[index].frameAllocations.load(std::memory_order_relaxed);
+      if (allocations == 0)
+        continue;
+
+      const auto* name = index < mPhaseNames.size() ? mPhaseNames[index] : "Unnamed";
+      std::fprintf(
+        stderr, "  %s: %llu allocations (%llu bytes).\n", name,
+        static_cast<unsigned long long>(allocations),
+        static_cast<unsigned long long>(mPhases[index].frameBytes.load(std::memory_order_relaxed))
+      );
+    }
+
+    if (mPolicy == AllocationPolicy::Abort)
+      std::abort();
+  }
+
+  AllocationCounts AllocationTracker::phaseCounts(std::uint8_t phase) const noexcept {
+    const auto& counters = mPhases[phase];
+    return AllocationCounts{
+      .allocations = counters.allocations.load(std::memory_order_relaxed),
+      .bytes       = counters.bytes.load(std::memory_order_relaxed),
+      .frees       = counters.frees.load(std::memory_order_relaxed)
+    };
+  }
+
+  AllocationCounts AllocationTracker::frameCounts() const noexcept {
+    return mLastFrame;
+  }
+
+  void AllocationTracker::recordAllocation(std::size_t size) noexcept {
+    auto& phase = currentPhase();
+    phase.allocations.fetch_add(1, std::memory_order_relaxed);
+    phase.bytes.fetch_add(size, std::memory_order_relaxed);
+    if (tExemptionDepth != 0)
+      return;
+
+    phase.frameAllocations.fetch_add(1, std::memory_order_relaxed);
+    phase.frameBytes.fetch_add(size, std::memory_order_relaxed);
+  }
+
+  void AllocationTracker::recordFree() noexcept {
+    currentPhase().frees.fetch_add(1, std::memory_order_relaxed);
+    mFrameFrees.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  AllocationTracker::PhaseCounters& AllocationTracker::currentPhase() noexcept {
+    const auto phase = tThreadPhase != NoPhase ? tThreadPhase : mPhase.load(std::memory_order_relaxed);
+    return mPhases[phase < MaxPhases ? phase : 0];
+  }
+
+}
+
+#if defined(HAPI_TRACK_ALLOCATIONS)
+/*!
+ * \brief     Allocates memory for the operator new hooks, calling the new handler until it succeeds.
+ * \param[in] size The size of the memory.
+ * \param[in] alignment The alignment of the memory, zero for the default alignment.
+ * \return    The memory, or null if there is no new handler left to call.
+ */
+static void* trackedAllocate(std::size_t size, std::size_t alignment) noexcept {
+  HAPI_NAMESPACE_NAME::AllocationTracker::instance().recordAllocation(size);
+
+  // Zero sized allocations must still return a unique pointer.
+  if (size == 0)
+    size = 1;
+
+  while (true) {
+    void* memory;
+    if (alignment == 0)
+      memory = std::malloc(size);
+    else {
+    #if defined(HAPI_WINDOWS_OS)
+      memory = _aligned_malloc(size, alignment);
+    #else
+      memory = std::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+    #endif
+    }
+
+    if (memory != nullptr)
+      return memory;
+
+    auto handler = std::get_new_handler();
+    if (handler == nullptr)
+      return nullptr;
+
+    try {
+      handler();
+    } catch (...) {
+      return nullptr;
+    }
+  }
+}
+
+/*!
+ * \brief     Frees memory allocated by trackedAllocate().
+ * \param[in] memory The memory to free, may be null.
+ * \param[in] alignment The alignment the memory was allocated with.
+ */
+static void trackedFree(void* memory, std::size_t alignment) noexcept {
+  if (memory == nullptr)
+    return;
+
+  HAPI_NAMESPACE_NAME::AllocationTracker::instance().recordFree();
+#if defined(HAPI_WINDOWS_OS)
+  if (alignment != 0) {
+    _aligned_free(memory);
+    return;
+  }
+#else
+  static_cast<void>(alignment);
+#endif
+  std::free(memory);
+}
+
+void* operator new(std::size_t size) {
+  if (auto* memory = trackedAllocate(size, 0))
+    return memory;
+  throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  if (auto* memory = trackedAllocate(size, static_cast<std::size_t>(alignment)))
+    return memory;
+  throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return trackedAllocate(size, 0);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return trackedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+  return operator new(size, alignment);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+  return operator new(size, tag);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t& tag) noexcept {
+  return operator new(size, alignment, tag);
+}
+
+void operator delete(void* memory) noexcept {
+  trackedFree(memory, 0);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+  trackedFree(memory, 0);
+}
+
+void operator delete(void* memory, std::align_val_t alignment) noexcept {
+  trackedFree(memory, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t alignment) noexcept {
+  trackedFree(memory, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+  trackedFree(memory, 0);
+}
+
+void operator delete(void* memory, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  trackedFree(memory, static_cast<std::size_t>(alignment));
+}
+
+void operator delete[](void* memory) noexcept {
+  trackedFree(memory, 0);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+  trackedFree(memory, 0);
+}
+
+void operator delete[](void* memory, std::align_val_t alignment) noexcept {
+  trackedFree(memory, static_cast<std::size_t>(alignment));
+}
+
+void operator delete[](void* memory, std::size_t, std::align_val_t alignment) noexcept {
+  trackedFree(memory, static_cast<std::size_t>(alignment));
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+  trackedFree(memory, 0);
+}
+
+void operator delete[](void* memory, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  trackedFree(memory, static_cast<std::size_t>(alignment));
+}
+#endif
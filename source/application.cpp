@@ -19,9 +19,9 @@
  * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
+#include <cstddef>
 #include <iostream>
 #include <stdexcept>
-#include <thread>
 #include <hearth/application.hpp>
 #define GLM_FORCE_RADIANS
 #include <glm/gtc/matrix_transform.hpp>
@@ -29,6 +29,19 @@
 
 namespace HAPI_NAMESPACE_NAME {
 
+  // The names of the execution phases in allocation reports, in order of the phases.
+  constexpr const char* kPhaseNames[] = {
+    "Initialization",
+    "EventPolling",
+    "Simulation",
+    "Updating",
+    "Rendering",
+    "Termination",
+  };
+
+  // The states the draw sets on its command buffer where the device allows, instead of baking them.
+  constexpr std::uint32_t kDrawDynamicStates = gfx::DynamicStateCullModeBit | gfx::DynamicStateFrontFaceBit | gfx::DynamicStateTopologyBit;
+
   // Temporary.
   struct Vertex {
     glm::fvec2 position;
@@ -46,11 +59,31 @@ namespace HAPI_NAMESPACE_NAME {
     : mTiming()
     , mCreateInfo(createInfo)
     , mExecutionState()
+    , mFramePacer(FramePacer::CreateInfo{
+        .mode            = createInfo.targetFrameRate > 0.0 ? PacingMode::TargetRate : PacingMode::Uncapped,
+        .targetFrameRate = createInfo.targetFrameRate,
+        .spinThreshold   = std::chrono::milliseconds(1)
+      })
+    , mPreviousState()
+    , mCurrentState()
   {
     // First things first, make sure the environment isn't null.
     if (createInfo.appResidency == nullptr)
       throw std::runtime_error("Expected non-null application residency.");
 
+    // Resolve simulation defaults.
+    if (createInfo.simulationRate < 0.0)
+      throw std::runtime_error("Expected non-negative simulation rate.");
+
+    if (mCreateInfo.simulationRate == 0.0)
+      mCreateInfo.simulationRate = DefaultSimulationRate;
+
+    if (mCreateInfo.maxSimulationSteps == 0)
+      mCreateInfo.maxSimulationSteps = DefaultMaxSimulationSteps;
+
+    const auto step = std::chrono::duration<double>(1.0 / mCreateInfo.simulationRate);
+    mTiming.simulationStep = std::chrono::duration_cast<Nanoseconds>(step);
+
     // Track this application.
     createInfo.appResidency->mRunningApps.push_back(this);
     EventBus::registerHandler(this, &Application::onEvent, 0);
@@ -70,6 +103,8 @@ namespace HAPI_NAMESPACE_NAME {
 
   void Application::run() noexcept {
     // Try to initialize application.
+    AllocationTracker::instance().configure(mCreateInfo.allocationPolicy, 0, kPhaseNames);
+    enterPhase(Initialization);
     try {
       initialize();
     } catch (const std::runtime_error& err) {
@@ -83,6 +118,7 @@ namespace HAPI_NAMESPACE_NAME {
     // Prepare frame execution.
     mExecutionState.running = true;
     mTiming.start           = SteadyClock::now();
+    mFramePacer.reset(mTiming.start);
 
     // Execute frames.
     while (!mExecutionState.quitting)
@@ -93,6 +129,7 @@ namespace HAPI_NAMESPACE_NAME {
     mTiming.end             = SteadyClock::now();
 
     // Terminate.
+    enterPhase(Termination);
     terminate();
   }
 
@@ -108,6 +145,49 @@ namespace HAPI_NAMESPACE_NAME {
     return mExecutionState.quitting;
   }
 
+  FramePacer& Application::framePacer() noexcept {
+    return mFramePacer;
+  }
+
+  const FramePacer& Application::framePacer() const noexcept {
+    return mFramePacer;
+  }
+
+  float Application::interpolationAlpha() const noexcept {
+    return mTiming.interpolationAlpha;
+  }
+
+  const gfx::GpuProfiler* Application::gpuProfiler() const noexcept {
+  #if defined(HAPI_PROFILE)
+    return mGpuProfiler.get();
+  #else
+    return nullptr;
+  #endif
+  }
+
+  void Application::initializeJobScheduler() {
+    // Provide job scheduler create info.
+    const JobScheduler::CreateInfo jobschCreateInfo {
+      .workerCount = mCreateInfo.workerCount
+    };
+
+    // Create job scheduler, this thread becomes its main thread.
+    mJobScheduler = std::make_unique<JobScheduler>(jobschCreateInfo);
+  }
+
+  void Application::initializeFrameArenas() {
+    // Provide linear arena create info.
+    const LinearArena::CreateInfo arenaCreateInfo {
+      .capacity = LinearArena::DefaultCapacity
+    };
+
+    // One per worker, and one for the render thread if pipelined.
+    const auto threadCount = mJobScheduler->workerCount() + (mCreateInfo.pipelinedRendering ? 1 : 0);
+    mFrameArenas.clear();
+    for (std::uint32_t index = 0; index < threadCount; index++)
+      mFrameArenas.push_back(std::make_unique<LinearArena>(arenaCreateInfo));
+  }
+
   void Application::initializeWindow() {
     // Provide window create info.
     const Window::CreateInfo wndCreateInfo {
@@ -129,28 +209,95 @@ namespace HAPI_NAMESPACE_NAME {
       throw std::runtime_error("Failed to create application window.");
   }
 
+  void Application::initializeHostAllocator() {
+    // Provide host allocator create info.
+    const gfx::HostAllocator::CreateInfo hstalcCreateInfo {
+      .slabSize = gfx::HostAllocator::DefaultSlabSize
+    };
+
+    // Create host allocator.
+    mHostAllocator = std::make_unique<gfx::HostAllocator>(hstalcCreateInfo);
+  }
+
   void Application::initializeRenderContext() {
     // Provide render context create info.
     const gfx::RenderContext::CreateInfo rdrctxCreateInfo {
-      .appName        = "Hearthfire",
-      .surface        = mMainWindow,
-      .appVersion     = Version::v1_0_0
+      .appName              = "Hearthfire",
+      .surface              = mMainWindow,
+      .appVersion           = Version::v1_0_0,
+      .allocationCallbacks  = mHostAllocator->callbacks(),
+      .pipelineCachePath    = mCreateInfo.pipelineCachePath,
+      .pipelineThreadCount  = mJobScheduler->workerCount() + (mCreateInfo.pipelinedRendering ? 1 : 0),
+      .extendedDynamicState = mCreateInfo.extendedDynamicState
     };
 
     // Create RenderContext.
     mRenderContext = std::make_unique<gfx::RenderContext>(rdrctxCreateInfo);
   }
 
+  void Application::initializeMemoryAllocator() {
+    // Provide memory allocator create info.
+    const gfx::MemoryAllocator::CreateInfo memalcCreateInfo {
+      .physicalDevice      = mRenderContext->physicalDevice(),
+      .logicalDevice       = mRenderContext->logicalDevice(),
+      .allocationCallbacks = mHostAllocator->callbacks(),
+      .blockSize           = gfx::MemoryAllocator::DefaultBlockSize,
+      .dedicatedThreshold  = 0
+    };
+
+    // Create memory allocator.
+    mMemoryAllocator = std::make_unique<gfx::MemoryAllocator>(memalcCreateInfo);
+  }
+
+  void Application::initializeDeletionQueue() {
+    // Create deletion queue.
+    mDeletionQueue = std::make_unique<gfx::DeletionQueue>();
+  }
+
+  void Application::initializeShaderLibrary() {
+    // Provide shader library create info.
+    const gfx::ShaderLibrary::CreateInfo shdlibCreateInfo {
+      .logicalDevice       = mRenderContext->logicalDevice(),
+      .allocationCallbacks = mHostAllocator->callbacks()
+    };
+
+    // Create shader library.
+    mShaderLibrary = std::make_unique<gfx::ShaderLibrary>(shdlibCreateInfo);
+  }
+
+  void Application::initializePipelineCompiler() {
+    // Provide pipeline compiler create info.
+    const gfx::PipelineCompiler::CreateInfo pipcmpCreateInfo {
+      .scheduler     = mJobScheduler.get(),
+      .pipelineCache = &mRenderContext->pipelineCache()
+    };
+
+    // Create pipeline compiler.
+    mPipelineCompiler = std::make_unique<gfx::PipelineCompiler>(pipcmpCreateInfo);
+  }
+
+  void Application::initializePipelineRegistry() {
+    // Provide pipeline registry create info.
+    const gfx::PipelineRegistry::CreateInfo pipregCreateInfo {
+      .compiler = mPipelineCompiler.get()
+    };
+
+    // Create pipeline registry.
+    mPipelineRegistry = std::make_unique<gfx::PipelineRegistry>(pipregCreateInfo);
+  }
+
   void Application::initializeSwapChain() {
     // Provide swapchain create info.
     const gfx::SwapChain::CreateInfo swpchnCreateInfo {
-      .surfacePair     = std::pair{ mMainWindow, mRenderContext->surface() },
-      .physicalDevice  = mRenderContext->physicalDevice(),
-      .logicalDevice   = mRenderContext->logicalDevice(),
-      .imageResolution = mMainWindow->size(),
-      .imageFormat     = gfx::Format::B8G8R8A8unorm,
-      .bufferStrategy  = gfx::BufferStrategy::DoubleBuffer,
-      .vsyncEnabled    = false
+      .surfacePair         = std::pair{ mMainWindow, mRenderContext->surface() },
+      .physicalDevice      = mRenderContext->physicalDevice(),
+      .logicalDevice       = mRenderContext->logicalDevice(),
+      .allocationCallbacks = mHostAllocator->callbacks(),
+      .deletionQueue       = mDeletionQueue.get(),
+      .imageResolution     = mMainWindow->size(),
+      .imageFormat         = gfx::Format::B8G8R8A8unorm,
+      .bufferStrategy      = gfx::BufferStrategy::DoubleBuffer,
+      .vsyncEnabled        = false
     };
 
     // Create swapchain.
@@ -186,9 +333,11 @@ namespace HAPI_NAMESPACE_NAME {
 
     // Provide renderpass create info.
     const gfx::RenderPass::CreateInfo rdrpssCreateInfo {
-      .attachments   = std::vector{ &colorAttachment },
-      .subpasses     = std::vector{ &subpass },
-      .logicalDevice = mRenderContext->logicalDevice()
+      .attachments         = std::vector{ &colorAttachment },
+      .subpasses           = std::vector{ &subpass },
+      .logicalDevice       = mRenderContext->logicalDevice(),
+      .allocationCallbacks = mHostAllocator->callbacks(),
+      .deletionQueue       = mDeletionQueue.get()
     };
 
     // Create renderpass.
@@ -199,14 +348,22 @@ namespace HAPI_NAMESPACE_NAME {
     // Create framebuffers.
     const auto& imageViews      = mSwapChain->imageViews();
     const auto  imageResolution = mSwapChain->imageResolution();
-    const auto  bufferStrategy  = mSwapChain->bufferStrategy();
-    for (std::size_t index = 0; index < static_cast<std::size_t>(bufferStrategy); index++) {
+    const auto  imageCount      = mSwapChain->imageCount();
+
+    // One per image the swapchain actually has, no longer tracking any frame that used one.
+    mFrameBuffers.clear();
+    mFrameBuffers.resize(imageCount);
+    mImagesInFlight.assign(imageCount, 0);
+    for (std::size_t index = 0; index < imageCount; index++) {
+
       // Provide framebuffer create info.
       const gfx::FrameBuffer::CreateInfo frmbufCreateInfo {
-        .attachments   = std::vector{ imageViews[index] },
-        .resolution    = imageResolution,
-        .logicalDevice = mRenderContext->logicalDevice(),
-        .renderPass    = mRenderPass->handle()
+        .attachments         = std::vector{ imageViews[index] },
+        .resolution          = imageResolution,
+        .logicalDevice       = mRenderContext->logicalDevice(),
+        .allocationCallbacks = mHostAllocator->callbacks(),
+        .deletionQueue       = mDeletionQueue.get(),
+        .renderPass          = mRenderPass->handle()
       };
 
       // Create framebuffer.
@@ -225,15 +382,36 @@ namespace HAPI_NAMESPACE_NAME {
 
     // Provide resource buffer create info.
     const gfx::ResourceBuffer::CreateInfo vertbuffCreateInfo {
-      .physicalDevice = mRenderContext->physicalDevice(),
-      .logicalDevice  = mRenderContext->logicalDevice(),
-      .bufferSize     = sizeof(vertices[0]) * vertices.size(),
-      .initialData    = vertices.data(),
-      .bufferUsage    = gfx::ResourceBuffer::UsageVertexBufferBit
+      .allocator           = mMemoryAllocator.get(),
+      .stagingRing         = mStagingRing.get(),
+      .deletionQueue       = mDeletionQueue.get(),
+      .logicalDevice       = mRenderContext->logicalDevice(),
+      .allocationCallbacks = mHostAllocator->callbacks(),
+      .bufferSize          = sizeof(vertices[0]) * vertices.size(),
+      .initialData         = mTransferQueue == nullptr ? vertices.data() : nullptr,
+      .bufferUsage         = gfx::ResourceBuffer::UsageVertexBufferBit,
+      .residency           = gfx::BufferResidency::DeviceLocal
     };
 
     // Create resource buffer.
     mVertexBuffer = std::make_unique<gfx::ResourceBuffer>(vertbuffCreateInfo);
+
+    // Upload on the transfer queue when there is one, instead of the frame's command buffer.
+    if (mTransferQueue != nullptr)
+      mGeometryTicket = mTransferQueue->upload(mVertexBuffer.get(), 0, vertices.data(), vertbuffCreateInfo.bufferSize);
+
+    // Provide streamable info, evicting drops the buffer until the next frame streams it back in.
+    gfx::ResidencyManager::StreamableInfo streamableInfo {
+      .memoryType = mVertexBuffer->allocation().memoryType,
+      .size       = mVertexBuffer->allocation().size,
+      .evict      = [this]() -> VkDeviceSize {
+        mVertexBuffer.reset();
+        return 0;
+      }
+    };
+
+    // Track vertex buffer.
+    mVertexResidency = mResidencyManager->track(std::move(streamableInfo));
   }
 
   void Application::initializeIndexBuffer() {
@@ -244,47 +422,53 @@ namespace HAPI_NAMESPACE_NAME {
 
     // Provide index buffer create info.
     const gfx::ResourceBuffer::CreateInfo indbufCreateInfo {
-      .physicalDevice = mRenderContext->physicalDevice(),
-      .logicalDevice  = mRenderContext->logicalDevice(),
-      .bufferSize     = sizeof(indices[0]) * indices.size(),
-      .initialData    = indices.data(),
-      .bufferUsage    = gfx::ResourceBuffer::UsageIndexBufferBit
+      .allocator           = mMemoryAllocator.get(),
+      .stagingRing         = mStagingRing.get(),
+      .deletionQueue       = mDeletionQueue.get(),
+      .logicalDevice       = mRenderContext->logicalDevice(),
+      .allocationCallbacks = mHostAllocator->callbacks(),
+      .bufferSize          = sizeof(indices[0]) * indices.size(),
+      .initialData         = mTransferQueue == nullptr ? indices.data() : nullptr,
+      .bufferUsage         = gfx::ResourceBuffer::UsageIndexBufferBit,
+      .residency           = gfx::BufferResidency::DeviceLocal
     };
 
     // Create resource buffer.
     mIndexBuffer = std::make_unique<gfx::ResourceBuffer>(indbufCreateInfo);
-  }
 
-  void Application::initializeUniformBuffer() {
-    // The data to store.
-    UniformBufferObject object;
+    // Upload on the transfer queue when there is one, instead of the frame's command buffer.
+    if (mTransferQueue != nullptr)
+      mGeometryTicket = mTransferQueue->upload(mIndexBuffer.get(), 0, indices.data(), indbufCreateInfo.bufferSize);
+  }
 
-    // Provide uniform buffer create info.
-    const gfx::ResourceBuffer::CreateInfo ufmbufCreateInfo {
-      .physicalDevice = mRenderContext->physicalDevice(),
-      .logicalDevice  = mRenderContext->logicalDevice(),
-      .bufferSize     = sizeof(UniformBufferObject),
-      .initialData    = &object,
-      .bufferUsage    = gfx::ResourceBuffer::UsageUniformBufferBit |
-                        gfx::ResourceBuffer::UsageTransferDstBit
+  void Application::initializeUniformRing() {
+    // Provide uniform ring create info, with a region for every frame in flight.
+    const gfx::UniformRing::CreateInfo ufmrngCreateInfo {
+      .allocator           = mMemoryAllocator.get(),
+      .physicalDevice      = mRenderContext->physicalDevice(),
+      .logicalDevice       = mRenderContext->logicalDevice(),
+      .allocationCallbacks = mHostAllocator->callbacks(),
+      .framesInFlight      = mFrameRing->size(),
+      .frameCapacity       = gfx::UniformRing::DefaultFrameCapacity
     };
 
-    // Create uniform buffer.
-    mUniformBuffer = std::make_unique<gfx::ResourceBuffer>(ufmbufCreateInfo);
+    // Create uniform ring.
+    mUniformRing = std::make_unique<gfx::UniformRing>(ufmrngCreateInfo);
   }
 
   void Application::initializeDescriptorPool() {
     // Provide descriptor set size information.
     const gfx::DescriptorPool::SizeInfo descSizeInfo {
       .descriptorCount = 1,
-      .descriptorType  = gfx::DescriptorType::UniformBuffer
+      .descriptorType  = gfx::DescriptorType::UniformBufferDynamic
     };
 
     // Provide descriptor pool create info.
     const gfx::DescriptorPool::CreateInfo dscpllCreateInfo {
-      .sizeInformations = std::vector{ &descSizeInfo },
-      .logicalDevice    = mRenderContext->logicalDevice(),
-      .maxSets          = 1
+      .sizeInformations    = std::vector{ &descSizeInfo },
+      .logicalDevice       = mRenderContext->logicalDevice(),
+      .allocationCallbacks = mHostAllocator->callbacks(),
+      .maxSets             = 1
     };
 
     // Create descriptor pool.
@@ -297,23 +481,24 @@ namespace HAPI_NAMESPACE_NAME {
       .binding         = 0,
       .descriptorCount = 1,
       .stages          = gfx::ShaderStageVertexBit,
-      .descriptorType  = gfx::DescriptorType::UniformBuffer
+      .descriptorType  = gfx::DescriptorType::UniformBufferDynamic
     };
 
     // Provide descriptor set layout create info.
     const gfx::DescriptorSetLayout::CreateInfo dslCreatInfo {
-      .bindings      = std::vector{ &descriptorBinding },
-      .logicalDevice = mRenderContext->logicalDevice()
+      .bindings            = std::vector{ &descriptorBinding },
+      .logicalDevice       = mRenderContext->logicalDevice(),
+      .allocationCallbacks = mHostAllocator->callbacks()
     };
 
     // Create descriptor set layout.
     mDescriptorLayout = std::make_unique<gfx::DescriptorSetLayout>(dslCreatInfo);
   }
 
-  void Application::initializeDescriptorSet() {
-    // Provide descriptor set buffer info.
+  void Application::initializeDescriptorSets() {
+    // Provide descriptor set buffer info, slices of the uniform ring are picked by dynamic offset.
     const gfx::DescriptorSet::BufferInfo dscBufferInfo {
-      .buffer       = mUniformBuffer.get(),
+      .buffer       = mUniformRing->buffer(),
       .bufferOffset = 0,
       .bufferSize   = sizeof(UniformBufferObject),
       .binding      = 0
@@ -325,7 +510,7 @@ namespace HAPI_NAMESPACE_NAME {
       .descriptorPool   = mDescriptorPool.get(),
       .descriptorLayout = mDescriptorLayout.get(),
       .logicalDevice    = mRenderContext->logicalDevice(),
-      .descriptorType   = gfx::DescriptorType::UniformBuffer
+      .descriptorType   = gfx::DescriptorType::UniformBufferDynamic
     };
 
     // Create descriptor set.
@@ -338,8 +523,9 @@ namespace HAPI_NAMESPACE_NAME {
 
     // Provide pipeline layout create info.
     const gfx::PipelineLayout::CreateInfo piplytCreateInfo {
-      .descriptorLayouts = std::vector{ descriptorLayout },
-      .logicalDevice     = mRenderContext->logicalDevice()
+      .descriptorLayouts   = std::vector{ descriptorLayout },
+      .logicalDevice       = mRenderContext->logicalDevice(),
+      .allocationCallbacks = mHostAllocator->callbacks()
     };
 
     // Create pipeline layout.
@@ -347,6 +533,10 @@ namespace HAPI_NAMESPACE_NAME {
   }
 
   void Application::initializeGraphicsPipeline() {
+    // Load shader modules, they only need to live until the pipeline is created.
+    const auto vertexShader   = mShaderLibrary->load("./resources/vert.spv");
+    const auto fragmentShader = mShaderLibrary->load("./resources/frag.spv");
+
     // Provide binding description.
     const gfx::BindingDescription bindingDesc {
       .binding = 0,
@@ -394,116 +584,350 @@ namespace HAPI_NAMESPACE_NAME {
 
     // Provide graphics pipeline create info.
     const gfx::Pipeline::CreateInfo gfxpipCreateInfo {
-      .vertexBindings   = std::vector{ &bindingDesc },
-      .vertexAttributes = std::vector{ &posAttrDesc, &colorAttrDesc },
-      .colorBlending    = &colorBlendState,
-      .layout           = mPipelineLayout.get(),
-      .base             = nullptr,
-      .logicalDevice    = mRenderContext->logicalDevice(),
-      .renderPass       = mRenderPass->handle(),
-      .subpass          = 0,
-      .lineWidth        = 1.0f,
-      .topology         = gfx::TopologyType::TriangleList,
-      .polygonMode      = gfx::PolygonMode::Fill,
-      .cullMode         = gfx::FaceCullMode::Back,
-      .frontFace        = gfx::FrontFace::CounterClockwise
+      .vertexBindings      = std::vector{ &bindingDesc },
+      .vertexAttributes    = std::vector{ &posAttrDesc, &colorAttrDesc },
+      .vertexShader        = vertexShader.get(),
+      .fragmentShader      = fragmentShader.get(),
+      .colorBlending       = &colorBlendState,
+      .layout              = mPipelineLayout.get(),
+      .base                = nullptr,
+      .allowDerivatives    = false,
+      .logicalDevice       = mRenderContext->logicalDevice(),
+      .allocationCallbacks = mHostAllocator->callbacks(),
+      .pipelineCache       = mRenderContext->pipelineCache().handle(),
+      .deletionQueue       = mDeletionQueue.get(),
+      .renderPass          = mRenderPass->handle(),
+      .subpass             = 0,
+      .dynamicStates       = mRenderContext->dynamicStateSupport() & kDrawDynamicStates,
+      .lineWidth           = 1.0f,
+      .topology            = gfx::TopologyType::TriangleList,
+      .polygonMode         = gfx::PolygonMode::Fill,
+      .cullMode            = gfx::FaceCullMode::Back,
+      .frontFace           = gfx::FrontFace::CounterClockwise
     };
 
-    // Create graphics pipeline.
-    mGraphicsPipeline = std::make_unique<gfx::Pipeline>(gfxpipCreateInfo);
+    // Compile graphics pipeline on a worker, frames skip the draw until it's ready.
+    mGraphicsPipeline = mPipelineRegistry->acquire(gfxpipCreateInfo);
   }
 
   void Application::initializeCommandPool() {
     // Provide command pool create info.
     const gfx::CommandPool::CreateInfo cmdpllCreateInfo {
-      .logicalDevice = mRenderContext->logicalDevice(),
-      .queueIndex    = mRenderContext->graphicsQueueIndex()
+      .logicalDevice       = mRenderContext->logicalDevice(),
+      .allocationCallbacks = mHostAllocator->callbacks(),
+      .queueIndex          = mRenderContext->graphicsQueueIndex()
     };
 
     // Create command pool.
     mCommandPool = std::make_unique<gfx::CommandPool>(cmdpllCreateInfo);
   }
 
-  void Application::initializeCommandBuffer() {
-    // Provide command buffer create info.
-    const gfx::CommandBuffer::CreateInfo cmdbufCreateInfo {
-      .commandPool   = mCommandPool.get(),
-      .logicalDevice = mRenderContext->logicalDevice()
+  void Application::initializeFrameRing() {
+    // Provide frame ring create info.
+    const gfx::FrameRing::CreateInfo frmrngCreateInfo {
+      .commandPool         = mCommandPool.get(),
+      .logicalDevice       = mRenderContext->logicalDevice(),
+      .allocationCallbacks = mHostAllocator->callbacks(),
+      .framesInFlight      = mCreateInfo.framesInFlight,
+      .timelineSemaphores  = mRenderContext->timelineSemaphoreSupport()
+    };
+
+    // Create frame ring, with its command buffers and synchronization objects.
+    mFrameRing = std::make_unique<gfx::FrameRing>(frmrngCreateInfo);
+  }
+
+  void Application::initializeResidencyManager() {
+    // Provide residency manager create info.
+    const gfx::ResidencyManager::CreateInfo rsdmgrCreateInfo {
+      .renderContext  = mRenderContext.get(),
+      .allocator      = mMemoryAllocator.get(),
+      .framesInFlight = mFrameRing->size(),
+      .targetUsage    = gfx::ResidencyManager::DefaultTargetUsage
+    };
+
+    // Create residency manager.
+    mResidencyManager = std::make_unique<gfx::ResidencyManager>(rsdmgrCreateInfo);
+  }
+
+  void Application::initializeStagingRing() {
+    // Provide staging ring create info.
+    const gfx::StagingRing::CreateInfo stgrngCreateInfo {
+      .allocator           = mMemoryAllocator.get(),
+      .logicalDevice       = mRenderContext->logicalDevice(),
+      .allocationCallbacks = mHostAllocator->callbacks(),
+      .frameRing           = mFrameRing.get(),
+      .capacity            = gfx::StagingRing::DefaultCapacity
+    };
+
+    // Create staging ring.
+    mStagingRing = std::make_unique<gfx::StagingRing>(stgrngCreateInfo);
+  }
+
+  void Application::initializeTransferQueue() {
+    // Nothing has been uploaded yet.
+    mGeometryTicket = 0;
+
+    // Without a transfer only family, uploads go through the staging ring instead.
+    if (!mRenderContext->transferQueueSupport())
+      return;
+
+    // Provide transfer queue create info.
+    const gfx::TransferQueue::CreateInfo xfrqueCreateInfo {
+      .allocator           = mMemoryAllocator.get(),
+      .logicalDevice       = mRenderContext->logicalDevice(),
+      .allocationCallbacks = mHostAllocator->callbacks(),
+      .transferQueue       = mRenderContext->transferQueue(),
+      .transferFamily      = mRenderContext->transferQueueIndex(),
+      .graphicsFamily      = mRenderContext->graphicsQueueIndex()
+    };
+
+    // Create transfer queue.
+    mTransferQueue = std::make_unique<gfx::TransferQueue>(xfrqueCreateInfo);
+  }
+
+  void Application::initializeCommandPoolManager() {
+    // Provide command pool manager create info.
+    const gfx::CommandPoolManager::CreateInfo cmdmgrCreateInfo {
+      .logicalDevice       = mRenderContext->logicalDevice(),
+      .allocationCallbacks = mHostAllocator->callbacks(),
+      .queueIndex          = mRenderContext->graphicsQueueIndex(),
+      .framesInFlight      = mFrameRing->size(),
+      .threadCount         = mJobScheduler->workerCount() + (mCreateInfo.pipelinedRendering ? 1 : 0)
+    };
+
+    // Create command pool manager.
+    mCommandPoolManager = std::make_unique<gfx::CommandPoolManager>(cmdmgrCreateInfo);
+  }
+
+#if defined(HAPI_PROFILE)
+  void Application::initializeGpuProfiler() {
+    // Provide GPU profiler create info.
+    const gfx::GpuProfiler::CreateInfo gpuprfCreateInfo {
+      .physicalDevice      = mRenderContext->physicalDevice(),
+      .logicalDevice       = mRenderContext->logicalDevice(),
+      .allocationCallbacks = mHostAllocator->callbacks(),
+      .queueIndex          = mRenderContext->graphicsQueueIndex(),
+      .framesInFlight      = mFrameRing->size(),
+      .maxZones            = 0,
+      .historySize         = 0
     };
 
-    // Create command buffers and semaphores.
-    mCommandBuffer = std::make_unique<gfx::CommandBuffer>(cmdbufCreateInfo);
+    // Create GPU profiler.
+    mGpuProfiler = std::make_unique<gfx::GpuProfiler>(gpuprfCreateInfo);
   }
+#endif
 
   void Application::initialize() {
+  #if defined(HAPI_PROFILE)
+    // Start tracing first, so initialization shows up in the trace.
+    if (mCreateInfo.traceFilePath != nullptr && !Profiler::instance().tracing())
+      Profiler::instance().start(mCreateInfo.traceFilePath);
+  #endif
+
+    HAPI_PROFILE_ZONE("Application::initialize");
+    initializeJobScheduler();
+    initializeFrameArenas();
     initializeWindow();
+    initializeHostAllocator();
     initializeRenderContext();
+    initializeMemoryAllocator();
+    initializeDeletionQueue();
+    initializeShaderLibrary();
+    initializePipelineCompiler();
+    initializePipelineRegistry();
     initializeSwapChain();
     initializeRenderPass();
     initializeFrameBuffers();
+    initializeCommandPool();
+    initializeFrameRing();
+    initializeResidencyManager();
+    initializeStagingRing();
+    initializeTransferQueue();
+    initializeCommandPoolManager();
+  #if defined(HAPI_PROFILE)
+    initializeGpuProfiler();
+  #endif
     initializeVertexBuffer();
     initializeIndexBuffer();
-    initializeUniformBuffer();
+    initializeUniformRing();
     initializeDescriptorPool();
     initializeDescriptorSetLayout();
-    initializeDescriptorSet();
+    initializeDescriptorSets();
     initializePipelineLayout();
     initializeGraphicsPipeline();
-    initializeCommandPool();
-    initializeCommandBuffer();
-    mWindowMinimized = false;
+    mWindowMinimized     = false;
+    mPendingWindowSize   = mSwapChain->imageResolution();
+    mResizeSerial        = 0;
+    mAppliedResizeSerial = 0;
+
+    // Start rendering on its own thread, if pipelined.
+    if (mCreateInfo.pipelinedRendering)
+      mRenderThread = std::thread(&Application::renderThreadLoop, this);
   }
 
   void Application::terminate() noexcept {
-    mCommandBuffer.reset();
+    // Stop the render thread before anything it uses goes away.
+    mSnapshots.stop();
+    if (mRenderThread.joinable())
+      mRenderThread.join();
+
+    // Frames still in flight reference everything below, let them finish first. Nothing is
+    // submitted anymore, so everything from here on is destroyed right away.
+    mFrameRing.reset();
+    mDeletionQueue->drain();
+    mTransferQueue.reset();
+  #if defined(HAPI_PROFILE)
+    mGpuProfiler.reset();
+  #endif
+    mCommandPoolManager.reset();
     mCommandPool.reset();
-    mGraphicsPipeline.reset();
+    mGraphicsPipeline = gfx::PipelineHandle();
+    mPipelineRegistry.reset();
+    mPipelineCompiler.reset();
+    mShaderLibrary.reset();
     mPipelineLayout.reset();
     mUniformDescriptorSet.reset();
     mDescriptorLayout.reset();
     mDescriptorPool.reset();
-    mUniformBuffer.reset();
+    mUniformRing.reset();
     mIndexBuffer.reset();
+    mResidencyManager->untrack(mVertexResidency);
     mVertexBuffer.reset();
+    mStagingRing.reset();
     for (auto& framebuffer : mFrameBuffers)
       framebuffer.reset();
 
     mRenderPass.reset();
     mSwapChain.reset();
+    mDeletionQueue.reset();
+    mResidencyManager.reset();
+    mMemoryAllocator.reset();
     mRenderContext.reset();
+    mHostAllocator.reset();
+    mFrameArenas.clear();
+    mJobScheduler.reset();
+
+  #if defined(HAPI_PROFILE)
+    // Write out the rest of the trace.
+    if (mCreateInfo.traceFilePath != nullptr)
+      Profiler::instance().stop();
+  #endif
+  }
+
+  void Application::enterPhase(ExecutionPhase phase) noexcept {
+    mExecutionState.phase = phase;
+    AllocationTracker::instance().setPhase(phase);
   }
 
   void Application::executeFrame() noexcept {
+    HAPI_PROFILE_ZONE("Application::executeFrame");
+    AllocationTracker::instance().beginFrame();
+
     // Get start of frame.
     const auto frameStart = SteadyClock::now();
 
-    // Poll events.
+    // Nothing from the last frame runs on the workers anymore, reclaim their transient data.
+    for (std::uint32_t index = 0; index < mJobScheduler->workerCount(); index++)
+      mFrameArenas[index]->reset();
+
+    // Express the phases of the frame as a task graph. Event polling touches the window, so it has
+    // to run on the main thread, everything else may run on any worker.
+    JobCounter polled, simulated, updated, rendered;
+    mJobScheduler->schedule(makeMemberJob<&Application::executeEventPolling>(this, &polled, JobAffinity::MainThread));
+    mJobScheduler->scheduleAfter(makeMemberJob<&Application::executeSimulation>(this, &simulated), polled);
+    mJobScheduler->scheduleAfter(makeMemberJob<&Application::executeUpdating>(this, &updated), simulated);
+    mJobScheduler->scheduleAfter(makeMemberJob<&Application::executeRendering>(this, &rendered), updated);
+    mJobScheduler->wait(rendered);
+
+    // A steady state frame shouldn't allocate, tracking builds report any that do.
+    AllocationTracker::instance().endFrame();
+
+    // Wait out the rest of the frame, if pacing to a target rate.
+    mFramePacer.wait();
+
+    // Finish off frame and increment frame count.
+    const auto frameEnd = SteadyClock::now();
+    mTiming.lastFrameDelta = frameEnd - frameStart;
+    mTiming.framesElapsed++;
+  }
+
+  void Application::executeEventPolling() noexcept {
+    HAPI_PROFILE_ZONE("Application::executeEventPolling");
+
+    enterPhase(EventPolling);
     mCreateInfo.appResidency->pollEvents();
+  }
+
+  void Application::executeSimulation() noexcept {
+    HAPI_PROFILE_ZONE("Application::executeSimulation");
+
+    // Advance the simulation at its fixed rate, decoupled from the frame rate.
+    enterPhase(Simulation);
+    simulateFixedSteps();
+  }
 
-    // Get our delta time.
-          using fsec         = std::chrono::duration<float>;
-    const auto  delta        = std::chrono::duration_cast<fsec>(mTiming.lastFrameDelta);
-    const auto  deltaElapsed = std::chrono::duration_cast<fsec>(frameStart - mTiming.start).count();
+  void Application::executeUpdating() noexcept {
+    HAPI_PROFILE_ZONE("Application::executeUpdating");
 
-    // Perform updates.
+    // Perform variable rate updates.
+    enterPhase(Updating);
     // Update(delta);
-    // Render(delta);
+  }
+
+  void Application::executeRendering() noexcept {
+    HAPI_PROFILE_ZONE("Application::executeRendering");
+
+    // Capture everything rendering needs, interpolating between the last two simulation steps.
+    enterPhase(Rendering);
+    const RenderSnapshot snapshot {
+      .rotation        = glm::mix(mPreviousState.rotation, mCurrentState.rotation, mTiming.interpolationAlpha),
+      .windowSize      = mPendingWindowSize,
+      .resizeSerial    = mResizeSerial,
+      .windowMinimized = mWindowMinimized
+    };
+
+    // Render right away, unless a render thread is doing it for us.
+    if (!mCreateInfo.pipelinedRendering) {
+      renderSnapshot(snapshot, JobScheduler::workerIndex());
+      return;
+    }
+
+    // Hand the snapshot off, this only waits if the render thread is more than a frame behind.
+    if (auto* slot = mSnapshots.beginWrite(); slot != nullptr) {
+      *slot = snapshot;
+      mSnapshots.endWrite();
+    }
+  }
+
+  void Application::renderThreadLoop() noexcept {
+    const auto threadIndex = mJobScheduler->workerCount();
+    AllocationTracker::instance().setThreadPhase(Rendering);
+    while (const auto* snapshot = mSnapshots.beginRead()) {
+      mFrameArenas[threadIndex]->reset();
+      renderSnapshot(*snapshot, threadIndex);
+      mSnapshots.endRead();
+    }
+  }
+
+  void Application::renderSnapshot(const RenderSnapshot& snapshot, std::uint32_t threadIndex) noexcept {
+    HAPI_PROFILE_ZONE("Application::renderSnapshot");
+
+    // Apply any resize requested since the last rendered snapshot.
+    if (snapshot.resizeSerial != mAppliedResizeSerial) {
+      const AllocationTracker::Exemption exemption;
+      mAppliedResizeSerial = snapshot.resizeSerial;
+      mSwapChain->reseat(snapshot.windowSize);
+      initializeFrameBuffers();
+    }
 
     UniformBufferObject ubo;
     {
       const auto extent = mSwapChain->imageResolution();
-      ubo.model = glm::rotate(glm::fmat4(1.0f), deltaElapsed * glm::radians(90.0f), glm::fvec3(0.0f, 0.0f, 1.0f));
+      ubo.model = glm::rotate(glm::fmat4(1.0f), snapshot.rotation, glm::fvec3(0.0f, 0.0f, 1.0f));
       ubo.view  = glm::lookAt(glm::fvec3(2.0f, 2.0f, 2.0f), glm::fvec3(0.0f, 0.0f, 0.0f), glm::fvec3(0.0f, 0.0f, 1.0f));
       ubo.proj  = glm::perspective(glm::radians(45.0f), static_cast<float>(extent.x) / static_cast<float>(extent.y), 0.1f, 10.0f);
     }
 
-    // Provide renderpass begin info.
-    const gfx::BeginRenderPassInfo brpi {
-      .renderPass       = mRenderPass.get(),
-      .frameBuffer      = mFrameBuffers[mTiming.framesElapsed % 2].get(),
-      .renderAreaExtent = mSwapChain->imageResolution()
-    };
-
     // Get swapchain size.
     const auto resolution = mSwapChain->imageResolution();
 
@@ -521,30 +945,146 @@ namespace HAPI_NAMESPACE_NAME {
       .extent = resolution
     };
 
-    if (!mWindowMinimized) {
-      mCommandBuffer->begin();
-      mCommandBuffer->updateBuffer(mUniformBuffer.get(), 0, &ubo, sizeof(UniformBufferObject));
-      mCommandBuffer->beginRenderPass(brpi);
-      mCommandBuffer->bindPipeline(mGraphicsPipeline.get(), gfx::PipelineBindPoint::Graphics);
-      mCommandBuffer->updateViewport(viewport);
-      mCommandBuffer->updateScissor(scissor);
-      mCommandBuffer->bindVertexBuffer(mVertexBuffer.get());
-      mCommandBuffer->bindIndexBuffer(mIndexBuffer.get());
-      mCommandBuffer->bindDescriptorSet(mUniformDescriptorSet.get(), mPipelineLayout.get());
-      mCommandBuffer->drawIndexed(6, 0, 0);
-      mCommandBuffer->endRenderPass();
-      mCommandBuffer->end();
-      mCommandBuffer->submit(mRenderContext->graphicsQueue());
-      mSwapChain->present(mRenderContext->presentQueue());
+    if (!snapshot.windowMinimized) {
+      // Only blocks if the GPU is still executing the frame that last used this slot.
+      auto& frame = mFrameRing->acquireFrame();
+
+      // The slot's last submission has finished, and so has everything destroyed before it.
+      mDeletionQueue->collect(frame.completionValue);
+      mResidencyManager->update();
+      mCommandPoolManager->beginFrame(mFrameRing->index());
+      mUniformRing->beginFrame(mFrameRing->index());
+
+      // Stream the vertex buffer back in if it was evicted, this frame draws it again.
+      if (mVertexBuffer == nullptr) {
+        const AllocationTracker::Exemption exemption;
+        initializeVertexBuffer();
+      }
+
+      // Acquire the image first, so we know which framebuffer to record into.
+      const auto imageIndex = mSwapChain->acquireNextImage(&frame.imageAvailable);
+      if (imageIndex.has_value()) {
+        // Images can be acquired out of order, wait on any older frame still rendering to it.
+        mFrameRing->wait(mImagesInFlight[*imageIndex]);
+
+        // Only profiling builds measure GPU zones, null zones record nothing.
+        gfx::GpuProfiler* gpuProfiler = nullptr;
+      #if defined(HAPI_PROFILE)
+        gpuProfiler = mGpuProfiler.get();
+        gpuProfiler->beginFrame(mFrameRing->index());
+      #endif
+
+        // Provide renderpass begin info, draws are recorded into secondary command buffers.
+        const gfx::BeginRenderPassInfo brpi {
+          .renderPass       = mRenderPass.get(),
+          .frameBuffer      = mFrameBuffers[*imageIndex].get(),
+          .renderAreaExtent = resolution,
+          .contents         = gfx::SubpassContents::SecondaryCommandBuffers
+        };
+
+        // Provide inheritance info for the secondary command buffers.
+        const gfx::InheritanceInfo inheritanceInfo {
+          .renderPass  = mRenderPass.get(),
+          .frameBuffer = mFrameBuffers[*imageIndex].get(),
+          .subpass     = 0
+        };
+
+        // Geometry uploaded on the transfer queue can only be drawn once a frame has acquired it.
+        const bool geometryReady = mTransferQueue == nullptr || mTransferQueue->ready(mGeometryTicket);
+
+        // Record draws.
+        auto& drawCommands = mCommandPoolManager->acquireSecondary(threadIndex);
+        drawCommands.begin(inheritanceInfo);
+        // Skip the draw until its pipeline has compiled, rather than stalling the frame on it.
+        const auto* pipeline = mGraphicsPipeline.get();
+        if (geometryReady && pipeline != nullptr) {
+          drawCommands.bindPipeline(pipeline, gfx::PipelineBindPoint::Graphics);
+          drawCommands.updateViewport(viewport);
+          drawCommands.updateScissor(scissor);
+          drawCommands.setCullMode(gfx::FaceCullMode::Back);
+          drawCommands.setFrontFace(gfx::FrontFace::CounterClockwise);
+          drawCommands.setPrimitiveTopology(gfx::TopologyType::TriangleList);
+          mResidencyManager->touch(mVertexResidency);
+          drawCommands.bindVertexBuffer(mVertexBuffer.get());
+          drawCommands.bindIndexBuffer(mIndexBuffer.get());
+          const std::array<std::uint32_t, 1> dynamicOffsets{ mUniformRing->push(ubo) };
+          drawCommands.bindDescriptorSet(mUniformDescriptorSet.get(), mPipelineLayout.get(), dynamicOffsets);
+          const gfx::GpuZone zone(gpuProfiler, drawCommands, "Draw Quad");
+          drawCommands.drawIndexed(6, 0, 0);
+        }
+        drawCommands.end();
+
+        // Gather the secondaries to execute, without touching the heap.
+        ArenaVector<const gfx::CommandBuffer*> secondaries{ ArenaAllocator<const gfx::CommandBuffer*>(*mFrameArenas[threadIndex]) };
+        secondaries.push_back(&drawCommands);
+
+        // Record the primary command buffer, stitching in the draws.
+        auto& commandBuffer = frame.commandBuffer;
+        commandBuffer.begin();
+        if (gpuProfiler != nullptr)
+          gpuProfiler->resetQueries(commandBuffer);
+        {
+          const gfx::GpuZone frameZone(gpuProfiler, commandBuffer, "Frame");
+          mStagingRing->flush(commandBuffer);
+          if (mTransferQueue != nullptr) {
+            mTransferQueue->submit();
+            mTransferQueue->acquire(commandBuffer);
+          }
+
+          // Timestamps can't be written inside a renderpass that executes secondary command buffers.
+          const gfx::GpuZone renderPassZone(gpuProfiler, commandBuffer, "Main Render Pass");
+          commandBuffer.beginRenderPass(brpi);
+          commandBuffer.executeCommands(secondaries);
+          commandBuffer.endRenderPass();
+        }
+        commandBuffer.end();
+
+        // Provide submit info, a single submission waits on acquisition and signals presentation.
+        const auto            completionValue = mFrameRing->prepareSubmit();
+        mDeletionQueue->advance(completionValue);
+        const auto*           timeline        = mFrameRing->timeline();
+        const gfx::SubmitInfo submitInfo {
+          .waitSemaphore     = &frame.imageAvailable,
+          .waitStages        = gfx::PipelineStageColorAttachmentOutputBit,
+          .signalSemaphore   = &frame.renderFinished,
+          .fence             = timeline == nullptr ? &frame.inFlight : nullptr,
+          .timelineSemaphore = timeline,
+          .timelineValue     = completionValue
+        };
+
+        // Submit and present.
+        mImagesInFlight[*imageIndex] = completionValue;
+        mStagingRing->retire(completionValue);
+        commandBuffer.submit(mRenderContext->graphicsQueue(), submitInfo);
+        if (!mSwapChain->present(mRenderContext->presentQueue(), *imageIndex, &frame.renderFinished))
+          initializeFrameBuffers();
+      } else {
+        // The swapchain was rebuilt, so must our framebuffers be.
+        initializeFrameBuffers();
+      }
     }
+  }
 
-    // Temporarily simulate frame execution, sleep half a frame time.
-    std::this_thread::sleep_for(std::chrono::milliseconds(6));
+  void Application::simulateFixedSteps() noexcept {
+    // Accumulate the time the last frame took, dropping what we can't catch up on.
+    const auto step = mTiming.simulationStep;
+    mTiming.accumulator = std::min(mTiming.accumulator + mTiming.lastFrameDelta, step * mCreateInfo.maxSimulationSteps);
+
+    // Consume the accumulated time in fixed steps.
+    const auto stepSeconds = std::chrono::duration<float>(step).count();
+    while (mTiming.accumulator >= step) {
+      mPreviousState = mCurrentState;
+      simulate(stepSeconds);
+      mTiming.accumulator -= step;
+      mTiming.simulationSteps++;
+    }
 
-    // Finish off frame and increment frame count.
-    const auto frameEnd = SteadyClock::now();
-    mTiming.lastFrameDelta = frameEnd - frameStart;
-    mTiming.framesElapsed++;
+    // What's left over tells rendering how far into the next step we are.
+    mTiming.interpolationAlpha = std::chrono::duration<float>(mTiming.accumulator).count() / stepSeconds;
+  }
+
+  void Application::simulate(float step) noexcept {
+    mCurrentState.rotation += step * glm::radians(90.0f);
   }
 
   void Application::onEvent(Event& evnt) {
@@ -581,9 +1121,10 @@ namespace HAPI_NAMESPACE_NAME {
       return;
     }
 
-    // Rebuild swapchain.
-    mSwapChain->reseat(evnt.windowSize());
-    initializeFrameBuffers(); // This should handle things okay.
+    // Rebuild swapchain and framebuffers the next time a frame is rendered, which may happen on
+    // the render thread.
+    mPendingWindowSize = evnt.windowSize();
+    mResizeSerial++;
     evnt.consume();
   }
 
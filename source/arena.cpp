@@ -0,0 +1,96 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <hearth/arena.hpp>
+#include <hearth/profile.hpp>
+
+namespace HAPI_NAMESPACE_NAME {
+
+  LinearArena::LinearArena(const CreateInfo& createInfo)
+    : mBlock{ nullptr, createInfo.capacity != 0 ? createInfo.capacity : DefaultCapacity, 0 }
+    , mOverflow()
+    , mUsed(0)
+  {
+    mBlock.memory = std::make_unique<std::byte[]>(mBlock.size);
+  }
+
+  void* LinearArena::allocate(std::size_t size, std::size_t alignment) {
+    // Expects.
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+      throw std::runtime_error("Expected power of two arena alignment.");
+
+    // The main block first, then the newest overflow block.
+    auto& block  = mOverflow.empty() ? mBlock : mOverflow.back();
+    auto* memory = bump(block, size, alignment);
+    if (memory == nullptr) {
+      // Spill into a new block, large enough for the allocation at any alignment.
+      auto& overflow = mOverflow.emplace_back(Block{ nullptr, std::max(mBlock.size, size + alignment), 0 });
+      overflow.memory = std::make_unique<std::byte[]>(overflow.size);
+      memory = bump(overflow, size, alignment);
+    }
+
+    mUsed += size;
+    return memory;
+  }
+
+  void LinearArena::reset() {
+    // Grow the main block to hold the whole of the last frame, so the next one doesn't overflow.
+    if (!mOverflow.empty()) {
+      HAPI_PROFILE_ZONE("LinearArena::reset");
+
+      std::size_t size = mBlock.size;
+      for (const auto& overflow : mOverflow)
+        size += overflow.size;
+
+      mOverflow.clear();
+      mBlock.memory.reset();
+      mBlock.memory = std::make_unique<std::byte[]>(size);
+      mBlock.size   = size;
+    }
+
+    mBlock.offset = 0;
+    mUsed         = 0;
+  }
+
+  std::size_t LinearArena::used() const noexcept {
+    return mUsed;
+  }
+
+  std::size_t LinearArena::capacity() const noexcept {
+    return mBlock.size;
+  }
+
+  void* LinearArena::bump(Block& block, std::size_t size, std::size_t alignment) noexcept {
+    // Align the address rather than the offset, blocks are only aligned for fundamental types.
+    const auto base    = reinterpret_cast<std::uintptr_t>(block.memory.get());
+    const auto aligned = (base + block.offset + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+    const auto offset  = static_cast<std::size_t>(aligned - base);
+    if (offset > block.size || size > block.size - offset)
+      return nullptr;
+
+    block.offset = offset + size;
+    return reinterpret_cast<void*>(aligned);
+  }
+
+}
@@ -24,6 +24,7 @@
 #include <memory>
 #include <vector>
 #include <hearth/event.hpp>
+#include <hearth/profile.hpp>
 
 namespace HAPI_NAMESPACE_NAME {
 
@@ -136,6 +137,7 @@ namespace HAPI_NAMESPACE_NAME {
      * \param[in] evnt The event that was emitted.
      */
     static void emit(Event&& evnt) noexcept {
+      HAPI_PROFILE_ZONE("EventBus::emit");
       for (auto& handler : mHandlers)
         if (!evnt.isConsumed())
           handler->notify(evnt);
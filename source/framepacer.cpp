@@ -0,0 +1,156 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <hearth/framepacer.hpp>
+#include <hearth/profile.hpp>
+
+namespace HAPI_NAMESPACE_NAME {
+
+  // Weight given to a new sleep error sample in the running calibration.
+  constexpr double kCalibrationWeight = 0.1;
+
+  // The number of mean deviations of headroom reserved on top of the mean sleep error.
+  constexpr double kCalibrationDeviations = 4.0;
+
+  FramePacer::FramePacer() noexcept
+    : mStatistics()
+    , mDeadline()
+    , mFramePeriod(0)
+    , mMinimumSpin(0)
+    , mSleepErrorMean(0.0)
+    , mSleepErrorDeviation(0.0)
+    , mTargetFrameRate(0.0)
+    , mMode(PacingMode::Uncapped)
+  { }
+
+  FramePacer::FramePacer(const CreateInfo& createInfo)
+    : mStatistics()
+    , mDeadline()
+    , mFramePeriod(0)
+    , mMinimumSpin(createInfo.spinThreshold)
+    , mSleepErrorMean(static_cast<double>(createInfo.spinThreshold.count()))
+    , mSleepErrorDeviation(0.0)
+    , mTargetFrameRate(0.0)
+    , mMode(PacingMode::Uncapped)
+  {
+    // Expects.
+    if (createInfo.spinThreshold.count() < 0)
+      throw std::runtime_error("Expected non-negative frame pacer spin threshold.");
+
+    mStatistics.spinThreshold = createInfo.spinThreshold;
+    if (createInfo.mode == PacingMode::TargetRate)
+      targetFrameRate(createInfo.targetFrameRate);
+  }
+
+  void FramePacer::reset(TimePoint start) noexcept {
+    const auto spinThreshold = mStatistics.spinThreshold;
+    mStatistics = Statistics{ };
+    mStatistics.spinThreshold = spinThreshold;
+    mDeadline = start + mFramePeriod;
+  }
+
+  void FramePacer::wait() noexcept {
+    // Nothing to wait on.
+    if (mMode == PacingMode::Uncapped)
+      return;
+
+    HAPI_PROFILE_ZONE("FramePacer::wait");
+
+    // Already late, don't try to catch up if we fell behind by more than a frame.
+    auto now = SteadyClock::now();
+    if (now >= mDeadline) {
+      mStatistics.missedFrames++;
+      mDeadline = (now - mDeadline > mFramePeriod) ? now + mFramePeriod : mDeadline + mFramePeriod;
+      return;
+    }
+
+    // Sleep through the bulk of the wait, leaving the calibrated threshold to spin on.
+    const auto remaining = mDeadline - now;
+    if (remaining > mStatistics.spinThreshold) {
+      const auto requested = remaining - mStatistics.spinThreshold;
+      std::this_thread::sleep_for(requested);
+      const auto slept = SteadyClock::now() - now;
+      calibrate(slept - requested);
+    }
+
+    // Spin off the remainder.
+    do {
+      now = SteadyClock::now();
+    } while (now < mDeadline);
+
+    // Record how late we woke up.
+    const auto oversleep = now - mDeadline;
+    const auto paced     = ++mStatistics.pacedFrames;
+    mStatistics.lastOversleep    = oversleep;
+    mStatistics.maxOversleep     = std::max(mStatistics.maxOversleep, oversleep);
+    mStatistics.averageOversleep += (oversleep - mStatistics.averageOversleep) / static_cast<std::int64_t>(paced);
+
+    // Move onto the next frame.
+    mDeadline += mFramePeriod;
+  }
+
+  void FramePacer::targetFrameRate(double targetFrameRate) {
+    // Expects.
+    if (!(targetFrameRate >= 0.0) || std::isinf(targetFrameRate))
+      throw std::runtime_error("Expected finite, non-negative target frame rate.");
+
+    mTargetFrameRate = targetFrameRate;
+    if (targetFrameRate == 0.0) {
+      mMode        = PacingMode::Uncapped;
+      mFramePeriod = Nanoseconds(0);
+      return;
+    }
+
+    // Re-anchor so the new period applies from the current frame onward.
+    const auto period = std::chrono::duration<double>(1.0 / targetFrameRate);
+    mDeadline    += std::chrono::duration_cast<Nanoseconds>(period) - mFramePeriod;
+    mFramePeriod  = std::chrono::duration_cast<Nanoseconds>(period);
+    mMode         = PacingMode::TargetRate;
+  }
+
+  double FramePacer::targetFrameRate() const noexcept {
+    return mTargetFrameRate;
+  }
+
+  PacingMode FramePacer::mode() const noexcept {
+    return mMode;
+  }
+
+  const FramePacer::Statistics& FramePacer::statistics() const noexcept {
+    return mStatistics;
+  }
+
+  void FramePacer::calibrate(Nanoseconds error) noexcept {
+    // Track mean and mean deviation of the sleep error.
+    const auto sample = static_cast<double>(error.count());
+    mSleepErrorMean      += kCalibrationWeight * (sample - mSleepErrorMean);
+    mSleepErrorDeviation += kCalibrationWeight * (std::abs(sample - mSleepErrorMean) - mSleepErrorDeviation);
+
+    // Reserve enough spin time to cover nearly every oversleep, never going below the minimum.
+    const auto threshold = Nanoseconds(static_cast<std::int64_t>(mSleepErrorMean + kCalibrationDeviations * mSleepErrorDeviation));
+    mStatistics.spinThreshold = std::max(threshold, mMinimumSpin);
+  }
+
+}
@@ -19,20 +19,191 @@
  * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
+#include <algorithm>
+#include <array>
 #include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
 #include <hearth/graphics/cmdbuf.hpp>
+#include <hearth/graphics/dltque.hpp>
+#include <hearth/profile.hpp>
 
 namespace HAPI_NAMESPACE_NAME::gfx {
 
+  // The number of handles gathered on the stack before a command is recorded.
+  constexpr std::size_t kBatchSize = 16;
+
+#if defined(VK_EXT_extended_dynamic_state)
+  static void cmdSetCullModeEXT(VkDevice logicalDevice, VkCommandBuffer commandBuffer, VkCullModeFlags cullMode) {
+    // Attempt to load function on first call.
+    static auto _vk__func = reinterpret_cast<PFN_vkCmdSetCullModeEXT>(
+      vkGetDeviceProcAddr(logicalDevice, "vkCmdSetCullModeEXT")
+    );
+
+    // Double check that the function was loaded.
+    if (_vk__func == nullptr)
+      throw std::runtime_error("Unable to load vkCmdSetCullModeEXT");
+
+    // Call function.
+    (*_vk__func)(commandBuffer, cullMode);
+  }
+
+  static void cmdSetFrontFaceEXT(VkDevice logicalDevice, VkCommandBuffer commandBuffer, VkFrontFace frontFace) {
+    // Attempt to load function on first call.
+    static auto _vk__func = reinterpret_cast<PFN_vkCmdSetFrontFaceEXT>(
+      vkGetDeviceProcAddr(logicalDevice, "vkCmdSetFrontFaceEXT")
+    );
+
+    // Double check that the function was loaded.
+    if (_vk__func == nullptr)
+      throw std::runtime_error("Unable to load vkCmdSetFrontFaceEXT");
+
+    // Call function.
+    (*_vk__func)(commandBuffer, frontFace);
+  }
+
+  static void cmdSetPrimitiveTopologyEXT(VkDevice logicalDevice, VkCommandBuffer commandBuffer, VkPrimitiveTopology topology) {
+    // Attempt to load function on first call.
+    static auto _vk__func = reinterpret_cast<PFN_vkCmdSetPrimitiveTopologyEXT>(
+      vkGetDeviceProcAddr(logicalDevice, "vkCmdSetPrimitiveTopologyEXT")
+    );
+
+    // Double check that the function was loaded.
+    if (_vk__func == nullptr)
+      throw std::runtime_error("Unable to load vkCmdSetPrimitiveTopologyEXT");
+
+    // Call function.
+    (*_vk__func)(commandBuffer, topology);
+  }
+#endif
+
+#if defined(VK_EXT_extended_dynamic_state2)
+  static void cmdSetLogicOpEXT(VkDevice logicalDevice, VkCommandBuffer commandBuffer, VkLogicOp logicOp) {
+    // Attempt to load function on first call.
+    static auto _vk__func = reinterpret_cast<PFN_vkCmdSetLogicOpEXT>(
+      vkGetDeviceProcAddr(logicalDevice, "vkCmdSetLogicOpEXT")
+    );
+
+    // Double check that the function was loaded.
+    if (_vk__func == nullptr)
+      throw std::runtime_error("Unable to load vkCmdSetLogicOpEXT");
+
+    // Call function.
+    (*_vk__func)(commandBuffer, logicOp);
+  }
+#endif
+
+#if defined(VK_EXT_extended_dynamic_state3)
+  static void cmdSetPolygonModeEXT(VkDevice logicalDevice, VkCommandBuffer commandBuffer, VkPolygonMode polygonMode) {
+    // Attempt to load function on first call.
+    static auto _vk__func = reinterpret_cast<PFN_vkCmdSetPolygonModeEXT>(
+      vkGetDeviceProcAddr(logicalDevice, "vkCmdSetPolygonModeEXT")
+    );
+
+    // Double check that the function was loaded.
+    if (_vk__func == nullptr)
+      throw std::runtime_error("Unable to load vkCmdSetPolygonModeEXT");
+
+    // Call function.
+    (*_vk__func)(commandBuffer, polygonMode);
+  }
+
+  static void cmdSetColorBlendEnableEXT(VkDevice logicalDevice, VkCommandBuffer commandBuffer, std::uint32_t firstAttachment, std::uint32_t attachmentCount, const VkBool32* pEnables) {
+    // Attempt to load function on first call.
+    static auto _vk__func = reinterpret_cast<PFN_vkCmdSetColorBlendEnableEXT>(
+      vkGetDeviceProcAddr(logicalDevice, "vkCmdSetColorBlendEnableEXT")
+    );
+
+    // Double check that the function was loaded.
+    if (_vk__func == nullptr)
+      throw std::runtime_error("Unable to load vkCmdSetColorBlendEnableEXT");
+
+    // Call function.
+    (*_vk__func)(commandBuffer, firstAttachment, attachmentCount, pEnables);
+  }
+
+  static void cmdSetColorBlendEquationEXT(VkDevice logicalDevice, VkCommandBuffer commandBuffer, std::uint32_t firstAttachment, std::uint32_t attachmentCount, const VkColorBlendEquationEXT* pEquations) {
+    // Attempt to load function on first call.
+    static auto _vk__func = reinterpret_cast<PFN_vkCmdSetColorBlendEquationEXT>(
+      vkGetDeviceProcAddr(logicalDevice, "vkCmdSetColorBlendEquationEXT")
+    );
+
+    // Double check that the function was loaded.
+    if (_vk__func == nullptr)
+      throw std::runtime_error("Unable to load vkCmdSetColorBlendEquationEXT");
+
+    // Call function.
+    (*_vk__func)(commandBuffer, firstAttachment, attachmentCount, pEquations);
+  }
+
+  static void cmdSetColorWriteMaskEXT(VkDevice logicalDevice, VkCommandBuffer commandBuffer, std::uint32_t firstAttachment, std::uint32_t attachmentCount, const VkColorComponentFlags* pMasks) {
+    // Attempt to load function on first call.
+    static auto _vk__func = reinterpret_cast<PFN_vkCmdSetColorWriteMaskEXT>(
+      vkGetDeviceProcAddr(logicalDevice, "vkCmdSetColorWriteMaskEXT")
+    );
+
+    // Double check that the function was loaded.
+    if (_vk__func == nullptr)
+      throw std::runtime_error("Unable to load vkCmdSetColorWriteMaskEXT");
+
+    // Call function.
+    (*_vk__func)(commandBuffer, firstAttachment, attachmentCount, pMasks);
+  }
+#endif
+
+  static bool trackState(DynamicStateTracker& tracker, std::uint32_t state, bool unchanged) noexcept {
+    // Baked into the bound pipeline, the extension providing it may not even be enabled.
+    if ((tracker.dynamicStates & state) == 0)
+      return false;
+
+    // Already set to this value.
+    if ((tracker.knownStates & state) != 0 && unchanged)
+      return false;
+
+    tracker.knownStates |= state;
+    return true;
+  }
+
+  template<typename Apply>
+  static bool trackAttachments(DynamicStateTracker& tracker, std::uint32_t state, std::uint8_t& known, std::uint32_t firstAttachment, std::span<const ColorBlendAttachment* const> attachments, Apply apply) {
+    // Expects.
+    if (firstAttachment + attachments.size() > kMaxColorAttachments)
+      throw std::runtime_error("Cannot set dynamic blend state past the last color attachment.");
+
+    // Expects.
+    for (const auto* attachment : attachments)
+      if (attachment == nullptr)
+        throw std::runtime_error("Cannot set dynamic blend state from null color blend attachment.");
+
+    // Baked into the bound pipeline.
+    if ((tracker.dynamicStates & state) == 0)
+      return false;
+
+    // Record every attachment, only setting the state if one of them changes.
+    bool changed = false;
+    for (std::size_t index = 0; index < attachments.size(); index++) {
+      const auto bit = static_cast<std::uint8_t>(1u << (firstAttachment + index));
+      changed = apply(tracker.attachments[firstAttachment + index], *attachments[index]) || (known & bit) == 0 || changed;
+      known  |= bit;
+    }
+
+    return changed;
+  }
+
   CommandPool::CommandPool() noexcept
     : mLogicalDevice(nullptr)
+    , mAllocationCallbacks(nullptr)
     , mCommandPool(nullptr)
   { }
 
   CommandPool::CommandPool(const CreateInfo& createInfo)
     : mLogicalDevice(createInfo.logicalDevice)
+    , mAllocationCallbacks(createInfo.allocationCallbacks)
     , mCommandPool(nullptr)
   {
+    HAPI_PROFILE_ZONE("gfx::CommandPool::CommandPool");
+
     VkCommandPoolCreateInfo poolInfo;
     {
       poolInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
@@ -41,7 +212,7 @@ namespace HAPI_NAMESPACE_NAME::gfx {
       poolInfo.queueFamilyIndex = createInfo.queueIndex;
     }
 
-    if (vkCreateCommandPool(mLogicalDevice, &poolInfo, nullptr, &mCommandPool) != VK_SUCCESS)
+    if (vkCreateCommandPool(mLogicalDevice, &poolInfo, mAllocationCallbacks, &mCommandPool) != VK_SUCCESS)
       throw std::runtime_error("Failed to create command pool.");
   }
 
@@ -50,22 +221,27 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     if (mCommandPool == nullptr)
       return;
 
+    HAPI_PROFILE_ZONE("gfx::CommandPool::~CommandPool");
+
     // Delete.
-    vkDestroyCommandPool(mLogicalDevice, mCommandPool, nullptr);
+    vkDestroyCommandPool(mLogicalDevice, mCommandPool, mAllocationCallbacks);
   }
 
   CommandPool::CommandPool(CommandPool&& other) noexcept
     : mLogicalDevice(std::move(other.mLogicalDevice))
+    , mAllocationCallbacks(std::move(other.mAllocationCallbacks))
     , mCommandPool(std::move(other.mCommandPool))
   {
     // Ensures.
-    other.mLogicalDevice = nullptr;
-    other.mCommandPool   = nullptr;
+    other.mLogicalDevice       = nullptr;
+    other.mAllocationCallbacks = nullptr;
+    other.mCommandPool         = nullptr;
   }
 
   CommandPool& CommandPool::operator=(CommandPool&& other) noexcept {
-    std::swap(mLogicalDevice, other.mLogicalDevice);
-    std::swap(mCommandPool,   other.mCommandPool);
+    std::swap(mLogicalDevice,       other.mLogicalDevice);
+    std::swap(mAllocationCallbacks, other.mAllocationCallbacks);
+    std::swap(mCommandPool,         other.mCommandPool);
     return *this;
   }
 
@@ -73,20 +249,32 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     return mCommandPool;
   }
 
+  void CommandPool::reset() {
+    VkResult result = vkResetCommandPool(mLogicalDevice, mCommandPool, 0);
+    if (result != VK_SUCCESS)
+      throw std::runtime_error("Failed to reset command pool.");
+  }
+
   CommandBuffer::CommandBuffer() noexcept
     : mLogicalDevice(nullptr)
+    , mDeletionQueue(nullptr)
     , mCommandPool(nullptr)
     , mCommandBuffer(nullptr)
-    , mRecordingFence(nullptr)
+    , mLevel(CommandBufferLevel::Primary)
+    , mDynamicState()
   {
   }
 
   CommandBuffer::CommandBuffer(const CreateInfo& createInfo)
     : mLogicalDevice(createInfo.logicalDevice)
+    , mDeletionQueue(createInfo.deletionQueue)
     , mCommandPool(nullptr)
     , mCommandBuffer(nullptr)
-    , mRecordingFence(nullptr)
+    , mLevel(createInfo.level)
+    , mDynamicState()
   {
+    HAPI_PROFILE_ZONE("gfx::CommandBuffer::CommandBuffer");
+
     // Except.
     if (createInfo.commandPool == nullptr)
       throw std::runtime_error("Cannot create command buffer from null command pool.");
@@ -100,7 +288,7 @@ namespace HAPI_NAMESPACE_NAME::gfx {
       allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
       allocInfo.pNext              = nullptr;
       allocInfo.commandPool        = mCommandPool;
-      allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+      allocInfo.level              = mLevel == CommandBufferLevel::Primary ? VK_COMMAND_BUFFER_LEVEL_PRIMARY : VK_COMMAND_BUFFER_LEVEL_SECONDARY;
       allocInfo.commandBufferCount = 1;
     }
 
@@ -108,19 +296,6 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     VkResult result = vkAllocateCommandBuffers(mLogicalDevice, &allocInfo, &mCommandBuffer);
     if (result != VK_SUCCESS)
       throw std::runtime_error("Failed to create command buffer.");
-
-    // Provide fence creation info.
-    VkFenceCreateInfo fenceCreateInfo;
-    {
-      fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-      fenceCreateInfo.pNext = nullptr;
-      fenceCreateInfo.flags = 0;
-    }
-
-    // Create fence.
-    result = vkCreateFence(mLogicalDevice, &fenceCreateInfo, nullptr, &mRecordingFence);
-    if (result != VK_SUCCESS)
-      throw std::runtime_error("Failed to create recording fence.");
   }
 
   CommandBuffer::~CommandBuffer() noexcept {
@@ -128,37 +303,46 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     if (mCommandBuffer == nullptr)
       return;
 
-    // Wait for device then destroy fence.
+    HAPI_PROFILE_ZONE("gfx::CommandBuffer::~CommandBuffer");
+
+    // Free once the GPU is done with it, the pool must outlive the queue's deleters.
+    if (mDeletionQueue != nullptr) {
+      mDeletionQueue->enqueue([logicalDevice = mLogicalDevice, commandPool = mCommandPool, commandBuffer = mCommandBuffer] {
+        vkFreeCommandBuffers(logicalDevice, commandPool, 1, &commandBuffer);
+      });
+      return;
+    }
+
+    // Wait for device then free.
     vkDeviceWaitIdle(mLogicalDevice);
-    vkDestroyFence(mLogicalDevice, mRecordingFence, nullptr);
     vkFreeCommandBuffers(mLogicalDevice, mCommandPool, 1, &mCommandBuffer);
   }
 
   CommandBuffer::CommandBuffer(CommandBuffer&& other) noexcept
     : mLogicalDevice(std::move(other.mLogicalDevice))
+    , mDeletionQueue(std::move(other.mDeletionQueue))
     , mCommandPool(std::move(other.mCommandPool))
     , mCommandBuffer(std::move(other.mCommandBuffer))
-    , mRecordingFence(std::move(other.mRecordingFence))
+    , mLevel(other.mLevel)
+    , mDynamicState(other.mDynamicState)
   {
-    other.mLogicalDevice  = nullptr;
-    other.mCommandPool    = nullptr;
-    other.mCommandBuffer  = nullptr;
-    other.mRecordingFence = nullptr;
+    other.mLogicalDevice = nullptr;
+    other.mDeletionQueue = nullptr;
+    other.mCommandPool   = nullptr;
+    other.mCommandBuffer = nullptr;
   }
 
   CommandBuffer& CommandBuffer::operator=(CommandBuffer&& other) noexcept {
-    std::swap(mLogicalDevice,  other.mLogicalDevice);
-    std::swap(mCommandPool,    other.mCommandPool);
-    std::swap(mCommandBuffer,  other.mCommandBuffer);
-    std::swap(mRecordingFence, other.mRecordingFence);
+    std::swap(mLogicalDevice, other.mLogicalDevice);
+    std::swap(mDeletionQueue, other.mDeletionQueue);
+    std::swap(mCommandPool,   other.mCommandPool);
+    std::swap(mCommandBuffer, other.mCommandBuffer);
+    std::swap(mLevel,         other.mLevel);
+    std::swap(mDynamicState,  other.mDynamicState);
     return *this;
   }
 
   void CommandBuffer::begin() {
-    // Wait for fence.
-    vkWaitForFences(mLogicalDevice, 1, &mRecordingFence, VK_TRUE, UINT64_MAX);
-    vkResetFences(mLogicalDevice, 1, &mRecordingFence);
-
     VkCommandBufferBeginInfo cmdBeginInfo;
     {
       cmdBeginInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -170,6 +354,47 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     VkResult result = vkBeginCommandBuffer(mCommandBuffer, &cmdBeginInfo);
     if (result != VK_SUCCESS)
       throw std::runtime_error("Failed to begin command buffer recording.");
+
+    // Nothing carries over from the last recording.
+    mDynamicState = DynamicStateTracker();
+  }
+
+  void CommandBuffer::begin(const InheritanceInfo& inheritanceInfo) {
+    // Expects.
+    if (mLevel != CommandBufferLevel::Secondary)
+      throw std::runtime_error("Cannot inherit renderpass state in a primary command buffer.");
+
+    // Expects.
+    if (inheritanceInfo.renderPass == nullptr)
+      throw std::runtime_error("Cannot continue renderpass on null RenderPass.");
+
+    VkCommandBufferInheritanceInfo cmdInheritanceInfo;
+    {
+      cmdInheritanceInfo.sType                = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+      cmdInheritanceInfo.pNext                = nullptr;
+      cmdInheritanceInfo.renderPass           = inheritanceInfo.renderPass->handle();
+      cmdInheritanceInfo.subpass              = inheritanceInfo.subpass;
+      cmdInheritanceInfo.framebuffer          = inheritanceInfo.frameBuffer != nullptr ? inheritanceInfo.frameBuffer->handle() : VK_NULL_HANDLE;
+      cmdInheritanceInfo.occlusionQueryEnable = VK_FALSE;
+      cmdInheritanceInfo.queryFlags           = 0;
+      cmdInheritanceInfo.pipelineStatistics   = 0;
+    }
+
+    VkCommandBufferBeginInfo cmdBeginInfo;
+    {
+      cmdBeginInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+      cmdBeginInfo.pNext            = nullptr;
+      cmdBeginInfo.flags            = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT |
+                                      VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+      cmdBeginInfo.pInheritanceInfo = &cmdInheritanceInfo;
+    }
+
+    VkResult result = vkBeginCommandBuffer(mCommandBuffer, &cmdBeginInfo);
+    if (result != VK_SUCCESS)
+      throw std::runtime_error("Failed to begin secondary command buffer recording.");
+
+    // Nothing is inherited from the primary command buffer.
+    mDynamicState = DynamicStateTracker();
   }
 
   void CommandBuffer::end() {
@@ -178,23 +403,50 @@ namespace HAPI_NAMESPACE_NAME::gfx {
       throw std::runtime_error("Failed to end command buffer recording.");
   }
 
-  void CommandBuffer::submit(VkQueue queue) {
+  void CommandBuffer::submit(VkQueue queue, const SubmitInfo& submitInfo) {
+    // Gather synchronization primitives.
+    const VkSemaphore          waitSemaphore   = submitInfo.waitSemaphore   != nullptr ? submitInfo.waitSemaphore->handle()   : VK_NULL_HANDLE;
+    const VkPipelineStageFlags waitStages      = static_cast<VkPipelineStageFlags>(submitInfo.waitStages);
+    const VkFence              fence           = submitInfo.fence           != nullptr ? submitInfo.fence->handle()           : VK_NULL_HANDLE;
+
+    // Binary and timeline semaphores are signaled together, the binary semaphore's value is ignored.
+    std::array<VkSemaphore, 2>   signalSemaphores { };
+    std::array<std::uint64_t, 2> signalValues { };
+    std::uint32_t                signalCount = 0;
+    if (submitInfo.signalSemaphore != nullptr)
+      signalSemaphores[signalCount++] = submitInfo.signalSemaphore->handle();
+    if (submitInfo.timelineSemaphore != nullptr) {
+      signalValues[signalCount]       = submitInfo.timelineValue;
+      signalSemaphores[signalCount++] = submitInfo.timelineSemaphore->handle();
+    }
+
+    // Provide timeline submit info, only chained if a timeline semaphore is signaled.
+    VkTimelineSemaphoreSubmitInfoKHR timelineSubmitInfo;
+    {
+      timelineSubmitInfo.sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+      timelineSubmitInfo.pNext                     = nullptr;
+      timelineSubmitInfo.waitSemaphoreValueCount   = 0;
+      timelineSubmitInfo.pWaitSemaphoreValues      = nullptr;
+      timelineSubmitInfo.signalSemaphoreValueCount = signalCount;
+      timelineSubmitInfo.pSignalSemaphoreValues    = signalValues.data();
+    }
+
     // Provide submit info.
-    VkSubmitInfo submitInfo;
+    VkSubmitInfo vkSubmitInfo;
     {
-      submitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-      submitInfo.pNext                = nullptr;
-      submitInfo.waitSemaphoreCount   = 0;
-      submitInfo.pWaitSemaphores      = nullptr;
-      submitInfo.pWaitDstStageMask    = nullptr;
-      submitInfo.commandBufferCount   = 1;
-      submitInfo.pCommandBuffers      = &mCommandBuffer;
-      submitInfo.signalSemaphoreCount = 0;
-      submitInfo.pSignalSemaphores    = nullptr;
+      vkSubmitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+      vkSubmitInfo.pNext                = submitInfo.timelineSemaphore != nullptr ? &timelineSubmitInfo : nullptr;
+      vkSubmitInfo.waitSemaphoreCount   = submitInfo.waitSemaphore != nullptr ? 1 : 0;
+      vkSubmitInfo.pWaitSemaphores      = &waitSemaphore;
+      vkSubmitInfo.pWaitDstStageMask    = &waitStages;
+      vkSubmitInfo.commandBufferCount   = 1;
+      vkSubmitInfo.pCommandBuffers      = &mCommandBuffer;
+      vkSubmitInfo.signalSemaphoreCount = signalCount;
+      vkSubmitInfo.pSignalSemaphores    = signalSemaphores.data();
     }
 
     // Try and submit queue.
-    VkResult result = vkQueueSubmit(queue, 1, &submitInfo, mRecordingFence);
+    VkResult result = vkQueueSubmit(queue, 1, &vkSubmitInfo, fence);
     if (result != VK_SUCCESS)
       throw std::runtime_error("Failed to submit command buffer to queue.");
   }
@@ -208,6 +460,81 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     vkCmdUpdateBuffer(mCommandBuffer, buffer->handle(), offset, dataSize, data);
   }
 
+  void CommandBuffer::copyBuffer(const ResourceBuffer* source, const ResourceBuffer* destination, std::span<const VkBufferCopy> regions) {
+    // Expects.
+    if (source == nullptr || destination == nullptr)
+      throw std::runtime_error("Cannot copy between null resource buffers.");
+
+    // Copy.
+    vkCmdCopyBuffer(
+      mCommandBuffer,
+      source->handle(),
+      destination->handle(),
+      static_cast<std::uint32_t>(regions.size()),
+      regions.data()
+    );
+  }
+
+  void CommandBuffer::memoryBarrier(std::uint32_t sourceStages, VkAccessFlags sourceAccess, std::uint32_t destinationStages, VkAccessFlags destinationAccess) {
+    // Provide barrier.
+    VkMemoryBarrier barrier;
+    {
+      barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+      barrier.pNext         = nullptr;
+      barrier.srcAccessMask = sourceAccess;
+      barrier.dstAccessMask = destinationAccess;
+    }
+
+    // Perform command.
+    vkCmdPipelineBarrier(mCommandBuffer, sourceStages, destinationStages, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+  }
+
+  void CommandBuffer::bufferBarrier(std::uint32_t sourceStages, std::uint32_t destinationStages, std::span<const BufferBarrier> barriers) {
+    // Provide barriers, recording a command per full batch.
+    std::array<VkBufferMemoryBarrier, kBatchSize> bufferBarriers;
+    std::size_t                                    count = 0;
+    for (std::size_t index = 0; index < barriers.size(); index++) {
+      const auto& barrier = barriers[index];
+
+      // Expects.
+      if (barrier.buffer == nullptr)
+        throw std::runtime_error("Cannot synchronize null resource buffer.");
+
+      VkBufferMemoryBarrier bufferBarrier;
+      {
+        bufferBarrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        bufferBarrier.pNext               = nullptr;
+        bufferBarrier.srcAccessMask       = barrier.sourceAccess;
+        bufferBarrier.dstAccessMask       = barrier.destinationAccess;
+        bufferBarrier.srcQueueFamilyIndex = barrier.sourceQueueFamily;
+        bufferBarrier.dstQueueFamilyIndex = barrier.destinationQueueFamily;
+        bufferBarrier.buffer              = barrier.buffer->handle();
+        bufferBarrier.offset              = barrier.offset;
+        bufferBarrier.size                = barrier.size;
+      }
+
+      bufferBarriers[count++] = bufferBarrier;
+      if (count < kBatchSize && index + 1 < barriers.size())
+        continue;
+
+      // Perform command.
+      vkCmdPipelineBarrier(
+        mCommandBuffer,
+        sourceStages,
+        destinationStages,
+        0,
+        0,
+        nullptr,
+        static_cast<std::uint32_t>(count),
+        bufferBarriers.data(),
+        0,
+        nullptr
+      );
+
+      count = 0;
+    }
+  }
+
   void CommandBuffer::updateViewport(const Viewport& viewport) {
     // Provide new viewport.
     VkViewport newViewport;
@@ -236,6 +563,155 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     vkCmdSetScissor(mCommandBuffer, 0, 1, &newScissor);
   }
 
+  void CommandBuffer::setLineWidth(float lineWidth) {
+    if (!trackState(mDynamicState, DynamicStateLineWidthBit, mDynamicState.lineWidth == lineWidth))
+      return;
+
+    // Perform command.
+    mDynamicState.lineWidth = lineWidth;
+    vkCmdSetLineWidth(mCommandBuffer, lineWidth);
+  }
+
+  void CommandBuffer::setBlendConstants(const float blendConstants[4]) {
+    if (!trackState(mDynamicState, DynamicStateBlendConstantsBit, std::equal(blendConstants, blendConstants + 4, mDynamicState.blendConstants)))
+      return;
+
+    // Perform command.
+    std::copy_n(blendConstants, 4, mDynamicState.blendConstants);
+    vkCmdSetBlendConstants(mCommandBuffer, blendConstants);
+  }
+
+  void CommandBuffer::setCullMode(FaceCullMode cullMode) {
+    if (!trackState(mDynamicState, DynamicStateCullModeBit, mDynamicState.cullMode == cullMode))
+      return;
+
+    // Perform command.
+    mDynamicState.cullMode = cullMode;
+#if defined(VK_EXT_extended_dynamic_state)
+    cmdSetCullModeEXT(mLogicalDevice, mCommandBuffer, static_cast<VkCullModeFlags>(cullMode));
+#endif
+  }
+
+  void CommandBuffer::setFrontFace(FrontFace frontFace) {
+    if (!trackState(mDynamicState, DynamicStateFrontFaceBit, mDynamicState.frontFace == frontFace))
+      return;
+
+    // Perform command.
+    mDynamicState.frontFace = frontFace;
+#if defined(VK_EXT_extended_dynamic_state)
+    cmdSetFrontFaceEXT(mLogicalDevice, mCommandBuffer, static_cast<VkFrontFace>(frontFace));
+#endif
+  }
+
+  void CommandBuffer::setPrimitiveTopology(TopologyType topology) {
+    if (!trackState(mDynamicState, DynamicStateTopologyBit, mDynamicState.topology == topology))
+      return;
+
+    // Perform command.
+    mDynamicState.topology = topology;
+#if defined(VK_EXT_extended_dynamic_state)
+    cmdSetPrimitiveTopologyEXT(mLogicalDevice, mCommandBuffer, static_cast<VkPrimitiveTopology>(topology));
+#endif
+  }
+
+  void CommandBuffer::setPolygonMode(PolygonMode polygonMode) {
+    if (!trackState(mDynamicState, DynamicStatePolygonModeBit, mDynamicState.polygonMode == polygonMode))
+      return;
+
+    // Perform command.
+    mDynamicState.polygonMode = polygonMode;
+#if defined(VK_EXT_extended_dynamic_state3)
+    cmdSetPolygonModeEXT(mLogicalDevice, mCommandBuffer, static_cast<VkPolygonMode>(polygonMode));
+#endif
+  }
+
+  void CommandBuffer::setLogicOp(LogicOp logicOp) {
+    if (!trackState(mDynamicState, DynamicStateLogicOpBit, mDynamicState.logicOp == logicOp))
+      return;
+
+    // Perform command.
+    mDynamicState.logicOp = logicOp;
+#if defined(VK_EXT_extended_dynamic_state2)
+    cmdSetLogicOpEXT(mLogicalDevice, mCommandBuffer, static_cast<VkLogicOp>(logicOp));
+#endif
+  }
+
+  void CommandBuffer::setColorBlendEnable(std::uint32_t firstAttachment, std::span<const ColorBlendAttachment* const> attachments) {
+    bool changed = trackAttachments(mDynamicState, DynamicStateColorBlendEnableBit, mDynamicState.knownBlendEnables, firstAttachment, attachments, [](auto& tracked, const auto& attachment) {
+      return std::exchange(tracked.blendEnabled, attachment.blendEnabled) != attachment.blendEnabled;
+    });
+
+    if (!changed)
+      return;
+
+#if defined(VK_EXT_extended_dynamic_state3)
+    // Provide blend enables.
+    std::array<VkBool32, kMaxColorAttachments> blendEnables;
+    for (std::size_t index = 0; index < attachments.size(); index++)
+      blendEnables[index] = attachments[index]->blendEnabled ? VK_TRUE : VK_FALSE;
+
+    // Perform command.
+    cmdSetColorBlendEnableEXT(mLogicalDevice, mCommandBuffer, firstAttachment, static_cast<std::uint32_t>(attachments.size()), blendEnables.data());
+#endif
+  }
+
+  void CommandBuffer::setColorBlendEquation(std::uint32_t firstAttachment, std::span<const ColorBlendAttachment* const> attachments) {
+    bool changed = trackAttachments(mDynamicState, DynamicStateColorBlendEquationBit, mDynamicState.knownBlendEquations, firstAttachment, attachments, [](auto& tracked, const auto& attachment) {
+      auto equation = [](auto& blend) {
+        return std::tie(blend.srcColorFactor, blend.dstColorFactor, blend.colorOp, blend.srcAlphaFactor, blend.dstAlphaFactor, blend.alphaOp);
+      };
+
+      bool differs = equation(tracked) != equation(attachment);
+      equation(tracked) = equation(attachment);
+      return differs;
+    });
+
+    if (!changed)
+      return;
+
+#if defined(VK_EXT_extended_dynamic_state3)
+    // Provide blend equations.
+    std::array<VkColorBlendEquationEXT, kMaxColorAttachments> blendEquations;
+    for (std::size_t index = 0; index < attachments.size(); index++) {
+      const auto* attachment = attachments[index];
+
+      VkColorBlendEquationEXT blendEquation;
+      {
+        blendEquation.srcColorBlendFactor = static_cast<VkBlendFactor>(attachment->srcColorFactor);
+        blendEquation.dstColorBlendFactor = static_cast<VkBlendFactor>(attachment->dstColorFactor);
+        blendEquation.colorBlendOp        = static_cast<VkBlendOp>(attachment->colorOp);
+        blendEquation.srcAlphaBlendFactor = static_cast<VkBlendFactor>(attachment->srcAlphaFactor);
+        blendEquation.dstAlphaBlendFactor = static_cast<VkBlendFactor>(attachment->dstAlphaFactor);
+        blendEquation.alphaBlendOp        = static_cast<VkBlendOp>(attachment->alphaOp);
+      }
+
+      blendEquations[index] = blendEquation;
+    }
+
+    // Perform command.
+    cmdSetColorBlendEquationEXT(mLogicalDevice, mCommandBuffer, firstAttachment, static_cast<std::uint32_t>(attachments.size()), blendEquations.data());
+#endif
+  }
+
+  void CommandBuffer::setColorWriteMask(std::uint32_t firstAttachment, std::span<const ColorBlendAttachment* const> attachments) {
+    bool changed = trackAttachments(mDynamicState, DynamicStateColorWriteMaskBit, mDynamicState.knownWriteMasks, firstAttachment, attachments, [](auto& tracked, const auto& attachment) {
+      return std::exchange(tracked.colorWriteMask, attachment.colorWriteMask) != attachment.colorWriteMask;
+    });
+
+    if (!changed)
+      return;
+
+#if defined(VK_EXT_extended_dynamic_state3)
+    // Provide write masks.
+    std::array<VkColorComponentFlags, kMaxColorAttachments> writeMasks;
+    for (std::size_t index = 0; index < attachments.size(); index++)
+      writeMasks[index] = attachments[index]->colorWriteMask;
+
+    // Perform command.
+    cmdSetColorWriteMaskEXT(mLogicalDevice, mCommandBuffer, firstAttachment, static_cast<std::uint32_t>(attachments.size()), writeMasks.data());
+#endif
+  }
+
   void CommandBuffer::bindVertexBuffer(const ResourceBuffer* vertexBuffer) {
     // Expects.
     if (vertexBuffer == nullptr)
@@ -263,9 +739,24 @@ namespace HAPI_NAMESPACE_NAME::gfx {
 
     // Bind.
     vkCmdBindPipeline(mCommandBuffer, static_cast<VkPipelineBindPoint>(bindPoint), pipeline->handle());
+
+    // Compute pipelines leave the graphics state alone.
+    if (bindPoint != PipelineBindPoint::Graphics)
+      return;
+
+    // States the pipeline bakes overwrite whatever was set before.
+    const auto dynamicStates = pipeline->dynamicStates();
+    mDynamicState.dynamicStates  = dynamicStates;
+    mDynamicState.knownStates   &= dynamicStates;
+    if ((dynamicStates & DynamicStateColorBlendEnableBit) == 0)
+      mDynamicState.knownBlendEnables = 0;
+    if ((dynamicStates & DynamicStateColorBlendEquationBit) == 0)
+      mDynamicState.knownBlendEquations = 0;
+    if ((dynamicStates & DynamicStateColorWriteMaskBit) == 0)
+      mDynamicState.knownWriteMasks = 0;
   }
 
-  void CommandBuffer::bindDescriptorSet(const DescriptorSet* descriptorSet, const PipelineLayout* layout) {
+  void CommandBuffer::bindDescriptorSet(const DescriptorSet* descriptorSet, const PipelineLayout* layout, std::span<const std::uint32_t> dynamicOffsets) {
     // Expects.
     if (descriptorSet == nullptr)
       throw std::runtime_error("Cannot bind null descriptor set.");
@@ -276,7 +767,16 @@ namespace HAPI_NAMESPACE_NAME::gfx {
 
     // Perform bind.
     auto dscset = descriptorSet->handle();
-    vkCmdBindDescriptorSets(mCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout->handle(), 0, 1, &dscset, 0, nullptr);
+    vkCmdBindDescriptorSets(
+      mCommandBuffer,
+      VK_PIPELINE_BIND_POINT_GRAPHICS,
+      layout->handle(),
+      0,
+      1,
+      &dscset,
+      static_cast<std::uint32_t>(dynamicOffsets.size()),
+      dynamicOffsets.data()
+    );
   }
 
   void CommandBuffer::draw(std::uint32_t vertCount, std::uint32_t firstVertex) {
@@ -311,11 +811,55 @@ namespace HAPI_NAMESPACE_NAME::gfx {
       rdrpssBeginInfo.pClearValues      = &clearColor;
     }
 
-    vkCmdBeginRenderPass(mCommandBuffer, &rdrpssBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+    const auto contents = brpi.contents == SubpassContents::Inline ? VK_SUBPASS_CONTENTS_INLINE : VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS;
+    vkCmdBeginRenderPass(mCommandBuffer, &rdrpssBeginInfo, contents);
   }
 
   void CommandBuffer::endRenderPass() {
     vkCmdEndRenderPass(mCommandBuffer);
   }
 
+  void CommandBuffer::executeCommands(std::span<const CommandBuffer* const> commandBuffers) {
+    // Gather handles, executing a command per full batch.
+    std::array<VkCommandBuffer, kBatchSize> handles;
+    std::size_t                             count = 0;
+    for (std::size_t index = 0; index < commandBuffers.size(); index++) {
+      const auto* commandBuffer = commandBuffers[index];
+      if (commandBuffer == nullptr || commandBuffer->mLevel != CommandBufferLevel::Secondary)
+        throw std::runtime_error("Expected non-null secondary command buffers to execute.");
+
+      handles[count++] = commandBuffer->mCommandBuffer;
+      if (count < kBatchSize && index + 1 < commandBuffers.size())
+        continue;
+
+      vkCmdExecuteCommands(mCommandBuffer, static_cast<std::uint32_t>(count), handles.data());
+      count = 0;
+    }
+
+    // The secondary command buffers leave every state undefined, including the bound pipeline.
+    mDynamicState = DynamicStateTracker();
+  }
+
+  void CommandBuffer::resetQueries(VkQueryPool queryPool, std::uint32_t firstQuery, std::uint32_t queryCount) {
+    // Perform command.
+    vkCmdResetQueryPool(mCommandBuffer, queryPool, firstQuery, queryCount);
+  }
+
+  void CommandBuffer::writeTimestamp(VkQueryPool queryPool, std::uint32_t query, PipelineStages stage) {
+    // Perform command.
+    vkCmdWriteTimestamp(mCommandBuffer, static_cast<VkPipelineStageFlagBits>(stage), queryPool, query);
+  }
+
+  VkCommandBuffer CommandBuffer::handle() const noexcept {
+    return mCommandBuffer;
+  }
+
+  CommandBufferLevel CommandBuffer::level() const noexcept {
+    return mLevel;
+  }
+
+  const DynamicStateTracker& CommandBuffer::dynamicState() const noexcept {
+    return mDynamicState;
+  }
+
 }
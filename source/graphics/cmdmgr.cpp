@@ -0,0 +1,143 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stdexcept>
+#include <hearth/graphics/cmdmgr.hpp>
+#include <hearth/profile.hpp>
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  CommandPoolManager::CommandPoolManager() noexcept
+    : mLogicalDevice(nullptr)
+    , mSlots()
+    , mThreadCount(0)
+    , mFrameCount(0)
+    , mFrameIndex(0)
+  { }
+
+  CommandPoolManager::CommandPoolManager(const CreateInfo& createInfo)
+    : mLogicalDevice(createInfo.logicalDevice)
+    , mSlots()
+    , mThreadCount(createInfo.threadCount)
+    , mFrameCount(createInfo.framesInFlight)
+    , mFrameIndex(0)
+  {
+    HAPI_PROFILE_ZONE("gfx::CommandPoolManager::CommandPoolManager");
+
+    // Expects.
+    if (mThreadCount == 0 || mFrameCount == 0)
+      throw std::runtime_error("Expected at least one thread and frame for command pool manager.");
+
+    // Provide command pool create info.
+    const CommandPool::CreateInfo cmdpllCreateInfo {
+      .logicalDevice       = mLogicalDevice,
+      .allocationCallbacks = createInfo.allocationCallbacks,
+      .queueIndex          = createInfo.queueIndex
+    };
+
+    // Create a pool for every thread of every frame.
+    mSlots.reserve(static_cast<std::size_t>(mThreadCount) * mFrameCount);
+    for (std::size_t index = 0; index < static_cast<std::size_t>(mThreadCount) * mFrameCount; index++) {
+      mSlots.push_back(PoolSlot{
+        .commandPool     = CommandPool(cmdpllCreateInfo),
+        .secondaries     = std::deque<CommandBuffer>{ },
+        .secondariesUsed = 0
+      });
+    }
+  }
+
+  CommandPoolManager::CommandPoolManager(CommandPoolManager&& other) noexcept
+    : mLogicalDevice(std::move(other.mLogicalDevice))
+    , mSlots(std::move(other.mSlots))
+    , mThreadCount(other.mThreadCount)
+    , mFrameCount(other.mFrameCount)
+    , mFrameIndex(other.mFrameIndex)
+  {
+    // Ensures.
+    other.mLogicalDevice = nullptr;
+    other.mSlots.clear();
+    other.mThreadCount = 0;
+    other.mFrameCount  = 0;
+    other.mFrameIndex  = 0;
+  }
+
+  CommandPoolManager& CommandPoolManager::operator=(CommandPoolManager&& other) noexcept {
+    std::swap(mLogicalDevice, other.mLogicalDevice);
+    std::swap(mSlots,         other.mSlots);
+    std::swap(mThreadCount,   other.mThreadCount);
+    std::swap(mFrameCount,    other.mFrameCount);
+    std::swap(mFrameIndex,    other.mFrameIndex);
+    return *this;
+  }
+
+  void CommandPoolManager::beginFrame(std::uint32_t frameIndex) {
+    // Expects.
+    if (frameIndex >= mFrameCount)
+      throw std::runtime_error("Frame index out of range for command pool manager.");
+
+    // Reset every pool of this frame, recycling all of their command buffers at once.
+    mFrameIndex = frameIndex;
+    for (std::uint32_t thread = 0; thread < mThreadCount; thread++) {
+      auto& poolSlot = slot(thread);
+      poolSlot.commandPool.reset();
+      poolSlot.secondariesUsed = 0;
+    }
+  }
+
+  CommandBuffer& CommandPoolManager::acquireSecondary(std::uint32_t threadIndex) {
+    auto& poolSlot = slot(threadIndex);
+
+    // Allocate a new secondary command buffer only if every existing one is in use.
+    if (poolSlot.secondariesUsed == poolSlot.secondaries.size()) {
+      const CommandBuffer::CreateInfo cmdbufCreateInfo {
+        .commandPool   = &poolSlot.commandPool,
+        .logicalDevice = mLogicalDevice,
+        .deletionQueue = nullptr,
+        .level         = CommandBufferLevel::Secondary
+      };
+
+      poolSlot.secondaries.emplace_back(cmdbufCreateInfo);
+    }
+
+    return poolSlot.secondaries[poolSlot.secondariesUsed++];
+  }
+
+  CommandPool& CommandPoolManager::commandPool(std::uint32_t threadIndex) {
+    return slot(threadIndex).commandPool;
+  }
+
+  std::uint32_t CommandPoolManager::threadCount() const noexcept {
+    return mThreadCount;
+  }
+
+  std::uint32_t CommandPoolManager::frameCount() const noexcept {
+    return mFrameCount;
+  }
+
+  CommandPoolManager::PoolSlot& CommandPoolManager::slot(std::uint32_t threadIndex) {
+    // Expects.
+    if (threadIndex >= mThreadCount)
+      throw std::runtime_error("Thread index out of range for command pool manager.");
+
+    return mSlots[static_cast<std::size_t>(mFrameIndex) * mThreadCount + threadIndex];
+  }
+
+}
@@ -0,0 +1,95 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <limits>
+#include <hearth/graphics/dltque.hpp>
+#include <hearth/profile.hpp>
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  DeletionQueue::DeletionQueue() noexcept
+    : mDeleters()
+    , mLock()
+    , mRecordingValue(1)
+    , mDrained(false)
+  { }
+
+  DeletionQueue::~DeletionQueue() noexcept {
+    HAPI_PROFILE_ZONE("gfx::DeletionQueue::~DeletionQueue");
+
+    for (auto& [value, deleter] : mDeleters)
+      deleter();
+  }
+
+  void DeletionQueue::enqueue(std::function<void()> deleter) {
+    {
+      std::scoped_lock lock{ mLock };
+      if (!mDrained) {
+        mDeleters.emplace_back(mRecordingValue, std::move(deleter));
+        return;
+      }
+    }
+
+    // Nothing is in flight anymore.
+    deleter();
+  }
+
+  void DeletionQueue::advance(std::uint64_t submittedValue) noexcept {
+    std::scoped_lock lock{ mLock };
+    mRecordingValue = submittedValue + 1;
+  }
+
+  void DeletionQueue::collect(std::uint64_t completedValue) {
+    HAPI_PROFILE_ZONE("gfx::DeletionQueue::collect");
+
+    // Deleters run one at a time outside the lock, so they can't deadlock by queueing more.
+    while (auto deleter = takeFinished(completedValue))
+      deleter();
+  }
+
+  void DeletionQueue::drain() {
+    HAPI_PROFILE_ZONE("gfx::DeletionQueue::drain");
+
+    {
+      std::scoped_lock lock{ mLock };
+      mDrained = true;
+    }
+
+    while (auto deleter = takeFinished(std::numeric_limits<std::uint64_t>::max()))
+      deleter();
+  }
+
+  std::size_t DeletionQueue::pending() const {
+    std::scoped_lock lock{ mLock };
+    return mDeleters.size();
+  }
+
+  std::function<void()> DeletionQueue::takeFinished(std::uint64_t completedValue) {
+    std::scoped_lock lock{ mLock };
+    if (mDeleters.empty() || mDeleters.front().first > completedValue)
+      return { };
+
+    auto deleter = std::move(mDeleters.front().second);
+    mDeleters.pop_front();
+    return deleter;
+  }
+
+}
@@ -21,19 +21,24 @@
  */
 #include <stdexcept>
 #include <hearth/graphics/dscset.hpp>
+#include <hearth/profile.hpp>
 #include <hearth/graphics/resbuf.hpp>
 
 namespace HAPI_NAMESPACE_NAME::gfx {
 
   DescriptorPool::DescriptorPool() noexcept
     : mLogicalDevice(nullptr)
+    , mAllocationCallbacks(nullptr)
     , mDescriptorPool(nullptr)
   { }
 
   DescriptorPool::DescriptorPool(const CreateInfo& createInfo)
     : mLogicalDevice(createInfo.logicalDevice)
+    , mAllocationCallbacks(createInfo.allocationCallbacks)
     , mDescriptorPool(nullptr)
   {
+    HAPI_PROFILE_ZONE("gfx::DescriptorPool::DescriptorPool");
+
     // Provide descriptor pool sizes.
     std::vector<VkDescriptorPoolSize> poolSizing;
     for (auto sizeInfo : createInfo.sizeInformations) {
@@ -58,7 +63,7 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     }
 
     // Create descriptor pool.
-    VkResult result = vkCreateDescriptorPool(mLogicalDevice, &dscpllCreateInfo, nullptr, &mDescriptorPool);
+    VkResult result = vkCreateDescriptorPool(mLogicalDevice, &dscpllCreateInfo, mAllocationCallbacks, &mDescriptorPool);
     if (result != VK_SUCCESS)
       throw std::runtime_error("Failed to create descriptor pool.");
   }
@@ -68,22 +73,27 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     if (mDescriptorPool == nullptr)
       return;
 
+    HAPI_PROFILE_ZONE("gfx::DescriptorPool::~DescriptorPool");
+
     // Delete.
-    vkDestroyDescriptorPool(mLogicalDevice, mDescriptorPool, nullptr);
+    vkDestroyDescriptorPool(mLogicalDevice, mDescriptorPool, mAllocationCallbacks);
   }
 
   DescriptorPool::DescriptorPool(DescriptorPool&& other) noexcept
     : mLogicalDevice(std::move(other.mLogicalDevice))
+    , mAllocationCallbacks(std::move(other.mAllocationCallbacks))
     , mDescriptorPool(std::move(other.mDescriptorPool))
   {
     // Ensures.
-    other.mLogicalDevice  = nullptr;
-    other.mDescriptorPool = nullptr;
+    other.mLogicalDevice       = nullptr;
+    other.mAllocationCallbacks = nullptr;
+    other.mDescriptorPool      = nullptr;
   }
 
   DescriptorPool& DescriptorPool::operator=(DescriptorPool&& other) noexcept {
-    std::swap(mLogicalDevice,  other.mLogicalDevice);
-    std::swap(mDescriptorPool, other.mDescriptorPool);
+    std::swap(mLogicalDevice,       other.mLogicalDevice);
+    std::swap(mAllocationCallbacks, other.mAllocationCallbacks);
+    std::swap(mDescriptorPool,      other.mDescriptorPool);
     return *this;
   }
 
@@ -93,13 +103,17 @@ namespace HAPI_NAMESPACE_NAME::gfx {
 
   DescriptorSetLayout::DescriptorSetLayout() noexcept
     : mLogicalDevice(nullptr)
+    , mAllocationCallbacks(nullptr)
     , mDescriptorLayout(nullptr)
   { }
 
   DescriptorSetLayout::DescriptorSetLayout(const CreateInfo& createInfo)
     : mLogicalDevice(createInfo.logicalDevice)
+    , mAllocationCallbacks(createInfo.allocationCallbacks)
     , mDescriptorLayout(nullptr)
   {
+    HAPI_PROFILE_ZONE("gfx::DescriptorSetLayout::DescriptorSetLayout");
+
     // Provide descriptor set layout bindings.
     std::vector<VkDescriptorSetLayoutBinding> bindings;
     for (auto binding : createInfo.bindings) {
@@ -126,7 +140,7 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     }
 
     // Create descriptor set layout.
-    VkResult result = vkCreateDescriptorSetLayout(mLogicalDevice, &dslCreateInfo, nullptr, &mDescriptorLayout);
+    VkResult result = vkCreateDescriptorSetLayout(mLogicalDevice, &dslCreateInfo, mAllocationCallbacks, &mDescriptorLayout);
     if (result != VK_SUCCESS)
       throw std::runtime_error("Failed to create descriptor set layout.");
   }
@@ -136,22 +150,27 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     if (mDescriptorLayout == nullptr)
       return;
 
+    HAPI_PROFILE_ZONE("gfx::DescriptorSetLayout::~DescriptorSetLayout");
+
     // Delete.
-    vkDestroyDescriptorSetLayout(mLogicalDevice, mDescriptorLayout, nullptr);
+    vkDestroyDescriptorSetLayout(mLogicalDevice, mDescriptorLayout, mAllocationCallbacks);
   }
 
   DescriptorSetLayout::DescriptorSetLayout(DescriptorSetLayout&& other) noexcept
     : mLogicalDevice(std::move(other.mLogicalDevice))
+    , mAllocationCallbacks(std::move(other.mAllocationCallbacks))
     , mDescriptorLayout(std::move(other.mDescriptorLayout))
   {
     // Ensures.
-    other.mLogicalDevice    = nullptr;
-    other.mDescriptorLayout = nullptr;
+    other.mLogicalDevice       = nullptr;
+    other.mAllocationCallbacks = nullptr;
+    other.mDescriptorLayout    = nullptr;
   }
 
   DescriptorSetLayout& DescriptorSetLayout::operator=(DescriptorSetLayout&& other) noexcept {
-    std::swap(mLogicalDevice,    other.mLogicalDevice);
-    std::swap(mDescriptorLayout, other.mDescriptorLayout);
+    std::swap(mLogicalDevice,       other.mLogicalDevice);
+    std::swap(mAllocationCallbacks, other.mAllocationCallbacks);
+    std::swap(mDescriptorLayout,    other.mDescriptorLayout);
     return *this;
   }
 
@@ -170,6 +189,8 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     , mDescriptorPool(nullptr)
     , mDescriptorSet(nullptr)
   {
+    HAPI_PROFILE_ZONE("gfx::DescriptorSet::DescriptorSet");
+
     // Expects.
     if (createInfo.descriptorPool == nullptr)
       throw std::runtime_error("Cannot create descriptor set from null descriptor pool.");
@@ -202,6 +223,8 @@ namespace HAPI_NAMESPACE_NAME::gfx {
   }
 
   DescriptorSet::~DescriptorSet() noexcept {
+    HAPI_PROFILE_ZONE("gfx::DescriptorSet::~DescriptorSet");
+
   }
 
   DescriptorSet::DescriptorSet(DescriptorSet&& other) noexcept
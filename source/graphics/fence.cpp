@@ -21,26 +21,31 @@
  */
 #include <stdexcept>
 #include <hearth/graphics/fence.hpp>
+#include <hearth/profile.hpp>
 
 namespace HAPI_NAMESPACE_NAME::gfx {
 
   Fence::Fence() noexcept
     : mLogicalDevice(nullptr)
+    , mAllocationCallbacks(nullptr)
     , mFence(nullptr)
   { }
 
-  Fence::Fence(VkDevice logicalDevice)
+  Fence::Fence(VkDevice logicalDevice, bool signaled, const VkAllocationCallbacks* allocationCallbacks)
     : mLogicalDevice(logicalDevice)
+    , mAllocationCallbacks(allocationCallbacks)
     , mFence(nullptr)
   {
+    HAPI_PROFILE_ZONE("gfx::Fence::Fence");
+
     VkFenceCreateInfo createInfo;
     {
       createInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
       createInfo.pNext = nullptr;
-      createInfo.flags = 0;
+      createInfo.flags = signaled ? static_cast<VkFenceCreateFlags>(VK_FENCE_CREATE_SIGNALED_BIT) : 0;
     }
 
-    VkResult result = vkCreateFence(mLogicalDevice, &createInfo, nullptr, &mFence);
+    VkResult result = vkCreateFence(mLogicalDevice, &createInfo, mAllocationCallbacks, &mFence);
     if (result != VK_SUCCESS)
       throw std::runtime_error("Failed to create fence.");
   }
@@ -50,25 +55,30 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     if (mFence == nullptr)
       return;
 
+    HAPI_PROFILE_ZONE("gfx::Fence::~Fence");
+
     // Wait for device.
     vkDeviceWaitIdle(mLogicalDevice);
 
     // Delete.
-    vkDestroyFence(mLogicalDevice, mFence, nullptr);
+    vkDestroyFence(mLogicalDevice, mFence, mAllocationCallbacks);
   }
 
   Fence::Fence(Fence&& other) noexcept
     : mLogicalDevice(std::move(other.mLogicalDevice))
+    , mAllocationCallbacks(std::move(other.mAllocationCallbacks))
     , mFence(std::move(other.mFence))
   {
     // Ensures.
-    other.mLogicalDevice = nullptr;
-    other.mFence         = nullptr;
+    other.mLogicalDevice       = nullptr;
+    other.mAllocationCallbacks = nullptr;
+    other.mFence               = nullptr;
   }
 
   Fence& Fence::operator=(Fence&& other) noexcept {
-    std::swap(mLogicalDevice, other.mLogicalDevice);
-    std::swap(mFence,         other.mFence);
+    std::swap(mLogicalDevice,       other.mLogicalDevice);
+    std::swap(mAllocationCallbacks, other.mAllocationCallbacks);
+    std::swap(mFence,               other.mFence);
     return *this;
   }
 
@@ -82,10 +92,18 @@ namespace HAPI_NAMESPACE_NAME::gfx {
       throw std::runtime_error("Failed to reset fence.");
   }
 
-  void Fence::wait(std::uint64_t timeout) {
+  void Fence::wait(std::uint64_t timeout) const {
     VkResult result = vkWaitForFences(mLogicalDevice, 1, &mFence, VK_TRUE, timeout);
     if (result != VK_SUCCESS)
       throw std::runtime_error("Failed to wait for fence.");
   }
 
+  bool Fence::signaled() const {
+    VkResult result = vkGetFenceStatus(mLogicalDevice, mFence);
+    if (result != VK_SUCCESS && result != VK_NOT_READY)
+      throw std::runtime_error("Failed to query fence status.");
+
+    return result == VK_SUCCESS;
+  }
+
 }
@@ -21,18 +21,26 @@
  */
 #include <stdexcept>
 #include <hearth/graphics/frmbuf.hpp>
+#include <hearth/graphics/dltque.hpp>
+#include <hearth/profile.hpp>
 
 namespace HAPI_NAMESPACE_NAME::gfx {
 
   FrameBuffer::FrameBuffer() noexcept
     : mLogicalDevice(nullptr)
+    , mAllocationCallbacks(nullptr)
+    , mDeletionQueue(nullptr)
     , mFrameBuffer(nullptr)
   { }
 
   FrameBuffer::FrameBuffer(const CreateInfo& createInfo)
     : mLogicalDevice(createInfo.logicalDevice)
+    , mAllocationCallbacks(createInfo.allocationCallbacks)
+    , mDeletionQueue(createInfo.deletionQueue)
     , mFrameBuffer(nullptr)
   {
+    HAPI_PROFILE_ZONE("gfx::FrameBuffer::FrameBuffer");
+
     initializeFrameBuffer(createInfo);
   }
 
@@ -41,25 +49,41 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     if (mFrameBuffer == nullptr)
       return;
 
+    HAPI_PROFILE_ZONE("gfx::FrameBuffer::~FrameBuffer");
+
+    // Delete once the GPU is done with it.
+    if (mDeletionQueue != nullptr) {
+      mDeletionQueue->enqueue([logicalDevice = mLogicalDevice, allocationCallbacks = mAllocationCallbacks, handle = mFrameBuffer] {
+        vkDestroyFramebuffer(logicalDevice, handle, allocationCallbacks);
+      });
+      return;
+    }
+
     // Wait for device.
     vkDeviceWaitIdle(mLogicalDevice);
 
     // Delete.
-    vkDestroyFramebuffer(mLogicalDevice, mFrameBuffer, nullptr);
+    vkDestroyFramebuffer(mLogicalDevice, mFrameBuffer, mAllocationCallbacks);
   }
 
   FrameBuffer::FrameBuffer(FrameBuffer&& other) noexcept
     : mLogicalDevice(std::move(other.mLogicalDevice))
+    , mAllocationCallbacks(std::move(other.mAllocationCallbacks))
+    , mDeletionQueue(std::move(other.mDeletionQueue))
     , mFrameBuffer(std::move(other.mFrameBuffer))
   {
     // Ensures.
-    other.mLogicalDevice = nullptr;
-    other.mFrameBuffer   = nullptr;
+    other.mLogicalDevice       = nullptr;
+    other.mAllocationCallbacks = nullptr;
+    other.mDeletionQueue       = nullptr;
+    other.mFrameBuffer         = nullptr;
   }
 
   FrameBuffer& FrameBuffer::operator=(FrameBuffer&& other) noexcept {
-    std::swap(mLogicalDevice, other.mLogicalDevice);
-    std::swap(mFrameBuffer,   other.mFrameBuffer);
+    std::swap(mLogicalDevice,       other.mLogicalDevice);
+    std::swap(mAllocationCallbacks, other.mAllocationCallbacks);
+    std::swap(mDeletionQueue,       other.mDeletionQueue);
+    std::swap(mFrameBuffer,         other.mFrameBuffer);
     return *this;
   }
 
@@ -82,7 +106,7 @@ namespace HAPI_NAMESPACE_NAME::gfx {
       fbCreateInfo.layers          = 1;
     }
 
-    VkResult result = vkCreateFramebuffer(mLogicalDevice, &fbCreateInfo, nullptr, &mFrameBuffer);
+    VkResult result = vkCreateFramebuffer(mLogicalDevice, &fbCreateInfo, mAllocationCallbacks, &mFrameBuffer);
     if (result != VK_SUCCESS)
       throw std::runtime_error("Failed to create framebuffer.");
   }
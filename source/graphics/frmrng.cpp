@@ -0,0 +1,211 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <hearth/graphics/frmrng.hpp>
+#include <hearth/profile.hpp>
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  // How long to sleep between checks of a fence another thread may reset.
+  constexpr std::chrono::microseconds kFencePollInterval(100);
+
+  FrameRing::FrameRing() noexcept
+    : mLogicalDevice(nullptr)
+    , mFrames()
+    , mTimeline()
+    , mSubmittedValue(0)
+    , mFrameIndex(0)
+    , mSubmissionLock()
+  { }
+
+  FrameRing::FrameRing(const CreateInfo& createInfo)
+    : mLogicalDevice(createInfo.logicalDevice)
+    , mFrames()
+    , mTimeline()
+    , mSubmittedValue(0)
+    , mFrameIndex(0)
+    , mSubmissionLock()
+  {
+    HAPI_PROFILE_ZONE("gfx::FrameRing::FrameRing");
+
+    // Expects.
+    if (createInfo.commandPool == nullptr)
+      throw std::runtime_error("Expected non-null command pool for frame ring.");
+
+    // Provide command buffer create info.
+    const CommandBuffer::CreateInfo cmdbufCreateInfo {
+      .commandPool   = createInfo.commandPool,
+      .logicalDevice = mLogicalDevice,
+      .deletionQueue = nullptr,
+      .level         = CommandBufferLevel::Primary
+    };
+
+    // A single timeline replaces the per-frame fences.
+    if (createInfo.timelineSemaphores)
+      mTimeline = TimelineSemaphore(mLogicalDevice, 0, createInfo.allocationCallbacks);
+
+    // Create frames, fences start signaled so the first pass over the ring doesn't block.
+    const auto frameCount = createInfo.framesInFlight == 0 ? DefaultFramesInFlight : createInfo.framesInFlight;
+    mFrames.reserve(frameCount);
+    for (std::uint32_t index = 0; index < frameCount; index++) {
+      mFrames.push_back(FrameContext{
+        .commandBuffer   = CommandBuffer(cmdbufCreateInfo),
+        .inFlight        = createInfo.timelineSemaphores ? Fence() : Fence(mLogicalDevice, true, createInfo.allocationCallbacks),
+        .imageAvailable  = Semaphore(mLogicalDevice, createInfo.allocationCallbacks),
+        .renderFinished  = Semaphore(mLogicalDevice, createInfo.allocationCallbacks),
+        .completionValue = 0
+      });
+    }
+
+    // Start on the last slot, so the first acquired frame is slot zero.
+    mFrameIndex = frameCount - 1;
+  }
+
+  FrameRing::~FrameRing() noexcept {
+    // Wasn't created or was moved.
+    if (mFrames.empty())
+      return;
+
+    HAPI_PROFILE_ZONE("gfx::FrameRing::~FrameRing");
+
+    // Let every frame finish before its objects are destroyed.
+    try {
+      waitIdle();
+    } catch (const std::runtime_error&) {
+      vkDeviceWaitIdle(mLogicalDevice);
+    }
+  }
+
+  FrameRing::FrameRing(FrameRing&& other) noexcept
+    : mLogicalDevice(std::move(other.mLogicalDevice))
+    , mFrames(std::move(other.mFrames))
+    , mTimeline(std::move(other.mTimeline))
+    , mSubmittedValue(other.mSubmittedValue)
+    , mFrameIndex(other.mFrameIndex)
+    , mSubmissionLock()
+  {
+    // Ensures.
+    other.mLogicalDevice = nullptr;
+    other.mFrames.clear();
+    other.mSubmittedValue = 0;
+    other.mFrameIndex     = 0;
+  }
+
+  FrameRing& FrameRing::operator=(FrameRing&& other) noexcept {
+    std::swap(mLogicalDevice,  other.mLogicalDevice);
+    std::swap(mFrames,         other.mFrames);
+    std::swap(mTimeline,       other.mTimeline);
+    std::swap(mSubmittedValue, other.mSubmittedValue);
+    std::swap(mFrameIndex,     other.mFrameIndex);
+    return *this;
+  }
+
+  FrameContext& FrameRing::acquireFrame() {
+    // Advance and wait for the GPU to release this slot.
+    mFrameIndex = (mFrameIndex + 1) % static_cast<std::uint32_t>(mFrames.size());
+    auto& frame = mFrames[mFrameIndex];
+
+    // Only this thread resets fences, so the slot's own fence can be waited on without the lock.
+    if (mTimeline.handle() != nullptr)
+      mTimeline.wait(frame.completionValue);
+    else
+      frame.inFlight.wait(std::numeric_limits<std::uint64_t>::max());
+    return frame;
+  }
+
+  std::uint64_t FrameRing::prepareSubmit() {
+    std::scoped_lock lock{ mSubmissionLock };
+    auto& frame = mFrames[mFrameIndex];
+    frame.completionValue = ++mSubmittedValue;
+    if (mTimeline.handle() == nullptr)
+      frame.inFlight.reset();
+    return frame.completionValue;
+  }
+
+  const TimelineSemaphore* FrameRing::timeline() const noexcept {
+    return mTimeline.handle() != nullptr ? &mTimeline : nullptr;
+  }
+
+  bool FrameRing::completed(std::uint64_t value) const {
+    // Nothing to wait on.
+    if (value == 0)
+      return true;
+
+    if (mTimeline.handle() != nullptr)
+      return mTimeline.reached(value);
+
+    std::scoped_lock lock{ mSubmissionLock };
+    return findSubmission(value).inFlight.signaled();
+  }
+
+  void FrameRing::wait(std::uint64_t value) const {
+    // Nothing to wait on.
+    if (value == 0)
+      return;
+
+    // Waiting on a timeline is thread safe.
+    if (mTimeline.handle() != nullptr) {
+      mTimeline.wait(value);
+      return;
+    }
+
+    // Fences are reset as the ring advances, and can't be waited on while that happens. Only check
+    // them with the lock held, sleeping in between so the ring is never held up.
+    while (!completed(value))
+      std::this_thread::sleep_for(kFencePollInterval);
+  }
+
+  FrameContext& FrameRing::current() noexcept {
+    return mFrames[mFrameIndex];
+  }
+
+  std::uint32_t FrameRing::index() const noexcept {
+    return mFrameIndex;
+  }
+
+  std::uint32_t FrameRing::size() const noexcept {
+    return static_cast<std::uint32_t>(mFrames.size());
+  }
+
+  void FrameRing::waitIdle() {
+    wait(mSubmittedValue);
+  }
+
+  const FrameContext& FrameRing::findSubmission(std::uint64_t value) const {
+    // Expects.
+    if (value > mSubmittedValue)
+      throw std::runtime_error("Cannot wait on a frame that was never submitted.");
+
+    // Submissions execute in order, so once a slot's fence signals every older value is complete
+    // too. The slot holding the oldest value at or after the requested one covers it.
+    const FrameContext* submission = nullptr;
+    for (const auto& frame : mFrames)
+      if (frame.completionValue >= value && (submission == nullptr || frame.completionValue < submission->completionValue))
+        submission = &frame;
+
+    return *submission;
+  }
+
+}
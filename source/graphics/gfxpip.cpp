@@ -19,23 +19,49 @@
  * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
-#include <array>
-#include <fstream>
 #include <stdexcept>
+#include <utility>
 #include <hearth/graphics/gfxpip.hpp>
+#include <hearth/graphics/dltque.hpp>
+#include <hearth/profile.hpp>
 #include <hearth/graphics/dscset.hpp>
+#include <hearth/graphics/shdmod.hpp>
 
 namespace HAPI_NAMESPACE_NAME::gfx {
 
+  // The vulkan dynamic state of each of the DynamicStateFlags the vulkan headers declare.
+  constexpr std::pair<std::uint32_t, VkDynamicState> kDynamicStates[] {
+    { DynamicStateLineWidthBit,          VK_DYNAMIC_STATE_LINE_WIDTH },
+    { DynamicStateBlendConstantsBit,     VK_DYNAMIC_STATE_BLEND_CONSTANTS },
+#if defined(VK_EXT_extended_dynamic_state)
+    { DynamicStateCullModeBit,           VK_DYNAMIC_STATE_CULL_MODE_EXT },
+    { DynamicStateFrontFaceBit,          VK_DYNAMIC_STATE_FRONT_FACE_EXT },
+    { DynamicStateTopologyBit,           VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT },
+#endif
+#if defined(VK_EXT_extended_dynamic_state2)
+    { DynamicStateLogicOpBit,            VK_DYNAMIC_STATE_LOGIC_OP_EXT },
+#endif
+#if defined(VK_EXT_extended_dynamic_state3)
+    { DynamicStatePolygonModeBit,        VK_DYNAMIC_STATE_POLYGON_MODE_EXT },
+    { DynamicStateColorBlendEnableBit,   VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT },
+    { DynamicStateColorBlendEquationBit, VK_DYNAMIC_STATE_COLOR_BLEND_EQUATION_EXT },
+    { DynamicStateColorWriteMaskBit,     VK_DYNAMIC_STATE_COLOR_WRITE_MASK_EXT },
+#endif
+  };
+
   PipelineLayout::PipelineLayout() noexcept
     : mLogicalDevice(nullptr)
+    , mAllocationCallbacks(nullptr)
     , mPipelineLayout(nullptr)
   { }
 
   PipelineLayout::PipelineLayout(const CreateInfo& createInfo)
     : mLogicalDevice(createInfo.logicalDevice)
+    , mAllocationCallbacks(createInfo.allocationCallbacks)
     , mPipelineLayout(nullptr)
   {
+    HAPI_PROFILE_ZONE("gfx::PipelineLayout::PipelineLayout");
+
     // Get layouts.
     std::vector<VkDescriptorSetLayout> layouts;
     for (auto layout : createInfo.descriptorLayouts)
@@ -52,7 +78,7 @@ namespace HAPI_NAMESPACE_NAME::gfx {
       pipelineLayoutInfo.pPushConstantRanges    = nullptr;
     }
 
-    VkResult result = vkCreatePipelineLayout(mLogicalDevice, &pipelineLayoutInfo, nullptr, &mPipelineLayout);
+    VkResult result = vkCreatePipelineLayout(mLogicalDevice, &pipelineLayoutInfo, mAllocationCallbacks, &mPipelineLayout);
     if (result != VK_SUCCESS)
       throw std::runtime_error("Failed to create pipeline layout.");
   }
@@ -62,22 +88,27 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     if (mPipelineLayout == nullptr)
       return;
 
+    HAPI_PROFILE_ZONE("gfx::PipelineLayout::~PipelineLayout");
+
     // Delete.
-    vkDestroyPipelineLayout(mLogicalDevice, mPipelineLayout, nullptr);
+    vkDestroyPipelineLayout(mLogicalDevice, mPipelineLayout, mAllocationCallbacks);
   }
 
   PipelineLayout::PipelineLayout(PipelineLayout&& other) noexcept
     : mLogicalDevice(std::move(other.mLogicalDevice))
+    , mAllocationCallbacks(std::move(other.mAllocationCallbacks))
     , mPipelineLayout(std::move(other.mPipelineLayout))
   {
     // Ensures.
-    other.mLogicalDevice  = nullptr;
-    other.mPipelineLayout = nullptr;
+    other.mLogicalDevice       = nullptr;
+    other.mAllocationCallbacks = nullptr;
+    other.mPipelineLayout      = nullptr;
   }
 
   PipelineLayout& PipelineLayout::operator=(PipelineLayout&& other) noexcept {
-    std::swap(mLogicalDevice,  other.mLogicalDevice);
-    std::swap(mPipelineLayout, other.mPipelineLayout);
+    std::swap(mLogicalDevice,       other.mLogicalDevice);
+    std::swap(mAllocationCallbacks, other.mAllocationCallbacks);
+    std::swap(mPipelineLayout,      other.mPipelineLayout);
     return *this;
   }
 
@@ -87,13 +118,21 @@ namespace HAPI_NAMESPACE_NAME::gfx {
 
   Pipeline::Pipeline() noexcept
     : mLogicalDevice(nullptr)
+    , mAllocationCallbacks(nullptr)
+    , mDeletionQueue(nullptr)
     , mGraphicsPipeline(nullptr)
+    , mDynamicStates(0)
   { }
 
   Pipeline::Pipeline(const CreateInfo& createInfo)
     : mLogicalDevice(createInfo.logicalDevice)
+    , mAllocationCallbacks(createInfo.allocationCallbacks)
+    , mDeletionQueue(createInfo.deletionQueue)
     , mGraphicsPipeline(nullptr)
+    , mDynamicStates(createInfo.dynamicStates)
   {
+    HAPI_PROFILE_ZONE("gfx::Pipeline::Pipeline");
+
     initializePipeline(createInfo);
   }
 
@@ -102,25 +141,44 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     if (mGraphicsPipeline == nullptr)
       return;
 
+    HAPI_PROFILE_ZONE("gfx::Pipeline::~Pipeline");
+
+    // Delete once the GPU is done with it.
+    if (mDeletionQueue != nullptr) {
+      mDeletionQueue->enqueue([logicalDevice = mLogicalDevice, allocationCallbacks = mAllocationCallbacks, handle = mGraphicsPipeline] {
+        vkDestroyPipeline(logicalDevice, handle, allocationCallbacks);
+      });
+      return;
+    }
+
     // Wait for device.
     vkDeviceWaitIdle(mLogicalDevice);
 
     // Delete.
-    vkDestroyPipeline(mLogicalDevice, mGraphicsPipeline, nullptr);
+    vkDestroyPipeline(mLogicalDevice, mGraphicsPipeline, mAllocationCallbacks);
   }
 
   Pipeline::Pipeline(Pipeline&& other) noexcept
     : mLogicalDevice(std::move(other.mLogicalDevice))
+    , mAllocationCallbacks(std::move(other.mAllocationCallbacks))
+    , mDeletionQueue(std::move(other.mDeletionQueue))
     , mGraphicsPipeline(std::move(other.mGraphicsPipeline))
+    , mDynamicStates(other.mDynamicStates)
   {
     // Ensures.
-    other.mLogicalDevice    = nullptr;
-    other.mGraphicsPipeline = nullptr;
+    other.mLogicalDevice       = nullptr;
+    other.mAllocationCallbacks = nullptr;
+    other.mDeletionQueue       = nullptr;
+    other.mGraphicsPipeline    = nullptr;
+    other.mDynamicStates       = 0;
   }
 
   Pipeline& Pipeline::operator=(Pipeline&& other) noexcept {
-    std::swap(mLogicalDevice,    other.mLogicalDevice);
-    std::swap(mGraphicsPipeline, other.mGraphicsPipeline);
+    std::swap(mLogicalDevice,       other.mLogicalDevice);
+    std::swap(mAllocationCallbacks, other.mAllocationCallbacks);
+    std::swap(mDeletionQueue,       other.mDeletionQueue);
+    std::swap(mGraphicsPipeline,    other.mGraphicsPipeline);
+    std::swap(mDynamicStates,       other.mDynamicStates);
     return *this;
   }
 
@@ -128,44 +186,14 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     return mGraphicsPipeline;
   }
 
-  static std::vector<char> readFile(const std::string& filename) {
-    std::ifstream file(filename, std::ios::ate | std::ios::binary);
-
-    if (!file.is_open()) {
-        throw std::runtime_error("failed to open file!");
-    }
-
-    size_t fileSize = (size_t) file.tellg();
-    std::vector<char> buffer(fileSize);
-
-    file.seekg(0);
-    file.read(buffer.data(), fileSize);
-
-    file.close();
-
-    return buffer;
-  }
-
-  VkShaderModule createShaderModule(VkDevice logicalDevice, const std::vector<char>& code) {
-    VkShaderModuleCreateInfo createInfo{};
-    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = code.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
-
-    VkShaderModule shaderModule;
-    if (vkCreateShaderModule(logicalDevice, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
-      throw std::runtime_error("failed to create shader module!");
-    }
-
-    return shaderModule;
+  std::uint32_t Pipeline::dynamicStates() const noexcept {
+    return mDynamicStates;
   }
 
   void Pipeline::initializePipeline(const CreateInfo& createInfo) {
-    auto vertShaderCode = readFile("./resources/vert.spv");
-    auto fragShaderCode = readFile("./resources/frag.spv");
-
-    VkShaderModule vertShaderModule = createShaderModule(mLogicalDevice, vertShaderCode);
-    VkShaderModule fragShaderModule = createShaderModule(mLogicalDevice, fragShaderCode);
+    // Expects.
+    if (createInfo.vertexShader == nullptr || createInfo.fragmentShader == nullptr)
+      throw std::runtime_error("Expected vertex and fragment shader modules for graphics pipeline.");
 
     VkPipelineShaderStageCreateInfo vertShaderStageInfo;
     {
@@ -173,7 +201,7 @@ namespace HAPI_NAMESPACE_NAME::gfx {
       vertShaderStageInfo.pNext               = nullptr;
       vertShaderStageInfo.flags               = 0;
       vertShaderStageInfo.stage               = VK_SHADER_STAGE_VERTEX_BIT;
-      vertShaderStageInfo.module              = vertShaderModule;
+      vertShaderStageInfo.module              = createInfo.vertexShader->handle();
       vertShaderStageInfo.pName               = "main";
       vertShaderStageInfo.pSpecializationInfo = nullptr;
     }
@@ -184,7 +212,7 @@ namespace HAPI_NAMESPACE_NAME::gfx {
       fragShaderStageInfo.pNext               = nullptr;
       fragShaderStageInfo.flags               = 0;
       fragShaderStageInfo.stage               = VK_SHADER_STAGE_FRAGMENT_BIT;
-      fragShaderStageInfo.module              = fragShaderModule;
+      fragShaderStageInfo.module              = createInfo.fragmentShader->handle();
       fragShaderStageInfo.pName               = "main";
       fragShaderStageInfo.pSpecializationInfo = nullptr;
     }
@@ -313,10 +341,15 @@ namespace HAPI_NAMESPACE_NAME::gfx {
       colorBlend.blendConstants[3] = createInfo.colorBlending->blendConstants[3];
     }
 
-    std::array<VkDynamicState, 2> dynamicStates {
+    // Viewport and scissor are always dynamic, the rest only when asked for.
+    std::vector<VkDynamicState> dynamicStates {
       VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR
     };
 
+    for (const auto& [flag, state] : kDynamicStates)
+      if ((mDynamicStates & flag) != 0)
+        dynamicStates.push_back(state);
+
     VkPipelineDynamicStateCreateInfo pdsCreateInfo;
     {
       pdsCreateInfo.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
@@ -330,11 +363,18 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     if (createInfo.layout == nullptr)
       throw std::runtime_error("Cannot create graphics pipeline with null layout.");
 
+    // Derivatives only need to be compiled relative to their base.
+    VkPipelineCreateFlags pipelineFlags = 0;
+    if (createInfo.allowDerivatives)
+      pipelineFlags |= VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT;
+    if (createInfo.base != nullptr)
+      pipelineFlags |= VK_PIPELINE_CREATE_DERIVATIVE_BIT;
+
     VkGraphicsPipelineCreateInfo pipelineCreateInfo;
     {
       pipelineCreateInfo.sType                = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
       pipelineCreateInfo.pNext                = nullptr;
-      pipelineCreateInfo.flags                = 0;
+      pipelineCreateInfo.flags                = pipelineFlags;
       pipelineCreateInfo.stageCount           = 2;
       pipelineCreateInfo.pStages              = shaderStages;
       pipelineCreateInfo.pVertexInputState    = &vertexInputInfo;
@@ -349,16 +389,13 @@ namespace HAPI_NAMESPACE_NAME::gfx {
       pipelineCreateInfo.layout               = createInfo.layout->handle();
       pipelineCreateInfo.renderPass           = createInfo.renderPass;
       pipelineCreateInfo.subpass              = createInfo.subpass;
-      pipelineCreateInfo.basePipelineHandle   = nullptr;
-      pipelineCreateInfo.basePipelineIndex    = 0;
+      pipelineCreateInfo.basePipelineHandle   = createInfo.base != nullptr ? createInfo.base->handle() : nullptr;
+      pipelineCreateInfo.basePipelineIndex    = -1;
     }
 
-    VkResult result = vkCreateGraphicsPipelines(mLogicalDevice, nullptr, 1, &pipelineCreateInfo, nullptr, &mGraphicsPipeline);
+    VkResult result = vkCreateGraphicsPipelines(mLogicalDevice, createInfo.pipelineCache, 1, &pipelineCreateInfo, mAllocationCallbacks, &mGraphicsPipeline);
     if (result != VK_SUCCESS)
       throw std::runtime_error("Failed to create graphics pipeline.");
-
-    vkDestroyShaderModule(mLogicalDevice, fragShaderModule, nullptr);
-    vkDestroyShaderModule(mLogicalDevice, vertShaderModule, nullptr);
   }
 
 }
@@ -0,0 +1,238 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <hearth/graphics/gpuprf.hpp>
+#include <hearth/profile.hpp>
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  // The number of zones read back on the stack at once.
+  constexpr std::uint32_t kBatchSize = 16;
+
+  // Nearest rank percentile of already sorted samples.
+  static double percentile(const std::vector<double>& sorted, double fraction) noexcept {
+    const auto rank = static_cast<std::size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+    return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+  }
+
+  GpuProfiler::GpuProfiler(const CreateInfo& createInfo)
+    : mLogicalDevice(createInfo.logicalDevice)
+    , mAllocationCallbacks(createInfo.allocationCallbacks)
+    , mQueryPool(nullptr)
+    , mSlots()
+    , mHistories()
+    , mHistoriesLock()
+    , mZoneCount(0)
+    , mTimestampPeriod(0.0)
+    , mTimestampMask(0)
+    , mHistorySize(createInfo.historySize == 0 ? DefaultHistorySize : createInfo.historySize)
+    , mMaxZones(createInfo.maxZones == 0 ? DefaultMaxZones : createInfo.maxZones)
+    , mFrameIndex(0)
+  {
+    HAPI_PROFILE_ZONE("gfx::GpuProfiler::GpuProfiler");
+
+    // Expects.
+    if (createInfo.framesInFlight == 0)
+      throw std::runtime_error("Expected at least one frame for GPU profiler.");
+
+    // Queues without valid timestamp bits can't be profiled, zones become no-ops.
+    std::uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(createInfo.physicalDevice, &familyCount, nullptr);
+
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(createInfo.physicalDevice, &familyCount, families.data());
+
+    const auto validBits = createInfo.queueIndex < familyCount ? families[createInfo.queueIndex].timestampValidBits : 0;
+    if (validBits == 0)
+      return;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(createInfo.physicalDevice, &properties);
+    mTimestampPeriod = static_cast<double>(properties.limits.timestampPeriod);
+    mTimestampMask   = validBits >= 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << validBits) - 1;
+
+    // Each frame gets a begin and end query per zone.
+    VkQueryPoolCreateInfo poolInfo;
+    {
+      poolInfo.sType              = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+      poolInfo.pNext              = nullptr;
+      poolInfo.flags              = 0;
+      poolInfo.queryType          = VK_QUERY_TYPE_TIMESTAMP;
+      poolInfo.queryCount         = createInfo.framesInFlight * mMaxZones * 2;
+      poolInfo.pipelineStatistics = 0;
+    }
+
+    VkResult result = vkCreateQueryPool(mLogicalDevice, &poolInfo, mAllocationCallbacks, &mQueryPool);
+    if (result != VK_SUCCESS)
+      throw std::runtime_error("Failed to create timestamp query pool.");
+
+    // Create frame slots.
+    mSlots.reserve(createInfo.framesInFlight);
+    for (std::uint32_t index = 0; index < createInfo.framesInFlight; index++) {
+      mSlots.push_back(FrameSlot{
+        .names     = std::vector<std::string_view>(mMaxZones),
+        .zoneCount = 0
+      });
+    }
+  }
+
+  GpuProfiler::~GpuProfiler() noexcept {
+    // Wasn't created or timestamps weren't supported.
+    if (mQueryPool == nullptr)
+      return;
+
+    HAPI_PROFILE_ZONE("gfx::GpuProfiler::~GpuProfiler");
+
+    // Wait for device.
+    vkDeviceWaitIdle(mLogicalDevice);
+    vkDestroyQueryPool(mLogicalDevice, mQueryPool, mAllocationCallbacks);
+  }
+
+  void GpuProfiler::beginFrame(std::uint32_t frameIndex) {
+    // Nothing to do.
+    if (mQueryPool == nullptr)
+      return;
+
+    // Expects.
+    if (frameIndex >= mSlots.size())
+      throw std::runtime_error("Frame index out of range of GPU profiler.");
+
+    // Close out the frame that was recorded last.
+    mSlots[mFrameIndex].zoneCount = std::min(mZoneCount.exchange(0, std::memory_order_relaxed), mMaxZones);
+
+    // The previous use of this frame has finished executing, so its results are ready.
+    mFrameIndex = frameIndex;
+    collect(mSlots[mFrameIndex], mFrameIndex * mMaxZones * 2);
+    mSlots[mFrameIndex].zoneCount = 0;
+  }
+
+  void GpuProfiler::resetQueries(CommandBuffer& commandBuffer) {
+    if (mQueryPool != nullptr)
+      commandBuffer.resetQueries(mQueryPool, mFrameIndex * mMaxZones * 2, mMaxZones * 2);
+  }
+
+  std::uint32_t GpuProfiler::beginZone(CommandBuffer& commandBuffer, std::string_view name, PipelineStages stage) {
+    // Nothing to do.
+    if (mQueryPool == nullptr)
+      return InvalidZone;
+
+    // Claim a zone, dropping it if the frame is out of queries.
+    const auto zone = mZoneCount.fetch_add(1, std::memory_order_relaxed);
+    if (zone >= mMaxZones)
+      return InvalidZone;
+
+    mSlots[mFrameIndex].names[zone] = name;
+    commandBuffer.writeTimestamp(mQueryPool, (mFrameIndex * mMaxZones + zone) * 2, stage);
+    return zone;
+  }
+
+  void GpuProfiler::endZone(CommandBuffer& commandBuffer, std::uint32_t zone, PipelineStages stage) {
+    if (zone != InvalidZone)
+      commandBuffer.writeTimestamp(mQueryPool, (mFrameIndex * mMaxZones + zone) * 2 + 1, stage);
+  }
+
+  std::vector<GpuZoneStatistics> GpuProfiler::statistics() const {
+    std::vector<GpuZoneStatistics> statistics;
+    std::vector<double>            sorted;
+
+    std::lock_guard<std::mutex> guard(mHistoriesLock);
+    statistics.reserve(mHistories.size());
+    for (const auto& [name, history] : mHistories) {
+      sorted = history.samples;
+      std::sort(sorted.begin(), sorted.end());
+
+      statistics.push_back(GpuZoneStatistics{
+        .name                = name,
+        .lastMilliseconds    = history.last,
+        .averageMilliseconds = std::accumulate(sorted.begin(), sorted.end(), 0.0) / static_cast<double>(sorted.size()),
+        .p50Milliseconds     = percentile(sorted, 0.50),
+        .p95Milliseconds     = percentile(sorted, 0.95),
+        .p99Milliseconds     = percentile(sorted, 0.99),
+        .sampleCount         = sorted.size()
+      });
+    }
+
+    std::sort(statistics.begin(), statistics.end(), [](const auto& lhs, const auto& rhs) {
+      return lhs.name < rhs.name;
+    });
+    return statistics;
+  }
+
+  bool GpuProfiler::supported() const noexcept {
+    return mQueryPool != nullptr;
+  }
+
+  void GpuProfiler::collect(const FrameSlot& slot, std::uint32_t firstQuery) {
+    // Nothing was recorded.
+    if (slot.zoneCount == 0)
+      return;
+
+    // Read back a batch of zones at a time, each query is followed by its availability and zones
+    // that never ended stay unavailable.
+    std::array<std::uint64_t, kBatchSize * 4> results;
+    for (std::uint32_t first = 0; first < slot.zoneCount; first += kBatchSize) {
+      const auto count = std::min(kBatchSize, slot.zoneCount - first);
+      VkResult result = vkGetQueryPoolResults(
+        mLogicalDevice, mQueryPool, firstQuery + first * 2, count * 2,
+        count * 4 * sizeof(std::uint64_t), results.data(), 2 * sizeof(std::uint64_t),
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT
+      );
+      if (result != VK_SUCCESS && result != VK_NOT_READY)
+        throw std::runtime_error("Failed to read back timestamp queries.");
+
+      std::lock_guard<std::mutex> guard(mHistoriesLock);
+      for (std::uint32_t zone = 0; zone < count; zone++) {
+        const auto* query = &results[static_cast<std::size_t>(zone) * 4];
+        if (query[1] == 0 || query[3] == 0)
+          continue;
+
+        // Timestamps wrap at their valid bits.
+        const auto ticks        = (query[2] - query[0]) & mTimestampMask;
+        const auto milliseconds = static_cast<double>(ticks) * mTimestampPeriod / 1'000'000.0;
+
+        auto& history = mHistories[slot.names[first + zone]];
+        if (history.samples.size() < mHistorySize)
+          history.samples.push_back(milliseconds);
+        else
+          history.samples[history.next] = milliseconds;
+        history.next = (history.next + 1) % mHistorySize;
+        history.last = milliseconds;
+      }
+    }
+  }
+
+  GpuZone::GpuZone(GpuProfiler* profiler, CommandBuffer& commandBuffer, std::string_view name)
+    : mProfiler(profiler)
+    , mCommandBuffer(commandBuffer)
+    , mZone(profiler != nullptr ? profiler->beginZone(commandBuffer, name) : GpuProfiler::InvalidZone)
+  { }
+
+  GpuZone::~GpuZone() noexcept {
+    if (mProfiler != nullptr)
+      mProfiler->endZone(mCommandBuffer, mZone);
+  }
+
+}
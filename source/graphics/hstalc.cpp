@@ -0,0 +1,294 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <hearth/graphics/hstalc.hpp>
+#include <hearth/profile.hpp>
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  // Precedes every allocation, so frees know where the memory came from.
+  struct alignas(16) BlockHeader {
+    std::size_t   size;
+    std::size_t   alignment;
+    std::uint32_t sizeClass;
+    std::uint32_t scope;
+  };
+
+  // The alignment pooled blocks guarantee, anything aligned further is allocated directly.
+  constexpr std::size_t kPoolAlignment = alignof(BlockHeader);
+
+  // The size class of allocations that bypass the pools.
+  constexpr std::uint32_t kDirectClass = ~std::uint32_t(0);
+
+  // The size of the smallest pooled block, header included.
+  constexpr std::size_t kSmallestClass = 64;
+
+  static std::size_t classSize(std::size_t sizeClass) noexcept {
+    return kSmallestClass << sizeClass;
+  }
+
+  static BlockHeader* headerOf(void* memory) noexcept {
+    return reinterpret_cast<BlockHeader*>(static_cast<std::byte*>(memory) - sizeof(BlockHeader));
+  }
+
+  static std::size_t scopeIndex(VkSystemAllocationScope scope) noexcept {
+    // Attribute anything unknown to object scope, rather than indexing out of bounds.
+    const auto index = static_cast<std::size_t>(scope);
+    return index < HostAllocator::ScopeCount ? index : static_cast<std::size_t>(VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+  }
+
+  static VKAPI_ATTR void* VKAPI_CALL allocationCallback(void* pUserData, std::size_t size, std::size_t alignment, VkSystemAllocationScope scope) {
+    return static_cast<HostAllocator*>(pUserData)->allocate(size, alignment, scope);
+  }
+
+  static VKAPI_ATTR void* VKAPI_CALL reallocationCallback(void* pUserData, void* pOriginal, std::size_t size, std::size_t alignment, VkSystemAllocationScope scope) {
+    return static_cast<HostAllocator*>(pUserData)->reallocate(pOriginal, size, alignment, scope);
+  }
+
+  static VKAPI_ATTR void VKAPI_CALL freeCallback(void* pUserData, void* pMemory) {
+    static_cast<HostAllocator*>(pUserData)->deallocate(pMemory);
+  }
+
+  static VKAPI_ATTR void VKAPI_CALL internalAllocationCallback(void* pUserData, std::size_t size, [[maybe_unused]] VkInternalAllocationType type, VkSystemAllocationScope scope) {
+    static_cast<HostAllocator*>(pUserData)->internalAllocated(size, scope);
+  }
+
+  static VKAPI_ATTR void VKAPI_CALL internalFreeCallback(void* pUserData, std::size_t size, [[maybe_unused]] VkInternalAllocationType type, VkSystemAllocationScope scope) {
+    static_cast<HostAllocator*>(pUserData)->internalFreed(size, scope);
+  }
+
+  HostAllocator::HostAllocator(const CreateInfo& createInfo)
+    : mCallbacks()
+    , mPools()
+    , mCounters()
+    , mSampleLock()
+    , mSamples()
+    , mSampleTime(std::chrono::steady_clock::now())
+    , mSlabSize(std::max(createInfo.slabSize != 0 ? createInfo.slabSize : DefaultSlabSize, classSize(SizeClassCount - 1)))
+  {
+    HAPI_PROFILE_ZONE("gfx::HostAllocator::HostAllocator");
+
+    // Provide callbacks.
+    {
+      mCallbacks.pUserData             = this;
+      mCallbacks.pfnAllocation         = allocationCallback;
+      mCallbacks.pfnReallocation       = reallocationCallback;
+      mCallbacks.pfnFree               = freeCallback;
+      mCallbacks.pfnInternalAllocation = internalAllocationCallback;
+      mCallbacks.pfnInternalFree       = internalFreeCallback;
+    }
+
+    for (auto& pool : mPools)
+      pool.freeLists.fill(nullptr);
+
+    for (auto& counters : mCounters) {
+      counters.bytes.store(0, std::memory_order_relaxed);
+      counters.peakBytes.store(0, std::memory_order_relaxed);
+      counters.internalBytes.store(0, std::memory_order_relaxed);
+      counters.allocations.store(0, std::memory_order_relaxed);
+      counters.reallocations.store(0, std::memory_order_relaxed);
+      counters.frees.store(0, std::memory_order_relaxed);
+    }
+
+    mSamples.fill(Sample{ 0, 0 });
+  }
+
+  const VkAllocationCallbacks* HostAllocator::callbacks() const noexcept {
+    return &mCallbacks;
+  }
+
+  std::array<HostAllocationStatistics, HostAllocator::ScopeCount> HostAllocator::statistics() {
+    std::scoped_lock lock{ mSampleLock };
+    const auto now     = std::chrono::steady_clock::now();
+    const auto seconds = std::chrono::duration<double>(now - mSampleTime).count();
+    mSampleTime = now;
+
+    std::array<HostAllocationStatistics, ScopeCount> statistics;
+    for (std::size_t index = 0; index < ScopeCount; index++) {
+      const auto& counters = mCounters[index];
+      auto&       sample   = mSamples[index];
+      auto&       result   = statistics[index];
+      result.scope         = static_cast<VkSystemAllocationScope>(index);
+      result.bytes         = counters.bytes.load(std::memory_order_relaxed);
+      result.peakBytes     = counters.peakBytes.load(std::memory_order_relaxed);
+      result.internalBytes = counters.internalBytes.load(std::memory_order_relaxed);
+      result.allocations   = counters.allocations.load(std::memory_order_relaxed);
+      result.reallocations = counters.reallocations.load(std::memory_order_relaxed);
+      result.frees         = counters.frees.load(std::memory_order_relaxed);
+
+      // Rates over the time since the last sample.
+      result.allocationsPerSecond = seconds > 0.0 ? static_cast<double>(result.allocations - sample.allocations) / seconds : 0.0;
+      result.freesPerSecond       = seconds > 0.0 ? static_cast<double>(result.frees - sample.frees) / seconds : 0.0;
+      sample = Sample{ result.allocations, result.frees };
+    }
+
+    return statistics;
+  }
+
+  void* HostAllocator::allocate(std::size_t size, std::size_t alignment, VkSystemAllocationScope scope) noexcept {
+    // Nothing to allocate.
+    if (size == 0)
+      return nullptr;
+
+    const auto index     = scopeIndex(scope);
+    const auto blockSize = sizeof(BlockHeader) + size;
+    void*      memory    = nullptr;
+    if (alignment <= kPoolAlignment && blockSize <= classSize(SizeClassCount - 1)) {
+      // Pooled, in the smallest class that fits.
+      std::size_t sizeClass = 0;
+      while (classSize(sizeClass) < blockSize)
+        sizeClass++;
+
+      auto* block = takeBlock(mPools[index], sizeClass);
+      if (block == nullptr)
+        return nullptr;
+
+      new (block) BlockHeader{ size, alignment, static_cast<std::uint32_t>(sizeClass), static_cast<std::uint32_t>(index) };
+      memory = static_cast<std::byte*>(block) + sizeof(BlockHeader);
+    } else {
+      // Direct, with room for the header in front of the aligned allocation.
+      const auto offset = std::max(sizeof(BlockHeader), alignment);
+      auto*      base   = ::operator new(offset + size, std::align_val_t(std::max(alignment, kPoolAlignment)), std::nothrow);
+      if (base == nullptr)
+        return nullptr;
+
+      memory = static_cast<std::byte*>(base) + offset;
+      new (headerOf(memory)) BlockHeader{ size, alignment, kDirectClass, static_cast<std::uint32_t>(index) };
+    }
+
+    auto& counters = mCounters[index];
+    counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    addBytes(counters, size);
+    return memory;
+  }
+
+  void* HostAllocator::reallocate(void* original, std::size_t size, std::size_t alignment, VkSystemAllocationScope scope) noexcept {
+    // Behaves like allocate.
+    if (original == nullptr)
+      return allocate(size, alignment, scope);
+
+    // Behaves like free.
+    if (size == 0) {
+      deallocate(original);
+      return nullptr;
+    }
+
+    // Resize in place, if the block has room.
+    auto* header   = headerOf(original);
+    auto& counters = mCounters[header->scope];
+    counters.reallocations.fetch_add(1, std::memory_order_relaxed);
+    if (header->sizeClass != kDirectClass && sizeof(BlockHeader) + size <= classSize(header->sizeClass)) {
+      if (size > header->size)
+        addBytes(counters, size - header->size);
+      else
+        counters.bytes.fetch_sub(header->size - size, std::memory_order_relaxed);
+
+      header->size = size;
+      return original;
+    }
+
+    // Move, the original must stay valid if this fails.
+    auto* memory = allocate(size, alignment, scope);
+    if (memory == nullptr)
+      return nullptr;
+
+    std::memcpy(memory, original, std::min(size, header->size));
+    deallocate(original);
+    return memory;
+  }
+
+  void HostAllocator::deallocate(void* memory) noexcept {
+    // Nothing to free.
+    if (memory == nullptr)
+      return;
+
+    auto* header   = headerOf(memory);
+    auto& counters = mCounters[header->scope];
+    counters.frees.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_sub(header->size, std::memory_order_relaxed);
+
+    // Direct allocations go back to the system.
+    if (header->sizeClass == kDirectClass) {
+      const auto alignment = header->alignment;
+      auto*      base      = static_cast<std::byte*>(memory) - std::max(sizeof(BlockHeader), alignment);
+      ::operator delete(base, std::align_val_t(std::max(alignment, kPoolAlignment)));
+      return;
+    }
+
+    // Pooled blocks go back on their free list.
+    auto& pool = mPools[header->scope];
+    std::scoped_lock lock{ pool.lock };
+    void* block = header;
+    *static_cast<void**>(block)       = pool.freeLists[header->sizeClass];
+    pool.freeLists[header->sizeClass] = block;
+  }
+
+  void HostAllocator::internalAllocated(std::size_t size, VkSystemAllocationScope scope) noexcept {
+    mCounters[scopeIndex(scope)].internalBytes.fetch_add(size, std::memory_order_relaxed);
+  }
+
+  void HostAllocator::internalFreed(std::size_t size, VkSystemAllocationScope scope) noexcept {
+    mCounters[scopeIndex(scope)].internalBytes.fetch_sub(size, std::memory_order_relaxed);
+  }
+
+  void* HostAllocator::takeBlock(Pool& pool, std::size_t sizeClass) noexcept {
+    std::scoped_lock lock{ pool.lock };
+    auto& head = pool.freeLists[sizeClass];
+    if (head == nullptr) {
+      // Carve a new slab into blocks of this class.
+      std::unique_ptr<std::byte[]> slab(new (std::nothrow) std::byte[mSlabSize]);
+      if (slab == nullptr)
+        return nullptr;
+
+      try {
+        pool.slabs.push_back(nullptr);
+      } catch (...) {
+        return nullptr;
+      }
+
+      const auto blockSize = classSize(sizeClass);
+      for (std::size_t offset = 0; offset + blockSize <= mSlabSize; offset += blockSize) {
+        void* block = slab.get() + offset;
+        *static_cast<void**>(block) = head;
+        head = block;
+      }
+
+      pool.slabs.back() = std::move(slab);
+    }
+
+    void* block = head;
+    head = *static_cast<void**>(block);
+    return block;
+  }
+
+  void HostAllocator::addBytes(Counters& counters, std::uint64_t bytes) noexcept {
+    // Raise the peak if we went past it.
+    const auto current = counters.bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    auto       peak    = counters.peakBytes.load(std::memory_order_relaxed);
+    while (current > peak)
+      if (counters.peakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed))
+        break;
+  }
+
+}
@@ -0,0 +1,718 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <hearth/graphics/memalc.hpp>
+#include <hearth/profile.hpp>
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  /*!
+   * \brief A single device memory allocation, sub-allocated with a two level segregated fit.
+   *
+   * Free ranges are kept in lists segregated first by the power of two of their size, then by a
+   * linear subdivision of that power. A bitmap per level makes finding the smallest list that is
+   * guaranteed to fit a request a couple of bit scans. Ranges also link to their physical
+   * neighbours, so freeing merges with free neighbours immediately.
+   */
+  class MemoryBlock final {
+  public:
+    //! \brief Marks the absence of a node.
+    static constexpr std::uint32_t NullNode = std::numeric_limits<std::uint32_t>::max();
+
+  private:
+    //! \brief The log2 of the number of second level lists per first level.
+    static constexpr std::uint32_t SecondLevelBits = 4;
+
+    //! \brief The number of second level lists per first level.
+    static constexpr std::uint32_t SecondLevelCount = 1u << SecondLevelBits;
+
+    //! \brief The log2 of the size below which every range shares the first list.
+    static constexpr std::uint32_t SmallSizeBits = 8;
+
+    //! \brief The number of first level lists.
+    static constexpr std::uint32_t FirstLevelCount = 32;
+
+    //! \brief The smallest range worth splitting off as free.
+    static constexpr VkDeviceSize MinimumSplit = 256;
+
+    //! \brief A range of the block, either free or handed out.
+    struct Node {
+      VkDeviceSize  offset;
+      VkDeviceSize  size;
+      void*         userData;
+      VkDeviceSize  alignment;
+      std::uint32_t previousPhysical;
+      std::uint32_t nextPhysical;
+      std::uint32_t previousFree;
+      std::uint32_t nextFree;
+      bool          free;
+    };
+
+  public:
+    /*!
+     * \brief     Explicitly defined constructor, takes ownership of the given memory.
+     * \param[in] logicalDevice The device the memory was allocated from.
+     * \param[in] allocationCallbacks The callbacks the memory was allocated with.
+     * \param[in] memory The device memory of the block.
+     * \param[in] size The size of the device memory.
+     * \param[in] mapped The host address of the memory, if mapped.
+     * \param[in] memoryType The memory type of the memory.
+     */
+    MemoryBlock(VkDevice logicalDevice, const VkAllocationCallbacks* allocationCallbacks, VkDeviceMemory memory, VkDeviceSize size, void* mapped, std::uint32_t memoryType)
+      : mLogicalDevice(logicalDevice)
+      , mAllocationCallbacks(allocationCallbacks)
+      , mMemory(memory)
+      , mMapped(static_cast<std::byte*>(mapped))
+      , mSize(size)
+      , mUsed(0)
+      , mMemoryType(memoryType)
+      , mAllocationCount(0)
+      , mNodes()
+      , mRecycledNodes()
+      , mFreeLists()
+      , mSecondLevelMaps()
+      , mFirstLevelMap(0)
+    {
+      mFreeLists.fill(NullNode);
+      mSecondLevelMaps.fill(0);
+      insertFree(createNode(Node{
+        .offset           = 0,
+        .size             = size,
+        .userData         = nullptr,
+        .alignment        = 1,
+        .previousPhysical = NullNode,
+        .nextPhysical     = NullNode,
+        .previousFree     = NullNode,
+        .nextFree         = NullNode,
+        .free             = true
+      }));
+    }
+
+    //! \brief Explicitly defined destructor, frees the device memory.
+   ~MemoryBlock() noexcept {
+      if (mMapped != nullptr)
+        vkUnmapMemory(mLogicalDevice, mMemory);
+      vkFreeMemory(mLogicalDevice, mMemory, mAllocationCallbacks);
+    }
+
+    // Not allowed.
+    MemoryBlock(const MemoryBlock&) = delete;
+    MemoryBlock& operator=(const MemoryBlock&) = delete;
+
+  public:
+    /*!
+     * \brief     Hands out a range of the block.
+     * \param[in] size The size of the range.
+     * \param[in] alignment The alignment of the range's offset.
+     * \param[in] userData The user data to remember for the range.
+     * \return    The node of the range, or nothing if no free range fits.
+     */
+    std::optional<std::uint32_t> allocate(VkDeviceSize size, VkDeviceSize alignment, void* userData) {
+      alignment = std::max<VkDeviceSize>(alignment, 1);
+
+      // Any range from the found list fits, even when the worst alignment padding is needed.
+      auto found = findFree(size + alignment - 1);
+      if (found == NullNode)
+        return std::nullopt;
+      removeFree(found);
+
+      // Give the alignment padding back, the previous neighbour is never free.
+      const auto aligned = (mNodes[found].offset + alignment - 1) / alignment * alignment;
+      if (const auto padding = aligned - mNodes[found].offset; padding > 0) {
+        const auto back = split(found, padding);
+        insertFree(found);
+        found = back;
+      }
+
+      // Give the tail back, if large enough to be worth tracking.
+      if (mNodes[found].size - size >= MinimumSplit)
+        insertFree(split(found, size));
+
+      auto& node     = mNodes[found];
+      node.free      = false;
+      node.userData  = userData;
+      node.alignment = alignment;
+      mUsed += node.size;
+      mAllocationCount++;
+      return found;
+    }
+
+    /*!
+     * \brief     Gets the user data of a handed out range.
+     * \param[in] index The node of the range.
+     * \return    The user data the range was allocated with.
+     */
+    void* userData(std::uint32_t index) const noexcept {
+      return mNodes[index].userData;
+    }
+
+    /*!
+     * \brief     Replaces the user data of a handed out range.
+     * \param[in] index The node of the range.
+     * \param[in] userData The new user data.
+     */
+    void setUserData(std::uint32_t index, void* userData) noexcept {
+      mNodes[index].userData = userData;
+    }
+
+    /*!
+     * \brief     Returns a range to the block, merging it with free neighbours.
+     * \param[in] index The node of the range.
+     */
+    void free(std::uint32_t index) noexcept {
+      mUsed -= mNodes[index].size;
+      mAllocationCount--;
+      mNodes[index].free     = true;
+      mNodes[index].userData = nullptr;
+
+      // Merge with the previous neighbour.
+      if (const auto previous = mNodes[index].previousPhysical; previous != NullNode && mNodes[previous].free) {
+        removeFree(previous);
+        merge(previous, index);
+        index = previous;
+      }
+
+      // Merge with the next neighbour.
+      if (const auto next = mNodes[index].nextPhysical; next != NullNode && mNodes[next].free) {
+        removeFree(next);
+        merge(index, next);
+      }
+
+      insertFree(index);
+    }
+
+    /*!
+     * \brief  Computes the largest free range of the block.
+     * \return The size of the largest free range.
+     */
+    VkDeviceSize largestFree() const noexcept {
+      if (mFirstLevelMap == 0)
+        return 0;
+
+      // The largest range is in the highest non-empty list.
+      const auto firstLevel  = 31u - static_cast<std::uint32_t>(std::countl_zero(mFirstLevelMap));
+      const auto secondLevel = 31u - static_cast<std::uint32_t>(std::countl_zero(mSecondLevelMaps[firstLevel]));
+      VkDeviceSize largest = 0;
+      for (auto index = mFreeLists[firstLevel * SecondLevelCount + secondLevel]; index != NullNode; index = mNodes[index].nextFree)
+        largest = std::max(largest, mNodes[index].size);
+      return largest;
+    }
+
+    /*!
+     * \brief     Visits every handed out range of the block, in address order.
+     * \param[in] visitor The function to call with each node and its contents.
+     */
+    template<typename Visitor>
+    void forEachAllocation(Visitor&& visitor) const {
+      for (auto index = firstPhysical(); index != NullNode; index = mNodes[index].nextPhysical)
+        if (!mNodes[index].free)
+          visitor(index, mNodes[index]);
+    }
+
+    /*!
+     * \brief     Describes a range of this block as an allocation.
+     * \param[in] index The node of the range.
+     * \return    The allocation of the range.
+     */
+    Allocation describe(std::uint32_t index) noexcept {
+      return Allocation{
+        .memory     = mMemory,
+        .offset     = mNodes[index].offset,
+        .size       = mNodes[index].size,
+        .mapped     = mMapped != nullptr ? mMapped + mNodes[index].offset : nullptr,
+        .memoryType = mMemoryType,
+        .block      = this,
+        .node       = index
+      };
+    }
+
+    VkDeviceSize  size() const noexcept            { return mSize; }
+    VkDeviceSize  used() const noexcept            { return mUsed; }
+    std::size_t   allocationCount() const noexcept { return mAllocationCount; }
+    std::uint32_t memoryType() const noexcept      { return mMemoryType; }
+
+  private:
+    //! \brief Maps a size to the list it's stored in.
+    static std::pair<std::uint32_t, std::uint32_t> mapping(VkDeviceSize size) noexcept {
+      if (size < (VkDeviceSize(1) << SmallSizeBits))
+        return { 0, static_cast<std::uint32_t>(size >> (SmallSizeBits - SecondLevelBits)) };
+
+      const auto msb = 63u - static_cast<std::uint32_t>(std::countl_zero(size));
+      return {
+        std::min(msb - SmallSizeBits + 1, FirstLevelCount - 1),
+        static_cast<std::uint32_t>(size >> (msb - SecondLevelBits)) & (SecondLevelCount - 1)
+      };
+    }
+
+    //! \brief Finds a free node that is guaranteed to fit the given size, without removing it.
+    std::uint32_t findFree(VkDeviceSize size) const noexcept {
+      // Round up to the next list, so every range in the found list fits.
+      const auto msb = 63u - static_cast<std::uint32_t>(std::countl_zero(size | 1));
+      size += (VkDeviceSize(1) << (std::max(msb, SmallSizeBits) - SecondLevelBits)) - 1;
+
+      auto [firstLevel, secondLevel] = mapping(size);
+      auto secondLevelMap = mSecondLevelMaps[firstLevel] & (~0u << secondLevel);
+      if (secondLevelMap == 0) {
+        const auto firstLevelMap = firstLevel + 1 < FirstLevelCount ? mFirstLevelMap & (~0u << (firstLevel + 1)) : 0;
+        if (firstLevelMap == 0)
+          return NullNode;
+
+        firstLevel     = static_cast<std::uint32_t>(std::countr_zero(firstLevelMap));
+        secondLevelMap = mSecondLevelMaps[firstLevel];
+      }
+
+      secondLevel = static_cast<std::uint32_t>(std::countr_zero(secondLevelMap));
+      return mFreeLists[firstLevel * SecondLevelCount + secondLevel];
+    }
+
+    void insertFree(std::uint32_t index) noexcept {
+      const auto [firstLevel, secondLevel] = mapping(mNodes[index].size);
+      auto& head = mFreeLists[firstLevel * SecondLevelCount + secondLevel];
+      mNodes[index].free         = true;
+      mNodes[index].previousFree = NullNode;
+      mNodes[index].nextFree     = head;
+      if (head != NullNode)
+        mNodes[head].previousFree = index;
+      head = index;
+      mFirstLevelMap               |= 1u << firstLevel;
+      mSecondLevelMaps[firstLevel] |= 1u << secondLevel;
+    }
+
+    void removeFree(std::uint32_t index) noexcept {
+      const auto [firstLevel, secondLevel] = mapping(mNodes[index].size);
+      auto& head = mFreeLists[firstLevel * SecondLevelCount + secondLevel];
+      auto& node = mNodes[index];
+      if (node.previousFree != NullNode)
+        mNodes[node.previousFree].nextFree = node.nextFree;
+      else
+        head = node.nextFree;
+      if (node.nextFree != NullNode)
+        mNodes[node.nextFree].previousFree = node.previousFree;
+
+      // Clear the bitmaps once the list empties.
+      if (head == NullNode) {
+        mSecondLevelMaps[firstLevel] &= ~(1u << secondLevel);
+        if (mSecondLevelMaps[firstLevel] == 0)
+          mFirstLevelMap &= ~(1u << firstLevel);
+      }
+    }
+
+    //! \brief Splits the given node in two, the front keeps the given size. Returns the back.
+    std::uint32_t split(std::uint32_t index, VkDeviceSize size) {
+      const auto back = createNode(Node{
+        .offset           = mNodes[index].offset + size,
+        .size             = mNodes[index].size - size,
+        .userData         = nullptr,
+        .alignment        = 1,
+        .previousPhysical = index,
+        .nextPhysical     = mNodes[index].nextPhysical,
+        .previousFree     = NullNode,
+        .nextFree         = NullNode,
+        .free             = true
+      });
+
+      if (mNodes[back].nextPhysical != NullNode)
+        mNodes[mNodes[back].nextPhysical].previousPhysical = back;
+      mNodes[index].nextPhysical = back;
+      mNodes[index].size         = size;
+      return back;
+    }
+
+    //! \brief Merges the back node into the physically preceding front node.
+    void merge(std::uint32_t front, std::uint32_t back) noexcept {
+      mNodes[front].size        += mNodes[back].size;
+      mNodes[front].nextPhysical = mNodes[back].nextPhysical;
+      if (mNodes[front].nextPhysical != NullNode)
+        mNodes[mNodes[front].nextPhysical].previousPhysical = front;
+      mRecycledNodes.push_back(back);
+    }
+
+    std::uint32_t createNode(const Node& node) {
+      if (mRecycledNodes.empty()) {
+        mNodes.push_back(node);
+        return static_cast<std::uint32_t>(mNodes.size() - 1);
+      }
+
+      const auto index = mRecycledNodes.back();
+      mRecycledNodes.pop_back();
+      mNodes[index] = node;
+      return index;
+    }
+
+    //! \brief The node at offset zero is created first and only ever merged into.
+    std::uint32_t firstPhysical() const noexcept {
+      return 0;
+    }
+
+  private:
+    VkDevice                                                      mLogicalDevice;
+    const VkAllocationCallbacks*                                  mAllocationCallbacks;
+    VkDeviceMemory                                                mMemory;
+    std::byte*                                                    mMapped;
+    VkDeviceSize                                                  mSize;
+    VkDeviceSize                                                  mUsed;
+    std::uint32_t                                                 mMemoryType;
+    std::size_t                                                   mAllocationCount;
+    std::vector<Node>                                             mNodes;
+    std::vector<std::uint32_t>                                    mRecycledNodes;
+    std::array<std::uint32_t, FirstLevelCount * SecondLevelCount> mFreeLists;
+    std::array<std::uint32_t, FirstLevelCount>                    mSecondLevelMaps;
+    std::uint32_t                                                 mFirstLevelMap;
+  };
+
+  //! \brief The memory properties a usage requires, prefers and avoids.
+  struct MemoryPolicy {
+    std::uint32_t required;
+    std::uint32_t preferred;
+    std::uint32_t avoided;
+  };
+
+  static MemoryPolicy memoryPolicy(MemoryUsage usage) noexcept {
+    constexpr std::uint32_t hostMemory = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    switch (usage) {
+    case MemoryUsage::GpuOnly:
+      return { 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT };
+    case MemoryUsage::CpuToGpu:
+      return { hostMemory, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT };
+    case MemoryUsage::GpuToCpu:
+      return { hostMemory, VK_MEMORY_PROPERTY_HOST_CACHED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+    case MemoryUsage::CpuToGpuFrequent:
+      return { hostMemory, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT };
+    }
+    return { };
+  }
+
+  MemoryAllocator::MemoryAllocator(const CreateInfo& createInfo)
+    : mLogicalDevice(createInfo.logicalDevice)
+    , mAllocationCallbacks(createInfo.allocationCallbacks)
+    , mMemoryProperties{ }
+    , mHeaps()
+    , mDedicated()
+    , mLock()
+    , mBlockSize(createInfo.blockSize != 0 ? createInfo.blockSize : DefaultBlockSize)
+    , mDedicatedThreshold(createInfo.dedicatedThreshold)
+    , mDeviceAllocationCount(0)
+    , mMaxDeviceAllocationCount(0)
+    , mResizableBar(false)
+  {
+    HAPI_PROFILE_ZONE("gfx::MemoryAllocator::MemoryAllocator");
+
+    // Expects.
+    if (createInfo.physicalDevice == nullptr)
+      throw std::runtime_error("Memory allocator requires a physical device");
+    if (createInfo.logicalDevice == nullptr)
+      throw std::runtime_error("Memory allocator requires a logical device");
+
+    vkGetPhysicalDeviceMemoryProperties(createInfo.physicalDevice, &mMemoryProperties);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(createInfo.physicalDevice, &properties);
+    mMaxDeviceAllocationCount = properties.limits.maxMemoryAllocationCount;
+
+    if (mDedicatedThreshold == 0)
+      mDedicatedThreshold = mBlockSize / 2;
+
+    // Without resizable BAR, host visible device local memory is a small window of a larger heap.
+    VkDeviceSize largestDeviceHeap = 0;
+    VkDeviceSize largestVisibleHeap = 0;
+    for (std::uint32_t type = 0; type < mMemoryProperties.memoryTypeCount; type++) {
+      const auto flags    = mMemoryProperties.memoryTypes[type].propertyFlags;
+      const auto heapSize = mMemoryProperties.memoryHeaps[mMemoryProperties.memoryTypes[type].heapIndex].size;
+      if (flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) {
+        largestDeviceHeap = std::max(largestDeviceHeap, heapSize);
+        if (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+          largestVisibleHeap = std::max(largestVisibleHeap, heapSize);
+      }
+    }
+    mResizableBar = largestVisibleHeap != 0 && largestVisibleHeap == largestDeviceHeap;
+  }
+
+  MemoryAllocator::~MemoryAllocator() noexcept {
+    HAPI_PROFILE_ZONE("gfx::MemoryAllocator::~MemoryAllocator");
+
+    vkDeviceWaitIdle(mLogicalDevice);
+    for (auto& heap : mHeaps)
+      heap.blocks.clear();
+  }
+
+  Allocation MemoryAllocator::allocate(const AllocationInfo& allocationInfo) {
+    const auto& requirements = allocationInfo.requirements;
+    const auto  memoryType   = findMemoryType(requirements.memoryTypeBits, allocationInfo.usage);
+
+    std::scoped_lock lock{ mLock };
+
+    // Large resources would waste most of a block, give them memory of their own.
+    if (allocationInfo.dedicated || requirements.size >= mDedicatedThreshold) {
+      void* mapped = nullptr;
+      const auto memory = allocateDeviceMemory(memoryType, requirements.size, &mapped);
+      mDedicated[memoryType].first++;
+      mDedicated[memoryType].second += requirements.size;
+      return Allocation{
+        .memory     = memory,
+        .offset     = 0,
+        .size       = requirements.size,
+        .mapped     = mapped,
+        .memoryType = memoryType,
+        .block      = nullptr,
+        .node       = MemoryBlock::NullNode
+      };
+    }
+
+    // Try the existing blocks first, newest last as they're likely the emptiest.
+    auto& blocks = heap(memoryType, allocationInfo.kind).blocks;
+    for (auto& block : blocks)
+      if (const auto node = block->allocate(requirements.size, requirements.alignment, allocationInfo.userData))
+        return block->describe(*node);
+
+    void* mapped = nullptr;
+    const auto memory = allocateDeviceMemory(memoryType, mBlockSize, &mapped);
+    auto& block = blocks.emplace_back(std::make_unique<MemoryBlock>(mLogicalDevice, mAllocationCallbacks, memory, mBlockSize, mapped, memoryType));
+    const auto node = block->allocate(requirements.size, requirements.alignment, allocationInfo.userData);
+
+    // Ensures.
+    if (!node)
+      throw std::runtime_error("Unable to sub-allocate from a new memory block");
+
+    return block->describe(*node);
+  }
+
+  void MemoryAllocator::free(Allocation& allocation) noexcept {
+    if (allocation.memory == nullptr)
+      return;
+
+    std::scoped_lock lock{ mLock };
+    if (allocation.block == nullptr) {
+      if (allocation.mapped != nullptr)
+        vkUnmapMemory(mLogicalDevice, allocation.memory);
+      vkFreeMemory(mLogicalDevice, allocation.memory, mAllocationCallbacks);
+      mDedicated[allocation.memoryType].first--;
+      mDedicated[allocation.memoryType].second -= allocation.size;
+      mDeviceAllocationCount--;
+    } else {
+      auto* block = allocation.block;
+      block->free(allocation.node);
+
+      // Release empty blocks, but keep the last one of a heap around to avoid thrashing.
+      if (block->allocationCount() == 0) {
+        for (const auto kind : { AllocationKind::Buffer, AllocationKind::Image }) {
+          auto& heap = this->heap(block->memoryType(), kind);
+          auto  it = std::find_if(heap.blocks.begin(), heap.blocks.end(), [block](const auto& b) { return b.get() == block; });
+          if (it == heap.blocks.end())
+            continue;
+          if (heap.blocks.size() > 1) {
+            heap.blocks.erase(it);
+            mDeviceAllocationCount--;
+          }
+          break;
+        }
+      }
+    }
+
+    allocation = Allocation{
+      .memory     = nullptr,
+      .offset     = 0,
+      .size       = 0,
+      .mapped     = nullptr,
+      .memoryType = 0,
+      .block      = nullptr,
+      .node       = MemoryBlock::NullNode
+    };
+  }
+
+  void* MemoryAllocator::userData(const Allocation& allocation) const noexcept {
+    // Dedicated allocations are never moved, so they don't keep any.
+    if (allocation.block == nullptr)
+      return nullptr;
+
+    std::scoped_lock lock{ mLock };
+    return allocation.block->userData(allocation.node);
+  }
+
+  void MemoryAllocator::setUserData(const Allocation& allocation, void* userData) noexcept {
+    // Dedicated allocations are never moved, so they don't keep any.
+    if (allocation.block == nullptr)
+      return;
+
+    std::scoped_lock lock{ mLock };
+    allocation.block->setUserData(allocation.node, userData);
+  }
+
+  std::vector<DefragmentationMove> MemoryAllocator::planDefragmentation(VkDeviceSize maxBytes) {
+    std::scoped_lock lock{ mLock };
+    std::vector<DefragmentationMove> moves;
+    VkDeviceSize planned = 0;
+
+    for (auto& heap : mHeaps) {
+      if (heap.blocks.size() < 2)
+        continue;
+
+      // Empty the least used block into the others, never into a new block.
+      const auto source = std::min_element(heap.blocks.begin(), heap.blocks.end(), [](const auto& a, const auto& b) {
+        return a->used() < b->used();
+      })->get();
+
+      source->forEachAllocation([&](std::uint32_t index, const auto& node) {
+        if (node.userData == nullptr || planned + node.size > maxBytes)
+          return;
+
+        for (auto& destination : heap.blocks) {
+          if (destination.get() == source)
+            continue;
+
+          if (const auto moved = destination->allocate(node.size, node.alignment, node.userData)) {
+            moves.push_back(DefragmentationMove{
+              .userData    = node.userData,
+              .source      = source->describe(index),
+              .destination = destination->describe(*moved)
+            });
+            planned += node.size;
+            break;
+          }
+        }
+      });
+    }
+
+    return moves;
+  }
+
+  MemoryStatistics MemoryAllocator::statistics() const {
+    MemoryStatistics combined{ };
+    for (std::uint32_t type = 0; type < mMemoryProperties.memoryTypeCount; type++) {
+      const auto single = statistics(type);
+      combined.blockCount       += single.blockCount;
+      combined.allocationCount  += single.allocationCount;
+      combined.dedicatedCount   += single.dedicatedCount;
+      combined.blockBytes       += single.blockBytes;
+      combined.usedBytes        += single.usedBytes;
+      combined.dedicatedBytes   += single.dedicatedBytes;
+      combined.largestFreeRange  = std::max(combined.largestFreeRange, single.largestFreeRange);
+    }
+
+    return combined;
+  }
+
+  MemoryStatistics MemoryAllocator::statistics(std::uint32_t memoryType) const {
+    std::scoped_lock lock{ mLock };
+    MemoryStatistics single{ };
+    single.dedicatedCount = mDedicated[memoryType].first;
+    single.dedicatedBytes = mDedicated[memoryType].second;
+
+    for (const auto kind : { AllocationKind::Buffer, AllocationKind::Image }) {
+      for (const auto& block : mHeaps[memoryType * 2 + static_cast<std::uint32_t>(kind)].blocks) {
+        single.blockCount++;
+        single.allocationCount  += block->allocationCount();
+        single.blockBytes       += block->size();
+        single.usedBytes        += block->used();
+        single.largestFreeRange  = std::max(single.largestFreeRange, block->largestFree());
+      }
+    }
+
+    return single;
+  }
+
+  std::uint32_t MemoryAllocator::findMemoryType(std::uint32_t typeBits, MemoryUsage usage) const {
+    // Types that need special handling are never picked for ordinary resources.
+    constexpr std::uint32_t unusable = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT | VK_MEMORY_PROPERTY_PROTECTED_BIT;
+    const auto policy = memoryPolicy(usage);
+
+    // Score every suitable type, preferred properties add and avoided ones subtract.
+    std::optional<std::uint32_t> best;
+    std::pair<int, VkDeviceSize> bestScore{ };
+    for (std::uint32_t type = 0; type < mMemoryProperties.memoryTypeCount; type++) {
+      const auto flags = mMemoryProperties.memoryTypes[type].propertyFlags;
+      if (!(typeBits & (1u << type)) || (flags & policy.required) != policy.required || (flags & unusable))
+        continue;
+
+      // Ties go to the larger heap.
+      const std::pair<int, VkDeviceSize> score {
+        std::popcount(flags & policy.preferred) - std::popcount(flags & policy.avoided),
+        mMemoryProperties.memoryHeaps[mMemoryProperties.memoryTypes[type].heapIndex].size
+      };
+      if (!best || score > bestScore) {
+        best      = type;
+        bestScore = score;
+      }
+    }
+
+    if (!best)
+      throw std::runtime_error("Failed to find suitable memory type");
+    return *best;
+  }
+
+  MemoryPlacement MemoryAllocator::placement(std::uint32_t memoryType) const noexcept {
+    const auto flags = mMemoryProperties.memoryTypes[memoryType].propertyFlags;
+    return MemoryPlacement{
+      .memoryType    = memoryType,
+      .propertyFlags = flags,
+      .heapSize      = mMemoryProperties.memoryHeaps[mMemoryProperties.memoryTypes[memoryType].heapIndex].size,
+      .deviceLocal   = (flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0,
+      .hostVisible   = (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0,
+      .hostCached    = (flags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT) != 0
+    };
+  }
+
+  bool MemoryAllocator::resizableBar() const noexcept {
+    return mResizableBar;
+  }
+
+  const VkPhysicalDeviceMemoryProperties& MemoryAllocator::memoryProperties() const noexcept {
+    return mMemoryProperties;
+  }
+
+  VkDeviceMemory MemoryAllocator::allocateDeviceMemory(std::uint32_t memoryType, VkDeviceSize size, void** mapped) {
+    if (mDeviceAllocationCount >= mMaxDeviceAllocationCount)
+      throw std::runtime_error("Exceeded the device's memory allocation count");
+
+    VkMemoryAllocateInfo allocateInfo;
+    {
+      allocateInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+      allocateInfo.pNext           = nullptr;
+      allocateInfo.allocationSize  = size;
+      allocateInfo.memoryTypeIndex = memoryType;
+    }
+
+    VkDeviceMemory memory = nullptr;
+    if (vkAllocateMemory(mLogicalDevice, &allocateInfo, mAllocationCallbacks, &memory) != VK_SUCCESS)
+      throw std::runtime_error("Failed to allocate device memory");
+
+    // Host visible memory stays mapped for its lifetime.
+    *mapped = nullptr;
+    if (mMemoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+      if (vkMapMemory(mLogicalDevice, memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS) {
+        vkFreeMemory(mLogicalDevice, memory, mAllocationCallbacks);
+        throw std::runtime_error("Failed to map device memory");
+      }
+    }
+
+    mDeviceAllocationCount++;
+    return memory;
+  }
+
+  MemoryAllocator::Heap& MemoryAllocator::heap(std::uint32_t memoryType, AllocationKind kind) noexcept {
+    return mHeaps[memoryType * 2 + static_cast<std::uint32_t>(kind)];
+  }
+
+}
@@ -0,0 +1,298 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <hearth/graphics/pipcch.hpp>
+#include <hearth/profile.hpp>
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  // Identifies a Hearth pipeline cache file, "HPCF".
+  constexpr std::uint32_t kCacheMagic = 0x46435048;
+
+  // The version of the cache file layout, bump when the header changes.
+  constexpr std::uint32_t kCacheVersion = 1;
+
+  //! \brief The header written in front of the driver's cache data.
+  struct CacheFileHeader {
+    //! \brief Always kCacheMagic.
+    std::uint32_t magic;
+
+    //! \brief The layout version of the file.
+    std::uint32_t version;
+
+    //! \brief The vendor of the device the cache was created with.
+    std::uint32_t vendorId;
+
+    //! \brief The device the cache was created with.
+    std::uint32_t deviceId;
+
+    //! \brief The version of the driver the cache was created with.
+    std::uint32_t driverVersion;
+
+    //! \brief The pipeline cache UUID of the device the cache was created with.
+    std::uint8_t cacheUuid[VK_UUID_SIZE];
+
+    //! \brief The size of the driver's cache data following the header.
+    std::uint64_t dataSize;
+
+    //! \brief The FNV-1a hash of the driver's cache data.
+    std::uint64_t dataHash;
+  };
+
+  static std::uint64_t hashData(const std::uint8_t* data, std::size_t size) noexcept {
+    std::uint64_t hash = 0xCBF29CE484222325ull;
+    for (std::size_t index = 0; index < size; index++) {
+      hash ^= data[index];
+      hash *= 0x100000001B3ull;
+    }
+
+    return hash;
+  }
+
+  static VkPipelineCache createCache(
+          VkDevice                   logicalDevice,
+    const VkAllocationCallbacks*     allocationCallbacks,
+    const std::vector<std::uint8_t>& initialData
+  ) {
+    VkPipelineCacheCreateInfo cacheCreateInfo;
+    {
+      cacheCreateInfo.sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+      cacheCreateInfo.pNext           = nullptr;
+      cacheCreateInfo.flags           = 0;
+      cacheCreateInfo.initialDataSize = initialData.size();
+      cacheCreateInfo.pInitialData    = initialData.empty() ? nullptr : initialData.data();
+    }
+
+    VkPipelineCache pipelineCache = nullptr;
+    VkResult        result        = vkCreatePipelineCache(logicalDevice, &cacheCreateInfo, allocationCallbacks, &pipelineCache);
+    if (result != VK_SUCCESS)
+      throw std::runtime_error("Failed to create pipeline cache.");
+
+    return pipelineCache;
+  }
+
+  PipelineCache::PipelineCache() noexcept
+    : mPhysicalDevice(nullptr)
+    , mLogicalDevice(nullptr)
+    , mAllocationCallbacks(nullptr)
+    , mFilePath()
+    , mPipelineCache(nullptr)
+    , mThreadCaches()
+    , mLoaded(false)
+  { }
+
+  PipelineCache::PipelineCache(const CreateInfo& createInfo)
+    : mPhysicalDevice(createInfo.physicalDevice)
+    , mLogicalDevice(createInfo.logicalDevice)
+    , mAllocationCallbacks(createInfo.allocationCallbacks)
+    , mFilePath(createInfo.filePath != nullptr ? createInfo.filePath : "")
+    , mPipelineCache(nullptr)
+    , mThreadCaches()
+    , mLoaded(false)
+  {
+    HAPI_PROFILE_ZONE("gfx::PipelineCache::PipelineCache");
+
+    // Start from what the last run compiled, if it was compiled for this device and driver.
+    auto initialData = readCacheFile();
+    mLoaded = !initialData.empty();
+
+    // Every cache starts with the loaded data, so pipelines hit no matter which thread creates them.
+    mPipelineCache = createCache(mLogicalDevice, mAllocationCallbacks, initialData);
+    mThreadCaches.reserve(createInfo.threadCount);
+    try {
+      for (std::uint32_t index = 0; index < createInfo.threadCount; index++)
+        mThreadCaches.push_back(createCache(mLogicalDevice, mAllocationCallbacks, initialData));
+    } catch (...) {
+      for (auto threadCache : mThreadCaches)
+        vkDestroyPipelineCache(mLogicalDevice, threadCache, mAllocationCallbacks);
+      vkDestroyPipelineCache(mLogicalDevice, mPipelineCache, mAllocationCallbacks);
+      throw;
+    }
+  }
+
+  PipelineCache::~PipelineCache() noexcept {
+    // Wasn't created or was moved.
+    if (mPipelineCache == nullptr)
+      return;
+
+    HAPI_PROFILE_ZONE("gfx::PipelineCache::~PipelineCache");
+
+    // Losing the cache only costs compile time next run, don't let it stop shutdown.
+    try {
+      save();
+    } catch (const std::exception& err) {
+      std::cerr << err.what() << std::endl;
+    }
+
+    for (auto threadCache : mThreadCaches)
+      vkDestroyPipelineCache(mLogicalDevice, threadCache, mAllocationCallbacks);
+
+    vkDestroyPipelineCache(mLogicalDevice, mPipelineCache, mAllocationCallbacks);
+  }
+
+  PipelineCache::PipelineCache(PipelineCache&& other) noexcept
+    : mPhysicalDevice(std::move(other.mPhysicalDevice))
+    , mLogicalDevice(std::move(other.mLogicalDevice))
+    , mAllocationCallbacks(std::move(other.mAllocationCallbacks))
+    , mFilePath(std::move(other.mFilePath))
+    , mPipelineCache(std::move(other.mPipelineCache))
+    , mThreadCaches(std::move(other.mThreadCaches))
+    , mLoaded(other.mLoaded)
+  {
+    // Ensures.
+    other.mPhysicalDevice      = nullptr;
+    other.mLogicalDevice       = nullptr;
+    other.mAllocationCallbacks = nullptr;
+    other.mPipelineCache       = nullptr;
+    other.mLoaded              = false;
+  }
+
+  PipelineCache& PipelineCache::operator=(PipelineCache&& other) noexcept {
+    std::swap(mPhysicalDevice,      other.mPhysicalDevice);
+    std::swap(mLogicalDevice,       other.mLogicalDevice);
+    std::swap(mAllocationCallbacks, other.mAllocationCallbacks);
+    std::swap(mFilePath,            other.mFilePath);
+    std::swap(mPipelineCache,       other.mPipelineCache);
+    std::swap(mThreadCaches,        other.mThreadCaches);
+    std::swap(mLoaded,              other.mLoaded);
+    return *this;
+  }
+
+  VkPipelineCache PipelineCache::handle() const noexcept {
+    return mPipelineCache;
+  }
+
+  VkPipelineCache PipelineCache::threadHandle(std::uint32_t threadIndex) const noexcept {
+    return threadIndex < mThreadCaches.size() ? mThreadCaches[threadIndex] : mPipelineCache;
+  }
+
+  bool PipelineCache::loaded() const noexcept {
+    return mLoaded;
+  }
+
+  void PipelineCache::save() {
+    // Nowhere to save to.
+    if (mFilePath.empty())
+      return;
+
+    HAPI_PROFILE_ZONE("gfx::PipelineCache::save");
+
+    // Gather what every thread compiled.
+    if (!mThreadCaches.empty()) {
+      VkResult result = vkMergePipelineCaches(mLogicalDevice, mPipelineCache, static_cast<std::uint32_t>(mThreadCaches.size()), mThreadCaches.data());
+      if (result != VK_SUCCESS)
+        throw std::runtime_error("Failed to merge pipeline caches.");
+    }
+
+    std::size_t dataSize = 0;
+    VkResult    result   = vkGetPipelineCacheData(mLogicalDevice, mPipelineCache, &dataSize, nullptr);
+    if (result != VK_SUCCESS)
+      throw std::runtime_error("Failed to get pipeline cache size.");
+
+    std::vector<std::uint8_t> data(dataSize);
+    result = vkGetPipelineCacheData(mLogicalDevice, mPipelineCache, &dataSize, data.data());
+    if (result != VK_SUCCESS && result != VK_INCOMPLETE)
+      throw std::runtime_error("Failed to get pipeline cache data.");
+
+    data.resize(dataSize);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(mPhysicalDevice, &properties);
+
+    CacheFileHeader header;
+    {
+      header.magic         = kCacheMagic;
+      header.version       = kCacheVersion;
+      header.vendorId      = properties.vendorID;
+      header.deviceId      = properties.deviceID;
+      header.driverVersion = properties.driverVersion;
+      header.dataSize      = data.size();
+      header.dataHash      = hashData(data.data(), data.size());
+      std::memcpy(header.cacheUuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    }
+
+    // Write everything to a temporary file first, then swap it in with a single rename.
+    const std::filesystem::path filePath(mFilePath);
+    auto temporaryPath = filePath;
+    temporaryPath += ".tmp";
+    {
+      std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+      if (!file.is_open())
+        throw std::runtime_error("Failed to open pipeline cache file for writing.");
+
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+      file.flush();
+      if (!file.good())
+        throw std::runtime_error("Failed to write pipeline cache file.");
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, filePath, error);
+    if (error) {
+      std::filesystem::remove(temporaryPath, error);
+      throw std::runtime_error("Failed to replace pipeline cache file.");
+    }
+  }
+
+  std::vector<std::uint8_t> PipelineCache::readCacheFile() const {
+    // Nothing to load.
+    if (mFilePath.empty())
+      return { };
+
+    std::ifstream file(mFilePath, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+      return { };
+
+    const auto fileSize = static_cast<std::size_t>(file.tellg());
+    if (fileSize < sizeof(CacheFileHeader))
+      return { };
+
+    CacheFileHeader header;
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    // A cache from another device or driver would be rejected by the driver at best.
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(mPhysicalDevice, &properties);
+    if (header.magic         != kCacheMagic               ||
+        header.version       != kCacheVersion             ||
+        header.vendorId      != properties.vendorID       ||
+        header.deviceId      != properties.deviceID       ||
+        header.driverVersion != properties.driverVersion  ||
+        header.dataSize      != fileSize - sizeof(header) ||
+        std::memcmp(header.cacheUuid, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+      return { };
+
+    std::vector<std::uint8_t> data(header.dataSize);
+    file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    if (!file.good() || hashData(data.data(), data.size()) != header.dataHash)
+      return { };
+
+    return data;
+  }
+
+}
@@ -0,0 +1,247 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <stdexcept>
+#include <hearth/alloctracker.hpp>
+#include <hearth/scheduler.hpp>
+#include <hearth/graphics/pipcch.hpp>
+#include <hearth/graphics/pipcmp.hpp>
+#include <hearth/graphics/shdmod.hpp>
+#include <hearth/profile.hpp>
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  struct PipelineHandle::Build {
+    //! \brief The information the pipeline is created with, pointing into the copies below.
+    Pipeline::CreateInfo createInfo;
+
+    //! \brief The copied vertex binding descriptions.
+    std::vector<BindingDescription> bindings;
+
+    //! \brief The copied vertex attribute descriptions.
+    std::vector<AttributeDescription> attributes;
+
+    //! \brief The copied color blend attachments.
+    std::vector<ColorBlendAttachment> blendAttachments;
+
+    //! \brief The copied color blend state.
+    ColorBlendState colorBlending;
+
+    //! \brief Keeps the vertex shader alive until compiled, if owned by a shader library.
+    std::shared_ptr<const ShaderModule> vertexShader;
+
+    //! \brief Keeps the fragment shader alive until compiled, if owned by a shader library.
+    std::shared_ptr<const ShaderModule> fragmentShader;
+
+    //! \brief Keeps the base pipeline alive until compiled, if derived from a handle.
+    std::shared_ptr<Build> base;
+
+    //! \brief The pipeline cache to compile through, may be null.
+    const PipelineCache* pipelineCache;
+
+    //! \brief The compiled pipeline, only valid once ready.
+    Pipeline pipeline;
+
+    //! \brief Counts the compilation job, for waiting on it.
+    JobCounter counter;
+
+    //! \brief The state of the compilation.
+    std::atomic<PipelineStatus> status;
+  };
+
+  PipelineHandle::PipelineHandle(std::shared_ptr<Build> build) noexcept
+    : mBuild(std::move(build))
+  { }
+
+  PipelineStatus PipelineHandle::status() const noexcept {
+    return mBuild != nullptr ? mBuild->status.load(std::memory_order_acquire) : PipelineStatus::Failed;
+  }
+
+  bool PipelineHandle::ready() const noexcept {
+    return status() == PipelineStatus::Ready;
+  }
+
+  const Pipeline* PipelineHandle::get() const noexcept {
+    return ready() ? &mBuild->pipeline : nullptr;
+  }
+
+  const Pipeline* PipelineHandle::resolve(const Pipeline* fallback) const noexcept {
+    const auto* pipeline = get();
+    return pipeline != nullptr ? pipeline : fallback;
+  }
+
+  PipelineCompiler::PipelineCompiler(const CreateInfo& createInfo)
+    : mScheduler(createInfo.scheduler)
+    , mPipelineCache(createInfo.pipelineCache)
+    , mBuilds()
+    , mLock()
+  {
+    // Expects.
+    if (mScheduler == nullptr)
+      throw std::runtime_error("Expected job scheduler for pipeline compiler.");
+  }
+
+  PipelineCompiler::~PipelineCompiler() noexcept {
+    HAPI_PROFILE_ZONE("gfx::PipelineCompiler::~PipelineCompiler");
+
+    // Jobs still refer to their compilations, and through them to this compiler's cache.
+    waitAll();
+  }
+
+  PipelineHandle PipelineCompiler::compile(const Pipeline::CreateInfo& createInfo, const PipelineHandle& base) {
+    HAPI_PROFILE_ZONE("gfx::PipelineCompiler::compile");
+
+    // Materials may show up mid-game, copying their state is expected to allocate.
+    const AllocationTracker::Exemption exemption;
+
+    auto build = std::make_shared<PipelineHandle::Build>();
+    build->createInfo    = createInfo;
+    build->pipelineCache = mPipelineCache;
+    build->status.store(PipelineStatus::Pending, std::memory_order_relaxed);
+
+    // Copy everything the caller may let go of once this returns.
+    build->bindings.reserve(createInfo.vertexBindings.size());
+    for (const auto* binding : createInfo.vertexBindings)
+      build->bindings.push_back(*binding);
+
+    build->attributes.reserve(createInfo.vertexAttributes.size());
+    for (const auto* attribute : createInfo.vertexAttributes)
+      build->attributes.push_back(*attribute);
+
+    build->createInfo.vertexBindings.clear();
+    for (const auto& binding : build->bindings)
+      build->createInfo.vertexBindings.push_back(&binding);
+
+    build->createInfo.vertexAttributes.clear();
+    for (const auto& attribute : build->attributes)
+      build->createInfo.vertexAttributes.push_back(&attribute);
+
+    if (createInfo.colorBlending != nullptr) {
+      build->colorBlending = *createInfo.colorBlending;
+      build->blendAttachments.reserve(createInfo.colorBlending->attachments.size());
+      for (const auto* attachment : createInfo.colorBlending->attachments)
+        build->blendAttachments.push_back(*attachment);
+
+      build->colorBlending.attachments.clear();
+      for (const auto& attachment : build->blendAttachments)
+        build->colorBlending.attachments.push_back(&attachment);
+
+      build->createInfo.colorBlending = &build->colorBlending;
+    }
+
+    if (createInfo.vertexShader != nullptr)
+      build->vertexShader = createInfo.vertexShader->weak_from_this().lock();
+
+    if (createInfo.fragmentShader != nullptr)
+      build->fragmentShader = createInfo.fragmentShader->weak_from_this().lock();
+
+    // Deriving is only a faster way to compile, don't wait on a base that isn't ready.
+    if (createInfo.base == nullptr && base.ready() && base.mBuild->createInfo.allowDerivatives) {
+      build->base            = base.mBuild;
+      build->createInfo.base = &base.mBuild->pipeline;
+    }
+
+    {
+      std::scoped_lock lock{ mLock };
+      collectFinished();
+      mBuilds.push_back(build);
+    }
+
+    // The compiler keeps the build alive until the job has let go of its counter.
+    mScheduler->schedule(Job{
+      .function = &PipelineCompiler::compileJob,
+      .data     = build.get(),
+      .counter  = &build->counter,
+      .affinity = JobAffinity::Background
+    });
+
+    return PipelineHandle(std::move(build));
+  }
+
+  const Pipeline* PipelineCompiler::wait(const PipelineHandle& handle) {
+    // Nothing to wait on.
+    if (handle.mBuild == nullptr)
+      return nullptr;
+
+    mScheduler->wait(handle.mBuild->counter);
+    return handle.get();
+  }
+
+  void PipelineCompiler::waitAll() {
+    std::vector<std::shared_ptr<PipelineHandle::Build>> builds;
+    {
+      std::scoped_lock lock{ mLock };
+      builds.swap(mBuilds);
+    }
+
+    for (auto& build : builds)
+      mScheduler->wait(build->counter);
+  }
+
+  std::size_t PipelineCompiler::pending() const {
+    std::scoped_lock lock{ mLock };
+    return static_cast<std::size_t>(std::count_if(mBuilds.begin(), mBuilds.end(), [](const auto& build) {
+      return build->status.load(std::memory_order_acquire) == PipelineStatus::Pending;
+    }));
+  }
+
+  void PipelineCompiler::compileJob(void* data) noexcept {
+    HAPI_PROFILE_ZONE("gfx::PipelineCompiler::compileJob");
+
+    // Compiling allocates in the driver and here, mid-game too, without being part of any frame.
+    const AllocationTracker::Exemption exemption;
+
+    auto* build = static_cast<PipelineHandle::Build*>(data);
+
+    // Compile through this worker's own cache, so workers don't contend on the driver's.
+    if (build->pipelineCache != nullptr)
+      build->createInfo.pipelineCache = build->pipelineCache->threadHandle(JobScheduler::workerIndex());
+
+    // Jobs must not throw, a pipeline that fails to compile is reported through its status.
+    try {
+      build->pipeline = Pipeline(build->createInfo);
+      build->status.store(PipelineStatus::Ready, std::memory_order_release);
+    } catch (const std::exception& err) {
+      std::cerr << err.what() << std::endl;
+      build->status.store(PipelineStatus::Failed, std::memory_order_release);
+    }
+
+    // Shaders and the base are only needed while compiling.
+    build->vertexShader.reset();
+    build->fragmentShader.reset();
+    build->base.reset();
+  }
+
+  void PipelineCompiler::collectFinished() {
+    // Waiting on a finished counter only makes sure its job has let go of it.
+    std::erase_if(mBuilds, [this](const auto& build) {
+      if (!build->counter.done())
+        return false;
+
+      mScheduler->wait(build->counter);
+      return true;
+    });
+  }
+
+}
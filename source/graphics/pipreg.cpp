@@ -0,0 +1,217 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <hearth/graphics/pipreg.hpp>
+#include <hearth/graphics/shdmod.hpp>
+#include <hearth/profile.hpp>
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  // Stands in for optional state that isn't set, no real value flattens to it.
+  constexpr std::uint64_t kAbsent = ~std::uint64_t(0);
+
+  static std::uint64_t handleWord(const void* handle) noexcept {
+    return static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(handle));
+  }
+
+  static std::uint64_t topologyClass(TopologyType topology) noexcept {
+    // A dynamic topology only has to match the class of the one the pipeline was created with.
+    switch (topology) {
+      case TopologyType::PointList:
+        return 0;
+      case TopologyType::LineList:
+      case TopologyType::LineStrip:
+      case TopologyType::LineListWithAdjacency:
+      case TopologyType::LineStripWithAdjacency:
+        return 1;
+      case TopologyType::PatchList:
+        return 3;
+      default:
+        return 2;
+    }
+  }
+
+  PipelineKey::PipelineKey(const Pipeline::CreateInfo& createInfo)
+    : mWords()
+    , mHash(0)
+  {
+    // Vertex layout, in binding and location order so listing order doesn't matter.
+    auto bindings = createInfo.vertexBindings;
+    std::sort(bindings.begin(), bindings.end(), [](const auto* lhs, const auto* rhs) {
+      return lhs->binding < rhs->binding;
+    });
+
+    auto attributes = createInfo.vertexAttributes;
+    std::sort(attributes.begin(), attributes.end(), [](const auto* lhs, const auto* rhs) {
+      return lhs->location < rhs->location;
+    });
+
+    mWords.push_back(bindings.size());
+    for (const auto* binding : bindings) {
+      mWords.push_back(binding->binding);
+      mWords.push_back(binding->stride);
+    }
+
+    mWords.push_back(attributes.size());
+    for (const auto* attribute : attributes) {
+      mWords.push_back(attribute->location);
+      mWords.push_back(attribute->binding);
+      mWords.push_back(static_cast<std::uint64_t>(attribute->format));
+      mWords.push_back(attribute->offset);
+    }
+
+    // Shaders, by the code they were created from and by module, since hashes of different code
+    // may collide. The shader library hands out one module per distinct code, so equal code still
+    // keys equal.
+    for (const auto& shader : { createInfo.vertexShader, createInfo.fragmentShader }) {
+      mWords.push_back(shader != nullptr ? shader->hash() : kAbsent);
+      mWords.push_back(shader != nullptr ? handleWord(shader->handle()) : kAbsent);
+    }
+
+    // States set on the command buffer don't tell pipelines apart, only leave the baked ones in.
+    const auto dynamic = [&](std::uint32_t state) {
+      return (createInfo.dynamicStates & state) != 0;
+    };
+
+    mWords.push_back(createInfo.dynamicStates);
+
+    // Blending, attachment order matters since it matches the subpass's color attachments.
+    if (const auto* blending = createInfo.colorBlending) {
+      mWords.push_back(blending->attachments.size());
+      for (const auto* attachment : blending->attachments) {
+        std::uint64_t word = 0;
+        if (!dynamic(DynamicStateColorBlendEquationBit)) {
+          word |= static_cast<std::uint64_t>(attachment->srcColorFactor)      |
+                  static_cast<std::uint64_t>(attachment->dstColorFactor) << 8  |
+                  static_cast<std::uint64_t>(attachment->colorOp)        << 16 |
+                  static_cast<std::uint64_t>(attachment->srcAlphaFactor) << 24 |
+                  static_cast<std::uint64_t>(attachment->dstAlphaFactor) << 32 |
+                  static_cast<std::uint64_t>(attachment->alphaOp)        << 40;
+        }
+
+        if (!dynamic(DynamicStateColorWriteMaskBit))
+          word |= static_cast<std::uint64_t>(attachment->colorWriteMask) << 48;
+        if (!dynamic(DynamicStateColorBlendEnableBit))
+          word |= static_cast<std::uint64_t>(attachment->blendEnabled) << 56;
+
+        mWords.push_back(word);
+      }
+
+      if (!dynamic(DynamicStateBlendConstantsBit))
+        for (const auto constant : blending->blendConstants)
+          mWords.push_back(std::bit_cast<std::uint32_t>(constant));
+
+      if (!blending->logicOpEnabled)
+        mWords.push_back(kAbsent);
+      else
+        mWords.push_back(dynamic(DynamicStateLogicOpBit) ? 0 : static_cast<std::uint64_t>(blending->logicOp));
+    } else {
+      mWords.push_back(kAbsent);
+    }
+
+    // Rasterization.
+    const auto topology  = dynamic(DynamicStateTopologyBit)    ? topologyClass(createInfo.topology) : static_cast<std::uint64_t>(createInfo.topology);
+    const auto polygon   = dynamic(DynamicStatePolygonModeBit) ? 0 : static_cast<std::uint64_t>(createInfo.polygonMode);
+    const auto cullMode  = dynamic(DynamicStateCullModeBit)    ? 0 : static_cast<std::uint64_t>(createInfo.cullMode);
+    const auto frontFace = dynamic(DynamicStateFrontFaceBit)   ? 0 : static_cast<std::uint64_t>(createInfo.frontFace);
+    const auto lineWidth = dynamic(DynamicStateLineWidthBit)   ? 0 : static_cast<std::uint64_t>(std::bit_cast<std::uint32_t>(createInfo.lineWidth));
+    mWords.push_back(topology | polygon << 8 | cullMode << 16 | frontFace << 24 | lineWidth << 32);
+
+    // Layout and render pass, the pipeline is only compatible with the exact objects.
+    mWords.push_back(createInfo.layout != nullptr ? handleWord(createInfo.layout->handle()) : kAbsent);
+    mWords.push_back(handleWord(createInfo.renderPass));
+    mWords.push_back(createInfo.subpass);
+
+    // FNV-1a over the words.
+    std::uint64_t hash = 0xCBF29CE484222325ull;
+    for (const auto word : mWords) {
+      hash ^= word;
+      hash *= 0x100000001B3ull;
+    }
+
+    mHash = static_cast<std::size_t>(hash);
+  }
+
+  std::size_t PipelineKey::hash() const noexcept {
+    return mHash;
+  }
+
+  bool PipelineKey::operator==(const PipelineKey& other) const noexcept {
+    return mHash == other.mHash && mWords == other.mWords;
+  }
+
+  PipelineRegistry::PipelineRegistry(const CreateInfo& createInfo)
+    : mCompiler(createInfo.compiler)
+    , mPipelines()
+    , mHits(0)
+    , mLock()
+  {
+    // Expects.
+    if (mCompiler == nullptr)
+      throw std::runtime_error("Expected pipeline compiler for pipeline registry.");
+  }
+
+  PipelineHandle PipelineRegistry::acquire(const Pipeline::CreateInfo& createInfo, const PipelineHandle& base) {
+    HAPI_PROFILE_ZONE("gfx::PipelineRegistry::acquire");
+
+    PipelineKey key(createInfo);
+    std::scoped_lock lock{ mLock };
+    auto itr = mPipelines.find(key);
+    if (itr != mPipelines.end()) {
+      // Failures aren't cached, the next acquire compiles again.
+      if (itr->second.status() != PipelineStatus::Failed) {
+        mHits++;
+        return itr->second;
+      }
+    }
+
+    // Every registered state can be the base of the next similar one.
+    auto registeredCreateInfo = createInfo;
+    registeredCreateInfo.allowDerivatives = true;
+
+    auto handle = mCompiler->compile(registeredCreateInfo, base);
+    if (itr != mPipelines.end())
+      itr->second = handle;
+    else
+      mPipelines.emplace(std::move(key), handle);
+
+    return handle;
+  }
+
+  void PipelineRegistry::clear() {
+    std::scoped_lock lock{ mLock };
+    mPipelines.clear();
+  }
+
+  std::size_t PipelineRegistry::size() const {
+    std::scoped_lock lock{ mLock };
+    return mPipelines.size();
+  }
+
+  std::uint64_t PipelineRegistry::hits() const {
+    std::scoped_lock lock{ mLock };
+    return mHits;
+  }
+
+}
@@ -20,6 +20,7 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 #pragma once
+#include <array>
 #include <cstdint>
 #include <optional>
 #include <utility>
@@ -38,9 +39,12 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     //! \brief The present queue family.
     std::optional<std::uint32_t> present;
 
+    //! \brief A transfer queue family without graphics support, if the device has one.
+    std::optional<std::uint32_t> transfer;
+
     /*!
      * \brief  Checks if the queue families are complete.
-     * \return True if all queue families have a value.
+     * \return True if all required queue families have a value, the transfer family is optional.
      */
     bool isComplete() const noexcept {
       return graphics.has_value() && present.has_value();
@@ -81,6 +85,16 @@ namespace HAPI_NAMESPACE_NAME::gfx {
         break;
     }
 
+    // Find a transfer only family, preferring one without compute as it's most likely a DMA engine.
+    const std::array<VkQueueFlags, 2> exclusions { VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT };
+    for (const auto excluded : exclusions) {
+      for (std::size_t index = 0; index < queueFamilyCount && !indices.transfer.has_value(); index++) {
+        const auto flags = availableFamilies[index].queueFlags;
+        if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & excluded))
+          indices.transfer = index;
+      }
+    }
+
     // Finally return.
     return indices;
   }
@@ -29,6 +29,8 @@
 #include <vector>
 #include <hearth/version.hpp>
 #include <hearth/graphics/rdrctx.hpp>
+#include <hearth/graphics/gfxpip.hpp>
+#include <hearth/profile.hpp>
 #if defined(HAPI_WINDOWS_OS)
 #  include "../win32/winapi.hpp"
 #  include "../win32/window.hpp"
@@ -62,6 +64,11 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     VK_KHR_SWAPCHAIN_EXTENSION_NAME
   };
 
+  // The dynamic states each of the extended dynamic state extensions provide.
+  constexpr std::uint32_t gExtendedDynamicStateBits  = DynamicStateCullModeBit | DynamicStateFrontFaceBit | DynamicStateTopologyBit;
+  constexpr std::uint32_t gExtendedDynamicState2Bits = DynamicStateLogicOpBit;
+  constexpr std::uint32_t gExtendedDynamicState3Bits = DynamicStatePolygonModeBit | DynamicStateColorBlendEnableBit | DynamicStateColorBlendEquationBit | DynamicStateColorWriteMaskBit;
+
 #if defined(HAPI_DEBUG)
   constexpr std::array<const char*, 1> gValidationLayers {
     "VK_LAYER_KHRONOS_validation"
@@ -129,6 +136,123 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     return requiredExtensions.empty();
   }
 
+  static bool checkOptionalExtensionSupport(VkPhysicalDevice physicalDevice, const char* extensionName) noexcept {
+    std::uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+    for (const auto& extension: availableExtensions)
+      if (std::strcmp(extension.extensionName, extensionName) == 0)
+        return true;
+
+    return false;
+  }
+
+  static bool checkTimelineSemaphoreSupport(VkPhysicalDevice physicalDevice) noexcept {
+    // The extension being listed doesn't mean the feature is, check both.
+    if (!checkOptionalExtensionSupport(physicalDevice, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME))
+      return false;
+
+    VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures;
+    {
+      timelineFeatures.sType             = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+      timelineFeatures.pNext             = nullptr;
+      timelineFeatures.timelineSemaphore = VK_FALSE;
+    }
+
+    VkPhysicalDeviceFeatures2 features;
+    {
+      features.sType    = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+      features.pNext    = &timelineFeatures;
+      features.features = VkPhysicalDeviceFeatures{ };
+    }
+
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+    return timelineFeatures.timelineSemaphore == VK_TRUE;
+  }
+
+  // The features of every extended dynamic state extension the vulkan headers declare. Levels
+  // missing from older headers drop out, and are never reported as supported.
+  struct ExtendedDynamicStateFeatures {
+#if defined(VK_EXT_extended_dynamic_state)
+    VkPhysicalDeviceExtendedDynamicStateFeaturesEXT eds1;
+#endif
+#if defined(VK_EXT_extended_dynamic_state2)
+    VkPhysicalDeviceExtendedDynamicState2FeaturesEXT eds2;
+#endif
+#if defined(VK_EXT_extended_dynamic_state3)
+    VkPhysicalDeviceExtendedDynamicState3FeaturesEXT eds3;
+#endif
+  };
+
+  static std::uint32_t checkExtendedDynamicStateSupport(VkPhysicalDevice physicalDevice, [[maybe_unused]] ExtendedDynamicStateFeatures& edsFeatures) noexcept {
+    // Only chain the features of extensions the device lists, the others stay zeroed.
+    void* featureChain = nullptr;
+#if defined(VK_EXT_extended_dynamic_state3)
+    edsFeatures.eds3       = VkPhysicalDeviceExtendedDynamicState3FeaturesEXT{ };
+    edsFeatures.eds3.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+    if (checkOptionalExtensionSupport(physicalDevice, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME)) {
+      edsFeatures.eds3.pNext = featureChain;
+      featureChain           = &edsFeatures.eds3;
+    }
+#endif
+
+#if defined(VK_EXT_extended_dynamic_state2)
+    edsFeatures.eds2       = VkPhysicalDeviceExtendedDynamicState2FeaturesEXT{ };
+    edsFeatures.eds2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT;
+    if (checkOptionalExtensionSupport(physicalDevice, VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME)) {
+      edsFeatures.eds2.pNext = featureChain;
+      featureChain           = &edsFeatures.eds2;
+    }
+#endif
+
+#if defined(VK_EXT_extended_dynamic_state)
+    edsFeatures.eds1       = VkPhysicalDeviceExtendedDynamicStateFeaturesEXT{ };
+    edsFeatures.eds1.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+    if (checkOptionalExtensionSupport(physicalDevice, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME)) {
+      edsFeatures.eds1.pNext = featureChain;
+      featureChain           = &edsFeatures.eds1;
+    }
+#endif
+
+    // Nothing to query.
+    if (featureChain == nullptr)
+      return DynamicStateCoreBits;
+
+    VkPhysicalDeviceFeatures2 features;
+    {
+      features.sType    = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+      features.pNext    = featureChain;
+      features.features = VkPhysicalDeviceFeatures{ };
+    }
+
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    std::uint32_t support = DynamicStateCoreBits;
+#if defined(VK_EXT_extended_dynamic_state)
+    if (edsFeatures.eds1.extendedDynamicState == VK_TRUE)
+      support |= gExtendedDynamicStateBits;
+#endif
+#if defined(VK_EXT_extended_dynamic_state2)
+    if (edsFeatures.eds2.extendedDynamicState2LogicOp == VK_TRUE)
+      support |= DynamicStateLogicOpBit;
+#endif
+#if defined(VK_EXT_extended_dynamic_state3)
+    if (edsFeatures.eds3.extendedDynamicState3PolygonMode == VK_TRUE)
+      support |= DynamicStatePolygonModeBit;
+    if (edsFeatures.eds3.extendedDynamicState3ColorBlendEnable == VK_TRUE)
+      support |= DynamicStateColorBlendEnableBit;
+    if (edsFeatures.eds3.extendedDynamicState3ColorBlendEquation == VK_TRUE)
+      support |= DynamicStateColorBlendEquationBit;
+    if (edsFeatures.eds3.extendedDynamicState3ColorWriteMask == VK_TRUE)
+      support |= DynamicStateColorWriteMaskBit;
+#endif
+
+    return support;
+  }
+
   static bool deviceIsSuitable(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface) noexcept {
     QueueFamilyIndices indices             = getQueueFamilies(std::pair{ physicalDevice, surface });
     bool               extensionsSupported = checkDeviceExtensionSupport(physicalDevice);
@@ -138,10 +262,16 @@ namespace HAPI_NAMESPACE_NAME::gfx {
   RenderContext::RenderContext() noexcept
     : mGraphicsQueuePair(std::pair{ nullptr, 0 })
     , mPresentQueuePair(std::pair{ nullptr, 0 })
+    , mTransferQueuePair(std::pair{ nullptr, 0 })
     , mInstance(nullptr)
     , mSurface(nullptr)
     , mPhysicalDevice(nullptr)
     , mLogicalDevice(nullptr)
+    , mAllocationCallbacks(nullptr)
+    , mPipelineCache()
+    , mDynamicStateSupport(DynamicStateCoreBits)
+    , mTimelineSemaphoreSupport(false)
+    , mMemoryBudgetSupport(false)
   #if defined(HAPI_DEBUG)
     , mDebugMessenger(nullptr)
   #endif
@@ -150,18 +280,27 @@ namespace HAPI_NAMESPACE_NAME::gfx {
   RenderContext::RenderContext(const CreateInfo& createInfo)
     : mGraphicsQueuePair(std::pair{ nullptr, 0 })
     , mPresentQueuePair(std::pair{ nullptr, 0 })
+    , mTransferQueuePair(std::pair{ nullptr, 0 })
     , mInstance(nullptr)
     , mSurface(nullptr)
     , mPhysicalDevice(nullptr)
     , mLogicalDevice(nullptr)
+    , mAllocationCallbacks(createInfo.allocationCallbacks)
+    , mPipelineCache()
+    , mDynamicStateSupport(DynamicStateCoreBits)
+    , mTimelineSemaphoreSupport(false)
+    , mMemoryBudgetSupport(false)
   #if defined(HAPI_DEBUG)
     , mDebugMessenger(nullptr)
   #endif
   {
+    HAPI_PROFILE_ZONE("gfx::RenderContext::RenderContext");
+
     initializeInstance(createInfo.appName, createInfo.appVersion);
     initializeSurface(createInfo.surface);
     pickPhysicalDevice();
-    initializeLogicalDevice();
+    initializeLogicalDevice(createInfo.extendedDynamicState);
+    initializePipelineCache(createInfo.pipelineCachePath, createInfo.pipelineThreadCount);
   }
 
   RenderContext::~RenderContext() noexcept {
@@ -169,48 +308,70 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     if (mInstance == nullptr)
       return;
 
+    HAPI_PROFILE_ZONE("gfx::RenderContext::~RenderContext");
+
     // Wait for device.
     vkDeviceWaitIdle(mLogicalDevice);
-    vkDestroyDevice(mLogicalDevice, nullptr);
-    vkDestroySurfaceKHR(mInstance, mSurface, nullptr);
+
+    // Write the pipeline cache back while the device is still around.
+    mPipelineCache = PipelineCache();
+    vkDestroyDevice(mLogicalDevice, mAllocationCallbacks);
+    vkDestroySurfaceKHR(mInstance, mSurface, mAllocationCallbacks);
 
   #if defined(HAPI_DEBUG)
-    destroyDebugUtilsMessengerEXT(mInstance, mDebugMessenger, nullptr);
+    destroyDebugUtilsMessengerEXT(mInstance, mDebugMessenger, mAllocationCallbacks);
   #endif
 
-    vkDestroyInstance(mInstance, nullptr);
+    vkDestroyInstance(mInstance, mAllocationCallbacks);
   }
 
   RenderContext::RenderContext(RenderContext&& other) noexcept
     : mGraphicsQueuePair(std::move(other.mGraphicsQueuePair))
     , mPresentQueuePair(std::move(other.mPresentQueuePair))
+    , mTransferQueuePair(std::move(other.mTransferQueuePair))
     , mInstance(std::move(other.mInstance))
     , mSurface(std::move(other.mSurface))
     , mPhysicalDevice(std::move(other.mPhysicalDevice))
     , mLogicalDevice(std::move(other.mLogicalDevice))
+    , mAllocationCallbacks(std::move(other.mAllocationCallbacks))
+    , mPipelineCache(std::move(other.mPipelineCache))
+    , mDynamicStateSupport(other.mDynamicStateSupport)
+    , mTimelineSemaphoreSupport(other.mTimelineSemaphoreSupport)
+    , mMemoryBudgetSupport(other.mMemoryBudgetSupport)
   #if defined(HAPI_DEBUG)
     , mDebugMessenger(std::move(other.mDebugMessenger))
   #endif
   {
     // Ensuring.
-    other.mGraphicsQueuePair = std::pair{ nullptr, 0 };
-    other.mPresentQueuePair  = std::pair{ nullptr, 0 };
-    other.mInstance          = nullptr;
-    other.mSurface           = nullptr;
-    other.mPhysicalDevice    = nullptr;
-    other.mLogicalDevice     = nullptr;
+    other.mGraphicsQueuePair        = std::pair{ nullptr, 0 };
+    other.mPresentQueuePair         = std::pair{ nullptr, 0 };
+    other.mTransferQueuePair        = std::pair{ nullptr, 0 };
+    other.mInstance                 = nullptr;
+    other.mSurface                  = nullptr;
+    other.mPhysicalDevice           = nullptr;
+    other.mLogicalDevice            = nullptr;
+    other.mAllocationCallbacks      = nullptr;
+    other.mDynamicStateSupport      = DynamicStateCoreBits;
+    other.mTimelineSemaphoreSupport = false;
+    other.mMemoryBudgetSupport      = false;
   #if defined(HAPI_DEBUG)
-    other.mDebugMessenger    = nullptr;
+    other.mDebugMessenger           = nullptr;
   #endif
   }
 
   RenderContext& RenderContext::operator=(RenderContext&& other) noexcept {
-    std::swap(mGraphicsQueuePair, other.mGraphicsQueuePair);
-    std::swap(mPresentQueuePair,  other.mPresentQueuePair);
-    std::swap(mInstance,          other.mInstance);
-    std::swap(mSurface,           other.mSurface);
-    std::swap(mPhysicalDevice,    other.mPhysicalDevice);
-    std::swap(mLogicalDevice,     other.mLogicalDevice);
+    std::swap(mGraphicsQueuePair,        other.mGraphicsQueuePair);
+    std::swap(mPresentQueuePair,         other.mPresentQueuePair);
+    std::swap(mTransferQueuePair,        other.mTransferQueuePair);
+    std::swap(mInstance,                 other.mInstance);
+    std::swap(mSurface,                  other.mSurface);
+    std::swap(mPhysicalDevice,           other.mPhysicalDevice);
+    std::swap(mLogicalDevice,            other.mLogicalDevice);
+    std::swap(mAllocationCallbacks,      other.mAllocationCallbacks);
+    std::swap(mPipelineCache,            other.mPipelineCache);
+    std::swap(mDynamicStateSupport,      other.mDynamicStateSupport);
+    std::swap(mTimelineSemaphoreSupport, other.mTimelineSemaphoreSupport);
+    std::swap(mMemoryBudgetSupport,      other.mMemoryBudgetSupport);
   #if defined(HAPI_DEBUG)
     std::swap(mDebugMessenger, other.mDebugMessenger);
   #endif
@@ -221,6 +382,62 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     return mInstance;
   }
 
+  bool RenderContext::timelineSemaphoreSupport() const noexcept {
+    return mTimelineSemaphoreSupport;
+  }
+
+  bool RenderContext::transferQueueSupport() const noexcept {
+    return mTransferQueuePair.first != nullptr;
+  }
+
+  bool RenderContext::memoryBudgetSupport() const noexcept {
+    return mMemoryBudgetSupport;
+  }
+
+  MemoryBudget RenderContext::memoryBudget() const {
+    // Provide budget properties, only chained in if the extension was enabled.
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties;
+    {
+      budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+      budgetProperties.pNext = nullptr;
+    }
+
+    VkPhysicalDeviceMemoryProperties2 memoryProperties;
+    {
+      memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+      memoryProperties.pNext = mMemoryBudgetSupport ? &budgetProperties : nullptr;
+    }
+
+    vkGetPhysicalDeviceMemoryProperties2(mPhysicalDevice, &memoryProperties);
+
+    // Without the driver's numbers, assume paging starts past a safe share of the heap.
+    const auto& heaps = memoryProperties.memoryProperties;
+    MemoryBudget budget;
+    budget.heapCount = heaps.memoryHeapCount;
+    budget.reported  = mMemoryBudgetSupport;
+    for (std::uint32_t index = 0; index < budget.heapCount; index++) {
+      auto& heap = budget.heaps[index];
+      heap.size        = heaps.memoryHeaps[index].size;
+      heap.usage       = mMemoryBudgetSupport ? budgetProperties.heapUsage[index] : 0;
+      heap.budget      = mMemoryBudgetSupport ? budgetProperties.heapBudget[index] : heap.size / 10 * 8;
+      heap.deviceLocal = (heaps.memoryHeaps[index].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+    }
+
+    return budget;
+  }
+
+  std::uint32_t RenderContext::dynamicStateSupport() const noexcept {
+    return mDynamicStateSupport;
+  }
+
+  const PipelineCache& RenderContext::pipelineCache() const noexcept {
+    return mPipelineCache;
+  }
+
+  PipelineCache& RenderContext::pipelineCache() noexcept {
+    return mPipelineCache;
+  }
+
   void RenderContext::initializeInstance(std::string_view appName, std::uint32_t appVersion) {
     // Get the application information.
     VkApplicationInfo appInfo;
@@ -297,12 +514,12 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     }
 
     // Try to create vulkan instance.
-    VkResult result = vkCreateInstance(&instCreateInfo, nullptr, &mInstance);
+    VkResult result = vkCreateInstance(&instCreateInfo, mAllocationCallbacks, &mInstance);
     if (result != VK_SUCCESS)
       throw std::runtime_error("Failed to create vulkan instance.");
 
   #if defined(HAPI_DEBUG)
-    result = createDebugUtilsMessengerEXT(mInstance, &dbMessengerCreateInfo, nullptr, &mDebugMessenger);
+    result = createDebugUtilsMessengerEXT(mInstance, &dbMessengerCreateInfo, mAllocationCallbacks, &mDebugMessenger);
     if (result != VK_SUCCESS)
       throw std::runtime_error("Failed to create debug messenger.");
   #endif
@@ -324,7 +541,7 @@ namespace HAPI_NAMESPACE_NAME::gfx {
       surfaceCreateInfo.hwnd      = static_cast<HWND>(static_cast<native::Win32Window*>(surface)->handle());
     }
 
-    result = vkCreateWin32SurfaceKHR(mInstance, &surfaceCreateInfo, nullptr, &mSurface);
+    result = vkCreateWin32SurfaceKHR(mInstance, &surfaceCreateInfo, mAllocationCallbacks, &mSurface);
   #endif
 
     // Check if surface creation succeeded.
@@ -354,16 +571,18 @@ namespace HAPI_NAMESPACE_NAME::gfx {
       throw std::runtime_error("Failed to find a suitable GPU.");
   }
 
-  void RenderContext::initializeLogicalDevice() {
+  void RenderContext::initializeLogicalDevice(bool extendedDynamicState) {
     // Get queue family indices for our physical device.
     QueueFamilyIndices indices = getQueueFamilies(std::pair{ mPhysicalDevice, mSurface });
 
-    // A place to store our Queue creation info. We can support up to 2 currently.
+    // A place to store our Queue creation info. We can support up to 3 currently.
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     std::set<std::uint32_t> uniqueFamilies = {
       indices.graphics.value(),
       indices.present.value()
     };
+    if (indices.transfer.has_value())
+      uniqueFamilies.insert(indices.transfer.value());
 
     // Prepare population.
     float queuePriority = 1.0f;
@@ -382,14 +601,72 @@ namespace HAPI_NAMESPACE_NAME::gfx {
       queueCreateInfos.emplace_back(qCreateInfo);
     }
 
-    // Device features.
-    VkPhysicalDeviceFeatures deviceFeatures { };
+    // Timeline semaphores are optional, enable them when the device has them.
+    mTimelineSemaphoreSupport = checkTimelineSemaphoreSupport(mPhysicalDevice);
+    std::vector<const char*> deviceExtensions(gRequiredDeviceExtensions.begin(), gRequiredDeviceExtensions.end());
+    if (mTimelineSemaphoreSupport)
+      deviceExtensions.emplace_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+
+    // Memory budgets are optional too, without them the budget is estimated.
+    mMemoryBudgetSupport = checkOptionalExtensionSupport(mPhysicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    if (mMemoryBudgetSupport)
+      deviceExtensions.emplace_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+    // Extended dynamic state is opt in, pipelines bake everything but the core states without it.
+    ExtendedDynamicStateFeatures edsFeatures;
+    mDynamicStateSupport = DynamicStateCoreBits;
+    if (extendedDynamicState)
+      mDynamicStateSupport = checkExtendedDynamicStateSupport(mPhysicalDevice, edsFeatures);
+
+    // Extension features, chained so they can be enabled.
+    void* featureChain = nullptr;
+#if defined(VK_EXT_extended_dynamic_state3)
+    if ((mDynamicStateSupport & gExtendedDynamicState3Bits) != 0) {
+      deviceExtensions.emplace_back(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+      edsFeatures.eds3.pNext = featureChain;
+      featureChain           = &edsFeatures.eds3;
+    }
+#endif
+
+#if defined(VK_EXT_extended_dynamic_state2)
+    if ((mDynamicStateSupport & gExtendedDynamicState2Bits) != 0) {
+      deviceExtensions.emplace_back(VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME);
+      edsFeatures.eds2.pNext = featureChain;
+      featureChain           = &edsFeatures.eds2;
+    }
+#endif
+
+#if defined(VK_EXT_extended_dynamic_state)
+    if ((mDynamicStateSupport & gExtendedDynamicStateBits) != 0) {
+      deviceExtensions.emplace_back(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+      edsFeatures.eds1.pNext = featureChain;
+      featureChain           = &edsFeatures.eds1;
+    }
+#endif
+
+    VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures;
+    {
+      timelineFeatures.sType             = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+      timelineFeatures.pNext             = featureChain;
+      timelineFeatures.timelineSemaphore = mTimelineSemaphoreSupport ? VK_TRUE : VK_FALSE;
+    }
+
+    if (mTimelineSemaphoreSupport)
+      featureChain = &timelineFeatures;
+
+    // Device features, chained so extension features can be enabled.
+    VkPhysicalDeviceFeatures2 deviceFeatures;
+    {
+      deviceFeatures.sType    = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+      deviceFeatures.pNext    = featureChain;
+      deviceFeatures.features = VkPhysicalDeviceFeatures{ };
+    }
 
     // Our device create info.
     VkDeviceCreateInfo deviceCreateInfo;
     {
       deviceCreateInfo.sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-      deviceCreateInfo.pNext                   = nullptr;
+      deviceCreateInfo.pNext                   = &deviceFeatures;
       deviceCreateInfo.flags                   = 0;
       deviceCreateInfo.queueCreateInfoCount    = static_cast<std::uint32_t>(queueCreateInfos.size());
       deviceCreateInfo.pQueueCreateInfos       = queueCreateInfos.data();
@@ -400,13 +677,13 @@ namespace HAPI_NAMESPACE_NAME::gfx {
       deviceCreateInfo.enabledLayerCount       = 0;
       deviceCreateInfo.ppEnabledLayerNames     = nullptr;
     #endif /* HAPI_DEBUG */
-      deviceCreateInfo.enabledExtensionCount   = static_cast<std::uint32_t>(gRequiredDeviceExtensions.size());
-      deviceCreateInfo.ppEnabledExtensionNames = gRequiredDeviceExtensions.data();
-      deviceCreateInfo.pEnabledFeatures        = &deviceFeatures;
+      deviceCreateInfo.enabledExtensionCount   = static_cast<std::uint32_t>(deviceExtensions.size());
+      deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
+      deviceCreateInfo.pEnabledFeatures        = nullptr;
     }
 
     // Attempt to create logical device.
-    VkResult result = vkCreateDevice(mPhysicalDevice, &deviceCreateInfo, nullptr, &mLogicalDevice);
+    VkResult result = vkCreateDevice(mPhysicalDevice, &deviceCreateInfo, mAllocationCallbacks, &mLogicalDevice);
     if (result != VK_SUCCESS)
       throw std::runtime_error("Failed to create logical device.");
 
@@ -417,6 +694,26 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     // Set indices.
     mGraphicsQueuePair.second = indices.graphics.value();
     mPresentQueuePair.second  = indices.present.value();
+
+    // Uploads only get their own queue on a transfer only family.
+    if (indices.transfer.has_value()) {
+      vkGetDeviceQueue(mLogicalDevice, indices.transfer.value(), 0, &mTransferQueuePair.first);
+      mTransferQueuePair.second = indices.transfer.value();
+    }
+  }
+
+  void RenderContext::initializePipelineCache(const char* filePath, std::uint32_t threadCount) {
+    // Provide pipeline cache create info.
+    const PipelineCache::CreateInfo pipcchCreateInfo {
+      .physicalDevice      = mPhysicalDevice,
+      .logicalDevice       = mLogicalDevice,
+      .allocationCallbacks = mAllocationCallbacks,
+      .filePath            = filePath,
+      .threadCount         = threadCount
+    };
+
+    // Create pipeline cache.
+    mPipelineCache = PipelineCache(pipcchCreateInfo);
   }
 
 }
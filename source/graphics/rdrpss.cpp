@@ -21,18 +21,26 @@
  */
 #include <stdexcept>
 #include <hearth/graphics/rdrpss.hpp>
+#include <hearth/graphics/dltque.hpp>
+#include <hearth/profile.hpp>
 
 namespace HAPI_NAMESPACE_NAME::gfx {
 
   RenderPass::RenderPass() noexcept
     : mLogicalDevice(nullptr)
+    , mAllocationCallbacks(nullptr)
+    , mDeletionQueue(nullptr)
     , mRenderPass(nullptr)
   { }
 
   RenderPass::RenderPass(const CreateInfo& createInfo)
     : mLogicalDevice(createInfo.logicalDevice)
+    , mAllocationCallbacks(createInfo.allocationCallbacks)
+    , mDeletionQueue(createInfo.deletionQueue)
     , mRenderPass(nullptr)
   {
+    HAPI_PROFILE_ZONE("gfx::RenderPass::RenderPass");
+
     initializeRenderPass(createInfo);
   }
 
@@ -41,25 +49,41 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     if (mRenderPass == nullptr)
       return;
 
+    HAPI_PROFILE_ZONE("gfx::RenderPass::~RenderPass");
+
+    // Delete once the GPU is done with it.
+    if (mDeletionQueue != nullptr) {
+      mDeletionQueue->enqueue([logicalDevice = mLogicalDevice, allocationCallbacks = mAllocationCallbacks, handle = mRenderPass] {
+        vkDestroyRenderPass(logicalDevice, handle, allocationCallbacks);
+      });
+      return;
+    }
+
     // Wait for device.
     vkDeviceWaitIdle(mLogicalDevice);
 
     // Delete.
-    vkDestroyRenderPass(mLogicalDevice, mRenderPass, nullptr);
+    vkDestroyRenderPass(mLogicalDevice, mRenderPass, mAllocationCallbacks);
   }
 
   RenderPass::RenderPass(RenderPass&& other) noexcept
     : mLogicalDevice(std::move(other.mLogicalDevice))
+    , mAllocationCallbacks(std::move(other.mAllocationCallbacks))
+    , mDeletionQueue(std::move(other.mDeletionQueue))
     , mRenderPass(std::move(other.mRenderPass))
   {
     // Ensures.
-    other.mLogicalDevice = nullptr;
-    other.mRenderPass    = nullptr;
+    other.mLogicalDevice       = nullptr;
+    other.mAllocationCallbacks = nullptr;
+    other.mDeletionQueue       = nullptr;
+    other.mRenderPass          = nullptr;
   }
 
   RenderPass& RenderPass::operator=(RenderPass&& other) noexcept {
-    std::swap(mLogicalDevice, other.mLogicalDevice);
-    std::swap(mRenderPass,    other.mRenderPass);
+    std::swap(mLogicalDevice,       other.mLogicalDevice);
+    std::swap(mAllocationCallbacks, other.mAllocationCallbacks);
+    std::swap(mDeletionQueue,       other.mDeletionQueue);
+    std::swap(mRenderPass,          other.mRenderPass);
     return *this;
   }
 
@@ -154,7 +178,7 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     }
 
     // Try and create renderpass.
-    VkResult result = vkCreateRenderPass(mLogicalDevice, &rdrpssCreateInfo, nullptr, &mRenderPass);
+    VkResult result = vkCreateRenderPass(mLogicalDevice, &rdrpssCreateInfo, mAllocationCallbacks, &mRenderPass);
     if (result != VK_SUCCESS)
       throw std::runtime_error("Failed to create render pass.");
   }
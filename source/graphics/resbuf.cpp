@@ -21,24 +21,78 @@
  */
 #include <cstring>
 #include <stdexcept>
+#include <utility>
 #include <hearth/graphics/resbuf.hpp>
+#include <hearth/graphics/cmdbuf.hpp>
+#include <hearth/graphics/dltque.hpp>
+#include <hearth/graphics/stgrng.hpp>
+#include <hearth/profile.hpp>
 
 namespace HAPI_NAMESPACE_NAME::gfx {
 
+  static VkBuffer createBuffer(VkDevice logicalDevice, const VkAllocationCallbacks* allocationCallbacks, std::size_t size, std::uint16_t usage) {
+    // Provide buffer create info.
+    VkBufferCreateInfo resbufCreateInfo;
+    {
+      resbufCreateInfo.sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+      resbufCreateInfo.pNext                 = nullptr;
+      resbufCreateInfo.flags                 = 0;
+      resbufCreateInfo.size                  = size;
+      resbufCreateInfo.usage                 = usage;
+      resbufCreateInfo.sharingMode           = VK_SHARING_MODE_EXCLUSIVE;
+      resbufCreateInfo.queueFamilyIndexCount = 0;
+      resbufCreateInfo.pQueueFamilyIndices   = nullptr;
+    }
+
+    // Create resource buffer.
+    VkBuffer buffer = nullptr;
+    VkResult result = vkCreateBuffer(logicalDevice, &resbufCreateInfo, allocationCallbacks, &buffer);
+    if (result != VK_SUCCESS)
+      throw std::runtime_error("Failed to create resource buffer.");
+
+    return buffer;
+  }
+
   ResourceBuffer::ResourceBuffer() noexcept
-    : mPhysicalDevice(nullptr)
+    : mAllocator(nullptr)
+    , mStagingRing(nullptr)
+    , mDeletionQueue(nullptr)
     , mLogicalDevice(nullptr)
+    , mAllocationCallbacks(nullptr)
     , mBufferHandle(nullptr)
-    , mBufferMemory(nullptr)
+    , mAllocation{ }
+    , mSize(0)
+    , mUsage(0)
+    , mResidency(BufferResidency::Upload)
   { }
 
   ResourceBuffer::ResourceBuffer(const CreateInfo& createInfo)
-    : mPhysicalDevice(createInfo.physicalDevice)
+    : mAllocator(createInfo.allocator)
+    , mStagingRing(createInfo.stagingRing)
+    , mDeletionQueue(createInfo.deletionQueue)
     , mLogicalDevice(createInfo.logicalDevice)
+    , mAllocationCallbacks(createInfo.allocationCallbacks)
     , mBufferHandle(nullptr)
-    , mBufferMemory(nullptr)
+    , mAllocation{ }
+    , mSize(createInfo.bufferSize)
+    , mUsage(createInfo.bufferUsage)
+    , mResidency(createInfo.residency)
   {
-    initializeBuffer(createInfo.bufferSize, createInfo.bufferUsage);
+    HAPI_PROFILE_ZONE("gfx::ResourceBuffer::ResourceBuffer");
+
+    // Expects.
+    if (createInfo.allocator == nullptr)
+      throw std::runtime_error("Resource buffer requires a memory allocator.");
+
+    // Expects.
+    if (createInfo.residency == BufferResidency::DeviceLocal && createInfo.initialData != nullptr && createInfo.stagingRing == nullptr)
+      throw std::runtime_error("Device local resource buffer requires a staging ring for its initial data.");
+
+    // Relocating copies the contents with a transfer, and device local memory can only be written
+    // by transfers.
+    mUsage |= UsageTransferSrcBit | UsageTransferDstBit;
+
+    initializeBuffer(createInfo.bufferSize, mUsage);
     mapMemory(createInfo.bufferSize, createInfo.initialData);
   }
 
@@ -47,30 +101,68 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     if (mBufferHandle == nullptr)
       return;
 
+    HAPI_PROFILE_ZONE("gfx::ResourceBuffer::~ResourceBuffer");
+
+    // Delete data once the GPU is done with it.
+    if (mDeletionQueue != nullptr) {
+      mDeletionQueue->enqueue([logicalDevice = mLogicalDevice, allocationCallbacks = mAllocationCallbacks, buffer = mBufferHandle, allocator = mAllocator, allocation = mAllocation]() mutable {
+        vkDestroyBuffer(logicalDevice, buffer, allocationCallbacks);
+        allocator->free(allocation);
+      });
+      return;
+    }
+
     // Wait for device and delete data.
     vkDeviceWaitIdle(mLogicalDevice);
-    vkDestroyBuffer(mLogicalDevice, mBufferHandle, nullptr);
-    vkFreeMemory(mLogicalDevice, mBufferMemory, nullptr);
+    vkDestroyBuffer(mLogicalDevice, mBufferHandle, mAllocationCallbacks);
+    mAllocator->free(mAllocation);
   }
 
   ResourceBuffer::ResourceBuffer(ResourceBuffer&& other) noexcept
-    : mPhysicalDevice(std::move(other.mPhysicalDevice))
+    : mAllocator(std::move(other.mAllocator))
+    , mStagingRing(std::move(other.mStagingRing))
+    , mDeletionQueue(std::move(other.mDeletionQueue))
     , mLogicalDevice(std::move(other.mLogicalDevice))
+    , mAllocationCallbacks(std::move(other.mAllocationCallbacks))
     , mBufferHandle(std::move(other.mBufferHandle))
-    , mBufferMemory(std::move(other.mBufferMemory))
+    , mAllocation(std::move(other.mAllocation))
+    , mSize(std::move(other.mSize))
+    , mUsage(std::move(other.mUsage))
+    , mResidency(std::move(other.mResidency))
   {
+    // Defragmentation moves name the buffer by its address, follow it.
+    if (mAllocator != nullptr && mAllocator->userData(mAllocation) == &other)
+      mAllocator->setUserData(mAllocation, this);
+
     // Ensures.
-    other.mPhysicalDevice = nullptr;
-    other.mLogicalDevice  = nullptr;
-    other.mBufferHandle   = nullptr;
-    other.mBufferMemory   = nullptr;
+    other.mAllocator           = nullptr;
+    other.mStagingRing         = nullptr;
+    other.mDeletionQueue       = nullptr;
+    other.mLogicalDevice       = nullptr;
+    other.mAllocationCallbacks = nullptr;
+    other.mBufferHandle        = nullptr;
+    other.mAllocation          = Allocation{ };
+    other.mSize                = 0;
+    other.mUsage               = 0;
   }
 
   ResourceBuffer& ResourceBuffer::operator=(ResourceBuffer&& other) noexcept {
-    std::swap(mPhysicalDevice, other.mPhysicalDevice);
-    std::swap(mLogicalDevice,  other.mLogicalDevice);
-    std::swap(mBufferHandle,   other.mBufferHandle);
-    std::swap(mBufferMemory,   other.mBufferMemory);
+    std::swap(mAllocator,           other.mAllocator);
+    std::swap(mStagingRing,         other.mStagingRing);
+    std::swap(mDeletionQueue,       other.mDeletionQueue);
+    std::swap(mLogicalDevice,       other.mLogicalDevice);
+    std::swap(mAllocationCallbacks, other.mAllocationCallbacks);
+    std::swap(mBufferHandle,        other.mBufferHandle);
+    std::swap(mAllocation,          other.mAllocation);
+    std::swap(mSize,                other.mSize);
+    std::swap(mUsage,               other.mUsage);
+    std::swap(mResidency,           other.mResidency);
+
+    // Defragmentation moves name the buffers by their addresses, follow them.
+    if (mAllocator != nullptr && mAllocator->userData(mAllocation) == &other)
+      mAllocator->setUserData(mAllocation, this);
+    if (other.mAllocator != nullptr && other.mAllocator->userData(other.mAllocation) == this)
+      other.mAllocator->setUserData(other.mAllocation, &other);
     return *this;
   }
 
@@ -78,66 +170,126 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     return mBufferHandle;
   }
 
-  // TODO: make more efficient for the GPU.
-  void ResourceBuffer::initializeBuffer(std::size_t size, std::uint16_t usage) {
-    // Provide buffer create info.
-    VkBufferCreateInfo resbufCreateInfo;
+  const Allocation& ResourceBuffer::allocation() const noexcept {
+    return mAllocation;
+  }
+
+  std::size_t ResourceBuffer::size() const noexcept {
+    return mSize;
+  }
+
+  BufferResidency ResourceBuffer::residency() const noexcept {
+    return mResidency;
+  }
+
+  void* ResourceBuffer::mapped() const noexcept {
+    return mAllocation.mapped;
+  }
+
+  MemoryPlacement ResourceBuffer::placement() const noexcept {
+    return mAllocator->placement(mAllocation.memoryType);
+  }
+
+  ResourceBuffer ResourceBuffer::relocate(CommandBuffer& commandBuffer, const DefragmentationMove& move) {
+    HAPI_PROFILE_ZONE("gfx::ResourceBuffer::relocate");
+
+    // Expects.
+    if (move.userData != this || move.source.memory != mAllocation.memory || move.source.offset != mAllocation.offset)
+      throw std::runtime_error("Defragmentation move is not for this resource buffer.");
+
+    // Create the new buffer over the destination first, so nothing changes if that fails.
+    VkBuffer buffer = createBuffer(mLogicalDevice, mAllocationCallbacks, mSize, mUsage);
+    VkResult result = vkBindBufferMemory(mLogicalDevice, buffer, move.destination.memory, move.destination.offset);
+    if (result != VK_SUCCESS) {
+      vkDestroyBuffer(mLogicalDevice, buffer, mAllocationCallbacks);
+      throw std::runtime_error("Failed to bind resource buffer memory.");
+    }
+
+    // The old buffer holds on to the contents until the copy has executed, and is never moved.
+    ResourceBuffer previous;
+    previous.mAllocator           = mAllocator;
+    previous.mDeletionQueue       = mDeletionQueue;
+    previous.mLogicalDevice       = mLogicalDevice;
+    previous.mAllocationCallbacks = mAllocationCallbacks;
+    previous.mBufferHandle        = std::exchange(mBufferHandle, buffer);
+    previous.mAllocation          = std::exchange(mAllocation, move.destination);
+    previous.mSize                = mSize;
+    previous.mUsage               = mUsage;
+    previous.mResidency           = mResidency;
+    mAllocator->setUserData(previous.mAllocation, nullptr);
+
+    // Copy the contents over.
+    VkBufferCopy region;
     {
-      resbufCreateInfo.sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-      resbufCreateInfo.pNext                 = nullptr;
-      resbufCreateInfo.flags                 = 0;
-      resbufCreateInfo.size                  = size;
-      resbufCreateInfo.usage                 = usage;
-      resbufCreateInfo.sharingMode           = VK_SHARING_MODE_EXCLUSIVE;
-      resbufCreateInfo.queueFamilyIndexCount = 0;
-      resbufCreateInfo.pQueueFamilyIndices   = nullptr;
+      region.srcOffset = 0;
+      region.dstOffset = 0;
+      region.size      = mSize;
     }
 
-    // Create resource buffer.
-    VkResult result = vkCreateBuffer(mLogicalDevice, &resbufCreateInfo, nullptr, &mBufferHandle);
-    if (result != VK_SUCCESS)
-      throw std::runtime_error("Failed to create resource buffer.");
+    vkCmdCopyBuffer(commandBuffer.handle(), previous.mBufferHandle, mBufferHandle, 1, &region);
+    return previous;
+  }
+
+  void ResourceBuffer::initializeBuffer(std::size_t size, std::uint16_t usage) {
+    mBufferHandle = createBuffer(mLogicalDevice, mAllocationCallbacks, size, usage);
 
     // Get requirements.
     VkMemoryRequirements memRequirements;
     vkGetBufferMemoryRequirements(mLogicalDevice, mBufferHandle, &memRequirements);
 
-    // Prepare these for memory properties.
-    const auto& filter     = memRequirements.memoryTypeBits;
-    const auto  properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    // Pick the memory usage for the residency.
+    MemoryUsage memoryUsage = MemoryUsage::CpuToGpu;
+    switch (mResidency) {
+    case BufferResidency::DeviceLocal:
+      memoryUsage = MemoryUsage::GpuOnly;
+      break;
+    case BufferResidency::Upload:
+      break;
+    case BufferResidency::Readback:
+      memoryUsage = MemoryUsage::GpuToCpu;
+      break;
+    case BufferResidency::Dynamic:
+      memoryUsage = MemoryUsage::CpuToGpuFrequent;
+      break;
+    }
 
-    // Get memory type.
-    std::uint32_t                    type;
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(mPhysicalDevice, &memProperties);
-    for (std::size_t index = 0; index < memProperties.memoryTypeCount; index++)
-      if ((filter & (1 << index)) && (memProperties.memoryTypes[index].propertyFlags & properties) == properties)
-        type = index;
+    // Sub-allocate memory.
+    const AllocationInfo allocationInfo {
+      .requirements = memRequirements,
+      .usage        = memoryUsage,
+      .kind         = AllocationKind::Buffer,
+      .dedicated    = false,
+      .userData     = this
+    };
 
-    // Prepare to allocate memory.
-    VkMemoryAllocateInfo allocInfo;
-    {
-      allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-      allocInfo.pNext           = nullptr;
-      allocInfo.allocationSize  = memRequirements.size;
-      allocInfo.memoryTypeIndex = type;
+    // Don't leak the buffer when there is no memory for it.
+    try {
+      mAllocation = mAllocator->allocate(allocationInfo);
+    } catch (...) {
+      vkDestroyBuffer(mLogicalDevice, mBufferHandle, mAllocationCallbacks);
+      mBufferHandle = nullptr;
+      throw;
     }
 
-    // Proceed to allocate memory.
-    result = vkAllocateMemory(mLogicalDevice, &allocInfo, nullptr, &mBufferMemory);
-    if (result != VK_SUCCESS)
-      throw std::runtime_error("Failed to allocate memory on GPU for resource buffer.");
+    // Bind memory before writing.
+    VkResult result = vkBindBufferMemory(mLogicalDevice, mBufferHandle, mAllocation.memory, mAllocation.offset);
+    if (result != VK_SUCCESS) {
+      vkDestroyBuffer(mLogicalDevice, mBufferHandle, mAllocationCallbacks);
+      mBufferHandle = nullptr;
+      mAllocator->free(mAllocation);
+      throw std::runtime_error("Failed to bind resource buffer memory.");
+    }
   }
 
   void ResourceBuffer::mapMemory(std::size_t size, const void* data) {
-    // Bind memory before mapping.
-    vkBindBufferMemory(mLogicalDevice, mBufferHandle, mBufferMemory, 0);
-
-    // Get data map.
-    void* buffer;
-    vkMapMemory(mLogicalDevice, mBufferMemory, 0, size, 0, &buffer);
-      std::memcpy(buffer, data, size);
-    vkUnmapMemory(mLogicalDevice, mBufferMemory);
+    if (data == nullptr)
+      return;
+
+    // The allocator keeps host visible memory mapped.
+    if (mAllocation.mapped == nullptr)
+      mStagingRing->upload(this, 0, data, size);
+    else
+      std::memcpy(mAllocation.mapped, data, size);
   }
 
 }
@@ -0,0 +1,245 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <stdexcept>
+#include <hearth/graphics/memalc.hpp>
+#include <hearth/graphics/rsdmgr.hpp>
+#include <hearth/profile.hpp>
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  ResidencyManager::ResidencyManager(const CreateInfo& createInfo)
+    : mRenderContext(createInfo.renderContext)
+    , mAllocator(createInfo.allocator)
+    , mEntries()
+    , mFreeIndices()
+    , mHead(InvalidIndex)
+    , mTail(InvalidIndex)
+    , mRecentlyEvicted()
+    , mBudget()
+    , mLock()
+    , mFrame(0)
+    , mFramesInFlight(createInfo.framesInFlight)
+    , mTargetUsage(createInfo.targetUsage > 0.0f ? createInfo.targetUsage : DefaultTargetUsage)
+  {
+    HAPI_PROFILE_ZONE("gfx::ResidencyManager::ResidencyManager");
+
+    // Expects.
+    if (mRenderContext == nullptr || mAllocator == nullptr)
+      throw std::runtime_error("Expected render context and memory allocator for residency manager.");
+
+    // Evictions stay in the driver's usage until every frame in flight has finished.
+    mRecentlyEvicted.resize(mFramesInFlight + 1);
+    for (auto& evicted : mRecentlyEvicted)
+      evicted.fill(0);
+
+    mBudget.heapCount = 0;
+    mBudget.reported  = false;
+  }
+
+  ResidencyHandle ResidencyManager::track(StreamableInfo streamableInfo) {
+    // Expects.
+    if (!streamableInfo.evict)
+      throw std::runtime_error("Expected eviction callback for streamable resource.");
+
+    const auto& memoryProperties = mAllocator->memoryProperties();
+    if (streamableInfo.memoryType >= memoryProperties.memoryTypeCount)
+      throw std::runtime_error("Invalid memory type for streamable resource.");
+
+    std::scoped_lock lock{ mLock };
+    std::uint32_t index;
+    if (!mFreeIndices.empty()) {
+      index = mFreeIndices.back();
+      mFreeIndices.pop_back();
+    } else {
+      index = static_cast<std::uint32_t>(mEntries.size());
+      mEntries.emplace_back();
+    }
+
+    auto& entry = mEntries[index];
+    entry.evict    = std::move(streamableInfo.evict);
+    entry.size     = streamableInfo.size;
+    entry.lastUsed = mFrame;
+    entry.heap     = memoryProperties.memoryTypes[streamableInfo.memoryType].heapIndex;
+    entry.previous = InvalidIndex;
+    entry.next     = InvalidIndex;
+    entry.tracked  = true;
+
+    append(index);
+    return static_cast<ResidencyHandle>(entry.generation) << 32 | index;
+  }
+
+  void ResidencyManager::untrack(ResidencyHandle handle) {
+    // Nothing to untrack.
+    if (handle == InvalidHandle)
+      return;
+
+    std::scoped_lock lock{ mLock };
+    if (const auto index = find(handle); index != InvalidIndex)
+      release(index);
+  }
+
+  void ResidencyManager::touch(ResidencyHandle handle) {
+    std::scoped_lock lock{ mLock };
+    const auto index = find(handle);
+
+    // Gone, or already the most recent.
+    if (index == InvalidIndex || mEntries[index].lastUsed == mFrame)
+      return;
+
+    mEntries[index].lastUsed = mFrame;
+    unlink(index);
+    append(index);
+  }
+
+  void ResidencyManager::resize(ResidencyHandle handle, VkDeviceSize size) {
+    std::scoped_lock lock{ mLock };
+    if (const auto index = find(handle); index != InvalidIndex)
+      mEntries[index].size = size;
+  }
+
+  void ResidencyManager::update() {
+    HAPI_PROFILE_ZONE("gfx::ResidencyManager::update");
+
+    // Query outside the lock, usage comes from our own allocator if the driver doesn't report it.
+    auto budget = mRenderContext->memoryBudget();
+    if (!budget.reported) {
+      const auto& memoryProperties = mAllocator->memoryProperties();
+      for (std::uint32_t memoryType = 0; memoryType < memoryProperties.memoryTypeCount; memoryType++) {
+        const auto statistics = mAllocator->statistics(memoryType);
+        budget.heaps[memoryProperties.memoryTypes[memoryType].heapIndex].usage += statistics.blockBytes + statistics.dedicatedBytes;
+      }
+    }
+
+    std::unique_lock lock{ mLock };
+    mFrame++;
+    auto& evictedNow = mRecentlyEvicted[mFrame % mRecentlyEvicted.size()];
+    evictedNow.fill(0);
+
+    for (std::uint32_t heap = 0; heap < budget.heapCount; heap++) {
+      // Don't count what earlier frames evicted, it is only waiting on the frames in flight.
+      auto& heapBudget = budget.heaps[heap];
+      for (const auto& evicted : mRecentlyEvicted)
+        heapBudget.usage -= std::min(heapBudget.usage, evicted[heap]);
+
+      const auto target = static_cast<VkDeviceSize>(static_cast<double>(heapBudget.budget) * mTargetUsage);
+      auto       index  = mHead;
+      while (heapBudget.usage > target && index != InvalidIndex) {
+        // The list is in order of use, everything from here on is still used by a frame in flight.
+        if (mEntries[index].lastUsed + mFramesInFlight >= mFrame)
+          break;
+
+        if (mEntries[index].heap != heap) {
+          index = mEntries[index].next;
+          continue;
+        }
+
+        // Evict without the lock, the callback may track, untrack or touch.
+        const auto evict      = mEntries[index].evict;
+        const auto size       = mEntries[index].size;
+        const auto generation = mEntries[index].generation;
+        lock.unlock();
+        const auto remaining = evict();
+        lock.lock();
+
+        const auto freed = size - std::min(size, remaining);
+        heapBudget.usage -= std::min(heapBudget.usage, freed);
+        evictedNow[heap] += freed;
+
+        // The callback may have untracked it, and something else may have reused the entry since,
+        // then we can't know where we were.
+        auto& entry = mEntries[index];
+        if (!entry.tracked || entry.generation != generation) {
+          index = mHead;
+          continue;
+        }
+
+        const auto next = entry.next;
+        if (remaining == 0)
+          release(index);
+        else
+          entry.size = std::min(size, remaining);
+
+        index = next;
+      }
+    }
+
+    mBudget = budget;
+  }
+
+  MemoryBudget ResidencyManager::budget() const {
+    std::scoped_lock lock{ mLock };
+    return mBudget;
+  }
+
+  std::uint32_t ResidencyManager::find(ResidencyHandle handle) const noexcept {
+    const auto index      = static_cast<std::uint32_t>(handle);
+    const auto generation = static_cast<std::uint32_t>(handle >> 32);
+    if (handle == InvalidHandle || index >= mEntries.size())
+      return InvalidIndex;
+
+    // A stale handle names an entry released, and maybe reused, since.
+    const auto& entry = mEntries[index];
+    if (!entry.tracked || entry.generation != generation)
+      return InvalidIndex;
+
+    return index;
+  }
+
+  void ResidencyManager::unlink(std::uint32_t index) noexcept {
+    auto& entry = mEntries[index];
+    if (entry.previous != InvalidIndex)
+      mEntries[entry.previous].next = entry.next;
+    else
+      mHead = entry.next;
+
+    if (entry.next != InvalidIndex)
+      mEntries[entry.next].previous = entry.previous;
+    else
+      mTail = entry.previous;
+
+    entry.previous = InvalidIndex;
+    entry.next     = InvalidIndex;
+  }
+
+  void ResidencyManager::append(std::uint32_t index) noexcept {
+    auto& entry = mEntries[index];
+    entry.previous = mTail;
+    entry.next     = InvalidIndex;
+    if (mTail != InvalidIndex)
+      mEntries[mTail].next = index;
+    else
+      mHead = index;
+
+    mTail = index;
+  }
+
+  void ResidencyManager::release(std::uint32_t index) {
+    unlink(index);
+    auto& entry = mEntries[index];
+    entry.evict   = nullptr;
+    entry.tracked = false;
+    entry.generation++;
+    mFreeIndices.push_back(index);
+  }
+
+}
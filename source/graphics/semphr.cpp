@@ -21,18 +21,65 @@
  */
 #include <stdexcept>
 #include <hearth/graphics/semphr.hpp>
+#include <hearth/profile.hpp>
 
 namespace HAPI_NAMESPACE_NAME::gfx {
 
+  static VkResult waitSemaphoresKHR(VkDevice logicalDevice, const VkSemaphoreWaitInfoKHR* pWaitInfo, std::uint64_t timeout) {
+    // Attempt to load function on first call.
+    static auto _vk__func = reinterpret_cast<PFN_vkWaitSemaphoresKHR>(
+      vkGetDeviceProcAddr(logicalDevice, "vkWaitSemaphoresKHR")
+    );
+
+    // Double check that the function was loaded.
+    if (_vk__func == nullptr)
+      throw std::runtime_error("Unable to load vkWaitSemaphoresKHR");
+
+    // Call function.
+    return (*_vk__func)(logicalDevice, pWaitInfo, timeout);
+  }
+
+  static VkResult signalSemaphoreKHR(VkDevice logicalDevice, const VkSemaphoreSignalInfoKHR* pSignalInfo) {
+    // Attempt to load function on first call.
+    static auto _vk__func = reinterpret_cast<PFN_vkSignalSemaphoreKHR>(
+      vkGetDeviceProcAddr(logicalDevice, "vkSignalSemaphoreKHR")
+    );
+
+    // Double check that the function was loaded.
+    if (_vk__func == nullptr)
+      throw std::runtime_error("Unable to load vkSignalSemaphoreKHR");
+
+    // Call function.
+    return (*_vk__func)(logicalDevice, pSignalInfo);
+  }
+
+  static VkResult getSemaphoreCounterValueKHR(VkDevice logicalDevice, VkSemaphore semaphore, std::uint64_t* pValue) {
+    // Attempt to load function on first call.
+    static auto _vk__func = reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>(
+      vkGetDeviceProcAddr(logicalDevice, "vkGetSemaphoreCounterValueKHR")
+    );
+
+    // Double check that the function was loaded.
+    if (_vk__func == nullptr)
+      throw std::runtime_error("Unable to load vkGetSemaphoreCounterValueKHR");
+
+    // Call function.
+    return (*_vk__func)(logicalDevice, semaphore, pValue);
+  }
+
   Semaphore::Semaphore() noexcept
     : mLogicalDevice(nullptr)
+    , mAllocationCallbacks(nullptr)
     , mSemaphore(nullptr)
   { }
 
-  Semaphore::Semaphore(VkDevice logicalDevice)
+  Semaphore::Semaphore(VkDevice logicalDevice, const VkAllocationCallbacks* allocationCallbacks)
     : mLogicalDevice(logicalDevice)
+    , mAllocationCallbacks(allocationCallbacks)
     , mSemaphore(nullptr)
   {
+    HAPI_PROFILE_ZONE("gfx::Semaphore::Semaphore");
+
     VkSemaphoreCreateInfo createInfo;
     {
       createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -40,7 +87,7 @@ namespace HAPI_NAMESPACE_NAME::gfx {
       createInfo.flags = 0;
     }
 
-    VkResult result = vkCreateSemaphore(mLogicalDevice, &createInfo, nullptr, &mSemaphore);
+    VkResult result = vkCreateSemaphore(mLogicalDevice, &createInfo, mAllocationCallbacks, &mSemaphore);
     if (result != VK_SUCCESS)
       throw std::runtime_error("Failed to create Semaphore.");
   }
@@ -50,25 +97,30 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     if (mSemaphore == nullptr)
       return;
 
+    HAPI_PROFILE_ZONE("gfx::Semaphore::~Semaphore");
+
     // Wait for device.
     vkDeviceWaitIdle(mLogicalDevice);
 
     // Delete.
-    vkDestroySemaphore(mLogicalDevice, mSemaphore, nullptr);
+    vkDestroySemaphore(mLogicalDevice, mSemaphore, mAllocationCallbacks);
   }
 
   Semaphore::Semaphore(Semaphore&& other) noexcept
     : mLogicalDevice(std::move(other.mLogicalDevice))
+    , mAllocationCallbacks(std::move(other.mAllocationCallbacks))
     , mSemaphore(std::move(other.mSemaphore))
   {
     // Ensures.
-    other.mLogicalDevice = nullptr;
-    other.mSemaphore         = nullptr;
+    other.mLogicalDevice       = nullptr;
+    other.mAllocationCallbacks = nullptr;
+    other.mSemaphore           = nullptr;
   }
 
   Semaphore& Semaphore::operator=(Semaphore&& other) noexcept {
-    std::swap(mLogicalDevice, other.mLogicalDevice);
-    std::swap(mSemaphore,         other.mSemaphore);
+    std::swap(mLogicalDevice,       other.mLogicalDevice);
+    std::swap(mAllocationCallbacks, other.mAllocationCallbacks);
+    std::swap(mSemaphore,           other.mSemaphore);
     return *this;
   }
 
@@ -76,4 +128,118 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     return mSemaphore;
   }
 
+  TimelineSemaphore::TimelineSemaphore() noexcept
+    : mLogicalDevice(nullptr)
+    , mAllocationCallbacks(nullptr)
+    , mSemaphore(nullptr)
+  { }
+
+  TimelineSemaphore::TimelineSemaphore(VkDevice logicalDevice, std::uint64_t initialValue, const VkAllocationCallbacks* allocationCallbacks)
+    : mLogicalDevice(logicalDevice)
+    , mAllocationCallbacks(allocationCallbacks)
+    , mSemaphore(nullptr)
+  {
+    HAPI_PROFILE_ZONE("gfx::TimelineSemaphore::TimelineSemaphore");
+
+    VkSemaphoreTypeCreateInfoKHR typeCreateInfo;
+    {
+      typeCreateInfo.sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+      typeCreateInfo.pNext         = nullptr;
+      typeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+      typeCreateInfo.initialValue  = initialValue;
+    }
+
+    VkSemaphoreCreateInfo createInfo;
+    {
+      createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+      createInfo.pNext = &typeCreateInfo;
+      createInfo.flags = 0;
+    }
+
+    VkResult result = vkCreateSemaphore(mLogicalDevice, &createInfo, mAllocationCallbacks, &mSemaphore);
+    if (result != VK_SUCCESS)
+      throw std::runtime_error("Failed to create TimelineSemaphore.");
+  }
+
+  TimelineSemaphore::~TimelineSemaphore() noexcept {
+    // Wasn't created or was moved.
+    if (mSemaphore == nullptr)
+      return;
+
+    HAPI_PROFILE_ZONE("gfx::TimelineSemaphore::~TimelineSemaphore");
+
+    // Wait for device.
+    vkDeviceWaitIdle(mLogicalDevice);
+
+    // Delete.
+    vkDestroySemaphore(mLogicalDevice, mSemaphore, mAllocationCallbacks);
+  }
+
+  TimelineSemaphore::TimelineSemaphore(TimelineSemaphore&& other) noexcept
+    : mLogicalDevice(std::move(other.mLogicalDevice))
+    , mAllocationCallbacks(std::move(other.mAllocationCallbacks))
+    , mSemaphore(std::move(other.mSemaphore))
+  {
+    // Ensures.
+    other.mLogicalDevice       = nullptr;
+    other.mAllocationCallbacks = nullptr;
+    other.mSemaphore           = nullptr;
+  }
+
+  TimelineSemaphore& TimelineSemaphore::operator=(TimelineSemaphore&& other) noexcept {
+    std::swap(mLogicalDevice,       other.mLogicalDevice);
+    std::swap(mAllocationCallbacks, other.mAllocationCallbacks);
+    std::swap(mSemaphore,           other.mSemaphore);
+    return *this;
+  }
+
+  VkSemaphore TimelineSemaphore::handle() const noexcept {
+    return mSemaphore;
+  }
+
+  std::uint64_t TimelineSemaphore::value() const {
+    std::uint64_t value = 0;
+    VkResult result = getSemaphoreCounterValueKHR(mLogicalDevice, mSemaphore, &value);
+    if (result != VK_SUCCESS)
+      throw std::runtime_error("Failed to get the value of TimelineSemaphore.");
+    return value;
+  }
+
+  bool TimelineSemaphore::reached(std::uint64_t value) const {
+    return this->value() >= value;
+  }
+
+  bool TimelineSemaphore::wait(std::uint64_t value, std::uint64_t timeout) const {
+    VkSemaphoreWaitInfoKHR waitInfo;
+    {
+      waitInfo.sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+      waitInfo.pNext          = nullptr;
+      waitInfo.flags          = 0;
+      waitInfo.semaphoreCount = 1;
+      waitInfo.pSemaphores    = &mSemaphore;
+      waitInfo.pValues        = &value;
+    }
+
+    VkResult result = waitSemaphoresKHR(mLogicalDevice, &waitInfo, timeout);
+    if (result == VK_TIMEOUT)
+      return false;
+    if (result != VK_SUCCESS)
+      throw std::runtime_error("Failed to wait on TimelineSemaphore.");
+    return true;
+  }
+
+  void TimelineSemaphore::signal(std::uint64_t value) {
+    VkSemaphoreSignalInfoKHR signalInfo;
+    {
+      signalInfo.sType     = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO_KHR;
+      signalInfo.pNext     = nullptr;
+      signalInfo.semaphore = mSemaphore;
+      signalInfo.value     = value;
+    }
+
+    VkResult result = signalSemaphoreKHR(mLogicalDevice, &signalInfo);
+    if (result != VK_SUCCESS)
+      throw std::runtime_error("Failed to signal TimelineSemaphore.");
+  }
+
 }
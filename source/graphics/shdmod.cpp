@@ -0,0 +1,282 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <stdexcept>
+#include <hearth/graphics/shdmod.hpp>
+#include <hearth/profile.hpp>
+#if defined(HAPI_WINDOWS_OS)
+#  include "../win32/winapi.hpp"
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  //! \brief A read only view of a file mapped into memory, unmapped when destroyed.
+  class MappedFile final {
+  public:
+    /*!
+     * \brief     Explicitly defined constructor, maps the whole file.
+     * \param[in] filePath The path of the file to map.
+     */
+    explicit MappedFile(const std::string& filePath)
+      : mData(nullptr)
+      , mSize(0)
+    {
+    #if defined(HAPI_WINDOWS_OS)
+      HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+      if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Failed to open shader file.");
+
+      LARGE_INTEGER fileSize;
+      if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        throw std::runtime_error("Failed to get shader file size.");
+      }
+
+      HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      CloseHandle(file);
+      if (mapping == nullptr)
+        throw std::runtime_error("Failed to map shader file.");
+
+      mData = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      CloseHandle(mapping);
+      mSize = static_cast<std::size_t>(fileSize.QuadPart);
+    #else
+      const int file = ::open(filePath.c_str(), O_RDONLY);
+      if (file < 0)
+        throw std::runtime_error("Failed to open shader file.");
+
+      struct stat fileStatus;
+      if (::fstat(file, &fileStatus) != 0 || fileStatus.st_size == 0) {
+        ::close(file);
+        throw std::runtime_error("Failed to get shader file size.");
+      }
+
+      mSize = static_cast<std::size_t>(fileStatus.st_size);
+      mData = ::mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, file, 0);
+      ::close(file);
+      if (mData == MAP_FAILED)
+        mData = nullptr;
+    #endif
+
+      // Ensures.
+      if (mData == nullptr)
+        throw std::runtime_error("Failed to map shader file.");
+    }
+
+    //! \brief Explicitly defined destructor, unmaps the file.
+   ~MappedFile() noexcept {
+    #if defined(HAPI_WINDOWS_OS)
+      UnmapViewOfFile(mData);
+    #else
+      ::munmap(mData, mSize);
+    #endif
+    }
+
+  private:
+    // Not allowed.
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+  public:
+    /*!
+     * \brief  Gets the contents of the file as SPIR-V words, mappings are page aligned.
+     * \return The words of the file, a trailing partial word is left out.
+     */
+    std::span<const std::uint32_t> words() const noexcept {
+      return std::span{ static_cast<const std::uint32_t*>(mData), mSize / sizeof(std::uint32_t) };
+    }
+
+  private:
+    //! \brief The mapped contents of the file.
+    void* mData;
+
+    //! \brief The size of the file.
+    std::size_t mSize;
+  };
+
+  std::uint64_t ShaderModule::hashCode(std::span<const std::uint32_t> code) noexcept {
+    // FNV-1a over whole words, SPIR-V is always a whole number of them.
+    std::uint64_t hash = 0xCBF29CE484222325ull;
+    for (const auto word : code) {
+      hash ^= word;
+      hash *= 0x100000001B3ull;
+    }
+
+    return hash ^ code.size();
+  }
+
+  ShaderModule::ShaderModule() noexcept
+    : mLogicalDevice(nullptr)
+    , mAllocationCallbacks(nullptr)
+    , mShaderModule(nullptr)
+    , mHash(0)
+    , mCode()
+  { }
+
+  ShaderModule::ShaderModule(const CreateInfo& createInfo)
+    : mLogicalDevice(createInfo.logicalDevice)
+    , mAllocationCallbacks(createInfo.allocationCallbacks)
+    , mShaderModule(nullptr)
+    , mHash(hashCode(createInfo.code))
+    , mCode(createInfo.code.begin(), createInfo.code.end())
+  {
+    HAPI_PROFILE_ZONE("gfx::ShaderModule::ShaderModule");
+
+    // Expects.
+    if (createInfo.code.empty())
+      throw std::runtime_error("Expected SPIR-V code for shader module.");
+
+    VkShaderModuleCreateInfo moduleCreateInfo;
+    {
+      moduleCreateInfo.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+      moduleCreateInfo.pNext    = nullptr;
+      moduleCreateInfo.flags    = 0;
+      moduleCreateInfo.codeSize = createInfo.code.size_bytes();
+      moduleCreateInfo.pCode    = createInfo.code.data();
+    }
+
+    VkResult result = vkCreateShaderModule(mLogicalDevice, &moduleCreateInfo, mAllocationCallbacks, &mShaderModule);
+    if (result != VK_SUCCESS)
+      throw std::runtime_error("Failed to create shader module.");
+  }
+
+  ShaderModule::~ShaderModule() noexcept {
+    // Wasn't created or was moved.
+    if (mShaderModule == nullptr)
+      return;
+
+    HAPI_PROFILE_ZONE("gfx::ShaderModule::~ShaderModule");
+
+    // Pipelines don't need their modules once created, delete right away.
+    vkDestroyShaderModule(mLogicalDevice, mShaderModule, mAllocationCallbacks);
+  }
+
+  ShaderModule::ShaderModule(ShaderModule&& other) noexcept
+    : mLogicalDevice(std::move(other.mLogicalDevice))
+    , mAllocationCallbacks(std::move(other.mAllocationCallbacks))
+    , mShaderModule(std::move(other.mShaderModule))
+    , mHash(other.mHash)
+    , mCode(std::move(other.mCode))
+  {
+    // Ensures.
+    other.mLogicalDevice       = nullptr;
+    other.mAllocationCallbacks = nullptr;
+    other.mShaderModule        = nullptr;
+    other.mHash                = 0;
+    other.mCode.clear();
+  }
+
+  ShaderModule& ShaderModule::operator=(ShaderModule&& other) noexcept {
+    std::swap(mLogicalDevice,       other.mLogicalDevice);
+    std::swap(mAllocationCallbacks, other.mAllocationCallbacks);
+    std::swap(mShaderModule,        other.mShaderModule);
+    std::swap(mHash,                other.mHash);
+    std::swap(mCode,                other.mCode);
+    return *this;
+  }
+
+  VkShaderModule ShaderModule::handle() const noexcept {
+    return mShaderModule;
+  }
+
+  std::uint64_t ShaderModule::hash() const noexcept {
+    return mHash;
+  }
+
+  std::span<const std::uint32_t> ShaderModule::code() const noexcept {
+    return mCode;
+  }
+
+  ShaderLibrary::ShaderLibrary(const CreateInfo& createInfo) noexcept
+    : mLogicalDevice(createInfo.logicalDevice)
+    , mAllocationCallbacks(createInfo.allocationCallbacks)
+    , mPaths()
+    , mModules()
+    , mLock()
+  { }
+
+  std::shared_ptr<const ShaderModule> ShaderLibrary::load(const std::string& filePath) {
+    std::scoped_lock lock{ mLock };
+
+    // Loaded from this path before and still alive, don't even touch the file.
+    if (auto pathEntry = mPaths.find(filePath); pathEntry != mPaths.end())
+      if (auto shaderModule = pathEntry->second.lock())
+        return shaderModule;
+
+    const MappedFile file(filePath);
+    auto shaderModule = findOrCreate(file.words());
+    mPaths[filePath] = shaderModule;
+    return shaderModule;
+  }
+
+  std::shared_ptr<const ShaderModule> ShaderLibrary::load(std::span<const std::uint32_t> code) {
+    std::scoped_lock lock{ mLock };
+    return findOrCreate(code);
+  }
+
+  std::size_t ShaderLibrary::size() const {
+    std::scoped_lock lock{ mLock };
+    std::size_t count = 0;
+    for (const auto& [hash, shaderModule] : mModules)
+      count += shaderModule.expired() ? 0 : 1;
+
+    return count;
+  }
+
+  std::shared_ptr<const ShaderModule> ShaderLibrary::findOrCreate(std::span<const std::uint32_t> code) {
+    // Same code under another path, or from memory, compiles to the same module. The hash only
+    // narrows the search down, the code itself decides.
+    const auto hash = ShaderModule::hashCode(code);
+    auto [first, last] = mModules.equal_range(hash);
+    for (auto it = first; it != last; ++it) {
+      auto shaderModule = it->second.lock();
+      if (shaderModule != nullptr && std::ranges::equal(shaderModule->code(), code))
+        return shaderModule;
+    }
+
+    // About to add a module, forget the ones nothing holds on to anymore.
+    const auto expired = [](const auto& entry) {
+      return entry.second.expired();
+    };
+
+    std::erase_if(mModules, expired);
+    std::erase_if(mPaths, expired);
+
+    // Provide shader module create info.
+    const ShaderModule::CreateInfo shdmodCreateInfo {
+      .logicalDevice       = mLogicalDevice,
+      .allocationCallbacks = mAllocationCallbacks,
+      .code                = code
+    };
+
+    // Create shader module.
+    auto shaderModule = std::make_shared<const ShaderModule>(shdmodCreateInfo);
+    mModules.emplace(hash, shaderModule);
+    return shaderModule;
+  }
+
+}
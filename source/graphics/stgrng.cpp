@@ -0,0 +1,200 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <hearth/graphics/stgrng.hpp>
+#include <hearth/graphics/cmdbuf.hpp>
+#include <hearth/graphics/frmrng.hpp>
+#include <hearth/profile.hpp>
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  // The number of copy regions gathered on the stack before a command is recorded.
+  constexpr std::size_t kBatchSize = 16;
+
+  StagingRing::StagingRing(const CreateInfo& createInfo)
+    : mBuffer(ResourceBuffer::CreateInfo{
+        .allocator           = createInfo.allocator,
+        .stagingRing         = nullptr,
+        .deletionQueue       = nullptr,
+        .logicalDevice       = createInfo.logicalDevice,
+        .allocationCallbacks = createInfo.allocationCallbacks,
+        .bufferSize          = createInfo.capacity != 0 ? createInfo.capacity : DefaultCapacity,
+        .initialData         = nullptr,
+        .bufferUsage         = ResourceBuffer::UsageTransferSrcBit,
+        .residency           = BufferResidency::Upload
+      })
+    , mFrameRing(createInfo.frameRing)
+    , mCopies()
+    , mBatches()
+    , mLock()
+    , mCapacity(mBuffer.size())
+    , mHead(0)
+    , mTail(0)
+    , mUsed(0)
+    , mPendingBytes(0)
+    , mFlushedBytes(0)
+  {
+    HAPI_PROFILE_ZONE("gfx::StagingRing::StagingRing");
+
+    // Expects.
+    if (createInfo.frameRing == nullptr)
+      throw std::runtime_error("Staging ring requires a frame ring to track completion.");
+  }
+
+  StagingRing::~StagingRing() noexcept {
+    HAPI_PROFILE_ZONE("gfx::StagingRing::~StagingRing");
+
+    // The staging buffer waits for the device before it's destroyed.
+    mCopies.clear();
+    mBatches.clear();
+  }
+
+  void StagingRing::upload(const ResourceBuffer* destination, VkDeviceSize offset, const void* data, VkDeviceSize size) {
+    // Expects.
+    if (destination == nullptr)
+      throw std::runtime_error("Cannot upload into null resource buffer.");
+
+    // Expects.
+    const auto aligned = (size + UploadAlignment - 1) / UploadAlignment * UploadAlignment;
+    if (aligned > mCapacity)
+      throw std::runtime_error("Upload is larger than the staging ring.");
+
+    std::unique_lock lock{ mLock };
+    auto staged = std::optional<VkDeviceSize>{ };
+    for (reclaim(); !(staged = reserve(aligned)); reclaim()) {
+      // Wait for the oldest batch to finish executing, without holding up flushes and retires.
+      if (!mBatches.empty()) {
+        const auto completionValue = mBatches.front().completionValue;
+        lock.unlock();
+        mFrameRing->wait(completionValue);
+        lock.lock();
+        continue;
+      }
+
+      // Nothing in flight to wait on, the queued uploads alone fill the ring.
+      if (mFlushedBytes == 0)
+        throw std::runtime_error("Staging ring is too small for the queued uploads.");
+
+      // The flushed batch is about to be retired, let it.
+      lock.unlock();
+      std::this_thread::yield();
+      lock.lock();
+    }
+
+    std::memcpy(static_cast<std::byte*>(mBuffer.mapped()) + *staged, data, size);
+    mCopies.push_back(Copy{
+      .destination = destination,
+      .region      = VkBufferCopy{ *staged, offset, size }
+    });
+  }
+
+  void StagingRing::flush(CommandBuffer& commandBuffer) {
+    std::scoped_lock lock{ mLock };
+    if (mCopies.empty())
+      return;
+
+    // Batch consecutive copies into the same destination into a single command, recording a
+    // command per full batch.
+    std::array<VkBufferCopy, kBatchSize> regions;
+    std::size_t                          count = 0;
+    for (std::size_t index = 0; index < mCopies.size(); index++) {
+      regions[count++] = mCopies[index].region;
+
+      const auto last = index + 1 == mCopies.size() || mCopies[index + 1].destination != mCopies[index].destination;
+      if (count < kBatchSize && !last)
+        continue;
+
+      commandBuffer.copyBuffer(&mBuffer, mCopies[index].destination, std::span(regions.data(), count));
+      count = 0;
+    }
+
+    // Make the copies visible to everything that may read the destinations.
+    commandBuffer.memoryBarrier(
+      PipelineStageTransferBit,
+      VK_ACCESS_TRANSFER_WRITE_BIT,
+      PipelineStageVertexInputBit | PipelineStageVertexShaderBit | PipelineStageFragmentShaderBit | PipelineStageTransferBit,
+      VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT |
+      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT
+    );
+
+    mCopies.clear();
+    mFlushedBytes += mPendingBytes;
+    mPendingBytes  = 0;
+  }
+
+  void StagingRing::retire(std::uint64_t completionValue) {
+    std::scoped_lock lock{ mLock };
+    if (mFlushedBytes == 0)
+      return;
+
+    mBatches.push_back(Batch{
+      .bytes           = mFlushedBytes,
+      .completionValue = completionValue
+    });
+    mFlushedBytes = 0;
+  }
+
+  VkDeviceSize StagingRing::capacity() const noexcept {
+    return mCapacity;
+  }
+
+  std::optional<VkDeviceSize> StagingRing::reserve(VkDeviceSize size) {
+    // Start from the beginning whenever the ring is empty.
+    if (mUsed == 0) {
+      mHead = 0;
+      mTail = 0;
+    }
+
+    // Find a contiguous range, wrapping around when the end of the ring is too small.
+    VkDeviceSize offset = 0;
+    VkDeviceSize waste  = 0;
+    if (mUsed == 0 || mHead > mTail) {
+      if (mHead + size <= mCapacity)
+        offset = mHead;
+      else if (size <= mTail)
+        waste = mCapacity - mHead;
+      else
+        return std::nullopt;
+    } else if (mHead < mTail && mHead + size <= mTail) {
+      offset = mHead;
+    } else {
+      return std::nullopt;
+    }
+
+    mHead          = (offset + size) % mCapacity;
+    mUsed         += waste + size;
+    mPendingBytes += waste + size;
+    return offset;
+  }
+
+  void StagingRing::reclaim() {
+    while (!mBatches.empty() && mFrameRing->completed(mBatches.front().completionValue)) {
+      mTail  = (mTail + mBatches.front().bytes) % mCapacity;
+      mUsed -= mBatches.front().bytes;
+      mBatches.pop_front();
+    }
+  }
+
+}
@@ -19,9 +19,13 @@
  * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
+#include <algorithm>
+#include <array>
 #include <stdexcept>
 #include <vector>
 #include <hearth/graphics/swpchn.hpp>
+#include <hearth/graphics/dltque.hpp>
+#include <hearth/profile.hpp>
 #include "queuefamily.hpp"
 
 namespace HAPI_NAMESPACE_NAME::gfx {
@@ -91,15 +95,15 @@ namespace HAPI_NAMESPACE_NAME::gfx {
 
   SwapChain::SwapChain() noexcept
     : mSurfacePair{ nullptr, nullptr }
-    , mImages{ nullptr, nullptr, nullptr }
-    , mImageViews{ nullptr, nullptr, nullptr }
+    , mImages()
+    , mImageViews()
     , mPhysicalDevice(nullptr)
     , mLogicalDevice(nullptr)
+    , mAllocationCallbacks(nullptr)
+    , mDeletionQueue(nullptr)
     , mSwapChain(nullptr)
-    , mImageAvailable(nullptr)
-    , mRenderFinished(nullptr)
     , mExtent{ 0, 0 }
-    , mNextImage(0)
+    , mImageCount(0)
     , mFormat(VK_FORMAT_UNDEFINED)
     , mBufferStrategy(BufferStrategy::DoubleBuffer)
     , mVsyncEnabled(false)
@@ -107,22 +111,23 @@ namespace HAPI_NAMESPACE_NAME::gfx {
 
   SwapChain::SwapChain(const CreateInfo& createInfo)
     : mSurfacePair(createInfo.surfacePair)
-    , mImages{ nullptr, nullptr, nullptr }
-    , mImageViews{ nullptr, nullptr, nullptr }
+    , mImages()
+    , mImageViews()
     , mPhysicalDevice(createInfo.physicalDevice)
     , mLogicalDevice(createInfo.logicalDevice)
+    , mAllocationCallbacks(createInfo.allocationCallbacks)
+    , mDeletionQueue(createInfo.deletionQueue)
     , mSwapChain(nullptr)
-    , mImageAvailable(nullptr)
-    , mRenderFinished(nullptr)
     , mExtent{ 0, 0 }
-    , mNextImage(0)
+    , mImageCount(0)
     , mFormat(VK_FORMAT_UNDEFINED)
     , mBufferStrategy(createInfo.bufferStrategy)
     , mVsyncEnabled(createInfo.vsyncEnabled)
   {
+    HAPI_PROFILE_ZONE("gfx::SwapChain::SwapChain");
+
     initializeSwapchain(createInfo.imageResolution, createInfo.imageFormat);
     initializeImageViews();
-    initializeSemaphores();
   }
 
   SwapChain::~SwapChain() noexcept {
@@ -130,17 +135,14 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     if (mSwapChain == nullptr)
       return;
 
-    // Wait for device.
-    vkDeviceWaitIdle(mLogicalDevice);
+    HAPI_PROFILE_ZONE("gfx::SwapChain::~SwapChain");
 
-    // Delete semaphores.
-    vkDestroySemaphore(mLogicalDevice, mImageAvailable, nullptr);
-    vkDestroySemaphore(mLogicalDevice, mRenderFinished, nullptr);
+    // Without a deletion queue, wait for device.
+    if (mDeletionQueue == nullptr)
+      vkDeviceWaitIdle(mLogicalDevice);
 
     // Delete views and swapchain.
-    for (auto imageView : mImageViews)
-      vkDestroyImageView(mLogicalDevice, imageView, nullptr);
-    vkDestroySwapchainKHR(mLogicalDevice, mSwapChain, nullptr);
+    destroySwapChain(mImageViews, mSwapChain);
   }
 
   SwapChain::SwapChain(SwapChain&& other) noexcept
@@ -149,48 +151,48 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     , mImageViews(std::move(other.mImageViews))
     , mPhysicalDevice(std::move(other.mPhysicalDevice))
     , mLogicalDevice(std::move(other.mLogicalDevice))
+    , mAllocationCallbacks(std::move(other.mAllocationCallbacks))
+    , mDeletionQueue(std::move(other.mDeletionQueue))
     , mSwapChain(std::move(other.mSwapChain))
-    , mImageAvailable(std::move(other.mImageAvailable))
-    , mRenderFinished(std::move(other.mRenderFinished))
     , mExtent(std::move(other.mExtent))
-    , mNextImage(other.mNextImage)
+    , mImageCount(other.mImageCount)
     , mFormat(other.mFormat)
     , mBufferStrategy(other.mBufferStrategy)
     , mVsyncEnabled(other.mVsyncEnabled)
   {
     // Ensures.
-    other.mSurfacePair    = std::pair<Window*, VkSurfaceKHR>{ nullptr, nullptr };
-    other.mImages         = std::array<VkImage,     3>{ nullptr, nullptr, nullptr };
-    other.mImageViews     = std::array<VkImageView, 3>{ nullptr, nullptr, nullptr };
-    other.mPhysicalDevice = nullptr;
-    other.mLogicalDevice  = nullptr;
-    other.mSwapChain      = nullptr;
-    other.mImageAvailable = nullptr;
-    other.mRenderFinished = nullptr;
+    other.mSurfacePair         = std::pair<Window*, VkSurfaceKHR>{ nullptr, nullptr };
+    other.mImages.clear();
+    other.mImageViews.clear();
+    other.mPhysicalDevice      = nullptr;
+    other.mLogicalDevice       = nullptr;
+    other.mAllocationCallbacks = nullptr;
+    other.mDeletionQueue       = nullptr;
+    other.mSwapChain           = nullptr;
   }
 
   SwapChain& SwapChain::operator=(SwapChain&& other) noexcept {
-    std::swap(mSurfacePair,    other.mSurfacePair);
-    std::swap(mImages,         other.mImages);
-    std::swap(mImageViews,     other.mImageViews);
-    std::swap(mPhysicalDevice, other.mPhysicalDevice);
-    std::swap(mLogicalDevice,  other.mLogicalDevice);
-    std::swap(mSwapChain,      other.mSwapChain);
-    std::swap(mImageAvailable, other.mImageAvailable);
-    std::swap(mRenderFinished, other.mRenderFinished);
-    std::swap(mExtent,         other.mExtent);
-    std::swap(mNextImage,      other.mNextImage);
-    std::swap(mFormat,         other.mFormat);
-    std::swap(mBufferStrategy, other.mBufferStrategy);
-    std::swap(mVsyncEnabled,   other.mVsyncEnabled);
+    std::swap(mSurfacePair,         other.mSurfacePair);
+    std::swap(mImages,              other.mImages);
+    std::swap(mImageViews,          other.mImageViews);
+    std::swap(mPhysicalDevice,      other.mPhysicalDevice);
+    std::swap(mLogicalDevice,       other.mLogicalDevice);
+    std::swap(mAllocationCallbacks, other.mAllocationCallbacks);
+    std::swap(mDeletionQueue,       other.mDeletionQueue);
+    std::swap(mSwapChain,           other.mSwapChain);
+    std::swap(mExtent,              other.mExtent);
+    std::swap(mImageCount,          other.mImageCount);
+    std::swap(mFormat,              other.mFormat);
+    std::swap(mBufferStrategy,      other.mBufferStrategy);
+    std::swap(mVsyncEnabled,        other.mVsyncEnabled);
     return *this;
   }
 
-  const std::array<VkImageView, 3>& SwapChain::imageViews() const noexcept {
+  const std::vector<VkImageView>& SwapChain::imageViews() const noexcept {
     return mImageViews;
   }
 
-  std::array<VkImageView, 3>& SwapChain::imageViews() noexcept {
+  std::vector<VkImageView>& SwapChain::imageViews() noexcept {
     return mImageViews;
   }
 
@@ -210,52 +212,55 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     return mBufferStrategy;
   }
 
-  void SwapChain::present(VkQueue presentQueue) {
-    VkResult result = vkAcquireNextImageKHR(mLogicalDevice, mSwapChain, UINT64_MAX, mImageAvailable, VK_NULL_HANDLE, &mNextImage);
+  std::uint32_t SwapChain::imageCount() const noexcept {
+    return mImageCount;
+  }
+
+  std::optional<std::uint32_t> SwapChain::acquireNextImage(const Semaphore* imageAvailable) {
+    // Expects.
+    if (imageAvailable == nullptr)
+      throw std::runtime_error("Expected non-null semaphore on image acquisition.");
+
+    std::uint32_t imageIndex = 0;
+    VkResult result = vkAcquireNextImageKHR(mLogicalDevice, mSwapChain, UINT64_MAX, imageAvailable->handle(), VK_NULL_HANDLE, &imageIndex);
     if (result == VK_ERROR_OUT_OF_DATE_KHR) {
       rebuildSwapChain(glm::uvec2{ mExtent.width, mExtent.height });
-      return;
+      return std::nullopt;
     } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
       throw std::runtime_error("Failed to acquire next image.");
 
-    VkSemaphore          signalSemaphores[1] = { mRenderFinished };
-    VkSemaphore          waitSemaphores[1]   = { mImageAvailable };
-    VkPipelineStageFlags waitStages[1]       = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+    return imageIndex;
+  }
 
-    VkSubmitInfo submitInfo;
-    {
-      submitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-      submitInfo.pNext                = nullptr;
-      submitInfo.waitSemaphoreCount   = 1;
-      submitInfo.pWaitSemaphores      = waitSemaphores;
-      submitInfo.pWaitDstStageMask    = waitStages;
-      submitInfo.commandBufferCount   = 0;
-      submitInfo.pCommandBuffers      = nullptr;
-      submitInfo.signalSemaphoreCount = 1;
-      submitInfo.pSignalSemaphores    = signalSemaphores;
-    }
+  bool SwapChain::present(VkQueue presentQueue, std::uint32_t imageIndex, const Semaphore* renderFinished) {
+    HAPI_PROFILE_ZONE("gfx::SwapChain::present");
 
-    result = vkQueueSubmit(presentQueue, 1, &submitInfo, VK_NULL_HANDLE);
-    if (result != VK_SUCCESS)
-      throw std::runtime_error("Failed to submit semaphore to queue on present.");
+    // Expects.
+    if (renderFinished == nullptr)
+      throw std::runtime_error("Expected non-null semaphore on present.");
+
+    VkSemaphore waitSemaphores[1] = { renderFinished->handle() };
 
     VkPresentInfoKHR presinfo;
     {
       presinfo.sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
       presinfo.pNext              = nullptr;
       presinfo.waitSemaphoreCount = 1;
-      presinfo.pWaitSemaphores    = signalSemaphores;
+      presinfo.pWaitSemaphores    = waitSemaphores;
       presinfo.swapchainCount     = 1;
       presinfo.pSwapchains        = &mSwapChain;
-      presinfo.pImageIndices      = &mNextImage;
+      presinfo.pImageIndices      = &imageIndex;
       presinfo.pResults           = 0;
     }
 
-    result = vkQueuePresentKHR(presentQueue, &presinfo);
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+    VkResult result = vkQueuePresentKHR(presentQueue, &presinfo);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
       rebuildSwapChain(glm::uvec2{ mExtent.width, mExtent.height });
-    else if (result != VK_SUCCESS)
+      return false;
+    } else if (result != VK_SUCCESS)
       throw std::runtime_error("Failed to present.");
+
+    return true;
   }
 
   void SwapChain::reseat(const glm::uvec2& resolution) {
@@ -268,13 +273,10 @@ namespace HAPI_NAMESPACE_NAME::gfx {
     VkPresentModeKHR        surfacePresentMode = chooseSwapchainPresentMode(swapchainSupport.presentModes, mVsyncEnabled);
     VkExtent2D              surfaceExtent      = chooseSwapchainExtent(swapchainSupport.capabilities, resolution.x, resolution.y);
 
-    std::uint32_t imageCount  = swapchainSupport.capabilities.minImageCount + 1;
-    std::uint32_t bufferCount = static_cast<std::uint32_t>(mBufferStrategy);
+    // Ask for one image per buffer, within what the surface allows, a max of zero is unbounded.
+    std::uint32_t imageCount = std::max(static_cast<std::uint32_t>(mBufferStrategy), swapchainSupport.capabilities.minImageCount);
     if (swapchainSupport.capabilities.maxImageCount > 0)
-      imageCount = std::clamp(bufferCount, swapchainSupport.capabilities.minImageCount, swapchainSupport.capabilities.maxImageCount);
-
-    // Clamp if the max image count is infinite.
-    imageCount = std::min(bufferCount, 3u);
+      imageCount = std::min(imageCount, swapchainSupport.capabilities.maxImageCount);
 
     // Get queues.
     QueueFamilyIndices indices = getQueueFamilies(std::pair{ mPhysicalDevice, mSurfacePair.second });
@@ -311,17 +313,20 @@ namespace HAPI_NAMESPACE_NAME::gfx {
       swapchainCreateInfo.compositeAlpha          = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
       swapchainCreateInfo.presentMode             = surfacePresentMode;
       swapchainCreateInfo.clipped                 = VK_TRUE;
-      swapchainCreateInfo.oldSwapchain            = nullptr;
+      swapchainCreateInfo.oldSwapchain            = mSwapChain;
     }
 
     // Attempt to create swap chain.
-    VkResult result = vkCreateSwapchainKHR(mLogicalDevice, &swapchainCreateInfo, nullptr, &mSwapChain);
+    VkResult result = vkCreateSwapchainKHR(mLogicalDevice, &swapchainCreateInfo, mAllocationCallbacks, &mSwapChain);
     if (result != VK_SUCCESS)
       throw std::runtime_error("Failed to create swap chain.");
 
-    // Obtain swapchain images.
+    // Obtain swapchain images, the implementation may have created more than we asked for and
+    // acquisition can return any of them.
     vkGetSwapchainImagesKHR(mLogicalDevice, mSwapChain, &imageCount, nullptr);
+    mImages.resize(imageCount);
     vkGetSwapchainImagesKHR(mLogicalDevice, mSwapChain, &imageCount, mImages.data());
+    mImageCount = imageCount;
 
     mFormat = surfaceFormat.format;
     mExtent = surfaceExtent;
@@ -350,48 +355,47 @@ namespace HAPI_NAMESPACE_NAME::gfx {
 
     // Store result.
     VkResult result = VK_SUCCESS;
-    for (std::size_t index = 0; index < static_cast<std::size_t>(mBufferStrategy); index++) {
+    mImageViews.assign(mImageCount, nullptr);
+    for (std::size_t index = 0; index < mImageCount; index++) {
       // Set image.
       ivCreateInfo.image = mImages[index];
 
       // Perform creation.
-      result = vkCreateImageView(mLogicalDevice, &ivCreateInfo, nullptr, &mImageViews[index]);
+      result = vkCreateImageView(mLogicalDevice, &ivCreateInfo, mAllocationCallbacks, &mImageViews[index]);
       if (result != VK_SUCCESS)
         throw std::runtime_error("Failed to create image views.");
     }
   }
 
-  void SwapChain::initializeSemaphores() {
-    VkSemaphoreCreateInfo createInfo;
-    {
-      createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-      createInfo.pNext = nullptr;
-      createInfo.flags = 0;
-    }
-
-    VkResult result = vkCreateSemaphore(mLogicalDevice, &createInfo, nullptr, &mImageAvailable);
-    if (result != VK_SUCCESS)
-      throw std::runtime_error("Failed to create image available semaphore.");
-
-    result = vkCreateSemaphore(mLogicalDevice, &createInfo, nullptr, &mRenderFinished);
-    if (result != VK_SUCCESS)
-      throw std::runtime_error("Failed to create render finished semaphore");
-  }
-
   void SwapChain::rebuildSwapChain(const glm::uvec2& resolution) {
-    // Wait for device availability.
-    vkDeviceWaitIdle(mLogicalDevice);
+    HAPI_PROFILE_ZONE("gfx::SwapChain::rebuildSwapChain");
 
-    // Delete image views.
-    for (auto view : mImageViews)
-      vkDestroyImageView(mLogicalDevice, view, nullptr);
+    // Without a deletion queue, wait for device availability.
+    if (mDeletionQueue == nullptr)
+      vkDeviceWaitIdle(mLogicalDevice);
 
-    // Delete swapchain entirely.
-    vkDestroySwapchainKHR(mLogicalDevice, mSwapChain, nullptr);
-
-    // Recreate.
+    // Recreate from the old swapchain, frames in flight may still be presenting its images.
+    const auto oldImageViews = std::move(mImageViews);
+    const auto oldSwapChain  = mSwapChain;
+    mImageViews.clear();
     initializeSwapchain(resolution, static_cast<Format>(mFormat));
     initializeImageViews();
+
+    // Delete old views and swapchain.
+    destroySwapChain(oldImageViews, oldSwapChain);
+  }
+
+  void SwapChain::destroySwapChain(const std::vector<VkImageView>& imageViews, VkSwapchainKHR swapChain) noexcept {
+    const auto destroy = [logicalDevice = mLogicalDevice, allocationCallbacks = mAllocationCallbacks, imageViews, swapChain] {
+      for (auto imageView : imageViews)
+        vkDestroyImageView(logicalDevice, imageView, allocationCallbacks);
+      vkDestroySwapchainKHR(logicalDevice, swapChain, allocationCallbacks);
+    };
+
+    if (mDeletionQueue != nullptr)
+      mDeletionQueue->enqueue(destroy);
+    else
+      destroy();
   }
 
 }
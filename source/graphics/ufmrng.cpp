@@ -0,0 +1,114 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <stdexcept>
+#include <hearth/graphics/ufmrng.hpp>
+#include <hearth/profile.hpp>
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  //! \brief Queries the alignment dynamic uniform buffer offsets must have.
+  static std::size_t queryUniformAlignment(VkPhysicalDevice physicalDevice) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    return std::max<std::size_t>(static_cast<std::size_t>(properties.limits.minUniformBufferOffsetAlignment), 1);
+  }
+
+  //! \brief Rounds the given size up to a multiple of the given alignment.
+  static std::size_t alignUp(std::size_t size, std::size_t alignment) noexcept {
+    return (size + alignment - 1) / alignment * alignment;
+  }
+
+  UniformRing::UniformRing(const CreateInfo& createInfo)
+    : mBuffer()
+    , mAlignment(queryUniformAlignment(createInfo.physicalDevice))
+    , mFrameCapacity(0)
+    , mFrameBase(0)
+    , mHead(0)
+  {
+    HAPI_PROFILE_ZONE("gfx::UniformRing::UniformRing");
+
+    // Expects.
+    if (createInfo.framesInFlight == 0)
+      throw std::runtime_error("Uniform ring requires at least one frame in flight.");
+
+    // Every region starts aligned, so every slice does.
+    mFrameCapacity = alignUp(createInfo.frameCapacity != 0 ? createInfo.frameCapacity : DefaultFrameCapacity, mAlignment);
+
+    // Provide uniform buffer create info.
+    const ResourceBuffer::CreateInfo resbufCreateInfo {
+      .allocator           = createInfo.allocator,
+      .stagingRing         = nullptr,
+      .deletionQueue       = nullptr,
+      .logicalDevice       = createInfo.logicalDevice,
+      .allocationCallbacks = createInfo.allocationCallbacks,
+      .bufferSize          = mFrameCapacity * createInfo.framesInFlight,
+      .initialData         = nullptr,
+      .bufferUsage         = ResourceBuffer::UsageUniformBufferBit,
+      .residency           = BufferResidency::Dynamic
+    };
+
+    // Create uniform buffer.
+    mBuffer = ResourceBuffer(resbufCreateInfo);
+  }
+
+  UniformRing::~UniformRing() noexcept {
+    HAPI_PROFILE_ZONE("gfx::UniformRing::~UniformRing");
+
+    // The uniform buffer waits for the device before it's destroyed.
+  }
+
+  void UniformRing::beginFrame(std::uint32_t frameIndex) {
+    // Expects.
+    if ((frameIndex + 1) * mFrameCapacity > mBuffer.size())
+      throw std::runtime_error("Uniform ring frame index out of range.");
+
+    mFrameBase = frameIndex * mFrameCapacity;
+    mHead.store(0, std::memory_order_relaxed);
+  }
+
+  UniformSlice UniformRing::allocate(std::size_t size) {
+    // Bump the head, slices of a frame never overlap.
+    const auto begin = mHead.fetch_add(alignUp(size, mAlignment), std::memory_order_relaxed);
+    if (begin + size > mFrameCapacity)
+      throw std::runtime_error("Uniform ring frame capacity exceeded.");
+
+    const auto offset = mFrameBase + begin;
+    return UniformSlice{
+      .data   = static_cast<std::byte*>(mBuffer.mapped()) + offset,
+      .offset = static_cast<std::uint32_t>(offset)
+    };
+  }
+
+  const ResourceBuffer* UniformRing::buffer() const noexcept {
+    return &mBuffer;
+  }
+
+  std::size_t UniformRing::alignment() const noexcept {
+    return mAlignment;
+  }
+
+  std::size_t UniformRing::frameCapacity() const noexcept {
+    return mFrameCapacity;
+  }
+
+}
@@ -0,0 +1,290 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <hearth/graphics/xfrque.hpp>
+#include <hearth/profile.hpp>
+
+namespace HAPI_NAMESPACE_NAME::gfx {
+
+  TransferQueue::TransferQueue(const CreateInfo& createInfo)
+    : mAllocator(createInfo.allocator)
+    , mLogicalDevice(createInfo.logicalDevice)
+    , mAllocationCallbacks(createInfo.allocationCallbacks)
+    , mQueue(createInfo.transferQueue)
+    , mTransferFamily(createInfo.transferFamily)
+    , mGraphicsFamily(createInfo.graphicsFamily)
+    , mCommandPool()
+    , mUploads()
+    , mInFlight()
+    , mFreeBatches()
+    , mAcquires()
+    , mNextTicket(1)
+    , mCompletedTicket(0)
+    , mAcquiredTicket(0)
+    , mLock()
+  {
+    HAPI_PROFILE_ZONE("gfx::TransferQueue::TransferQueue");
+
+    // Expects.
+    if (createInfo.allocator == nullptr)
+      throw std::runtime_error("Transfer queue requires a memory allocator.");
+
+    // Expects.
+    if (createInfo.transferQueue == nullptr)
+      throw std::runtime_error("Transfer queue requires a queue of the transfer family.");
+
+    // Provide command pool create info.
+    const CommandPool::CreateInfo cmdpllCreateInfo {
+      .logicalDevice       = mLogicalDevice,
+      .allocationCallbacks = mAllocationCallbacks,
+      .queueIndex          = mTransferFamily
+    };
+
+    // Create command pool.
+    mCommandPool = CommandPool(cmdpllCreateInfo);
+  }
+
+  TransferQueue::~TransferQueue() noexcept {
+    HAPI_PROFILE_ZONE("gfx::TransferQueue::~TransferQueue");
+
+    // Let every batch finish before its staging memory is freed.
+    vkDeviceWaitIdle(mLogicalDevice);
+    for (auto& upload : mUploads)
+      destroyStaging(upload.staging);
+    for (auto& batch : mInFlight)
+      for (auto& staging : batch->staging)
+        destroyStaging(staging);
+
+    // Batches own command buffers of our pool, they go first.
+    mInFlight.clear();
+    mFreeBatches.clear();
+  }
+
+  std::uint64_t TransferQueue::upload(const ResourceBuffer* destination, VkDeviceSize offset, const void* data, VkDeviceSize size) {
+    // Expects.
+    if (destination == nullptr)
+      throw std::runtime_error("Cannot upload into null resource buffer.");
+
+    // Stage outside the lock, large uploads shouldn't hold up other threads.
+    auto staging = createStaging(data, size);
+
+    std::scoped_lock lock{ mLock };
+    mUploads.push_back(Upload{
+      .staging     = staging,
+      .destination = destination,
+      .region      = VkBufferCopy{ 0, offset, size }
+    });
+    return mNextTicket;
+  }
+
+  std::uint64_t TransferQueue::submit() {
+    std::scoped_lock lock{ mLock };
+    if (mUploads.empty())
+      return mNextTicket - 1;
+
+    HAPI_PROFILE_ZONE("gfx::TransferQueue::submit");
+
+    // Reuse a finished batch if there is one.
+    retireCompleted();
+    std::unique_ptr<Batch> batch;
+    if (mFreeBatches.empty()) {
+      const CommandBuffer::CreateInfo cmdbufCreateInfo {
+        .commandPool   = &mCommandPool,
+        .logicalDevice = mLogicalDevice,
+        .deletionQueue = nullptr,
+        .level         = CommandBufferLevel::Primary
+      };
+
+      batch = std::make_unique<Batch>(Batch{
+        .commandBuffer = CommandBuffer(cmdbufCreateInfo),
+        .fence         = Fence(mLogicalDevice, false, mAllocationCallbacks),
+        .ticket        = 0,
+        .staging       = { },
+        .releases      = { }
+      });
+    } else {
+      batch = std::move(mFreeBatches.back());
+      mFreeBatches.pop_back();
+      batch->fence.reset();
+    }
+
+    // Copy every upload, then release their destinations to the graphics family.
+    batch->ticket = mNextTicket++;
+    batch->commandBuffer.begin();
+    for (auto& upload : mUploads) {
+      vkCmdCopyBuffer(batch->commandBuffer.handle(), upload.staging.buffer, upload.destination->handle(), 1, &upload.region);
+      batch->staging.push_back(upload.staging);
+      batch->releases.push_back(BufferBarrier{
+        .buffer                 = upload.destination,
+        .offset                 = upload.region.dstOffset,
+        .size                   = upload.region.size,
+        .sourceAccess           = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .destinationAccess      = 0,
+        .sourceQueueFamily      = mTransferFamily,
+        .destinationQueueFamily = mGraphicsFamily
+      });
+    }
+    batch->commandBuffer.bufferBarrier(PipelineStageTransferBit, PipelineStageBottomOfPipeBit, batch->releases);
+    batch->commandBuffer.end();
+    mUploads.clear();
+
+    // Provide submit info, completion is only signaled to the host.
+    const SubmitInfo submitInfo {
+      .waitSemaphore     = nullptr,
+      .waitStages        = 0,
+      .signalSemaphore   = nullptr,
+      .fence             = &batch->fence,
+      .timelineSemaphore = nullptr,
+      .timelineValue     = 0
+    };
+
+    batch->commandBuffer.submit(mQueue, submitInfo);
+    mInFlight.push_back(std::move(batch));
+    return mNextTicket - 1;
+  }
+
+  std::uint64_t TransferQueue::acquire(CommandBuffer& commandBuffer) {
+    std::scoped_lock lock{ mLock };
+    retireCompleted();
+    if (mAcquires.empty())
+      return mAcquiredTicket;
+
+    // Acquire with the same ranges and families the batches released with.
+    commandBuffer.bufferBarrier(
+      PipelineStageTopOfPipeBit,
+      PipelineStageVertexInputBit | PipelineStageVertexShaderBit | PipelineStageFragmentShaderBit | PipelineStageTransferBit,
+      mAcquires
+    );
+
+    mAcquires.clear();
+    mAcquiredTicket = mCompletedTicket;
+    return mAcquiredTicket;
+  }
+
+  bool TransferQueue::completed(std::uint64_t ticket) const {
+    std::scoped_lock lock{ mLock };
+    if (ticket <= mCompletedTicket)
+      return true;
+
+    // Batches finish in submission order, so the batch's own fence tells for all before it.
+    const auto* batch = findBatch(ticket);
+    return batch != nullptr && batch->fence.signaled();
+  }
+
+  bool TransferQueue::ready(std::uint64_t ticket) const {
+    std::scoped_lock lock{ mLock };
+    return ticket <= mAcquiredTicket;
+  }
+
+  void TransferQueue::wait(std::uint64_t ticket) const {
+    std::scoped_lock lock{ mLock };
+    if (ticket <= mCompletedTicket)
+      return;
+
+    // Expects.
+    const auto* batch = findBatch(ticket);
+    if (batch == nullptr)
+      throw std::runtime_error("Cannot wait on a transfer batch that was never submitted.");
+
+    batch->fence.wait(std::numeric_limits<std::uint64_t>::max());
+  }
+
+  TransferQueue::Staging TransferQueue::createStaging(const void* data, VkDeviceSize size) {
+    // Provide staging buffer create info.
+    VkBufferCreateInfo bufferCreateInfo;
+    {
+      bufferCreateInfo.sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+      bufferCreateInfo.pNext                 = nullptr;
+      bufferCreateInfo.flags                 = 0;
+      bufferCreateInfo.size                  = size;
+      bufferCreateInfo.usage                 = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+      bufferCreateInfo.sharingMode           = VK_SHARING_MODE_EXCLUSIVE;
+      bufferCreateInfo.queueFamilyIndexCount = 0;
+      bufferCreateInfo.pQueueFamilyIndices   = nullptr;
+    }
+
+    Staging staging{ };
+    if (vkCreateBuffer(mLogicalDevice, &bufferCreateInfo, mAllocationCallbacks, &staging.buffer) != VK_SUCCESS)
+      throw std::runtime_error("Failed to create staging buffer.");
+
+    // Sub-allocate memory the host can write into.
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(mLogicalDevice, staging.buffer, &requirements);
+    const AllocationInfo allocationInfo {
+      .requirements = requirements,
+      .usage        = MemoryUsage::CpuToGpu,
+      .kind         = AllocationKind::Buffer,
+      .dedicated    = false,
+      .userData     = nullptr
+    };
+
+    try {
+      staging.allocation = mAllocator->allocate(allocationInfo);
+    } catch (...) {
+      vkDestroyBuffer(mLogicalDevice, staging.buffer, mAllocationCallbacks);
+      throw;
+    }
+
+    vkBindBufferMemory(mLogicalDevice, staging.buffer, staging.allocation.memory, staging.allocation.offset);
+    std::memcpy(staging.allocation.mapped, data, size);
+    return staging;
+  }
+
+  void TransferQueue::destroyStaging(Staging& staging) noexcept {
+    vkDestroyBuffer(mLogicalDevice, staging.buffer, mAllocationCallbacks);
+    mAllocator->free(staging.allocation);
+    staging.buffer = nullptr;
+  }
+
+  void TransferQueue::retireCompleted() {
+    while (!mInFlight.empty() && mInFlight.front()->fence.signaled()) {
+      auto batch = std::move(mInFlight.front());
+      mInFlight.pop_front();
+
+      // The staging memory is no longer read, and the destinations can be acquired.
+      for (auto& staging : batch->staging)
+        destroyStaging(staging);
+      for (auto acquire : batch->releases) {
+        acquire.sourceAccess      = 0;
+        acquire.destinationAccess = VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+                                    VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT |
+                                    VK_ACCESS_TRANSFER_READ_BIT;
+        mAcquires.push_back(acquire);
+      }
+
+      mCompletedTicket = batch->ticket;
+      batch->staging.clear();
+      batch->releases.clear();
+      mFreeBatches.push_back(std::move(batch));
+    }
+  }
+
+  const TransferQueue::Batch* TransferQueue::findBatch(std::uint64_t ticket) const noexcept {
+    for (const auto& batch : mInFlight)
+      if (batch->ticket == ticket)
+        return batch.get();
+    return nullptr;
+  }
+
+}
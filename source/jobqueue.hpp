@@ -0,0 +1,138 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <hearth/config.hpp>
+
+namespace HAPI_NAMESPACE_NAME {
+
+  /*!
+   * \brief A fixed capacity Chase-Lev work-stealing deque.
+   *
+   * The owning thread pushes and pops at the bottom, like a stack, which keeps recently spawned
+   * (and likely cache-hot) work local. Any other thread may steal from the top. Only the owner may
+   * call push() and pop(), steal() is safe from any thread.
+   *
+   * Follows "Correct and Efficient Work-Stealing for Weak Memory Models" (Lê et al. 2013), without
+   * growing the buffer, a full deque is reported to the caller instead.
+   */
+  template<typename Type>
+  class WorkStealingQueue final {
+  public:
+    /*!
+     * \brief     Constructs this deque with the given capacity.
+     * \param[in] capacity The number of elements the deque can hold, must be a power of two.
+     */
+    explicit WorkStealingQueue(std::size_t capacity)
+      : mTop(0)
+      , mBottom(0)
+      , mMask(static_cast<std::int64_t>(capacity) - 1)
+      , mBuffer(std::make_unique<std::atomic<Type*>[]>(capacity))
+    { }
+
+  private:
+    // Not allowed.
+    WorkStealingQueue(const WorkStealingQueue&) = delete;
+    WorkStealingQueue& operator=(const WorkStealingQueue&) = delete;
+
+  public:
+    /*!
+     * \brief     Pushes an element onto the bottom of the deque, owner only.
+     * \param[in] element The element to push.
+     * \return    False if the deque was full and the element was not pushed.
+     */
+    bool push(Type* element) noexcept {
+      const auto bottom = mBottom.load(std::memory_order_relaxed);
+      const auto top    = mTop.load(std::memory_order_acquire);
+      if (bottom - top > mMask)
+        return false;
+
+      mBuffer[bottom & mMask].store(element, std::memory_order_release);
+      std::atomic_thread_fence(std::memory_order_release);
+      mBottom.store(bottom + 1, std::memory_order_relaxed);
+      return true;
+    }
+
+    /*!
+     * \brief  Pops an element from the bottom of the deque, owner only.
+     * \return The popped element, or null if the deque was empty.
+     */
+    Type* pop() noexcept {
+      const auto bottom = mBottom.load(std::memory_order_relaxed) - 1;
+      mBottom.store(bottom, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      auto top = mTop.load(std::memory_order_relaxed);
+
+      // Empty, restore.
+      if (top > bottom) {
+        mBottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+      }
+
+      // More than one element left, no thief can race us for it.
+      Type* element = mBuffer[bottom & mMask].load(std::memory_order_acquire);
+      if (top != bottom)
+        return element;
+
+      // Last element, race thieves for it.
+      if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        element = nullptr;
+
+      mBottom.store(bottom + 1, std::memory_order_relaxed);
+      return element;
+    }
+
+    /*!
+     * \brief  Steals an element from the top of the deque, from any thread.
+     * \return The stolen element, or null if the deque was empty or another thread won the race.
+     */
+    Type* steal() noexcept {
+      auto top = mTop.load(std::memory_order_acquire);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      const auto bottom = mBottom.load(std::memory_order_acquire);
+      if (top >= bottom)
+        return nullptr;
+
+      Type* element = mBuffer[top & mMask].load(std::memory_order_acquire);
+      if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return nullptr;
+
+      return element;
+    }
+
+  private:
+    //! \brief The index thieves steal from, kept on its own cache line to avoid false sharing.
+    alignas(64) std::atomic<std::int64_t> mTop;
+
+    //! \brief The index the owner pushes to and pops from.
+    alignas(64) std::atomic<std::int64_t> mBottom;
+
+    //! \brief Masks indices into the buffer.
+    std::int64_t mMask;
+
+    //! \brief The ring buffer of elements.
+    std::unique_ptr<std::atomic<Type*>[]> mBuffer;
+  };
+
+}
@@ -0,0 +1,239 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <array>
+#include <cstdio>
+#include <stdexcept>
+#include <hearth/profile.hpp>
+
+namespace HAPI_NAMESPACE_NAME {
+
+  //! \brief A single producer, single consumer ring of the records of one thread.
+  class Profiler::ThreadBuffer final {
+  public:
+    /*!
+     * \brief     Explicitly defined constructor.
+     * \param[in] threadId The id the thread will be given in the trace.
+     */
+    explicit ThreadBuffer(std::uint32_t threadId) noexcept
+      : mRecords()
+      , mHead(0)
+      , mTail(0)
+      , mThreadId(threadId)
+    { }
+
+  public:
+    /*!
+     * \brief     Pushes a record, only called by the owning thread.
+     * \param[in] record The record to push.
+     * \return    False if the ring was full and the record was dropped.
+     */
+    bool push(const ProfileRecord& record) noexcept {
+      const auto head = mHead.load(std::memory_order_relaxed);
+      if (head - mTail.load(std::memory_order_acquire) == mRecords.size())
+        return false;
+
+      mRecords[head % mRecords.size()] = record;
+      mHead.store(head + 1, std::memory_order_release);
+      return true;
+    }
+
+    /*!
+     * \brief     Pops every record pushed so far, only called by the flushing thread.
+     * \param[in] consume The function to pass each record to.
+     */
+    template<typename Function>
+    void drain(Function&& consume) noexcept {
+      const auto tail = mTail.load(std::memory_order_relaxed);
+      const auto head = mHead.load(std::memory_order_acquire);
+      for (auto index = tail; index != head; index++)
+        consume(mRecords[index % mRecords.size()]);
+      mTail.store(head, std::memory_order_release);
+    }
+
+    /*!
+     * \brief  Gets the id of the owning thread in the trace.
+     * \return The trace thread id.
+     */
+    std::uint32_t threadId() const noexcept {
+      return mThreadId;
+    }
+
+  private:
+    //! \brief The records of the ring.
+    std::array<ProfileRecord, RecordsPerThread> mRecords;
+
+    //! \brief The number of records pushed, only written by the owning thread.
+    std::atomic<std::size_t> mHead;
+
+    //! \brief The number of records drained, only written by the flushing thread.
+    std::atomic<std::size_t> mTail;
+
+    //! \brief The id of the owning thread in the trace.
+    std::uint32_t mThreadId;
+  };
+
+  Profiler& Profiler::instance() noexcept {
+    static Profiler profiler;
+    return profiler;
+  }
+
+  Profiler::Profiler() noexcept
+    : mBuffers()
+    , mBuffersLock()
+    , mFlushThread()
+    , mFlushSignal()
+    , mFlushLock()
+    , mFile()
+    , mEpoch()
+    , mDropped(0)
+    , mTracing(false)
+    , mStopping(false)
+    , mFirstEvent(true)
+  { }
+
+  Profiler::~Profiler() noexcept {
+    stop();
+  }
+
+  void Profiler::start(const char* filePath) {
+    // Expects.
+    if (mTracing.load(std::memory_order_relaxed))
+      throw std::runtime_error("Profiler is already tracing.");
+
+    {
+      std::lock_guard<std::mutex> guard(mBuffersLock);
+      mFile.open(filePath, std::ios::out | std::ios::trunc);
+      if (!mFile.is_open())
+        throw std::runtime_error("Failed to open profiler trace file.");
+
+      // Discard anything recorded before this trace.
+      for (auto& buffer : mBuffers)
+        buffer->drain([](const ProfileRecord&) { });
+
+      mFile << "{\"traceEvents\":[\n";
+      mFirstEvent = true;
+      mEpoch      = std::chrono::steady_clock::now();
+      mDropped.store(0, std::memory_order_relaxed);
+    }
+
+    mStopping = false;
+    mTracing.store(true, std::memory_order_release);
+    mFlushThread = std::thread(&Profiler::flushLoop, this);
+  }
+
+  void Profiler::stop() noexcept {
+    // Not tracing.
+    if (!mTracing.exchange(false, std::memory_order_acq_rel))
+      return;
+
+    // Ask the flush thread to stop.
+    {
+      std::lock_guard<std::mutex> guard(mFlushLock);
+      mStopping = true;
+    }
+    mFlushSignal.notify_one();
+    if (mFlushThread.joinable())
+      mFlushThread.join();
+
+    // Write out the stragglers and close the trace.
+    flush();
+    std::lock_guard<std::mutex> guard(mBuffersLock);
+    mFile << "\n]}\n";
+    mFile.close();
+  }
+
+  bool Profiler::tracing() const noexcept {
+    return mTracing.load(std::memory_order_relaxed);
+  }
+
+  std::uint64_t Profiler::droppedRecords() const noexcept {
+    return mDropped.load(std::memory_order_relaxed);
+  }
+
+  void Profiler::record(const char* name, ProfilePhase phase) noexcept {
+    // Fast path when not tracing, acquire so the epoch of the trace is visible.
+    if (!mTracing.load(std::memory_order_acquire))
+      return;
+
+    auto* buffer = threadBuffer();
+    if (buffer == nullptr)
+      return;
+
+    const auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - mEpoch);
+    if (!buffer->push(ProfileRecord{ name, static_cast<std::uint64_t>(timestamp.count()), phase }))
+      mDropped.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  Profiler::ThreadBuffer* Profiler::threadBuffer() noexcept {
+    // The ring of the calling thread, once it has recorded a zone.
+    static thread_local ThreadBuffer* tThreadBuffer = nullptr;
+    if (tThreadBuffer != nullptr)
+      return tThreadBuffer;
+
+    try {
+      std::lock_guard<std::mutex> guard(mBuffersLock);
+      mBuffers.push_back(std::make_unique<ThreadBuffer>(static_cast<std::uint32_t>(mBuffers.size())));
+      tThreadBuffer = mBuffers.back().get();
+    } catch (const std::exception&) {
+      return nullptr;
+    }
+    return tThreadBuffer;
+  }
+
+  void Profiler::flushLoop() noexcept {
+    std::unique_lock<std::mutex> lock(mFlushLock);
+    while (!mStopping) {
+      mFlushSignal.wait_for(lock, FlushInterval);
+      lock.unlock();
+      flush();
+      lock.lock();
+    }
+  }
+
+  void Profiler::flush() noexcept {
+    std::lock_guard<std::mutex> guard(mBuffersLock);
+    for (auto& buffer : mBuffers) {
+      const auto threadId = buffer->threadId();
+      buffer->drain([&](const ProfileRecord& record) {
+        // Names are expected to be identifiers, anything that would break the JSON is replaced.
+        char name[128];
+        std::size_t length = 0;
+        for (const char* character = record.name; *character != '\0' && length + 1 < sizeof(name); character++)
+          name[length++] = (*character == '"' || *character == '\\' || static_cast<unsigned char>(*character) < 0x20) ? '_' : *character;
+        name[length] = '\0';
+
+        // Chrome traces are in microseconds.
+        char event[256];
+        std::snprintf(
+          event, sizeof(event), "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu.%03llu,\"pid\":1,\"tid\":%u}",
+          mFirstEvent ? "" : ",\n", name, record.phase == ProfilePhase::Begin ? 'B' : 'E',
+          static_cast<unsigned long long>(record.timestamp / 1000), static_cast<unsigned long long>(record.timestamp % 1000),
+          threadId
+        );
+        mFile << event;
+        mFirstEvent = false;
+      });
+    }
+    mFile.flush();
+  }
+
+}
@@ -0,0 +1,397 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <hearth/scheduler.hpp>
+#include "jobqueue.hpp"
+
+namespace HAPI_NAMESPACE_NAME {
+
+  // The index of the worker the calling thread belongs to.
+  thread_local std::uint32_t tWorkerIndex = std::numeric_limits<std::uint32_t>::max();
+
+  // The number of failed attempts at finding work before a worker goes to sleep.
+  constexpr std::uint32_t kSpinsBeforeSleep = 64;
+
+  // How long a sleeping worker waits before checking for work again, covers missed wake ups.
+  constexpr std::chrono::milliseconds kSleepTimeout(1);
+
+  // Puts a job at the back of a ring of jobs, unrolling the ring into one twice the size when full.
+  template<typename Slot>
+  static void pushRing(std::vector<Slot*>& ring, std::size_t& head, std::size_t& tail, Slot* slot) {
+    if (tail - head == ring.size()) {
+      std::vector<Slot*> grown(ring.size() * 2);
+      for (std::size_t index = head; index < tail; index++)
+        grown[index - head] = ring[index & (ring.size() - 1)];
+
+      tail -= head;
+      head  = 0;
+      ring.swap(grown);
+    }
+
+    ring[tail++ & (ring.size() - 1)] = slot;
+  }
+
+  struct JobScheduler::JobSlot {
+    //! \brief The job stored in this slot.
+    Job job;
+
+    //! \brief Whether the job was queued and hasn't started executing, so the slot can't be reused.
+    std::atomic<bool> live;
+  };
+
+  struct JobScheduler::Worker {
+    //! \brief Constructs a worker with an empty deque and job pool.
+    Worker()
+      : queue(MaxJobsPerWorker)
+      , jobs()
+      , nextJob(0)
+      , victimSeed(0)
+      , thread()
+    {
+      jobs.push_back(std::make_unique<JobSlot[]>(MaxJobsPerWorker));
+    }
+
+    //! \brief The deque of jobs scheduled from this worker.
+    WorkStealingQueue<JobSlot> queue;
+
+    //! \brief The storage for jobs scheduled from this worker, in blocks that never move.
+    std::vector<std::unique_ptr<JobSlot[]>> jobs;
+
+    //! \brief The next job storage slot to try.
+    std::size_t nextJob;
+
+    //! \brief Seeds the choice of which worker to steal from.
+    std::uint32_t victimSeed;
+
+    //! \brief The thread of this worker, not joinable for the main thread.
+    std::thread thread;
+  };
+
+  JobCounter::JobCounter() noexcept
+    : mValue(0)
+    , mContinuationLock()
+    , mInlineContinuations()
+    , mInlineCount(0)
+    , mContinuations()
+  { }
+
+  std::uint32_t JobCounter::value() const noexcept {
+    return mValue.load(std::memory_order_acquire);
+  }
+
+  bool JobCounter::done() const noexcept {
+    return value() == 0;
+  }
+
+  JobScheduler::JobScheduler(const CreateInfo& createInfo)
+    : mWorkers()
+    , mMainThreadLock()
+    , mMainThreadJobs(MaxJobsPerWorker)
+    , mMainThreadHead(0)
+    , mMainThreadTail(0)
+    , mBackgroundLock()
+    , mBackgroundJobs(MaxJobsPerWorker)
+    , mBackgroundHead(0)
+    , mBackgroundTail(0)
+    , mSleepLock()
+    , mWakeCondition()
+    , mSleepingWorkers(0)
+    , mRunning(true)
+  {
+    // Use every core if unspecified.
+    auto workerCount = createInfo.workerCount;
+    if (workerCount == 0)
+      workerCount = std::max(1u, std::thread::hardware_concurrency());
+
+    // Create workers.
+    mWorkers.reserve(workerCount);
+    for (std::uint32_t index = 0; index < workerCount; index++) {
+      mWorkers.push_back(std::make_unique<Worker>());
+      mWorkers.back()->victimSeed = index + 1;
+    }
+
+    // The calling thread is the main thread, every other worker gets its own thread.
+    tWorkerIndex = 0;
+    for (std::uint32_t index = 1; index < workerCount; index++)
+      mWorkers[index]->thread = std::thread(&JobScheduler::workerLoop, this, index);
+  }
+
+  JobScheduler::~JobScheduler() noexcept {
+    // Stop and join workers.
+    mRunning.store(false, std::memory_order_release);
+    {
+      std::lock_guard lock(mSleepLock);
+      mWakeCondition.notify_all();
+    }
+
+    for (auto& worker : mWorkers)
+      if (worker->thread.joinable())
+        worker->thread.join();
+
+    tWorkerIndex = std::numeric_limits<std::uint32_t>::max();
+  }
+
+  void JobScheduler::schedule(const Job& job) {
+    if (job.counter != nullptr)
+      job.counter->mValue.fetch_add(1, std::memory_order_relaxed);
+
+    enqueue(job);
+  }
+
+  void JobScheduler::scheduleAfter(const Job& job, JobCounter& dependency) {
+    if (job.counter != nullptr)
+      job.counter->mValue.fetch_add(1, std::memory_order_relaxed);
+
+    // Park the job on the dependency, unless it has already completed.
+    {
+      std::lock_guard lock(dependency.mContinuationLock);
+      if (dependency.mValue.load(std::memory_order_acquire) != 0) {
+        if (dependency.mInlineCount < JobCounter::InlineContinuations)
+          dependency.mInlineContinuations[dependency.mInlineCount++] = job;
+        else
+          dependency.mContinuations.push_back(job);
+        return;
+      }
+    }
+
+    enqueue(job);
+  }
+
+  void JobScheduler::wait(JobCounter& counter) {
+    while (counter.mValue.load(std::memory_order_acquire) != 0)
+      if (!tryExecuteJob())
+        std::this_thread::yield();
+
+    // Make sure the job that completed the counter has let go of it.
+    std::lock_guard lock(counter.mContinuationLock);
+  }
+
+  void JobScheduler::runMainThreadJobs() {
+    // Expects.
+    if (tWorkerIndex != 0)
+      throw std::runtime_error("Main thread jobs can only be run from the main thread.");
+
+    while (auto* slot = popMainThreadJob())
+      execute(slot);
+  }
+
+  std::uint32_t JobScheduler::workerCount() const noexcept {
+    return static_cast<std::uint32_t>(mWorkers.size());
+  }
+
+  std::uint32_t JobScheduler::workerIndex() {
+    // Expects.
+    if (tWorkerIndex == std::numeric_limits<std::uint32_t>::max())
+      throw std::runtime_error("Calling thread does not belong to a job scheduler.");
+
+    return tWorkerIndex;
+  }
+
+  void JobScheduler::enqueue(const Job& job) {
+    // Without other workers, nothing else would ever pick up background jobs.
+    if (job.affinity == JobAffinity::Background && mWorkers.size() == 1) {
+      run(job);
+      return;
+    }
+
+    // Copy the job into the scheduling worker's storage.
+    auto&    worker = *mWorkers[workerIndex()];
+    JobSlot* stored = acquireSlot(worker);
+    stored->job = job;
+    stored->live.store(true, std::memory_order_release);
+
+    // Main thread jobs go in their own queue.
+    if (job.affinity == JobAffinity::MainThread) {
+      std::lock_guard lock(mMainThreadLock);
+      pushRing(mMainThreadJobs, mMainThreadHead, mMainThreadTail, stored);
+      return;
+    }
+
+    // Background jobs go in their own queue, never inline since the frame would wait on them.
+    if (job.affinity == JobAffinity::Background) {
+      {
+        std::lock_guard lock(mBackgroundLock);
+        pushRing(mBackgroundJobs, mBackgroundHead, mBackgroundTail, stored);
+      }
+
+      if (mSleepingWorkers.load(std::memory_order_relaxed) != 0)
+        mWakeCondition.notify_one();
+      return;
+    }
+
+    // Our deque is full, work through it until there is room. The job itself stays queued, so it
+    // runs wherever and whenever it would have.
+    while (!worker.queue.push(stored))
+      if (auto* slot = worker.queue.pop())
+        execute(slot);
+
+    // Wake a sleeping worker to pick it up.
+    if (mSleepingWorkers.load(std::memory_order_relaxed) != 0)
+      mWakeCondition.notify_one();
+  }
+
+  JobScheduler::JobSlot* JobScheduler::acquireSlot(Worker& worker) {
+    // Slots are tried in order, skipping those whose job hasn't started yet.
+    const auto slotCount = worker.jobs.size() * MaxJobsPerWorker;
+    for (std::size_t attempt = 0; attempt < slotCount; attempt++) {
+      const auto index = worker.nextJob++ % slotCount;
+      JobSlot*   slot  = &worker.jobs[index / MaxJobsPerWorker][index % MaxJobsPerWorker];
+      if (!slot->live.load(std::memory_order_acquire))
+        return slot;
+    }
+
+    // Every slot is taken, add another block rather than waiting on any of them.
+    worker.jobs.push_back(std::make_unique<JobSlot[]>(MaxJobsPerWorker));
+    worker.nextJob = slotCount + 1;
+    return &worker.jobs.back()[0];
+  }
+
+  bool JobScheduler::tryExecuteJob() {
+    const auto index  = workerIndex();
+    auto&      worker = *mWorkers[index];
+
+    // Our own work first.
+    JobSlot* job = worker.queue.pop();
+
+    // Then work that can only run on the main thread.
+    if (job == nullptr && index == 0)
+      job = popMainThreadJob();
+
+    // Then steal, starting from a pseudo-random victim.
+    if (job == nullptr && mWorkers.size() > 1) {
+      worker.victimSeed ^= worker.victimSeed << 13;
+      worker.victimSeed ^= worker.victimSeed >> 17;
+      worker.victimSeed ^= worker.victimSeed << 5;
+
+      const auto count = static_cast<std::uint32_t>(mWorkers.size());
+      const auto start = worker.victimSeed % count;
+      for (std::uint32_t offset = 0; offset < count && job == nullptr; offset++) {
+        const auto victim = (start + offset) % count;
+        if (victim != index)
+          job = mWorkers[victim]->queue.steal();
+      }
+    }
+
+    if (job == nullptr)
+      return false;
+
+    execute(job);
+    return true;
+  }
+
+  void JobScheduler::execute(JobSlot* slot) {
+    // Copy out, the storage slot may be reused as soon as it's released.
+    const Job current = slot->job;
+    slot->live.store(false, std::memory_order_release);
+    run(current);
+  }
+
+  void JobScheduler::run(const Job& current) {
+    current.function(current.data);
+
+    // Nothing to complete.
+    if (current.counter == nullptr)
+      return;
+
+    // Not the last job of the counter, decrement without locking.
+    auto& counter = *current.counter;
+    auto  value   = counter.mValue.load(std::memory_order_acquire);
+    while (value > 1)
+      if (counter.mValue.compare_exchange_weak(value, value - 1, std::memory_order_acq_rel, std::memory_order_acquire))
+        return;
+
+    // Last job of the counter, release whatever was waiting on it. The lock is held across the
+    // decrement, so waiters can't destroy the counter until we are done touching it.
+    std::array<Job, JobCounter::InlineContinuations> continuations;
+    std::size_t      continuationCount = 0;
+    std::vector<Job> overflow;
+    {
+      std::lock_guard lock(counter.mContinuationLock);
+      if (counter.mValue.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        continuationCount = counter.mInlineCount;
+        std::copy_n(counter.mInlineContinuations.begin(), continuationCount, continuations.begin());
+        counter.mInlineCount = 0;
+        overflow.swap(counter.mContinuations);
+      }
+    }
+
+    for (std::size_t index = 0; index < continuationCount; index++)
+      enqueue(continuations[index]);
+    for (const auto& continuation : overflow)
+      enqueue(continuation);
+  }
+
+  JobScheduler::JobSlot* JobScheduler::popMainThreadJob() {
+    std::lock_guard lock(mMainThreadLock);
+    if (mMainThreadHead == mMainThreadTail)
+      return nullptr;
+
+    return mMainThreadJobs[mMainThreadHead++ & (mMainThreadJobs.size() - 1)];
+  }
+
+  JobScheduler::JobSlot* JobScheduler::popBackgroundJob() {
+    std::lock_guard lock(mBackgroundLock);
+    if (mBackgroundHead == mBackgroundTail)
+      return nullptr;
+
+    return mBackgroundJobs[mBackgroundHead++ & (mBackgroundJobs.size() - 1)];
+  }
+
+  void JobScheduler::workerLoop(std::uint32_t index) {
+    tWorkerIndex = index;
+
+    std::uint32_t spins = 0;
+    while (mRunning.load(std::memory_order_acquire)) {
+      // Found work.
+      if (tryExecuteJob()) {
+        spins = 0;
+        continue;
+      }
+
+      // Nothing urgent, pick up background work.
+      if (auto* slot = popBackgroundJob()) {
+        execute(slot);
+        spins = 0;
+        continue;
+      }
+
+      // Stay hot for a while before sleeping.
+      if (++spins < kSpinsBeforeSleep) {
+        std::this_thread::yield();
+        continue;
+      }
+
+      // Sleep until woken, or the timeout passes.
+      mSleepingWorkers.fetch_add(1, std::memory_order_relaxed);
+      {
+        std::unique_lock lock(mSleepLock);
+        if (mRunning.load(std::memory_order_acquire))
+          mWakeCondition.wait_for(lock, kSleepTimeout);
+      }
+      mSleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+      spins = 0;
+    }
+  }
+
+}
@@ -4,9 +4,19 @@
 int main() {
   // Provide application create info.
   const hearth::Application::CreateInfo appCreateInfo {
-    .appName      = L"Hearthfire",
-    .appResidency = hearth::Environment::instance(),
-    .appVersion   = hearth::Version::current
+    .appName              = L"Hearthfire",
+    .appResidency         = hearth::Environment::instance(),
+    .appVersion           = hearth::Version::current,
+    .framesInFlight       = 2,
+    .targetFrameRate      = 144.0,
+    .simulationRate       = 60.0,
+    .maxSimulationSteps   = 5,
+    .workerCount          = 0,
+    .pipelinedRendering   = true,
+    .extendedDynamicState = true,
+    .pipelineCachePath    = "hearthfire.pipelines.bin",
+    .traceFilePath        = "hearthfire.trace.json",
+    .allocationPolicy     = hearth::AllocationPolicy::Report
   };
 
   // Create application.